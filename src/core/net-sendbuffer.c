@@ -164,6 +164,14 @@ void net_sendbuffer_flush(NET_SENDBUF_REC *rec)
 	fcntl(handle, F_SETFL, O_NONBLOCK);
 }
 
+/* Returns the number of bytes waiting to be sent */
+int net_sendbuffer_pending(NET_SENDBUF_REC *rec)
+{
+	g_return_val_if_fail(rec != NULL, 0);
+
+	return rec->buffer == NULL ? 0 : rec->bufpos;
+}
+
 /* Returns the socket handle */
 GIOChannel *net_sendbuffer_handle(NET_SENDBUF_REC *rec)
 {
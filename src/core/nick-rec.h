@@ -6,6 +6,8 @@ int chat_type; /* chat_protocol_lookup(xx) */
 time_t last_check; /* last time gone was checked */
 
 char *nick;
+/* shared with the other nicks of the server, use the nicklist_set_*()
+   functions to change these */
 char *host;
 char *realname;
 char *account;
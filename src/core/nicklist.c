@@ -21,6 +21,7 @@
 #include "module.h"
 #include <irssi/src/core/signals.h>
 #include <irssi/src/core/misc.h>
+#include <irssi/src/core/refstrings.h>
 
 #include <irssi/src/core/servers.h>
 #include <irssi/src/core/channels.h>
@@ -88,6 +89,17 @@ void nicklist_insert(CHANNEL_REC *channel, NICK_REC *nick)
 	signal_emit("nicklist new", 2, channel, nick);
 }
 
+/* host, realname and account are shared between all the nick records
+   of the server, replace `*field' with a reference to `value' */
+static void nick_string_set(CHANNEL_REC *channel, char **field, const char *value)
+{
+	char *old;
+
+	old = *field;
+	*field = i_refstr_table_intern(channel->server->nick_strings, value);
+	i_refstr_table_release(channel->server->nick_strings, old);
+}
+
 /* Set host address for nick */
 void nicklist_set_host(CHANNEL_REC *channel, NICK_REC *nick, const char *host)
 {
@@ -95,20 +107,26 @@ void nicklist_set_host(CHANNEL_REC *channel, NICK_REC *nick, const char *host)
         g_return_if_fail(nick != NULL);
 	g_return_if_fail(host != NULL);
 
-        g_free_not_null(nick->host);
-	nick->host = g_strdup(host);
+	nick_string_set(channel, &nick->host, host);
 
         signal_emit("nicklist host changed", 2, channel, nick);
 }
 
 void nicklist_set_account(CHANNEL_REC *channel, NICK_REC *nick, const char *account)
 {
-	g_free(nick->account);
-	nick->account = g_strdup(account);
+	nick_string_set(channel, &nick->account, account);
 
 	signal_emit("nicklist account changed", 2, channel, nick);
 }
 
+void nicklist_set_realname(CHANNEL_REC *channel, NICK_REC *nick, const char *realname)
+{
+        g_return_if_fail(channel != NULL);
+        g_return_if_fail(nick != NULL);
+
+	nick_string_set(channel, &nick->realname, realname);
+}
+
 static void nicklist_destroy(CHANNEL_REC *channel, NICK_REC *nick)
 {
 	signal_emit("nicklist remove", 2, channel, nick);
@@ -118,9 +136,9 @@ static void nicklist_destroy(CHANNEL_REC *channel, NICK_REC *nick)
 
         /*MODULE_DATA_DEINIT(nick);*/
 	g_free(nick->nick);
-	g_free_not_null(nick->realname);
-	g_free_not_null(nick->host);
-	g_free(nick->account);
+	i_refstr_table_release(channel->server->nick_strings, nick->realname);
+	i_refstr_table_release(channel->server->nick_strings, nick->host);
+	i_refstr_table_release(channel->server->nick_strings, nick->account);
 	g_free(nick);
 }
 
@@ -25,9 +25,20 @@
 #include <irssi/src/lib-config/iconfig.h>
 #include <irssi/src/core/misc.h>
 
+/* max. number of cached iconv converters */
+#define RECODE_MAX_CONVERTERS 32
+
+typedef struct {
+	GIConv cd; /* (GIConv)-1 if the conversion isn't supported */
+	unsigned int ascii_safe:1; /* ASCII is converted as-is */
+} RECODE_CONV_REC;
+
 static char *translit_charset;
 static gboolean term_is_utf8;
 
+/* "to\nfrom" : RECODE_CONV_REC */
+static GHashTable *converters;
+
 gboolean is_utf8(void)
 {
 	return term_is_utf8;
@@ -77,14 +88,140 @@ static char *find_conversion(const SERVER_REC *server, const char *target)
 	return conv;
 }
 
-static int str_is_ascii(const char *str)
+/* Returns the length of the 7-bit prefix of str. The bytes are checked a
+   word at a time, which compilers can vectorize. */
+static gsize ascii_prefix_len(const char *str, gsize len)
+{
+	const guint64 high_bits = G_GUINT64_CONSTANT(0x8080808080808080);
+	guint64 word;
+	gsize pos;
+
+	for (pos = 0; pos + sizeof(word) <= len; pos += sizeof(word)) {
+		memcpy(&word, str + pos, sizeof(word));
+		if ((word & high_bits) != 0)
+			break;
+	}
+
+	while (pos < len && (str[pos] & 0x80) == 0)
+		pos++;
+	return pos;
+}
+
+static void converter_destroy(RECODE_CONV_REC *rec)
+{
+	if (rec->cd != (GIConv)-1)
+		g_iconv_close(rec->cd);
+	g_free(rec);
+}
+
+/* Returns TRUE if the converter gives ASCII characters out as they are.
+   This isn't true for example for UTF-16 or ISO-2022-JP. */
+static gboolean converter_ascii_safe(GIConv cd)
 {
+	char in[128], out[128], *inbuf, *outbuf;
+	gsize inleft, outleft;
 	int i;
 
-	for (i = 0; str[i] != '\0'; i++)
-		if (str[i] & 0x80)
-			return 0;
-	return 1;
+	/* ESC would change the state of some encodings */
+	for (i = 1; i < 128; i++)
+		in[i-1] = i == '\e' ? ' ' : i;
+
+	inbuf = in; inleft = 127;
+	outbuf = out; outleft = sizeof(out);
+	if (g_iconv(cd, &inbuf, &inleft, &outbuf, &outleft) == (gsize)-1 ||
+	    g_iconv(cd, NULL, NULL, &outbuf, &outleft) == (gsize)-1)
+		return FALSE;
+
+	return outleft == sizeof(out) - 127 && memcmp(in, out, 127) == 0;
+}
+
+/* Returns a cached converter, or NULL if the charsets aren't supported. */
+static RECODE_CONV_REC *converter_get(const char *to, const char *from)
+{
+	RECODE_CONV_REC *rec;
+	char *key;
+
+	key = g_strconcat(to, "\n", from, NULL);
+	rec = g_hash_table_lookup(converters, key);
+	if (rec != NULL) {
+		g_free(key);
+		/* reset the shift state */
+		if (rec->cd != (GIConv)-1)
+			g_iconv(rec->cd, NULL, NULL, NULL, NULL);
+		return rec->cd == (GIConv)-1 ? NULL : rec;
+	}
+
+	if (g_hash_table_size(converters) >= RECODE_MAX_CONVERTERS)
+		g_hash_table_remove_all(converters);
+
+	rec = g_new0(RECODE_CONV_REC, 1);
+	rec->cd = g_iconv_open(to, from);
+	if (rec->cd != (GIConv)-1) {
+		rec->ascii_safe = converter_ascii_safe(rec->cd);
+		g_iconv(rec->cd, NULL, NULL, NULL, NULL);
+	}
+	g_hash_table_insert(converters, key, rec);
+
+	return rec->cd == (GIConv)-1 ? NULL : rec;
+}
+
+/* Like g_convert(), but with a cached converter. If ascii is TRUE, str is
+   known to be 7-bit without ESC characters. With fallback, characters that
+   can't be converted are written as escapes like in
+   g_convert_with_fallback(). */
+static char *recode_convert(const char *str, gsize len, const char *to,
+			    const char *from, gboolean ascii, gboolean fallback)
+{
+	RECODE_CONV_REC *rec;
+	char *dest, *inbuf, *outbuf;
+	gsize inleft, outleft, size, used;
+	gboolean flushed;
+
+	rec = converter_get(to, from);
+	if (rec == NULL)
+		return NULL;
+
+	if (ascii && rec->ascii_safe)
+		return g_strndup(str, len);
+
+	/* room for a 4 byte NUL, wide charsets need it */
+	size = len + 16;
+	dest = g_malloc(size);
+	inbuf = (char *) str; inleft = len;
+	outbuf = dest; outleft = size - 4;
+
+	flushed = FALSE;
+	for (;;) {
+		gsize ret;
+
+		if (inleft > 0)
+			ret = g_iconv(rec->cd, &inbuf, &inleft, &outbuf, &outleft);
+		else
+			ret = g_iconv(rec->cd, NULL, NULL, &outbuf, &outleft);
+
+		if (ret != (gsize)-1) {
+			if (inleft == 0 && flushed)
+				break;
+			flushed = inleft == 0;
+			continue;
+		}
+		if (errno != E2BIG) {
+			/* invalid or incomplete input */
+			g_free(dest);
+			return !fallback ? NULL :
+				g_convert_with_fallback(str, len, to, from, NULL,
+							NULL, NULL, NULL);
+		}
+
+		used = outbuf - dest;
+		size *= 2;
+		dest = g_realloc(dest, size);
+		outbuf = dest + used;
+		outleft = size - used - 4;
+	}
+
+	memset(outbuf, 0, 4);
+	return dest;
 }
 
 char *recode_in(const SERVER_REC *server, const char *str, const char *target)
@@ -92,8 +229,8 @@ char *recode_in(const SERVER_REC *server, const char *str, const char *target)
 	const char *from = NULL;
 	const char *to = translit_charset;
 	char *recoded = NULL;
-	gboolean str_is_utf8, recode, autodetect;
-	int len;
+	gboolean str_is_utf8, recode, autodetect, ascii;
+	gsize len, ascii_len;
 
 	if (!str)
 		return NULL;
@@ -104,12 +241,15 @@ char *recode_in(const SERVER_REC *server, const char *str, const char *target)
 
 	len = strlen(str);
 
-	/* Only validate for UTF-8 if an 8-bit encoding. */
+	/* Only validate for UTF-8 if an 8-bit encoding. The 7-bit prefix
+	   doesn't need to be validated again. */
 	str_is_utf8 = 0;
-	if (!str_is_ascii(str))
-		str_is_utf8 = g_utf8_validate(str, len, NULL);
+	ascii = FALSE;
+	ascii_len = ascii_prefix_len(str, len);
+	if (ascii_len < len)
+		str_is_utf8 = g_utf8_validate(str + ascii_len, len - ascii_len, NULL);
 	else if (!strchr(str, '\e'))
-		str_is_utf8 = 1;
+		str_is_utf8 = ascii = TRUE;
 	autodetect = settings_get_bool("recode_autodetect_utf8");
 
 	if (autodetect && str_is_utf8)
@@ -121,7 +261,7 @@ char *recode_in(const SERVER_REC *server, const char *str, const char *target)
 		from = find_conversion(server, target);
 
 	if (from)
-		recoded = g_convert_with_fallback(str, len, to, from, NULL, NULL, NULL, NULL);
+		recoded = recode_convert(str, len, to, from, ascii, TRUE);
 
 	if (!recoded) {
 		if (str_is_utf8)
@@ -136,7 +276,7 @@ char *recode_in(const SERVER_REC *server, const char *str, const char *target)
 				from = NULL;
 
 		if (from)
-			recoded = g_convert_with_fallback(str, len, to, from, NULL, NULL, NULL, NULL);
+			recoded = recode_convert(str, len, to, from, ascii, TRUE);
 
 		if (!recoded)
 			recoded = g_strdup(str);
@@ -150,8 +290,8 @@ char *recode_out(const SERVER_REC *server, const char *str, const char *target)
 	const char *from = translit_charset;
 	const char *to = NULL;
 	char *translit_to = NULL;
-	gboolean translit, recode;
-	int len;
+	gboolean translit, recode, ascii;
+	gsize len;
 
 	if (!str)
 		return NULL;
@@ -173,7 +313,8 @@ char *recode_out(const SERVER_REC *server, const char *str, const char *target)
 		if (translit && !is_translit(to))
 			to = translit_to = g_strconcat(to ,"//TRANSLIT", NULL);
 
-		recoded = g_convert(str, len, to, from, NULL, NULL, NULL);
+		ascii = ascii_prefix_len(str, len) == len && !strchr(str, '\e');
+		recoded = recode_convert(str, len, to, from, ascii, FALSE);
 	}
 	g_free(translit_to);
 	if (!recoded)
@@ -185,7 +326,8 @@ char *recode_out(const SERVER_REC *server, const char *str, const char *target)
 char **recode_split(const SERVER_REC *server, const char *str,
 		    const char *target, int len, gboolean onspace)
 {
-	GIConv cd = (GIConv)-1;
+	RECODE_CONV_REC *conv;
+	GIConv cd;
 	const char *from = translit_charset;
 	const char *to = translit_charset;
 	char *translit_to = NULL;
@@ -221,13 +363,14 @@ char **recode_split(const SERVER_REC *server, const char *str,
 		}
 	}
 
-	cd = g_iconv_open(to, from);
-	if (cd == (GIConv)-1) {
+	conv = converter_get(to, from);
+	if (conv == NULL) {
 		/* Fall back to splitting by byte. */
 		ret = strsplit_len(str, len, onspace);
 		goto out;
 	}
 
+	cd = conv->cd;
 	tmp = g_malloc(outbytesleft);
 	outbuf = tmp;
 	ret = g_new(char *, 1);
@@ -273,8 +416,6 @@ char **recode_split(const SERVER_REC *server, const char *str,
 	ret[n] = NULL;
 
 out:
-	if (cd != (GIConv)-1)
-		g_iconv_close(cd);
 	g_free(translit_to);
 	g_free(tmp);
 
@@ -299,9 +440,13 @@ void recode_init(void)
 	settings_add_str("misc", "recode_out_default_charset", "");
 	settings_add_bool("misc", "recode_transliterate", TRUE);
 	settings_add_bool("misc", "recode_autodetect_utf8", TRUE);
+
+	converters = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+					   (GDestroyNotify) converter_destroy);
 }
 
 void recode_deinit(void)
 {
+	g_hash_table_destroy(converters);
 	g_free(translit_charset);
 }
@@ -127,3 +127,90 @@ char *i_refstr_table_size_info(void)
 }
 
 #endif
+
+struct _I_REFSTR_TABLE {
+	GHashTable *hash; /* string -> reference count */
+	size_t refs;
+	size_t bytes;
+	size_t unshared_bytes;
+};
+
+I_REFSTR_TABLE *i_refstr_table_new(void)
+{
+	I_REFSTR_TABLE *table;
+
+	table = g_new0(I_REFSTR_TABLE, 1);
+	table->hash = g_hash_table_new(g_str_hash, g_str_equal);
+	return table;
+}
+
+void i_refstr_table_destroy(I_REFSTR_TABLE *table)
+{
+	if (table == NULL)
+		return;
+
+	g_hash_table_foreach(table->hash, (GHFunc) g_free, NULL);
+	g_hash_table_destroy(table->hash);
+	g_free(table);
+}
+
+char *i_refstr_table_intern(I_REFSTR_TABLE *table, const char *str)
+{
+	gpointer rc_p, ret_p;
+	size_t rc, len;
+	char *ret;
+
+	if (str == NULL)
+		return NULL;
+
+	len = strlen(str) + 1;
+	if (g_hash_table_lookup_extended(table->hash, str, &ret_p, &rc_p)) {
+		rc = GPOINTER_TO_SIZE(rc_p);
+		ret = ret_p;
+	} else {
+		rc = 0;
+		ret = g_strdup(str);
+		table->bytes += len;
+	}
+
+	g_hash_table_insert(table->hash, ret, GSIZE_TO_POINTER(rc + 1));
+	table->refs++;
+	table->unshared_bytes += len;
+	return ret;
+}
+
+void i_refstr_table_release(I_REFSTR_TABLE *table, char *str)
+{
+	gpointer rc_p, ret_p;
+	size_t rc, len;
+
+	if (str == NULL)
+		return;
+
+	if (!g_hash_table_lookup_extended(table->hash, str, &ret_p, &rc_p) || ret_p != str) {
+		/* not from this table */
+		g_free(str);
+		return;
+	}
+
+	len = strlen(str) + 1;
+	rc = GPOINTER_TO_SIZE(rc_p);
+	table->refs--;
+	table->unshared_bytes -= len;
+	if (rc > 1) {
+		g_hash_table_insert(table->hash, str, GSIZE_TO_POINTER(rc - 1));
+	} else {
+		g_hash_table_remove(table->hash, str);
+		table->bytes -= len;
+		g_free(str);
+	}
+}
+
+void i_refstr_table_stats(I_REFSTR_TABLE *table, size_t *strings, size_t *refs,
+                          size_t *bytes, size_t *unshared_bytes)
+{
+	*strings = g_hash_table_size(table->hash);
+	*refs = table->refs;
+	*bytes = table->bytes;
+	*unshared_bytes = table->unshared_bytes;
+}
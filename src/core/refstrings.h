@@ -7,4 +7,17 @@ void i_refstr_release(char *str);
 void i_refstr_deinit(void);
 char *i_refstr_table_size_info(void);
 
+/* Separately accounted table of shared strings. Strings interned here must
+   be released with i_refstr_table_release() to the same table. */
+typedef struct _I_REFSTR_TABLE I_REFSTR_TABLE;
+
+I_REFSTR_TABLE *i_refstr_table_new(void);
+void i_refstr_table_destroy(I_REFSTR_TABLE *table);
+char *i_refstr_table_intern(I_REFSTR_TABLE *table, const char *str);
+void i_refstr_table_release(I_REFSTR_TABLE *table, char *str);
+/* Returns number of distinct strings, number of references to them, bytes
+   used by the strings and bytes that separate copies would have used. */
+void i_refstr_table_stats(I_REFSTR_TABLE *table, size_t *strings, size_t *refs,
+                          size_t *bytes, size_t *unshared_bytes);
+
 #endif
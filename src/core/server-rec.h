@@ -43,6 +43,8 @@ int lag; /* server lag in milliseconds */
 
 GSList *channels;
 GSList *queries;
+/* shared host, realname and account strings of the nicks in channels */
+struct _I_REFSTR_TABLE *nick_strings;
 
 /* transient meta data stash */
 GHashTable *current_incoming_meta;
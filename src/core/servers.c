@@ -375,6 +375,7 @@ void server_connect_init(SERVER_REC *server)
 	server->current_incoming_meta =
 	    g_hash_table_new_full(g_str_hash, (GEqualFunc) g_str_equal,
 	                          (GDestroyNotify) i_refstr_release, (GDestroyNotify) g_free);
+	server->nick_strings = i_refstr_table_new();
 
 	server->nick = g_strdup(server->connrec->nick);
 	if (server->connrec->username == NULL || *server->connrec->username == '\0') {
@@ -557,6 +558,7 @@ int server_unref(SERVER_REC *server)
 	g_free(server->nick);
 	g_free(server->tag);
 	g_hash_table_destroy(server->current_incoming_meta);
+	i_refstr_table_destroy(server->nick_strings);
 
 	server->type = 0;
 	g_free(server);
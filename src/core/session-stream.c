@@ -0,0 +1,386 @@
+/*
+ session-stream.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "module.h"
+#include <irssi/src/core/session-stream.h>
+
+/* File format, all integers are 32bit big endian:
+
+   header: "\177IRSSI-SESSION" <version>
+   record: <type byte> <nodes>
+   nodes: <count> <node>*
+   node: <type byte> <string key> (<string value> | <nodes>)
+   string: <length + 1> <data>, or 0 for NULL
+
+   The file ends with a SESSION_RECORD_END byte. */
+
+#define SESSION_STREAM_MAGIC "\177IRSSI-SESSION"
+#define SESSION_STREAM_MAGIC_LEN (sizeof(SESSION_STREAM_MAGIC) - 1)
+
+/* sanity limits for reading */
+#define MAX_STRING_LENGTH (16 * 1024 * 1024)
+#define MAX_NODE_DEPTH 16
+
+static void stream_write_uint(SESSION_STREAM *stream, guint32 value)
+{
+	value = GUINT32_TO_BE(value);
+	if (fwrite(&value, sizeof(value), 1, stream->file) != 1)
+		stream->error = TRUE;
+}
+
+static void stream_write_byte(SESSION_STREAM *stream, int value)
+{
+	if (putc(value, stream->file) == EOF)
+		stream->error = TRUE;
+}
+
+static void stream_write_str(SESSION_STREAM *stream, const char *str)
+{
+	size_t len;
+
+	if (str == NULL) {
+		stream_write_uint(stream, 0);
+		return;
+	}
+
+	len = strlen(str);
+	stream_write_uint(stream, len + 1);
+	if (len > 0 && fwrite(str, len, 1, stream->file) != 1)
+		stream->error = TRUE;
+}
+
+static void stream_write_nodes(SESSION_STREAM *stream, CONFIG_NODE *parent)
+{
+	CONFIG_NODE *node;
+	GSList *tmp;
+	int count;
+
+	count = 0;
+	for (tmp = config_node_first(parent->value); tmp != NULL; tmp = config_node_next(tmp))
+		count++;
+	stream_write_uint(stream, count);
+
+	for (tmp = config_node_first(parent->value); tmp != NULL; tmp = config_node_next(tmp)) {
+		node = tmp->data;
+
+		stream_write_byte(stream, node->type);
+		stream_write_str(stream, node->key);
+		if (is_node_list(node))
+			stream_write_nodes(stream, node);
+		else
+			stream_write_str(stream, node->value);
+	}
+}
+
+static int stream_read_uint(SESSION_STREAM *stream, guint32 *value)
+{
+	if (fread(value, sizeof(*value), 1, stream->file) != 1)
+		return FALSE;
+
+	*value = GUINT32_FROM_BE(*value);
+	return TRUE;
+}
+
+static int stream_read_str(SESSION_STREAM *stream, char **str)
+{
+	guint32 len;
+
+	*str = NULL;
+	if (!stream_read_uint(stream, &len) || len > MAX_STRING_LENGTH)
+		return FALSE;
+	if (len == 0)
+		return TRUE;
+
+	*str = g_malloc(len);
+	if (len > 1 && fread(*str, len - 1, 1, stream->file) != 1) {
+		g_free_and_null(*str);
+		return FALSE;
+	}
+	(*str)[len - 1] = '\0';
+	return TRUE;
+}
+
+static int stream_read_nodes(SESSION_STREAM *stream, CONFIG_NODE *parent, int depth)
+{
+	CONFIG_NODE *node;
+	guint32 count;
+	char *key, *value;
+	int type, ret;
+
+	if (depth > MAX_NODE_DEPTH || !stream_read_uint(stream, &count))
+		return FALSE;
+
+	ret = TRUE;
+	for (; count > 0 && ret; count--) {
+		type = getc(stream->file);
+		if (!stream_read_str(stream, &key))
+			return FALSE;
+
+		switch (type) {
+		case NODE_TYPE_KEY:
+		case NODE_TYPE_VALUE:
+			ret = stream_read_str(stream, &value) && value != NULL &&
+				(type == NODE_TYPE_VALUE || key != NULL);
+			if (ret) {
+				config_node_set_str(stream->config, parent,
+						    type == NODE_TYPE_KEY ? key : NULL,
+						    value);
+			}
+			g_free(value);
+			break;
+		case NODE_TYPE_BLOCK:
+		case NODE_TYPE_LIST:
+			node = config_node_section(stream->config, parent,
+						   key, type);
+			ret = node != NULL &&
+				stream_read_nodes(stream, node, depth + 1);
+			break;
+		default:
+			ret = FALSE;
+			break;
+		}
+		g_free(key);
+	}
+
+	return ret;
+}
+
+SESSION_STREAM *session_stream_create(const char *path)
+{
+	SESSION_STREAM *stream;
+	FILE *file;
+	int handle;
+
+	g_return_val_if_fail(path != NULL, NULL);
+
+	handle = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (handle == -1)
+		return NULL;
+
+	file = fdopen(handle, "wb");
+	if (file == NULL) {
+		close(handle);
+		return NULL;
+	}
+
+	stream = g_new0(SESSION_STREAM, 1);
+	stream->file = file;
+	stream->config = config_open(NULL, -1);
+	stream->version = SESSION_STREAM_VERSION;
+	stream->write = TRUE;
+
+	if (fwrite(SESSION_STREAM_MAGIC, SESSION_STREAM_MAGIC_LEN, 1, file) != 1)
+		stream->error = TRUE;
+	stream_write_uint(stream, stream->version);
+	return stream;
+}
+
+SESSION_STREAM *session_stream_create_text(const char *path)
+{
+	SESSION_STREAM *stream;
+
+	g_return_val_if_fail(path != NULL, NULL);
+
+	stream = g_new0(SESSION_STREAM, 1);
+	stream->text = config_open(path, 0600);
+	if (stream->text == NULL) {
+		g_free(stream);
+		return NULL;
+	}
+
+	stream->config = config_open(NULL, -1);
+	stream->version = SESSION_STREAM_VERSION;
+	stream->write = TRUE;
+	return stream;
+}
+
+SESSION_STREAM *session_stream_open(const char *path)
+{
+	SESSION_STREAM *stream;
+	char magic[SESSION_STREAM_MAGIC_LEN];
+	guint32 version;
+	FILE *file;
+
+	g_return_val_if_fail(path != NULL, NULL);
+
+	file = fopen(path, "rb");
+	if (file == NULL)
+		return NULL;
+
+	if (fread(magic, sizeof(magic), 1, file) != 1 ||
+	    memcmp(magic, SESSION_STREAM_MAGIC, sizeof(magic)) != 0) {
+		/* not a binary session file */
+		fclose(file);
+		return NULL;
+	}
+
+	stream = g_new0(SESSION_STREAM, 1);
+	stream->file = file;
+
+	if (!stream_read_uint(stream, &version) ||
+	    version > SESSION_STREAM_VERSION) {
+		g_warning("Session file %s has unsupported version", path);
+		fclose(file);
+		g_free(stream);
+		return NULL;
+	}
+
+	stream->config = config_open(NULL, -1);
+	stream->version = version;
+	return stream;
+}
+
+int session_stream_close(SESSION_STREAM *stream)
+{
+	int ret;
+
+	g_return_val_if_fail(stream != NULL, FALSE);
+
+	if (stream->text != NULL) {
+		ret = !stream->error &&
+			config_write(stream->text, NULL, -1) == 0;
+		config_close(stream->text);
+		config_close(stream->config);
+		g_free(stream);
+		return ret;
+	}
+
+	if (stream->write)
+		stream_write_byte(stream, SESSION_RECORD_END);
+
+	ret = !stream->error;
+	if (fclose(stream->file) != 0)
+		ret = FALSE;
+
+	config_close(stream->config);
+	g_free(stream);
+	return ret;
+}
+
+CONFIG_NODE *session_stream_record(SESSION_STREAM *stream)
+{
+	g_return_val_if_fail(stream != NULL, NULL);
+
+	config_nodes_remove_all(stream->config);
+	return stream->config->mainnode;
+}
+
+static void text_copy_nodes(CONFIG_REC *rec, CONFIG_NODE *dest,
+			    CONFIG_NODE *src)
+{
+	CONFIG_NODE *node;
+	GSList *tmp;
+
+	for (tmp = config_node_first(src->value); tmp != NULL; tmp = config_node_next(tmp)) {
+		node = tmp->data;
+
+		if (is_node_list(node)) {
+			text_copy_nodes(rec, config_node_section(rec, dest, node->key,
+								 node->type),
+					node);
+		} else {
+			config_node_set_str(rec, dest, node->key, node->value);
+		}
+	}
+}
+
+/* Add the current record to the text session where the older versions
+   expect it: servers have a list of their channels, and channels of
+   their nicks */
+static void text_write_record(SESSION_STREAM *stream, int type)
+{
+	CONFIG_REC *rec;
+	CONFIG_NODE *parent, *node;
+
+	rec = stream->text;
+	switch (type) {
+	case SESSION_RECORD_SERVER:
+		parent = config_node_traverse(rec, "(servers", TRUE);
+		break;
+	case SESSION_RECORD_CHANNEL:
+		parent = stream->text_server == NULL ? NULL :
+			config_node_section(rec, stream->text_server,
+					    "channels", NODE_TYPE_LIST);
+		break;
+	case SESSION_RECORD_NICK:
+		parent = stream->text_channel == NULL ? NULL :
+			config_node_section(rec, stream->text_channel,
+					    "nicks", NODE_TYPE_LIST);
+		break;
+	default:
+		text_copy_nodes(rec, rec->mainnode, stream->config->mainnode);
+		return;
+	}
+
+	if (parent == NULL) {
+		/* channel without a server or nick without a channel */
+		stream->error = TRUE;
+		return;
+	}
+
+	node = config_node_section(rec, parent, NULL, NODE_TYPE_BLOCK);
+	text_copy_nodes(rec, node, stream->config->mainnode);
+
+	if (type == SESSION_RECORD_SERVER) {
+		stream->text_server = node;
+		stream->text_channel = NULL;
+	} else if (type == SESSION_RECORD_CHANNEL) {
+		stream->text_channel = node;
+	}
+}
+
+void session_stream_write(SESSION_STREAM *stream, int type)
+{
+	g_return_if_fail(stream != NULL);
+	g_return_if_fail(stream->write);
+	g_return_if_fail(type > SESSION_RECORD_END && type < 256);
+
+	if (stream->text != NULL) {
+		text_write_record(stream, type);
+		return;
+	}
+
+	stream_write_byte(stream, type);
+	stream_write_nodes(stream, stream->config->mainnode);
+}
+
+int session_stream_read(SESSION_STREAM *stream)
+{
+	int type;
+
+	g_return_val_if_fail(stream != NULL, -1);
+	g_return_val_if_fail(!stream->write, -1);
+
+	if (stream->error)
+		return -1;
+
+	config_nodes_remove_all(stream->config);
+	type = getc(stream->file);
+	if (type == SESSION_RECORD_END)
+		return type;
+
+	if (type == EOF ||
+	    !stream_read_nodes(stream, stream->config->mainnode, 0)) {
+		/* truncated or corrupted */
+		stream->error = TRUE;
+		return -1;
+	}
+	return type;
+}
@@ -0,0 +1,55 @@
+#ifndef IRSSI_CORE_SESSION_STREAM_H
+#define IRSSI_CORE_SESSION_STREAM_H
+
+#include <irssi/src/lib-config/iconfig.h>
+
+/* Binary /UPGRADE session file. The file is a sequence of records which are
+   written and read one at a time, so the whole session never needs to be
+   kept in memory. Each record is a small config block, so the
+   "session save/restore ..." signal handlers can keep using the
+   config_node_*() functions. */
+
+#define SESSION_STREAM_VERSION 1
+
+enum {
+	SESSION_RECORD_END,
+	SESSION_RECORD_SERVER, /* followed by its channels */
+	SESSION_RECORD_CHANNEL, /* followed by its nicks */
+	SESSION_RECORD_NICK,
+	SESSION_RECORD_PIDS
+};
+
+typedef struct _SESSION_STREAM {
+	FILE *file;
+	CONFIG_REC *config; /* config->mainnode is the current record */
+	int version;
+
+	/* the records are collected to one text file instead of `file',
+	   which the versions before the binary format can read */
+	CONFIG_REC *text;
+	CONFIG_NODE *text_server, *text_channel; /* where the records go */
+
+	unsigned int write:1;
+	unsigned int error:1;
+} SESSION_STREAM;
+
+/* Create a new session file. Returns NULL and sets errno if it failed. */
+SESSION_STREAM *session_stream_create(const char *path);
+/* Create a new session file in the old text format. The whole session is
+   kept in memory and written when the stream is closed. */
+SESSION_STREAM *session_stream_create_text(const char *path);
+/* Open session file for reading. Returns NULL if the file doesn't exist or
+   isn't a binary session file. */
+SESSION_STREAM *session_stream_open(const char *path);
+/* Returns FALSE if there were any errors with the stream. */
+int session_stream_close(SESSION_STREAM *stream);
+
+/* Clear the current record and return its node for filling. */
+CONFIG_NODE *session_stream_record(SESSION_STREAM *stream);
+/* Write the current record with `type' */
+void session_stream_write(SESSION_STREAM *stream, int type);
+/* Read the next record to stream->config->mainnode. Returns the record type,
+   SESSION_RECORD_END at the end of the session or -1 if the file is broken. */
+int session_stream_read(SESSION_STREAM *stream);
+
+#endif
@@ -27,6 +27,7 @@
 #include <irssi/src/core/pidwait.h>
 #include <irssi/src/lib-config/iconfig.h>
 #include <irssi/src/core/misc.h>
+#include <irssi/src/core/session-stream.h>
 
 #include <irssi/src/core/chat-protocols.h>
 #include <irssi/src/core/servers.h>
@@ -56,33 +57,48 @@ void session_upgrade(void)
 		session_args[0], g_strerror(errno));
 }
 
-/* SYNTAX: UPGRADE [<irssi binary path>] */
+/* SYNTAX: UPGRADE [-text] [<irssi binary path>] */
 static void cmd_upgrade(const char *data)
 {
-	CONFIG_REC *session;
-	char *session_file, *str, *name;
+	GHashTable *optlist;
+	SESSION_STREAM *session;
+	char *session_file, *str, *name, *path;
 	char *binary;
+	void *free_arg;
+
+	if (!cmd_get_params(data, &free_arg, 1 | PARAM_FLAG_OPTIONS |
+			    PARAM_FLAG_GETREST, "upgrade", &optlist, &path))
+		return;
 
-	if (*data == '\0')
+	if (*path == '\0')
 		name = irssi_binary;
 	else
-		name = convert_home(data);
+		name = convert_home(path);
 
 	binary = g_find_program_in_path(name);
 	if (name != irssi_binary)
 		g_free(name);
 
 	if (binary == NULL)
-		cmd_return_error(CMDERR_PROGRAM_NOT_FOUND);
+		cmd_param_error(CMDERR_PROGRAM_NOT_FOUND);
 
-	/* save the session */
+	/* save the session, -text writes it so that the versions before
+	   the binary session files can read it */
         session_file = g_strdup_printf("%s/session", get_irssi_dir());
-	session = config_open(session_file, 0600);
         unlink(session_file);
+	if (g_hash_table_lookup(optlist, "text") != NULL)
+		session = session_stream_create_text(session_file);
+	else
+		session = session_stream_create(session_file);
+	if (session == NULL) {
+		g_free(session_file);
+		g_free(binary);
+		cmd_param_error(CMDERR_ERRNO);
+	}
 
 	signal_emit("session save", 1, session);
-        config_write(session, NULL, -1);
-        config_close(session);
+	if (!session_stream_close(session))
+		g_warning("Failed to write session file %s", session_file);
 
 	/* data may contain some other program as well, like
 	   /UPGRADE /usr/bin/screen irssi */
@@ -93,13 +109,18 @@ static void cmd_upgrade(const char *data)
         session_args = g_strsplit(str, " ", -1);
         g_free(str);
 
+	cmd_params_free(free_arg);
 	signal_emit("gui exit", 0);
 }
 
 static void session_save_nick(CHANNEL_REC *channel, NICK_REC *nick,
-			      CONFIG_REC *config, CONFIG_NODE *node)
+			      SESSION_STREAM *stream)
 {
-	node = config_node_section(config, node, NULL, NODE_TYPE_BLOCK);
+	CONFIG_REC *config;
+	CONFIG_NODE *node;
+
+	config = stream->config;
+	node = session_stream_record(stream);
 
 	config_node_set_str(config, node, "nick", nick->nick);
 	config_node_set_bool(config, node, "op", nick->op);
@@ -109,24 +130,17 @@ static void session_save_nick(CHANNEL_REC *channel, NICK_REC *nick,
 	config_node_set_str(config, node, "prefixes", nick->prefixes);
 
 	signal_emit("session save nick", 4, channel, nick, config, node);
+	session_stream_write(stream, SESSION_RECORD_NICK);
 }
 
-static void session_save_channel_nicks(CHANNEL_REC *channel, CONFIG_REC *config,
-				       CONFIG_NODE *node)
+static void session_save_channel(CHANNEL_REC *channel, SESSION_STREAM *stream)
 {
+	CONFIG_REC *config;
+	CONFIG_NODE *node;
 	GSList *tmp, *nicks;
 
-	node = config_node_section(config, node, "nicks", NODE_TYPE_LIST);
-        nicks = nicklist_getnicks(channel);
-	for (tmp = nicks; tmp != NULL; tmp = tmp->next)
-		session_save_nick(channel, tmp->data, config, node);
-        g_slist_free(nicks);
-}
-
-static void session_save_channel(CHANNEL_REC *channel, CONFIG_REC *config,
-				 CONFIG_NODE *node)
-{
-	node = config_node_section(config, node, NULL, NODE_TYPE_BLOCK);
+	config = stream->config;
+	node = session_stream_record(stream);
 
 	config_node_set_str(config, node, "name", channel->name);
 	config_node_set_str(config, node, "visible_name", channel->visible_name);
@@ -136,26 +150,24 @@ static void session_save_channel(CHANNEL_REC *channel, CONFIG_REC *config,
 	config_node_set_str(config, node, "key", channel->key);
 
 	signal_emit("session save channel", 3, channel, config, node);
-}
+	session_stream_write(stream, SESSION_RECORD_CHANNEL);
 
-static void session_save_server_channels(SERVER_REC *server,
-					 CONFIG_REC *config,
-					 CONFIG_NODE *node)
-{
-	GSList *tmp;
-
-	/* save channels */
-	node = config_node_section(config, node, "channels", NODE_TYPE_LIST);
-	for (tmp = server->channels; tmp != NULL; tmp = tmp->next)
-		session_save_channel(tmp->data, config, node);
+	/* nicks follow their channel */
+        nicks = nicklist_getnicks(channel);
+	for (tmp = nicks; tmp != NULL; tmp = tmp->next)
+		session_save_nick(channel, tmp->data, stream);
+        g_slist_free(nicks);
 }
 
-static void session_save_server(SERVER_REC *server, CONFIG_REC *config,
-				CONFIG_NODE *node)
+static void session_save_server(SERVER_REC *server, SESSION_STREAM *stream)
 {
+	CONFIG_REC *config;
+	CONFIG_NODE *node;
+	GSList *tmp;
 	int handle;
 
-	node = config_node_section(config, node, NULL, NODE_TYPE_BLOCK);
+	config = stream->config;
+	node = session_stream_record(stream);
 
 	config_node_set_str(config, node, "chat_type", chat_protocol_find_id(server->chat_type)->name);
 	config_node_set_str(config, node, "address", server->connrec->address);
@@ -179,6 +191,11 @@ static void session_save_server(SERVER_REC *server, CONFIG_REC *config,
 	config_node_set_int(config, node, "handle", handle);
 
 	signal_emit("session save server", 3, server, config, node);
+	session_stream_write(stream, SESSION_RECORD_SERVER);
+
+	/* channels follow their server */
+	for (tmp = server->channels; tmp != NULL; tmp = tmp->next)
+		session_save_channel(tmp->data, stream);
 
 	/* fake the server disconnection */
 	g_io_channel_unref(net_sendbuffer_handle(server->handle));
@@ -206,14 +223,14 @@ static void session_restore_channel_nicks(CHANNEL_REC *channel,
 	}
 }
 
-static void session_restore_channel(SERVER_REC *server, CONFIG_NODE *node)
+static CHANNEL_REC *session_restore_channel(SERVER_REC *server, CONFIG_NODE *node)
 {
         CHANNEL_REC *channel;
 	const char *name, *visible_name;
 
 	name = config_node_get_str(node, "name", NULL);
 	if (name == NULL)
-		return;
+		return NULL;
 
 	visible_name = config_node_get_str(node, "visible_name", NULL);
 	channel = CHAT_PROTOCOL(server)->channel_create(server, name, visible_name, TRUE);
@@ -224,6 +241,7 @@ static void session_restore_channel(SERVER_REC *server, CONFIG_NODE *node)
         channel->session_rejoin = TRUE;
 
 	signal_emit("session restore channel", 2, channel, node);
+	return channel;
 }
 
 static void session_restore_server_channels(SERVER_REC *server,
@@ -240,7 +258,9 @@ static void session_restore_server_channels(SERVER_REC *server,
 	}
 }
 
-static void session_restore_server(CONFIG_NODE *node)
+/* Returns the restored server, which still needs to be connected with
+   proto->server_connect() */
+static SERVER_REC *session_restore_server(CONFIG_NODE *node)
 {
 	CHAT_PROTOCOL_REC *proto;
 	SERVER_CONNECT_REC *conn;
@@ -257,19 +277,19 @@ static void session_restore_server(CONFIG_NODE *node)
 	handle = config_node_get_int(node, "handle", -1);
 
 	if (chat_type == NULL || address == NULL || nick == NULL || handle < 0)
-		return;
+		return NULL;
 
 	proto = chat_protocol_find(chat_type);
 	if (proto == NULL || proto->not_initialized) {
 		if (handle >= 0)
 			close(handle);
-		return;
+		return NULL;
 	}
 
 	conn = server_create_conn(proto->id, address, port,
 				  chatnet, password, nick);
 	if (conn == NULL)
-		return;
+		return NULL;
 
 	conn->use_tls = config_node_get_bool(node, "use_tls", FALSE);
 	conn->tls_cert = g_strdup(config_node_get_str(node, "tls_cert", NULL));
@@ -288,64 +308,123 @@ static void session_restore_server(CONFIG_NODE *node)
 	server->version = g_strdup(config_node_get_str(node, "version", NULL));
 	server->session_reconnect = TRUE;
 	signal_emit("session restore server", 2, server, node);
+	return server;
+}
+
+static void session_restore_pids(CONFIG_NODE *node)
+{
+        char **pids, **pid;
 
-	proto->server_connect(server);
+	/* restore pids (so we don't leave zombies) */
+	pids = g_strsplit(config_node_get_str(node, "pids", ""), " ", -1);
+	for (pid = pids; *pid != NULL; pid++)
+                pidwait_add(atoi(*pid));
+        g_strfreev(pids);
 }
 
-static void sig_session_save(CONFIG_REC *config)
+static void sig_session_save(SESSION_STREAM *stream)
 {
 	CONFIG_NODE *node;
 	GSList *tmp;
         GString *str;
 
         /* save servers */
-	node = config_node_traverse(config, "(servers", TRUE);
 	while (servers != NULL)
-		session_save_server(servers->data, config, node);
+		session_save_server(servers->data, stream);
 
 	/* save pids */
+	node = session_stream_record(stream);
         str = g_string_new(NULL);
 	for (tmp = pidwait_get_pids(); tmp != NULL; tmp = tmp->next)
                 g_string_append_printf(str, "%d ", GPOINTER_TO_INT(tmp->data));
-        config_node_set_str(config, config->mainnode, "pids", str->str);
+        config_node_set_str(stream->config, node, "pids", str->str);
         g_string_free(str, TRUE);
+	session_stream_write(stream, SESSION_RECORD_PIDS);
 }
 
+static void session_restore_stream(SESSION_STREAM *stream)
+{
+	SERVER_REC *server;
+	CHANNEL_REC *channel;
+	CONFIG_NODE *node;
+	int type;
+
+	server = NULL;
+	channel = NULL;
+	node = stream->config->mainnode;
+	while ((type = session_stream_read(stream)) > SESSION_RECORD_END) {
+		switch (type) {
+		case SESSION_RECORD_SERVER:
+			if (server != NULL)
+				CHAT_PROTOCOL(server)->server_connect(server);
+			server = session_restore_server(node);
+			channel = NULL;
+			break;
+		case SESSION_RECORD_CHANNEL:
+			channel = server == NULL ? NULL :
+				session_restore_channel(server, node);
+			break;
+		case SESSION_RECORD_NICK:
+			if (channel != NULL) {
+				signal_emit("session restore nick", 2,
+					    channel, node);
+			}
+			break;
+		case SESSION_RECORD_PIDS:
+			session_restore_pids(node);
+			break;
+		}
+	}
+
+	if (server != NULL)
+		CHAT_PROTOCOL(server)->server_connect(server);
+
+	if (type < 0)
+		g_warning("Session file is corrupted, not everything was restored");
+}
+
+/* session files written by older versions */
 static void sig_session_restore(CONFIG_REC *config)
 {
 	CONFIG_NODE *node;
+	SERVER_REC *server;
         GSList *tmp;
-        char **pids, **pid;
 
         /* restore servers */
 	node = config_node_traverse(config, "(servers", FALSE);
 	if (node != NULL) {
 		tmp = config_node_first(node->value);
-		for (; tmp != NULL; tmp = config_node_next(tmp))
-			session_restore_server(tmp->data);
+		for (; tmp != NULL; tmp = config_node_next(tmp)) {
+			server = session_restore_server(tmp->data);
+			if (server != NULL)
+				CHAT_PROTOCOL(server)->server_connect(server);
+		}
 	}
 
-	/* restore pids (so we don't leave zombies) */
-	pids = g_strsplit(config_node_get_str(config->mainnode, "pids", ""), " ", -1);
-	for (pid = pids; *pid != NULL; pid++)
-                pidwait_add(atoi(*pid));
-        g_strfreev(pids);
+	session_restore_pids(config->mainnode);
 }
 
 static void sig_init_finished(void)
 {
+	SESSION_STREAM *stream;
 	CONFIG_REC *session;
 
 	if (session_file == NULL)
 		return;
 
-	session = config_open(session_file, -1);
-	if (session == NULL)
-		return;
-
-	config_parse(session);
-        signal_emit("session restore", 1, session);
-	config_close(session);
+	stream = session_stream_open(session_file);
+	if (stream != NULL) {
+		session_restore_stream(stream);
+		session_stream_close(stream);
+	} else {
+		session = config_open(session_file, -1);
+		if (session == NULL)
+			return;
+
+		config_parse(session);
+		signal_emit("session restore", 1, session);
+		config_close(session);
+	}
 
 	unlink(session_file);
 }
@@ -364,12 +443,11 @@ void session_register_options(void)
 void session_init(void)
 {
 	command_bind("upgrade", NULL, (SIGNAL_FUNC) cmd_upgrade);
+	command_set_options("upgrade", "text");
 
 	signal_add("session save", (SIGNAL_FUNC) sig_session_save);
 	signal_add("session restore", (SIGNAL_FUNC) sig_session_restore);
-	signal_add("session save server", (SIGNAL_FUNC) session_save_server_channels);
 	signal_add("session restore server", (SIGNAL_FUNC) session_restore_server_channels);
-	signal_add("session save channel", (SIGNAL_FUNC) session_save_channel_nicks);
 	signal_add("session restore channel", (SIGNAL_FUNC) session_restore_channel_nicks);
 	signal_add("irssi init finished", (SIGNAL_FUNC) sig_init_finished);
 }
@@ -382,9 +460,7 @@ void session_deinit(void)
 
 	signal_remove("session save", (SIGNAL_FUNC) sig_session_save);
 	signal_remove("session restore", (SIGNAL_FUNC) sig_session_restore);
-	signal_remove("session save server", (SIGNAL_FUNC) session_save_server_channels);
 	signal_remove("session restore server", (SIGNAL_FUNC) session_restore_server_channels);
-	signal_remove("session save channel", (SIGNAL_FUNC) session_save_channel_nicks);
 	signal_remove("session restore channel", (SIGNAL_FUNC) session_restore_channel_nicks);
 	signal_remove("irssi init finished", (SIGNAL_FUNC) sig_init_finished);
 }
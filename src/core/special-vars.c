@@ -827,6 +827,59 @@ int *special_vars_get_signals(const char *text)
 	return special_vars_signals_task(text, 0, NULL, TASK_GET_SIGNALS);
 }
 
+GSList *special_vars_get_names(const char *text)
+{
+	GSList *names;
+	char *name;
+	int need_free;
+
+	names = NULL;
+	while (*text != '\0') {
+		if (*text == '\\' && text[1] != '\0') {
+                        /* escape */
+			text += 2;
+		} else if (*text == '$' && text[1] != '\0') {
+                        /* expando */
+			text++;
+			name = parse_special((char **) &text, NULL, NULL,
+					     NULL, &need_free, NULL,
+					     PARSE_FLAG_GETNAME);
+			if (name == NULL)
+				continue;
+
+			if (!isarg(*name) &&
+			    g_slist_find_custom(names, name, (GCompareFunc) strcmp) == NULL)
+				names = g_slist_append(names, g_strdup(name));
+			if (need_free) g_free(name);
+		} else {
+                        /* just a char */
+			text++;
+		}
+	}
+
+	return names;
+}
+
+char *special_vars_get_value(const char *name, SERVER_REC *server,
+			     void *item, int *free_ret)
+{
+	EXPANDO_FUNC func;
+
+	g_return_val_if_fail(name != NULL, NULL);
+	g_return_val_if_fail(free_ret != NULL, NULL);
+
+	if (name[0] != '\0' && name[1] != '\0')
+		return get_long_variable_value(name, server, item, free_ret);
+
+	*free_ret = FALSE;
+	func = expando_find_char(*name);
+	if (func == NULL)
+		return NULL;
+
+	current_expando = name;
+	return func(server, item, free_ret);
+}
+
 void special_vars_init(void)
 {
 	special_cache = NULL;
@@ -46,6 +46,14 @@ void special_vars_remove_signals(const char *text,
 /* Returns [<signal id>, EXPANDO_ARG_xxx, <signal id>, ..., -1] */
 int *special_vars_get_signals(const char *text);
 
+/* Returns the names of the $variables in text, without the arguments
+   ($0, $*, ..). The list and the names have to be g_free()'d. */
+GSList *special_vars_get_names(const char *text);
+/* Returns the value of $variable `name' the same way as it's expanded
+   in text. Return value has to be g_free()'d if `free_ret' is TRUE. */
+char *special_vars_get_value(const char *name, SERVER_REC *server,
+			     void *item, int *free_ret);
+
 void special_vars_init(void);
 
 void special_vars_deinit(void);
@@ -45,6 +45,39 @@ int string_advance(char const **str, int policy)
 	}
 }
 
+/* TRUE if all the bytes in word are printable ASCII, 0x20 .. 0x7e */
+static inline int word_is_printable_ascii(guint64 word)
+{
+	const guint64 ones = G_GUINT64_CONSTANT(0x0101010101010101);
+	const guint64 high_bits = ones * 0x80;
+	guint64 below_space, del;
+
+	/* the usual "has a byte less than n" and "has a zero byte" tricks */
+	below_space = (word - ones * 0x20) & ~word;
+	del = word ^ (ones * 0x7f);
+	del = (del - ones) & ~del;
+	return ((word | below_space | del) & high_bits) == 0;
+}
+
+gsize string_printable_ascii_len(const char *str, gsize len)
+{
+	guint64 words[2];
+	gsize pos;
+
+	/* 16 bytes at a time, which compilers can vectorize */
+	for (pos = 0; pos + sizeof(words) <= len; pos += sizeof(words)) {
+		memcpy(words, str + pos, sizeof(words));
+		if (!word_is_printable_ascii(words[0]) ||
+		    !word_is_printable_ascii(words[1]))
+			break;
+	}
+
+	while (pos < len && (unsigned char) str[pos] >= 0x20 &&
+	       (unsigned char) str[pos] < 0x7f)
+		pos++;
+	return pos;
+}
+
 int string_policy(const char *str)
 {
 	if (is_utf8()) {
@@ -75,6 +108,8 @@ int string_length(const char *str, int policy)
 
 int string_width(const char *str, int policy)
 {
+	const char *end;
+	gsize ascii;
 	int len;
 
 	g_return_val_if_fail(str != NULL, 0);
@@ -84,7 +119,16 @@ int string_width(const char *str, int policy)
 	}
 
 	len = 0;
-	while (*str != '\0') {
+	end = str + strlen(str);
+	while (str < end) {
+		if (policy == TREAT_STRING_AS_UTF8) {
+			/* printable ASCII is one column per byte */
+			ascii = string_printable_ascii_len(str, end - str);
+			len += ascii;
+			str += ascii;
+			if (str == end)
+				break;
+		}
 		len += string_advance(&str, policy);
 	}
 	return len;
@@ -50,6 +50,11 @@ int string_length(const char *str, int policy);
  */
 int string_width(const char *str, int policy);
 
+/* Return the number of bytes in the beginning of str (max. len bytes) that
+ * are printable ASCII characters, so each takes one column.
+ */
+gsize string_printable_ascii_len(const char *str, gsize len);
+
 /* Return the amount of characters from str it takes to reach n columns, or -1 if
  * str is NULL. Optionally return the equivalent amount of bytes.
  * If policy is -1, this function will call string_policy().
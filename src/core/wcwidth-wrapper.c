@@ -44,11 +44,82 @@ enum {
 #endif
 };
 
+/* The widths are looked up from a two-level table: one page for every 256
+   code points. A page is filled from wcwidth_impl_func the first time it's
+   used, so the table always matches the active implementation and the
+   Unicode version it knows. Pages where all characters have the same
+   width are shared. */
+#define WCWIDTH_PAGE_BITS 8
+#define WCWIDTH_PAGE_SIZE (1 << WCWIDTH_PAGE_BITS)
+#define WCWIDTH_MAX_CHAR 0x10ffff
+#define WCWIDTH_PAGES ((WCWIDTH_MAX_CHAR >> WCWIDTH_PAGE_BITS) + 1)
+
 WCWIDTH_FUNC wcwidth_impl_func = mk_wcwidth;
 
+static signed char *wcwidth_pages[WCWIDTH_PAGES];
+/* shared pages for widths -1 .. 2 */
+static signed char wcwidth_uniform_pages[4][WCWIDTH_PAGE_SIZE];
+/* implementation the table was filled with */
+static WCWIDTH_FUNC wcwidth_table_func;
+
+static void wcwidth_table_clear(void)
+{
+	int i;
+
+	for (i = 0; i < WCWIDTH_PAGES; i++) {
+		if (wcwidth_pages[i] != NULL &&
+		    (wcwidth_pages[i] < wcwidth_uniform_pages[0] ||
+		     wcwidth_pages[i] > wcwidth_uniform_pages[3]))
+			g_free(wcwidth_pages[i]);
+		wcwidth_pages[i] = NULL;
+	}
+	wcwidth_table_func = wcwidth_impl_func;
+}
+
+static signed char *wcwidth_page_fill(int pagenum)
+{
+	signed char widths[WCWIDTH_PAGE_SIZE], *page;
+	unichar first;
+	int i, width;
+
+	first = (unichar) pagenum << WCWIDTH_PAGE_BITS;
+	for (i = 0; i < WCWIDTH_PAGE_SIZE; i++) {
+		width = (*wcwidth_impl_func)(first + i);
+		widths[i] = CLAMP(width, -1, 2);
+	}
+
+	for (i = 1; i < WCWIDTH_PAGE_SIZE; i++) {
+		if (widths[i] != widths[0])
+			break;
+	}
+	if (i == WCWIDTH_PAGE_SIZE)
+		page = wcwidth_uniform_pages[widths[0] + 1];
+	else
+		page = g_new(signed char, WCWIDTH_PAGE_SIZE);
+	memcpy(page, widths, sizeof(widths));
+
+	wcwidth_pages[pagenum] = page;
+	return page;
+}
+
 int i_wcwidth(unichar ucs)
 {
-	return (*wcwidth_impl_func)(ucs);
+	signed char *page;
+
+	/* printable ASCII is the same everywhere */
+	if (ucs >= 0x20 && ucs < 0x7f)
+		return 1;
+
+	if (ucs > WCWIDTH_MAX_CHAR)
+		return (*wcwidth_impl_func)(ucs);
+
+	if (wcwidth_table_func != wcwidth_impl_func)
+		wcwidth_table_clear();
+
+	page = wcwidth_pages[ucs >> WCWIDTH_PAGE_BITS];
+	if (page == NULL)
+		page = wcwidth_page_fill(ucs >> WCWIDTH_PAGE_BITS);
+	return page[ucs & (WCWIDTH_PAGE_SIZE - 1)];
 }
 
 static int system_wcwidth(unichar ucs)
@@ -138,4 +209,5 @@ void wcwidth_wrapper_init(void)
 void wcwidth_wrapper_deinit(void)
 {
 	signal_remove("setup changed", (SIGNAL_FUNC) read_settings);
+	wcwidth_table_clear();
 }
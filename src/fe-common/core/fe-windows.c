@@ -38,6 +38,9 @@ GSList *windows; /* first in the list is the active window,
 GSequence *windows_seq;
 WINDOW_REC *active_win;
 
+/* window name : GSList of WINDOW_RECs */
+static GHashTable *windows_by_name;
+
 static int daytag;
 static int daycheck; /* 0 = don't check, 1 = time is 00:00, check,
                         2 = time is 00:00, already checked */
@@ -94,6 +97,38 @@ static GSequenceIter *windows_seq_refnum_search_left(int refnum)
 	return iter == windows_seq_begin() ? NULL : g_sequence_iter_prev(iter);
 }
 
+static void windows_by_name_add(WINDOW_REC *window)
+{
+	GSList *list;
+
+	if (window->name == NULL)
+		return;
+
+	list = g_hash_table_lookup(windows_by_name, window->name);
+	g_hash_table_replace(windows_by_name, g_strdup(window->name),
+			     g_slist_prepend(list, window));
+}
+
+static void windows_by_name_remove(WINDOW_REC *window)
+{
+	GSList *list;
+
+	if (window->name == NULL)
+		return;
+
+	list = g_hash_table_lookup(windows_by_name, window->name);
+	list = g_slist_remove(list, window);
+	if (list == NULL)
+		g_hash_table_remove(windows_by_name, window->name);
+	else
+		g_hash_table_replace(windows_by_name, g_strdup(window->name), list);
+}
+
+static void windows_by_name_free(char *name, GSList *list)
+{
+	g_slist_free(list);
+}
+
 static int window_get_new_refnum(void)
 {
 	WINDOW_REC *win;
@@ -187,6 +222,7 @@ void window_destroy(WINDOW_REC *window)
 	if (window->destroying) return;
 	window->destroying = TRUE;
 	windows = g_slist_remove(windows, window);
+	windows_by_name_remove(window);
 	iter = windows_seq_window_lookup(window);
 	if (iter != NULL) g_sequence_remove(iter);
 
@@ -300,8 +336,11 @@ void window_set_refnum(WINDOW_REC *window, int refnum)
 
 void window_set_name(WINDOW_REC *window, const char *name)
 {
+	windows_by_name_remove(window);
 	g_free_not_null(window->name);
 	window->name = name == NULL || *name == '\0' ? NULL : g_strdup(name);
+	if (!window->destroying)
+		windows_by_name_add(window);
 
 	signal_emit("window name changed", 1, window);
 }
@@ -448,18 +487,24 @@ WINDOW_REC *window_find_refnum(int refnum)
 WINDOW_REC *window_find_name(const char *name)
 {
 	GSList *tmp;
+	WINDOW_REC *found;
 
 	g_return_val_if_fail(name != NULL, NULL);
 
-	for (tmp = windows; tmp != NULL; tmp = tmp->next) {
-		WINDOW_REC *rec = tmp->data;
+	tmp = g_hash_table_lookup(windows_by_name, name);
+	if (tmp == NULL || tmp->next == NULL)
+		return tmp == NULL ? NULL : tmp->data;
 
-		if (rec->name != NULL &&
-		    g_ascii_strcasecmp(rec->name, name) == 0)
-			return rec;
+	/* several windows with the same name, return the first one */
+	found = NULL;
+	for (tmp = windows; tmp != NULL; tmp = tmp->next) {
+		if (g_slist_find(g_hash_table_lookup(windows_by_name, name),
+				 tmp->data) != NULL) {
+			found = tmp->data;
+			break;
+		}
 	}
-
-	return NULL;
+	return found;
 }
 
 WINDOW_REC *window_find_item(SERVER_REC *server, const char *name)
@@ -816,6 +861,9 @@ void windows_init(void)
 {
 	active_win = NULL;
 	windows_seq = g_sequence_new(NULL);
+	windows_by_name = g_hash_table_new_full((GHashFunc) i_istr_hash,
+						(GEqualFunc) i_istr_equal,
+						g_free, NULL);
 	daycheck = 0; daytag = -1;
 	settings_add_bool("lookandfeel", "window_auto_change", FALSE);
 	settings_add_bool("lookandfeel", "windows_auto_renumber", TRUE);
@@ -842,4 +890,7 @@ void windows_deinit(void)
 	signal_remove("setup changed", (SIGNAL_FUNC) read_settings);
 	g_sequence_free(windows_seq);
 	windows_seq = NULL;
+	g_hash_table_foreach(windows_by_name, (GHFunc) windows_by_name_free, NULL);
+	g_hash_table_destroy(windows_by_name);
+	windows_by_name = NULL;
 }
@@ -37,18 +37,36 @@ GSList *keyinfos;
 static GHashTable *keys, *default_keys;
 static int key_timeout;
 
-/* A cache of some sort for key presses that generate a single char only.
-   If the key isn't used, used_keys[key] is zero. */
-static char used_keys[256];
-
-/* Contains a list of all possible executable key bindings (not "key" keys).
-   Format is _always_ in key1-key2-key3 format and fully extracted, like
-   ^[-[-A, not meta-A */
-static GTree *key_states;
+/* A byte trie of all possible executable key bindings (not "key" keys).
+   The combos are _always_ in key1-key2-key3 format and fully extracted,
+   like ^[-[-A, not meta-A. Each node's children are in an array indexed
+   by the byte, covering only the range of bytes that are used. */
+typedef struct _KEY_STATE_REC KEY_STATE_REC;
+
+struct _KEY_STATE_REC {
+	GSList *keys; /* KEY_RECs of the combo ending here, newest first */
+
+	unsigned char first; /* byte of children[0] */
+	short count; /* size of children */
+	short used; /* non-NULL children */
+	KEY_STATE_REC **children;
+};
+
+#define key_state_child(state, chr) \
+	((unsigned int) ((unsigned char) (chr) - (state)->first) < \
+	 (unsigned int) (state)->count ? \
+	 (state)->children[(unsigned char) (chr) - (state)->first] : NULL)
+
+static KEY_STATE_REC *key_states;
+/* changed every time key_states is modified, so the nodes that
+   keyboards point to need to be looked up again */
+static unsigned int key_states_serial;
 static int key_config_frozen;
 
 struct _KEYBOARD_REC {
-	char *key_state; /* the ongoing key combo */
+	GString *key_combo; /* the ongoing key combo, empty if none */
+	KEY_STATE_REC *key_state; /* key_states node of key_combo */
+	unsigned int key_state_serial; /* key_states_serial of key_state */
 	guint timer_tag; /* used to check when a pending combo has expired */
 	void *gui_data; /* GUI specific data sent in "key pressed" signal */
 };
@@ -61,6 +79,7 @@ KEYBOARD_REC *keyboard_create(void *data)
 	KEYBOARD_REC *rec;
 
 	rec = g_new0(KEYBOARD_REC, 1);
+	rec->key_combo = g_string_new(NULL);
 	rec->gui_data = data;
 	rec->timer_tag = 0;
 
@@ -78,7 +97,7 @@ void keyboard_destroy(KEYBOARD_REC *keyboard)
 
 	signal_emit("keyboard destroyed", 1, keyboard);
 
-        g_free_not_null(keyboard->key_state);
+	g_string_free(keyboard->key_combo, TRUE);
         g_free(keyboard);
 }
 
@@ -375,7 +394,84 @@ static int expand_key(const char *key, GSList **out, int *limit)
         return TRUE;
 }
 
-static void key_states_scan_key(const char *key, KEY_REC *rec)
+static void key_state_destroy(KEY_STATE_REC *state)
+{
+	int i;
+
+	for (i = 0; i < state->count; i++) {
+		if (state->children[i] != NULL)
+			key_state_destroy(state->children[i]);
+	}
+	g_slist_free(state->keys);
+	g_free(state->children);
+	g_free(state);
+}
+
+static KEY_STATE_REC *key_state_get_child(KEY_STATE_REC *state, unsigned char chr)
+{
+	KEY_STATE_REC **children;
+	int first, last;
+
+	if (state->count == 0) {
+		state->first = chr;
+		state->count = 1;
+		state->children = g_new0(KEY_STATE_REC *, 1);
+	} else if (chr < state->first || chr >= state->first + state->count) {
+		/* grow the range of children to include chr */
+		first = MIN(state->first, chr);
+		last = MAX(state->first + state->count - 1, chr);
+		children = g_new0(KEY_STATE_REC *, last - first + 1);
+		memcpy(children + (state->first - first), state->children,
+		       state->count * sizeof(KEY_STATE_REC *));
+		g_free(state->children);
+		state->children = children;
+		state->first = first;
+		state->count = last - first + 1;
+	}
+
+	if (state->children[chr - state->first] == NULL) {
+		state->children[chr - state->first] = g_new0(KEY_STATE_REC, 1);
+		state->used++;
+	}
+	return state->children[chr - state->first];
+}
+
+static void key_state_add(const char *combo, KEY_REC *rec)
+{
+	KEY_STATE_REC *state;
+
+	state = key_states;
+	for (; *combo != '\0'; combo++)
+		state = key_state_get_child(state, *combo);
+
+	state->keys = g_slist_remove(state->keys, rec);
+	state->keys = g_slist_prepend(state->keys, rec);
+}
+
+/* Returns TRUE if state has become unused */
+static int key_state_remove(KEY_STATE_REC *state, const char *combo,
+			    KEY_REC *rec)
+{
+	KEY_STATE_REC *child;
+
+	if (*combo == '\0') {
+		state->keys = g_slist_remove(state->keys, rec);
+	} else {
+		child = key_state_child(state, *combo);
+		if (child != NULL && key_state_remove(child, combo + 1, rec)) {
+			key_state_destroy(child);
+			state->children[(unsigned char) *combo - state->first] = NULL;
+			state->used--;
+		}
+	}
+
+	return state->keys == NULL && state->used == 0;
+}
+
+/* Expands the key to all the combos that generate it, and calls func
+   for each of them */
+static void key_states_foreach_combo(KEY_REC *rec,
+				     void (*func) (const char *, KEY_REC *))
 {
 	GSList *tmp, *out;
 	int limit = MAX_EXPAND_RECURSION;
@@ -384,24 +480,25 @@ static void key_states_scan_key(const char *key, KEY_REC *rec)
 		return;
 
         out = g_slist_append(NULL, g_string_new(NULL));
-	if (expand_key(key, &out, &limit)) {
+	if (expand_key(rec->key, &out, &limit)) {
 		for (tmp = out; tmp != NULL; tmp = tmp->next) {
 			GString *str = tmp->data;
 
-			if (str->str[1] == '-' || str->str[1] == '\0')
-				used_keys[(int)(unsigned char)str->str[0]] = 1;
-
-			g_tree_insert(key_states, g_strdup(str->str), rec);
+			func(str->str, rec);
 		}
 	}
 
 	expand_out_free(out);
 }
 
-static int key_state_destroy(char *key)
+static void key_state_remove_combo(const char *combo, KEY_REC *rec)
 {
-	g_free(key);
-        return FALSE;
+	key_state_remove(key_states, combo, rec);
+}
+
+static void key_states_scan_key(const char *key, KEY_REC *rec)
+{
+	key_states_foreach_combo(rec, key_state_add);
 }
 
 /* Rescan all the key combos and figure out which characters are supposed
@@ -409,18 +506,30 @@ static int key_state_destroy(char *key)
    Yes, this is pretty slow function... */
 static void key_states_rescan(void)
 {
-	GString *temp;
+	if (key_states != NULL)
+		key_state_destroy(key_states);
+	key_states = g_new0(KEY_STATE_REC, 1);
+	key_states_serial++;
 
-	memset(used_keys, 0, sizeof(used_keys));
+	g_hash_table_foreach(keys, (GHFunc) key_states_scan_key, NULL);
+}
 
-	g_tree_foreach(key_states, (GTraverseFunc) key_state_destroy,
-			NULL);
-	g_tree_destroy(key_states);
-	key_states = g_tree_new((GCompareFunc) g_strcmp0);
+/* Update key_states after rec was added or is being removed. Named keys
+   change how other keys are expanded, so they need a full rescan. */
+static void key_states_update(KEY_REC *rec, int add)
+{
+	if (key_config_frozen)
+		return;
+
+	if (g_strcmp0(rec->info->id, "key") == 0) {
+		if (add)
+			key_states_rescan();
+		return;
+	}
 
-        temp = g_string_new(NULL);
-	g_hash_table_foreach(keys, (GHFunc) key_states_scan_key, temp);
-        g_string_free(temp, TRUE);
+	key_states_foreach_combo(rec, add ? key_state_add :
+				 key_state_remove_combo);
+	key_states_serial++;
 }
 
 void key_configure_freeze(void)
@@ -440,12 +549,13 @@ static void key_configure_destroy(KEY_REC *rec)
 {
 	g_return_if_fail(rec != NULL);
 
+	key_states_update(rec, FALSE);
 	rec->info->keys = g_slist_remove(rec->info->keys, rec);
 	g_hash_table_remove(keys, rec->key);
 
 	signal_emit("key destroyed", 1, rec);
 
-	if (!key_config_frozen)
+	if (!key_config_frozen && g_strcmp0(rec->info->id, "key") == 0)
                 key_states_rescan();
 
 	g_free_not_null(rec->data);
@@ -480,8 +590,7 @@ static void key_configure_create(const char *id, const char *key,
 
 	signal_emit("key created", 1, rec);
 
-	if (!key_config_frozen)
-                key_states_rescan();
+	key_states_update(rec, TRUE);
 }
 
 /* Bind a key for function */
@@ -521,12 +630,16 @@ void key_bind(const char *id, const char *description,
 
 static void keyinfo_remove(KEYINFO_REC *info)
 {
+	GSList *tmp;
+
 	g_return_if_fail(info != NULL);
 
 	keyinfos = g_slist_remove(keyinfos, info);
 	signal_emit("keyinfo destroyed", 1, info);
 
 	/* destroy all keys */
+	for (tmp = info->keys; tmp != NULL; tmp = tmp->next)
+		key_states_update(tmp->data, FALSE);
         g_slist_foreach(info->keys, (GFunc) key_destroy, keys);
         g_slist_foreach(info->default_keys, (GFunc) key_destroy, default_keys);
 
@@ -619,32 +732,40 @@ static int key_emit_signal(KEYBOARD_REC *keyboard, KEY_REC *key)
         return consumed;
 }
 
-static int key_states_search(const unsigned char *combo,
-			     const unsigned char *search)
+/* Returns the key_states node of the ongoing key combo, or NULL */
+static KEY_STATE_REC *keyboard_get_state(KEYBOARD_REC *keyboard)
 {
-	while (*search != '\0') {
-		if (*combo != *search)
-			return *search - *combo;
-                search++; combo++;
+	KEY_STATE_REC *state;
+	const char *p;
+
+	if (keyboard->key_combo->len == 0)
+		return NULL;
+
+	if (keyboard->key_state_serial != key_states_serial) {
+		/* key bindings have changed, find the combo again */
+		state = key_states;
+		for (p = keyboard->key_combo->str; state != NULL && *p != '\0'; p++)
+			state = key_state_child(state, *p);
+		keyboard->key_state = state;
+		keyboard->key_state_serial = key_states_serial;
 	}
-
-        return 0;
+	return keyboard->key_state;
 }
 
 static gboolean key_timeout_expired(KEYBOARD_REC *keyboard)
 {
-	KEY_REC *rec;
+	KEY_STATE_REC *state;
 
 	keyboard->timer_tag = 0;
 
 	/* So, the timeout has expired with the input queue full, let's see if
 	 * what we've got is bound to some action. */
-	rec = g_tree_lookup(key_states, keyboard->key_state);
+	state = keyboard_get_state(keyboard);
 	/* Drain the queue anyway. */
-	g_free_and_null(keyboard->key_state);
+	g_string_truncate(keyboard->key_combo, 0);
 
-	if (rec != NULL) {
-		(void)key_emit_signal(keyboard, rec);
+	if (state != NULL && state->keys != NULL) {
+		(void)key_emit_signal(keyboard, state->keys->data);
 	}
 
 	return FALSE;
@@ -652,8 +773,7 @@ static gboolean key_timeout_expired(KEYBOARD_REC *keyboard)
 
 int key_pressed(KEYBOARD_REC *keyboard, const char *key)
 {
-	KEY_REC *rec;
-        char *combo;
+	KEY_STATE_REC *state;
         int first_key, consumed;
 
 	g_return_val_if_fail(keyboard != NULL, FALSE);
@@ -664,30 +784,30 @@ int key_pressed(KEYBOARD_REC *keyboard, const char *key)
 		keyboard->timer_tag = 0;
 	}
 
-	if (keyboard->key_state == NULL && key[1] == '\0' &&
-	    !used_keys[(int) (unsigned char) key[0]]) {
-		/* fast check - key not used */
-		return -1;
+	first_key = keyboard->key_combo->len == 0;
+	state = first_key ? key_states : keyboard_get_state(keyboard);
+	if (!first_key) {
+		g_string_append_c(keyboard->key_combo, '-');
+		state = state == NULL ? NULL : key_state_child(state, '-');
 	}
 
-        first_key = keyboard->key_state == NULL;
-	combo = keyboard->key_state == NULL ? g_strdup(key) :
-                g_strconcat(keyboard->key_state, "-", key, NULL);
-	g_free_and_null(keyboard->key_state);
+	/* one step in key_states for each byte */
+	g_string_append(keyboard->key_combo, key);
+	for (; state != NULL && *key != '\0'; key++)
+		state = key_state_child(state, *key);
 
-	rec = g_tree_search(key_states,
-			    (GCompareFunc) key_states_search,
-			    combo);
-	if (rec == NULL) {
+	if (state == NULL ||
+	    (state->keys == NULL && key_state_child(state, '-') == NULL)) {
 		/* unknown key combo, eat the invalid key
 		   unless it was the first key pressed */
-                g_free(combo);
+		g_string_truncate(keyboard->key_combo, 0);
 		return first_key ? -1 : 1;
 	}
 
-	if (g_tree_lookup(key_states, combo) != rec) {
+	if (key_state_child(state, '-') != NULL) {
 		/* key combo continues.. */
-		keyboard->key_state = combo;
+		keyboard->key_state = state;
+		keyboard->key_state_serial = key_states_serial;
 		/* respect the timeout if specified by the user */
 		if (key_timeout > 0) {
 			keyboard->timer_tag =
@@ -699,8 +819,8 @@ int key_pressed(KEYBOARD_REC *keyboard, const char *key)
 	}
 
         /* finished key combo, execute */
-        g_free(combo);
-	consumed = key_emit_signal(keyboard, rec);
+	g_string_truncate(keyboard->key_combo, 0);
+	consumed = key_emit_signal(keyboard, state->keys->data);
 
 	/* never consume non-control characters */
 	return consumed ? 1 : -1;
@@ -964,9 +1084,8 @@ void keyboard_init(void)
 	default_keys = g_hash_table_new((GHashFunc) g_str_hash,
 					(GCompareFunc) g_str_equal);
 	keyinfos = NULL;
-	key_states = g_tree_new((GCompareFunc) g_strcmp0);
+	key_states = g_new0(KEY_STATE_REC, 1);
         key_config_frozen = 0;
-	memset(used_keys, 0, sizeof(used_keys));
 
 	settings_add_int("misc", "key_timeout", 0);
 
@@ -996,9 +1115,8 @@ void keyboard_deinit(void)
 	g_hash_table_destroy(keys);
 	g_hash_table_destroy(default_keys);
 
-	g_tree_foreach(key_states, (GTraverseFunc) key_state_destroy,
-			NULL);
-	g_tree_destroy(key_states);
+	key_state_destroy(key_states);
+	key_states = NULL;
 
 	signal_remove("irssi init read settings", (SIGNAL_FUNC) read_keyboard_config);
         signal_remove("setup reread", (SIGNAL_FUNC) read_keyboard_config);
@@ -21,6 +21,7 @@
 #include "module.h"
 #include <irssi/src/fe-common/core/module-formats.h>
 #include <irssi/src/core/modules.h>
+#include <irssi/src/core/misc.h>
 #include <irssi/src/core/signals.h>
 #include <irssi/src/core/servers.h>
 #include <irssi/src/core/channels.h>
@@ -32,6 +33,77 @@
 #include <irssi/src/fe-common/core/window-items.h>
 #include <irssi/src/fe-common/core/printtext.h>
 
+/* name or visible_name : GSList of WI_ITEM_RECs in windows */
+static GHashTable *items_by_name;
+/* WI_ITEM_REC : NULL-terminated array of the names it's indexed with */
+static GHashTable *item_names;
+
+static void items_by_name_add(const char *name, WI_ITEM_REC *item)
+{
+	GSList *list;
+
+	list = g_hash_table_lookup(items_by_name, name);
+	if (g_slist_find(list, item) == NULL) {
+		g_hash_table_replace(items_by_name, g_strdup(name),
+				     g_slist_prepend(list, item));
+	}
+}
+
+static void items_by_name_remove(const char *name, WI_ITEM_REC *item)
+{
+	GSList *list;
+
+	list = g_slist_remove(g_hash_table_lookup(items_by_name, name), item);
+	if (list == NULL)
+		g_hash_table_remove(items_by_name, name);
+	else
+		g_hash_table_replace(items_by_name, g_strdup(name), list);
+}
+
+static void items_by_name_free(char *name, GSList *list)
+{
+	g_slist_free(list);
+}
+
+static void window_item_index_add(WI_ITEM_REC *item)
+{
+	char **names;
+	int i;
+
+	i = 0;
+	names = g_new0(char *, 3);
+	if (item->visible_name != NULL)
+		names[i++] = g_strdup(item->visible_name);
+	if (item->name != NULL)
+		names[i++] = g_strdup(item->name);
+
+	for (i = 0; names[i] != NULL; i++)
+		items_by_name_add(names[i], item);
+	g_hash_table_insert(item_names, item, names);
+}
+
+static void window_item_index_remove(WI_ITEM_REC *item)
+{
+	char **names;
+	int i;
+
+	names = g_hash_table_lookup(item_names, item);
+	if (names == NULL)
+		return;
+
+	for (i = 0; names[i] != NULL; i++)
+		items_by_name_remove(names[i], item);
+	g_hash_table_remove(item_names, item);
+}
+
+static void sig_window_item_name_changed(WI_ITEM_REC *item)
+{
+	if (g_hash_table_contains(item_names, item)) {
+		window_item_index_remove(item);
+		window_item_index_add(item);
+	}
+}
+
 static void window_item_add_signal(WINDOW_REC *window, WI_ITEM_REC *item, int automatic, int send_signal)
 {
 	g_return_if_fail(window != NULL);
@@ -39,6 +111,7 @@ static void window_item_add_signal(WINDOW_REC *window, WI_ITEM_REC *item, int au
 	g_return_if_fail(item->window == NULL);
 
         item->window = window;
+	window_item_index_add(item);
 
 	if (window->items == NULL) {
 		window->active = item;
@@ -80,6 +153,7 @@ static void window_item_remove_signal(WI_ITEM_REC *item, int emit_signal)
 
         item->window = NULL;
 	window->items = g_slist_remove(window->items, item);
+	window_item_index_remove(item);
 
 	if (window->active == item) {
 		window_item_set_active(window, window->items == NULL ? NULL :
@@ -224,22 +298,44 @@ WI_ITEM_REC *window_item_find_window(WINDOW_REC *window,
 	return NULL;
 }
 
+/* Returns negative if item1 is found before item2 when going through the
+   windows and their items */
+static int window_item_order_cmp(WI_ITEM_REC *item1, WI_ITEM_REC *item2)
+{
+	WINDOW_REC *window1, *window2;
+
+	window1 = window_item_window(item1);
+	window2 = window_item_window(item2);
+	if (window1 != window2) {
+		return g_slist_index(windows, window1) -
+			g_slist_index(windows, window2);
+	}
+	return g_slist_index(window1->items, item1) -
+		g_slist_index(window1->items, item2);
+}
+
 /* Find wanted window item by name. `server' can be NULL. */
 WI_ITEM_REC *window_item_find(void *server, const char *name)
 {
-	WI_ITEM_REC *item;
+	WI_ITEM_REC *item, *found;
 	GSList *tmp;
 
 	g_return_val_if_fail(name != NULL, NULL);
 
-	for (tmp = windows; tmp != NULL; tmp = tmp->next) {
-		WINDOW_REC *rec = tmp->data;
+	found = NULL;
+	tmp = g_hash_table_lookup(items_by_name, name);
+	for (; tmp != NULL; tmp = tmp->next) {
+		item = tmp->data;
 
-		item = window_item_find_window(rec, server, name);
-		if (item != NULL) return item;
+		if (server != NULL && item->server != server)
+			continue;
+
+		/* the same name may be used in several windows */
+		if (found == NULL || window_item_order_cmp(item, found) < 0)
+			found = item;
 	}
 
-	return NULL;
+	return found;
 }
 
 static int window_bind_has_sticky(WINDOW_REC *window)
@@ -346,10 +442,26 @@ void window_items_init(void)
 	settings_add_bool("lookandfeel", "autocreate_split_windows", FALSE);
 	settings_add_bool("lookandfeel", "autofocus_new_items", TRUE);
 
+	items_by_name = g_hash_table_new_full((GHashFunc) i_istr_hash,
+					      (GEqualFunc) i_istr_equal,
+					      g_free, NULL);
+	item_names = g_hash_table_new_full(NULL, NULL, NULL,
+					   (GDestroyNotify) g_strfreev);
+
 	signal_add_last("window item changed", (SIGNAL_FUNC) signal_window_item_changed);
+	signal_add_first("window item name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_add_first("query nick changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_add_first("channel name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
 }
 
 void window_items_deinit(void)
 {
 	signal_remove("window item changed", (SIGNAL_FUNC) signal_window_item_changed);
+	signal_remove("window item name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_remove("query nick changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_remove("channel name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+
+	g_hash_table_foreach(items_by_name, (GHFunc) items_by_name_free, NULL);
+	g_hash_table_destroy(items_by_name);
+	g_hash_table_destroy(item_names);
 }
@@ -212,10 +212,10 @@ static void bans_ask_channel(const char *channel, IRC_SERVER_REC *server,
 
 static void bans_show_channel(IRC_CHANNEL_REC *channel, IRC_SERVER_REC *server)
 {
-	GSList *tmp;
+	GSList *list, *tmp;
         int counter;
 
-	if (channel->banlist == NULL) {
+	if (mode_list_count(channel->banlist) == 0) {
 		printformat(server, channel->visible_name,
 			    MSGLEVEL_CLIENTNOTICE,
 			    IRCTXT_NO_BANS, channel->visible_name);
@@ -224,7 +224,8 @@ static void bans_show_channel(IRC_CHANNEL_REC *channel, IRC_SERVER_REC *server)
 
 	/* show bans.. */
         counter = 1;
-	for (tmp = channel->banlist; tmp != NULL; tmp = tmp->next) {
+	list = mode_list_get_entries(channel->banlist);
+	for (tmp = list; tmp != NULL; tmp = tmp->next) {
 		char *timestr, *ago;
 		BAN_REC *rec = tmp->data;
 		timestr = my_asctime(rec->time);
@@ -236,6 +237,7 @@ static void bans_show_channel(IRC_CHANNEL_REC *channel, IRC_SERVER_REC *server)
 		            counter, channel->visible_name, rec->ban, rec->setby, ago, timestr);
 		counter++;
 	}
+	g_slist_free(list);
 }
 
 /* SYNTAX: BAN [<channel>] [<nicks>] */
@@ -29,9 +29,11 @@
 #include <irssi/src/core/levels.h>
 #include <irssi/src/irc/core/irc-chatnets.h>
 #include <irssi/src/irc/core/irc-servers.h>
+#include <irssi/src/irc/core/irc-commands.h>
 #include <irssi/src/irc/core/irc-channels.h>
 #include <irssi/src/core/servers-reconnect.h>
 #include <irssi/src/irc/core/irc-servers-setup.h>
+#include <irssi/src/irc/core/latency.h>
 
 #include <irssi/src/fe-common/core/fe-windows.h>
 #include <irssi/src/fe-common/core/printtext.h>
@@ -179,12 +181,79 @@ static void cmd_server_list(const char *data)
 	g_string_free(str, TRUE);
 }
 
+static char *latency_value(gint64 usecs)
+{
+	if (usecs < 1000)
+		return g_strdup_printf("%dus", (int) usecs);
+	if (usecs < G_USEC_PER_SEC)
+		return g_strdup_printf("%.1fms", usecs / 1000.0);
+	return g_strdup_printf("%.2fs", (double) usecs / G_USEC_PER_SEC);
+}
+
+static void latency_print(IRC_SERVER_REC *server, int type)
+{
+	LATENCY_HISTOGRAM_REC *hist;
+	char *count, *values[5];
+	int i;
+
+	hist = &server->latency->histograms[type];
+	if (hist->count == 0) {
+		printformat(server, NULL, MSGLEVEL_CLIENTCRAP,
+			    IRCTXT_LATENCY_EMPTY, latency_type_name(type));
+		return;
+	}
+
+	count = g_strdup_printf("%" G_GUINT64_FORMAT, hist->count);
+	values[0] = latency_value(hist->min);
+	values[1] = latency_value(latency_histogram_percentile(hist, 50));
+	values[2] = latency_value(latency_histogram_percentile(hist, 90));
+	values[3] = latency_value(latency_histogram_percentile(hist, 99));
+	values[4] = latency_value(hist->max);
+
+	printformat(server, NULL, MSGLEVEL_CLIENTCRAP, IRCTXT_LATENCY_LINE,
+		    latency_type_name(type), count, values[0], values[1],
+		    values[2], values[3], values[4]);
+
+	g_free(count);
+	for (i = 0; i < 5; i++)
+		g_free(values[i]);
+}
+
+/* SYNTAX: LATENCY [-clear] */
+static void cmd_latency(const char *data, IRC_SERVER_REC *server)
+{
+	GHashTable *optlist;
+	void *free_arg;
+	int type;
+
+	CMD_IRC_SERVER(server);
+
+	if (!cmd_get_params(data, &free_arg, PARAM_FLAG_OPTIONS,
+			    "latency", &optlist))
+		return;
+
+	if (g_hash_table_lookup(optlist, "clear") != NULL) {
+		irc_latency_clear(server);
+		printformat(server, NULL, MSGLEVEL_CLIENTNOTICE,
+			    IRCTXT_LATENCY_CLEARED, server->tag);
+	} else {
+		printformat(server, NULL, MSGLEVEL_CLIENTCRAP,
+			    IRCTXT_LATENCY_HEADER, server->tag);
+		for (type = 0; type < LATENCY_TYPES; type++)
+			latency_print(server, type);
+	}
+
+	cmd_params_free(free_arg);
+}
+
 void fe_irc_server_init(void)
 {
 	signal_add("server add fill", (SIGNAL_FUNC) sig_server_add_fill);
 	signal_add("server waiting cap ls", (SIGNAL_FUNC) sig_server_waiting_info);
 	command_bind("server list", NULL, (SIGNAL_FUNC) cmd_server_list);
+	command_bind_irc("latency", NULL, (SIGNAL_FUNC) cmd_latency);
 
+	command_set_options("latency", "clear");
 	command_set_options("server add",
 	                    "-ircnet -network -cmdspeed -cmdmax -querychans starttls "
 	                    "nostarttls disallow_starttls nodisallow_starttls cap nocap");
@@ -198,4 +267,5 @@ void fe_irc_server_deinit(void)
 	signal_remove("server add fill", (SIGNAL_FUNC) sig_server_add_fill);
 	signal_remove("server waiting cap ls", (SIGNAL_FUNC) sig_server_waiting_info);
 	command_unbind("server list", (SIGNAL_FUNC) cmd_server_list);
+	command_unbind("latency", (SIGNAL_FUNC) cmd_latency);
 }
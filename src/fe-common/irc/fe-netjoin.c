@@ -45,7 +45,8 @@ typedef struct {
 	IRC_SERVER_REC *server;
 	time_t last_netjoin;
 
-	GSList *netjoins;
+	GQueue *netjoins;
+	GHashTable *nicks; /* nick -> link in netjoins */
 } NETJOIN_SERVER_REC;
 
 typedef struct {
@@ -88,27 +89,32 @@ static NETJOIN_REC *netjoin_add(IRC_SERVER_REC *server, const char *nick,
 	while (channels != NULL) {
 		NETSPLIT_CHAN_REC *channel = channels->data;
 
-		rec->old_channels = g_slist_append(rec->old_channels,
-						   g_strdup(channel->name));
+		rec->old_channels = g_slist_prepend(rec->old_channels,
+						    g_strdup(channel->name));
 		channels = channels->next;
 	}
+	rec->old_channels = g_slist_reverse(rec->old_channels);
 
 	srec = netjoin_find_server(server);
 	if (srec == NULL) {
 		srec = g_new0(NETJOIN_SERVER_REC, 1);
 		srec->server = server;
+		srec->netjoins = g_queue_new();
+		srec->nicks = g_hash_table_new((GHashFunc) i_istr_hash,
+					       (GCompareFunc) i_istr_equal);
                 joinservers = g_slist_append(joinservers, srec);
 	}
 
 	srec->last_netjoin = time(NULL);
-	srec->netjoins = g_slist_append(srec->netjoins, rec);
+	g_queue_push_tail(srec->netjoins, rec);
+	g_hash_table_insert(srec->nicks, rec->nick, srec->netjoins->tail);
 	return rec;
 }
 
 static NETJOIN_REC *netjoin_find(IRC_SERVER_REC *server, const char *nick)
 {
 	NETJOIN_SERVER_REC *srec;
-	GSList *tmp;
+	GList *link;
 
 	g_return_val_if_fail(server != NULL, NULL);
 	g_return_val_if_fail(nick != NULL, NULL);
@@ -116,19 +122,16 @@ static NETJOIN_REC *netjoin_find(IRC_SERVER_REC *server, const char *nick)
 	srec = netjoin_find_server(server);
         if (srec == NULL) return NULL;
 
-	for (tmp = srec->netjoins; tmp != NULL; tmp = tmp->next) {
-		NETJOIN_REC *rec = tmp->data;
-
-		if (g_ascii_strcasecmp(rec->nick, nick) == 0)
-			return rec;
-	}
-
-	return NULL;
+	link = g_hash_table_lookup(srec->nicks, nick);
+	return link == NULL ? NULL : link->data;
 }
 
-static void netjoin_remove(NETJOIN_SERVER_REC *server, NETJOIN_REC *rec)
+static void netjoin_remove(NETJOIN_SERVER_REC *server, GList *link)
 {
-	server->netjoins = g_slist_remove(server->netjoins, rec);
+	NETJOIN_REC *rec = link->data;
+
+	g_hash_table_remove(server->nicks, rec->nick);
+	g_queue_delete_link(server->netjoins, link);
 
         g_slist_foreach(rec->old_channels, (GFunc) g_free, NULL);
 	g_slist_foreach(rec->now_channels, (GFunc) g_free, NULL);
@@ -143,8 +146,10 @@ static void netjoin_server_remove(NETJOIN_SERVER_REC *server)
 {
 	joinservers = g_slist_remove(joinservers, server);
 
-	while (server->netjoins != NULL)
-		netjoin_remove(server, server->netjoins->data);
+	while (server->netjoins->head != NULL)
+		netjoin_remove(server, server->netjoins->head);
+	g_queue_free(server->netjoins);
+	g_hash_table_destroy(server->nicks);
         g_free(server);
 }
 
@@ -168,7 +173,8 @@ static void print_netjoins(NETJOIN_SERVER_REC *server, const char *filter_channe
 {
 	TEMP_PRINT_REC *temp;
 	GHashTable *channels;
-	GSList *tmp, *tmp2, *next, *next2, *old;
+	GList *tmp, *next;
+	GSList *tmp2, *next2, *old;
 
 	g_return_if_fail(server != NULL);
 
@@ -177,10 +183,10 @@ static void print_netjoins(NETJOIN_SERVER_REC *server, const char *filter_channe
 	/* save nicks to string, clear now_channels and remove the same
 	   channels from old_channels list */
 	channels = g_hash_table_new((GHashFunc) i_istr_hash, (GCompareFunc) i_istr_equal);
-	for (tmp = server->netjoins; tmp != NULL; tmp = next) {
+	for (tmp = server->netjoins->head; tmp != NULL; tmp = next) {
 		NETJOIN_REC *rec = tmp->data;
 
-		next = g_slist_next(tmp);
+		next = tmp->next;
 
 		for (tmp2 = rec->now_channels; tmp2 != NULL; tmp2 = next2) {
 			char *channel = tmp2->data;
@@ -226,14 +232,14 @@ static void print_netjoins(NETJOIN_SERVER_REC *server, const char *filter_channe
 		}
 
 		if (rec->old_channels == NULL)
-                        netjoin_remove(server, rec);
+                        netjoin_remove(server, tmp);
 	}
 
 	g_hash_table_foreach(channels, (GHFunc) print_channel_netjoins,
 			     server);
 	g_hash_table_destroy(channels);
 
-	if (server->netjoins == NULL)
+	if (server->netjoins->head == NULL)
 		netjoin_server_remove(server);
 
 	printing_joins = FALSE;
@@ -252,7 +258,7 @@ static void sig_print_starting(TEXT_DEST_REC *dest)
 		return;
 
 	rec = netjoin_find_server(IRC_SERVER(dest->server));
-	if (rec != NULL && rec->netjoins != NULL) {
+	if (rec != NULL && rec->netjoins->head != NULL) {
 		/* if netjoins exists, the server rec should be
 		   still valid. otherwise, calling server->ischannel
 		   may not be safe. */
@@ -284,7 +290,7 @@ static int sig_check_netjoins(void)
 			continue;
 		}
 
-                if (server->netjoins != NULL)
+                if (server->netjoins->head != NULL)
 			print_netjoins(server, NULL);
 	}
 
@@ -22,6 +22,7 @@
 #include <irssi/src/fe-common/irc/module-formats.h>
 #include <irssi/src/core/signals.h>
 #include <irssi/src/core/levels.h>
+#include <irssi/src/core/misc.h>
 #include <irssi/src/core/settings.h>
 
 #include <irssi/src/irc/core/irc-servers.h>
@@ -62,6 +63,7 @@ typedef struct {
         IRC_SERVER_REC *server_rec;
 	GSList *servers; /* if many servers splitted from the same one */
 	GSList *channels;
+	GHashTable *channels_hash; /* name -> TEMP_SPLIT_CHAN_REC */
 } TEMP_SPLIT_REC;
 
 static GSList *get_source_servers(const char *server, GSList **servers)
@@ -83,29 +85,12 @@ static GSList *get_source_servers(const char *server, GSList **servers)
 	return list;
 }
 
-static TEMP_SPLIT_CHAN_REC *find_split_chan(TEMP_SPLIT_REC *rec,
-					    const char *name)
-{
-	GSList *tmp;
-
-	for (tmp = rec->channels; tmp != NULL; tmp = tmp->next) {
-		TEMP_SPLIT_CHAN_REC *chanrec = tmp->data;
-
-		if (g_ascii_strcasecmp(chanrec->name, name) == 0)
-			return chanrec;
-	}
-
-	return NULL;
-}
-
-static void get_server_splits(void *key, NETSPLIT_REC *split,
-			      TEMP_SPLIT_REC *rec)
+static void get_server_splits(NETSPLIT_REC *split, TEMP_SPLIT_REC *rec)
 {
 	TEMP_SPLIT_CHAN_REC *chanrec;
 	GSList *tmp;
 
-	if (split->printed ||
-	    g_slist_find(rec->servers, split->server) == NULL)
+	if (split->printed)
 		return;
 
 	split->printed = TRUE;
@@ -117,13 +102,14 @@ static void get_server_splits(void *key, NETSPLIT_REC *split,
 				 MSGLEVEL_QUITS))
 			continue;
 
-		chanrec = find_split_chan(rec, splitchan->name);
+		chanrec = g_hash_table_lookup(rec->channels_hash, splitchan->name);
 		if (chanrec == NULL) {
 			chanrec = g_new0(TEMP_SPLIT_CHAN_REC, 1);
 			chanrec->name = splitchan->name;
 			chanrec->nicks = g_string_new(NULL);
 
-			rec->channels = g_slist_append(rec->channels, chanrec);
+			rec->channels = g_slist_prepend(rec->channels, chanrec);
+			g_hash_table_insert(rec->channels_hash, chanrec->name, chanrec);
 		}
 
 		split->server->prints++;
@@ -202,7 +188,7 @@ static void temp_split_chan_free(TEMP_SPLIT_CHAN_REC *rec)
 static void print_splits(IRC_SERVER_REC *server, const char *filter_channel)
 {
 	TEMP_SPLIT_REC temp;
-	GSList *servers;
+	GSList *servers, *tmp;
 
 	printing_splits = TRUE;
 
@@ -215,13 +201,20 @@ static void print_splits(IRC_SERVER_REC *server, const char *filter_channel)
                 temp.servers = get_source_servers(sserver->server, &servers);
                 temp.server_rec = server;
 		temp.channels = NULL;
+		temp.channels_hash = g_hash_table_new((GHashFunc) i_istr_hash,
+						      (GCompareFunc) i_istr_equal);
+
+		for (tmp = temp.servers; tmp != NULL; tmp = tmp->next) {
+			NETSPLIT_SERVER_REC *rec = tmp->data;
 
-		g_hash_table_foreach(server->splits,
-				     (GHFunc) get_server_splits, &temp);
+			g_queue_foreach(rec->splits, (GFunc) get_server_splits, &temp);
+		}
+		temp.channels = g_slist_reverse(temp.channels);
 		print_server_splits(server, &temp, filter_channel);
 
 		g_slist_foreach(temp.channels,
 				(GFunc) temp_split_chan_free, NULL);
+		g_hash_table_destroy(temp.channels_hash);
 		g_slist_free(temp.servers);
 		g_slist_free(temp.channels);
 	}
@@ -310,8 +303,7 @@ static int split_equal(NETSPLIT_REC *n1, NETSPLIT_REC *n2)
 
 static void split_get(void *key, NETSPLIT_REC *rec, GSList **list)
 {
-	*list = g_slist_insert_sorted(*list, rec,
-				      (GCompareFunc) split_equal);
+	*list = g_slist_prepend(*list, rec);
 }
 
 static void split_print(NETSPLIT_REC *rec, SERVER_REC *server)
@@ -331,13 +323,30 @@ static void split_print(NETSPLIT_REC *rec, SERVER_REC *server)
 	g_free(chanstr);
 }
 
-/* SYNTAX: NETSPLIT */
+/* SYNTAX: NETSPLIT [-stats] */
 static void cmd_netsplit(const char *data, IRC_SERVER_REC *server)
 {
+	GHashTable *optlist;
 	GSList *list;
+	void *free_arg;
 
         CMD_IRC_SERVER(server);
 
+	if (!cmd_get_params(data, &free_arg, PARAM_FLAG_OPTIONS,
+			    "netsplit", &optlist))
+		return;
+
+	if (g_hash_table_lookup(optlist, "stats") != NULL) {
+		printformat(server, NULL, MSGLEVEL_CLIENTCRAP,
+			    IRCTXT_NETSPLITS_STATS,
+			    g_hash_table_size(server->splits),
+			    netsplit_stats.records, netsplit_stats.peak,
+			    netsplit_stats.expired, netsplit_stats.dropped);
+		cmd_params_free(free_arg);
+		return;
+	}
+	cmd_params_free(free_arg);
+
 	if (server->split_servers == NULL) {
 		printformat(server, NULL, MSGLEVEL_CLIENTNOTICE,
 			    IRCTXT_NO_NETSPLITS);
@@ -348,6 +357,7 @@ static void cmd_netsplit(const char *data, IRC_SERVER_REC *server)
 
         list = NULL;
 	g_hash_table_foreach(server->splits, (GHFunc) split_get, &list);
+	list = g_slist_sort(list, (GCompareFunc) split_equal);
 	g_slist_foreach(list, (GFunc) split_print, server);
         g_slist_free(list);
 
@@ -374,6 +384,7 @@ void fe_netsplit_init(void)
 	signal_add("netsplit new", (SIGNAL_FUNC) sig_netsplit_servers);
 	signal_add("setup changed", (SIGNAL_FUNC) read_settings);
 	command_bind_irc("netsplit", NULL, (SIGNAL_FUNC) cmd_netsplit);
+	command_set_options("netsplit", "stats");
 }
 
 void fe_netsplit_deinit(void)
@@ -36,6 +36,7 @@ FORMAT_REC fecommon_irc_formats[] = {
 	{ "netsplits_header", "%#Nick      Channel    Server               Split server", 0 },
 	{ "netsplits_line", "%#$[9]0 $[10]1 $[20]2 $3", 4, { 0, 0, 0, 0 } },
 	{ "netsplits_footer", "", 0 },
+	{ "netsplits_stats", "Netsplit nicks remembered: $0 on this server, $1 total (peak $2), $3 expired, $4 dropped", 5, { 1, 1, 1, 1, 1 } },
 	{ "network_added", "Network $0 saved", 1, { 0 } },
 	{ "network_removed", "Network $0 removed", 1, { 0 } },
 	{ "network_not_found", "Network $0 not found", 1, { 0 } },
@@ -55,6 +56,10 @@ FORMAT_REC fecommon_irc_formats[] = {
 	{ "cap_list", "Capabilities currently enabled: $0", 1, { 0 } },
 	{ "cap_new",  "Capabilities now available: $0", 1, { 0 } },
 	{ "cap_del",  "Capabilities removed: $0", 1, { 0 } },
+	{ "latency_header", "Latency on {server $0}:", 1, { 0 } },
+	{ "latency_line", "%#$[-8]0 $1 samples, min $2, median $3, 90th $4, 99th $5, max $6", 7, { 0, 0, 0, 0, 0, 0, 0 } },
+	{ "latency_empty", "%#$[-8]0 no samples", 1, { 0 } },
+	{ "latency_cleared", "Latency statistics of {server $0} cleared", 1, { 0 } },
 
 	/* ---- */
 	{ NULL, "Channels", 0 },
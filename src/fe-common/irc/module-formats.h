@@ -14,6 +14,7 @@ enum {
 	IRCTXT_NETSPLITS_HEADER,
 	IRCTXT_NETSPLITS_LINE,
 	IRCTXT_NETSPLITS_FOOTER,
+	IRCTXT_NETSPLITS_STATS,
 	IRCTXT_NETWORK_ADDED,
 	IRCTXT_NETWORK_REMOVED,
 	IRCTXT_NETWORK_NOT_FOUND,
@@ -33,6 +34,10 @@ enum {
 	IRCTXT_CAP_LIST,
 	IRCTXT_CAP_NEW,
 	IRCTXT_CAP_DEL,
+	IRCTXT_LATENCY_HEADER,
+	IRCTXT_LATENCY_LINE,
+	IRCTXT_LATENCY_EMPTY,
+	IRCTXT_LATENCY_CLEARED,
 
 	IRCTXT_FILL_2,
 
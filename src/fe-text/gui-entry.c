@@ -84,6 +84,7 @@ GUI_ENTRY_REC *gui_entry_create(int xpos, int ypos, int width, int utf8)
 	rec->text = g_new(unichar, rec->text_alloc);
 	rec->extents = NULL;
 	rec->text[0] = '\0';
+	rec->width_cache_pos = -1;
 	rec->utf8 = utf8;
 	return rec;
 }
@@ -101,6 +102,7 @@ static void destroy_extents(GUI_ENTRY_REC *entry)
 	g_free(entry->extents);
 	entry->extents = NULL;
 	entry->uses_extents = FALSE;
+	entry->width_cache_pos = -1;
 }
 
 void gui_entry_destroy(GUI_ENTRY_REC *entry)
@@ -201,64 +203,91 @@ static int scrlen_str(const char *str, int utf8)
 
 /* ----------------------------- */
 
+/* Return screen width of text[pos] and the extent after it */
+static int entry_char_width(GUI_ENTRY_REC *entry, int pos)
+{
+	unichar c = entry->text[pos];
+	const char *extent = entry->uses_extents ? entry->extents[pos+1] : NULL;
+	int width;
+
+	if (term_type == TERM_TYPE_BIG5)
+		width = big5_width(c);
+	else if (entry->utf8)
+		width = unichar_isprint(c) ? i_wcwidth(c) : 1;
+	else
+		width = 1;
+
+	if (extent != NULL) {
+		width += scrlen_str(extent, entry->utf8);
+	}
+	return width;
+}
+
 static int pos2scrpos(GUI_ENTRY_REC *entry, int pos, int cursor)
 {
-	int i;
-	int xpos = 0;
+	int i, target, xpos;
 
 	if (!cursor && pos <= 0)
 		return 0;
 
-	if (entry->uses_extents && entry->extents[0] != NULL) {
-		xpos += scrlen_str(entry->extents[0], entry->utf8);
+	target = CLAMP(pos, 0, entry->text_len);
+	if (entry->width_cache_pos >= 0 &&
+	    entry->width_cache_pos <= entry->text_len &&
+	    entry->width_cache_pos - target < target) {
+		/* the cached position is closer than the start */
+		i = entry->width_cache_pos;
+		xpos = entry->width_cache_xpos;
+	} else {
+		i = 0;
+		xpos = 0;
+		if (entry->uses_extents && entry->extents[0] != NULL) {
+			xpos += scrlen_str(entry->extents[0], entry->utf8);
+		}
 	}
 
-	for (i = 0; i < entry->text_len && i < pos; i++) {
-		unichar c = entry->text[i];
-		const char *extent = entry->uses_extents ? entry->extents[i+1] : NULL;
-
-		if (term_type == TERM_TYPE_BIG5)
-			xpos += big5_width(c);
-		else if (entry->utf8)
-			xpos += unichar_isprint(c) ? i_wcwidth(c) : 1;
-		else
-			xpos++;
+	for (; i < target; i++)
+		xpos += entry_char_width(entry, i);
+	for (; i > target; i--)
+		xpos -= entry_char_width(entry, i - 1);
 
-		if (extent != NULL) {
-			xpos += scrlen_str(extent, entry->utf8);
-		}
-	}
+	entry->width_cache_pos = i;
+	entry->width_cache_xpos = xpos;
 	return xpos + pos - i;
 }
 
 static int scrpos2pos(GUI_ENTRY_REC *entry, int pos)
 {
-	int i, width, xpos = 0;
-
-	if (entry->uses_extents && entry->extents[0] != NULL) {
-		xpos += scrlen_str(entry->extents[0], entry->utf8);
-	}
-
-	for (i = 0; i < entry->text_len && xpos < pos; i++) {
-		unichar c = entry->text[i];
-		const char *extent = entry->uses_extents ? entry->extents[i+1] : NULL;
-
-		if (term_type == TERM_TYPE_BIG5)
-			width = big5_width(c);
-		else if (entry->utf8)
-			width = unichar_isprint(c) ? i_wcwidth(c) : 1;
-		else
-			width = 1;
-
-		xpos += width;
-
-		if (extent != NULL) {
-			xpos += scrlen_str(extent, entry->utf8);
+	int i, xpos;
+
+	if (entry->width_cache_pos >= 0 &&
+	    entry->width_cache_pos <= entry->text_len &&
+	    entry->width_cache_xpos < pos) {
+		/* everything before the cached position is left of pos */
+		i = entry->width_cache_pos;
+		xpos = entry->width_cache_xpos;
+	} else {
+		i = 0;
+		xpos = 0;
+		if (entry->uses_extents && entry->extents[0] != NULL) {
+			xpos += scrlen_str(entry->extents[0], entry->utf8);
 		}
 	}
+
+	for (; i < entry->text_len && xpos < pos; i++)
+		xpos += entry_char_width(entry, i);
 	return i;
 }
 
+/* The text or extents after pos are going to change. The cached screen
+   position is moved back to pos while the old text is still there. */
+static void entry_width_cache_invalidate(GUI_ENTRY_REC *entry, int pos)
+{
+	if (pos < 0)
+		entry->width_cache_pos = -1;
+	else if (entry->width_cache_pos > pos)
+		pos2scrpos(entry, pos, TRUE);
+}
+
 /* Fixes the cursor position in screen */
 static void gui_entry_fix_cursor(GUI_ENTRY_REC *entry)
 {
@@ -345,10 +374,14 @@ static void gui_entry_draw_from(GUI_ENTRY_REC *entry, int pos)
 	if (entry->uses_extents && entry->extents[0] != NULL) {
 		g_string_append(str, entry->extents[0]);
 	}
-	for (i = 0; i < start && i < entry->text_len; i++) {
-		const char *extent = entry->uses_extents ? entry->extents[i+1] : NULL;
-		if (extent != NULL) {
-			g_string_append(str, extent);
+	if (!entry->uses_extents) {
+		/* nothing to collect from the text before start */
+		i = MIN(start, entry->text_len);
+	} else {
+		for (i = 0; i < start && i < entry->text_len; i++) {
+			if (entry->extents[i+1] != NULL) {
+				g_string_append(str, entry->extents[i+1]);
+			}
 		}
 	}
 	if (i == 0) {
@@ -528,6 +561,7 @@ void gui_entry_set_utf8(GUI_ENTRY_REC *entry, int utf8)
         g_return_if_fail(entry != NULL);
 
         entry->utf8 = utf8;
+	entry->width_cache_pos = -1;
 }
 
 void gui_entry_set_text(GUI_ENTRY_REC *entry, const char *str)
@@ -538,6 +572,7 @@ void gui_entry_set_text(GUI_ENTRY_REC *entry, const char *str)
 	entry->text_len = 0;
 	entry->pos = 0;
 	entry->text[0] = '\0';
+	entry->width_cache_pos = -1;
 	destroy_extents(entry);
 
 	gui_entry_insert_text(entry, str);
@@ -606,6 +641,7 @@ void gui_entry_insert_text(GUI_ENTRY_REC *entry, const char *str)
 	else
 		len = strlen(str);
         entry_text_grow(entry, len);
+	entry_width_cache_invalidate(entry, entry->pos);
 
         /* make space for the string */
 	memmove(entry->text + entry->pos + len, entry->text + entry->pos,
@@ -657,6 +693,7 @@ void gui_entry_insert_char(GUI_ENTRY_REC *entry, unichar chr)
 	gui_entry_redraw_from(entry, entry->pos);
 
 	entry_text_grow(entry, 1);
+	entry_width_cache_invalidate(entry, entry->pos);
 
 	/* make space for the string */
 	memmove(entry->text + entry->pos + 1, entry->text + entry->pos,
@@ -842,6 +879,7 @@ void gui_entry_erase(GUI_ENTRY_REC *entry, int size, CUTBUFFER_UPDATE_OP update_
 		while (entry->pos > size + w && i_wcwidth(entry->text[entry->pos - size - w]) == 0)
 			w++;
 
+	entry_width_cache_invalidate(entry, entry->pos - size);
 	memmove(entry->text + entry->pos - size, entry->text + entry->pos,
 	        (entry->text_len-entry->pos+1) * sizeof(unichar));
 
@@ -859,6 +897,8 @@ void gui_entry_erase(GUI_ENTRY_REC *entry, int size, CUTBUFFER_UPDATE_OP update_
 		if (entry->text_len == size && entry->extents[0] != NULL) {
 			g_free(entry->extents[0]);
 			entry->extents[0] = NULL;
+			/* the cached position includes its width */
+			entry->width_cache_pos = -1;
 		}
 	}
 
@@ -880,6 +920,7 @@ void gui_entry_erase_cell(GUI_ENTRY_REC *entry)
 		while (entry->pos+size < entry->text_len &&
 		       i_wcwidth(entry->text[entry->pos+size]) == 0) size++;
 
+	entry_width_cache_invalidate(entry, entry->pos);
 	memmove(entry->text + entry->pos, entry->text + entry->pos + size,
 	        (entry->text_len-entry->pos-size+1) * sizeof(unichar));
 
@@ -896,6 +937,8 @@ void gui_entry_erase_cell(GUI_ENTRY_REC *entry)
 		if (entry->text_len == size && entry->extents[0] != NULL) {
 			g_free(entry->extents[0]);
 			entry->extents[0] = NULL;
+			/* the cached position includes its width */
+			entry->width_cache_pos = -1;
 		}
 	}
 
@@ -969,6 +1012,8 @@ void gui_entry_transpose_chars(GUI_ENTRY_REC *entry)
 	if (entry->pos == entry->text_len)
                 entry->pos--;
 
+	entry_width_cache_invalidate(entry, entry->pos - 1);
+
         /* swap chars */
 	chr = entry->text[entry->pos];
 	entry->text[entry->pos] = entry->text[entry->pos-1];
@@ -1019,6 +1064,8 @@ void gui_entry_transpose_words(GUI_ENTRY_REC *entry)
 		char **first_extent, **sep_extent, **second_extent;
 		int i;
 
+		entry_width_cache_invalidate(entry, spos1);
+
 		first  = (unichar *) g_malloc( (epos1 - spos1) * sizeof(unichar) );
 		sep    = (unichar *) g_malloc( (spos2 - epos1) * sizeof(unichar) );
 		second = (unichar *) g_malloc( (epos2 - spos2) * sizeof(unichar) );
@@ -1080,6 +1127,9 @@ void gui_entry_transpose_words(GUI_ENTRY_REC *entry)
 void gui_entry_capitalize_word(GUI_ENTRY_REC *entry)
 {
 	int pos = entry->pos;
+
+	/* the case may have a different width */
+	entry_width_cache_invalidate(entry, pos);
 	while (pos < entry->text_len && !i_isalnum(entry->text[pos]))
 		pos++;
 
@@ -1102,6 +1152,9 @@ void gui_entry_capitalize_word(GUI_ENTRY_REC *entry)
 void gui_entry_downcase_word(GUI_ENTRY_REC *entry)
 {
 	int pos = entry->pos;
+
+	/* the case may have a different width */
+	entry_width_cache_invalidate(entry, pos);
 	while (pos < entry->text_len && !i_isalnum(entry->text[pos]))
 		pos++;
 
@@ -1119,6 +1172,9 @@ void gui_entry_downcase_word(GUI_ENTRY_REC *entry)
 void gui_entry_upcase_word(GUI_ENTRY_REC *entry)
 {
 	int pos = entry->pos;
+
+	/* the case may have a different width */
+	entry_width_cache_invalidate(entry, pos);
 	while (pos < entry->text_len && !i_isalnum(entry->text[pos]))
 		pos++;
 
@@ -1185,6 +1241,7 @@ void gui_entry_set_text_and_pos_bytes(GUI_ENTRY_REC *entry, const char *str, int
 				entry->extents[i] = NULL;
 			}
 		}
+		entry->width_cache_pos = -1;
 	}
 	gui_entry_redraw_from(entry, 0);
 	gui_entry_set_pos(entry, pos);
@@ -1300,6 +1357,7 @@ void gui_entry_set_extent(GUI_ENTRY_REC *entry, int pos, const char *text)
 	}
 
 	if (g_strcmp0(entry->extents[pos], text) != 0) {
+		entry_width_cache_invalidate(entry, pos - 1);
 		g_free(entry->extents[pos]);
 		if (*text == '\0') {
 			entry->extents[pos] = NULL;
@@ -1334,6 +1392,8 @@ void gui_entry_set_extents(GUI_ENTRY_REC *entry, int pos, int len, const char *l
 		gui_entry_alloc_extents(entry);
 	}
 
+	entry_width_cache_invalidate(entry, pos - 1);
+
 	if (g_strcmp0(entry->extents[pos], left) != 0) {
 		g_free(entry->extents[pos]);
 		if (*left == '\0') {
@@ -1379,6 +1439,8 @@ void gui_entry_clear_extents(GUI_ENTRY_REC *entry, int pos, int len)
 		return;
 	}
 
+	entry_width_cache_invalidate(entry, pos - 1);
+
 	for (i = pos; i <= end; i++) {
 		if (entry->extents[i] != NULL) {
 			g_free(entry->extents[i]);
@@ -22,6 +22,9 @@ typedef struct {
 	char *prompt;
 
 	int redraw_needed_from;
+	/* screen position of text[width_cache_pos], the screen positions
+	   around it are found from it. -1 if not known. */
+	int width_cache_pos, width_cache_xpos;
 	unsigned int utf8:1;
 
 	unsigned int previous_append_next_kill:1;
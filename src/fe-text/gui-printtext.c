@@ -60,6 +60,12 @@ static int scrollback_lines, scrollback_time, scrollback_burst_remove;
  */
 static int scrollback_max_age;
 
+/* If positive, text of the older lines is moved to disk when a window's or
+   all windows' lines use more memory than this. Some more than needed is
+   moved at once, so it isn't done for every line. */
+static gsize scrollback_memory, scrollback_total_memory;
+#define SPILL_TARGET(size) ((size) - (size) / 8)
+
 static int next_xpos, next_ypos;
 
 static GHashTable *indent_functions;
@@ -239,6 +245,42 @@ static void remove_old_lines(TEXT_BUFFER_VIEW_REC *view)
 	}
 }
 
+static void spill_old_lines(TEXT_BUFFER_VIEW_REC *view)
+{
+	TEXT_BUFFER_REC *buffer, *largest;
+	GSList *tmp;
+	gsize total, target;
+
+	if (scrollback_memory > 0 &&
+	    view->buffer->resident_size > scrollback_memory)
+		textbuffer_spill(view->buffer, SPILL_TARGET(scrollback_memory));
+
+	if (scrollback_total_memory == 0 ||
+	    textbuffer_resident_total() <= scrollback_total_memory)
+		return;
+
+	/* move lines from the windows using the most memory first */
+	target = SPILL_TARGET(scrollback_total_memory);
+	while ((total = textbuffer_resident_total()) > target) {
+		largest = NULL;
+		for (tmp = windows; tmp != NULL; tmp = tmp->next) {
+			buffer = WINDOW_GUI((WINDOW_REC *) tmp->data)->view->buffer;
+			if (largest == NULL ||
+			    buffer->resident_size > largest->resident_size)
+				largest = buffer;
+		}
+		if (largest == NULL)
+			break;
+
+		textbuffer_spill(largest, largest->resident_size -
+				 MIN(largest->resident_size, total - target));
+		if (textbuffer_resident_total() == total) {
+			/* nothing more can be moved */
+			break;
+		}
+	}
+}
+
 void gui_printtext_get_colors(int *flags, int *fg, int *bg, int *attr)
 {
 	*attr = 0;
@@ -388,6 +430,7 @@ static void sig_gui_printtext_finished(WINDOW_REC *window, TEXT_DEST_REC *dest)
 	if (insert_after != NULL)
 		view_add_eol(view, &insert_after);
 	remove_old_lines(view);
+	spill_old_lines(view);
 }
 
 static void read_settings(void)
@@ -396,6 +439,8 @@ static void read_settings(void)
 	scrollback_time = settings_get_time("scrollback_time")/1000;
 	scrollback_max_age = settings_get_time("scrollback_max_age")/1000;
         scrollback_burst_remove = settings_get_int("scrollback_burst_remove");
+	scrollback_memory = settings_get_size("scrollback_memory");
+	scrollback_total_memory = settings_get_size("scrollback_total_memory");
 }
 
 void gui_printtext_init(void)
@@ -409,6 +454,8 @@ void gui_printtext_init(void)
 	settings_add_time("history", "scrollback_time", "1day");
 	settings_add_time("history", "scrollback_max_age", "0");
 	settings_add_int("history", "scrollback_burst_remove", 10);
+	settings_add_size("history", "scrollback_memory", "0");
+	settings_add_size("history", "scrollback_total_memory", "0");
 
 	signal_add("gui print text", (SIGNAL_FUNC) sig_gui_print_text);
 	signal_add("gui print text finished", (SIGNAL_FUNC) sig_gui_printtext_finished);
@@ -74,6 +74,16 @@ static int paste_timeout_id;
 static int paste_use_bracketed_mode;
 static int paste_bracketed_mode;
 static int paste_was_bracketed_mode;
+static unsigned int paste_bracketed_scanned;
+
+/* pasted lines waiting to be sent, each one ending with \n */
+static GString *paste_send_text;
+static gsize paste_send_pos;
+static WINDOW_REC *paste_send_window;
+/* the server and window item that were active when the lines were pasted */
+static SERVER_REC *paste_send_server;
+static WI_ITEM_REC *paste_send_item;
+static int paste_send_tag;
 static int previous_yank_preceded;
 
 /* Terminal sequences that surround the input when the terminal has the
@@ -84,6 +94,13 @@ static const unichar bp_end[]   = { 0x1b, '[', '2', '0', '1', '~' };
 
 #define BRACKETED_PASTE_TIMEOUT (5 * 1000) // ms
 
+/* number of pasted lines sent at a time, before letting the main loop
+   handle the input and screen again */
+#define PASTE_SEND_BATCH_LINES 50
+
+/* paste buffers larger than this are freed instead of reused */
+#define PASTE_BUFFER_KEEP_LEN (64 * 1024)
+
 #if GLIB_CHECK_VERSION(2, 62, 0)
 /* nothing */
 #else
@@ -284,19 +301,126 @@ static void paste_buffer_join_lines(GArray *buf)
 	g_array_set_size(buf, dest - arr);
 }
 
-static void paste_send_line(char *text)
+static void paste_send_line(WINDOW_REC *window, SERVER_REC *server,
+			    WI_ITEM_REC *item, char *text)
 {
 	/* we need to get the current history every time because it might change between calls */
-	command_history_add(command_history_current(active_win), text);
+	command_history_add(command_history_current(window), text);
 
-	signal_emit("send command", 3, text, active_win->active_server, active_win->active);
+	signal_emit("send command", 3, text, server, item);
+}
+
+/* Convert the unichars in buf starting from pos to text the way they're
+   sent to the server, with \n as the line separator */
+static GString *paste_buffer_get_text(GArray *buf, unsigned int pos)
+{
+	GString *str;
+	unichar *arr;
+
+	str = g_string_sized_new(buf->len - pos + 1);
+	arr = (unichar *) buf->data;
+	for (; pos < buf->len; pos++) {
+		if (isnewline(arr[pos])) {
+			g_string_append_c(str, '\n');
+		} else if (arr[pos] == 0) {
+			/* would end the line */
+		} else if (active_entry->utf8) {
+			g_string_append_unichar(str, arr[pos]);
+		} else if (term_type == TERM_TYPE_BIG5) {
+			if (arr[pos] > 0xff)
+				g_string_append_c(str, (arr[pos] >> 8) & 0xff);
+			g_string_append_c(str, arr[pos] & 0xff);
+		} else {
+			g_string_append_c(str, arr[pos]);
+		}
+	}
+	return str;
+}
+
+/* Send at most max_lines of the pending pasted lines, or all of them if
+   max_lines is -1 */
+static void paste_send_pending(int max_lines)
+{
+	static int sending = FALSE;
+	GString *text;
+	char *line, *end;
+
+	if (paste_send_text == NULL || sending)
+		return;
+
+	sending = TRUE;
+	text = paste_send_text;
+	while (paste_send_pos < text->len && paste_send_window != NULL &&
+	       max_lines != 0) {
+		line = text->str + paste_send_pos;
+		end = strchr(line, '\n');
+		*end = '\0';
+		paste_send_pos += end - line + 1;
+
+		paste_send_line(paste_send_window, paste_send_server,
+				paste_send_item, line);
+		if (max_lines > 0)
+			max_lines--;
+	}
+
+	/* the lines are dropped if their target went away */
+	if (paste_send_pos == text->len || paste_send_window == NULL) {
+		if (paste_send_tag != -1) {
+			g_source_remove(paste_send_tag);
+			paste_send_tag = -1;
+		}
+		g_string_free(text, TRUE);
+		paste_send_text = NULL;
+		paste_send_pos = 0;
+		paste_send_window = NULL;
+		paste_send_server = NULL;
+		paste_send_item = NULL;
+	}
+	sending = FALSE;
+}
+
+static gboolean paste_send_idle(gpointer data)
+{
+	paste_send_pending(PASTE_SEND_BATCH_LINES);
+	return paste_send_text != NULL;
+}
+
+/* Send the lines to the active window item. The first lines are sent
+   immediately, the rest between handling the other events. */
+static void paste_send_queue(GString *lines)
+{
+	if (paste_send_text != NULL &&
+	    (paste_send_window != active_win ||
+	     paste_send_server != active_win->active_server ||
+	     paste_send_item != active_win->active)) {
+		/* lines pasted to another target go first */
+		paste_send_pending(-1);
+	}
+
+	if (paste_send_text == NULL) {
+		paste_send_text = lines;
+		paste_send_pos = 0;
+		paste_send_window = active_win;
+		paste_send_server = active_win->active_server;
+		paste_send_item = active_win->active;
+	} else {
+		g_string_append_len(paste_send_text, lines->str, lines->len);
+		g_string_free(lines, TRUE);
+	}
+
+	paste_send_pending(PASTE_SEND_BATCH_LINES);
+	if (paste_send_text != NULL && paste_send_tag == -1) {
+		paste_send_tag = g_idle_add_full(G_PRIORITY_LOW, paste_send_idle,
+						 NULL, NULL);
+	}
 }
 
 static void paste_send(void)
 {
 	unichar *arr;
 	GString *str;
-	char out[10], *text;
+	char *text, *end;
+	gsize rest_pos;
 	unsigned int i;
 
 	if (paste_join_multiline)
@@ -318,37 +442,30 @@ static void paste_send(void)
 		}
 
 		text = gui_entry_get_text(active_entry);
-		paste_send_line(text);
+		paste_send_pending(-1);
+		paste_send_line(active_win, active_win->active_server,
+				active_win->active, text);
 		g_free(text);
 	}
 
 	/* rest of the lines */
-	str = g_string_new(NULL);
-	for (; i < paste_buffer->len; i++) {
-		if (isnewline(arr[i])) {
-			paste_send_line(str->str);
-			g_string_truncate(str, 0);
-		} else if (active_entry->utf8) {
-			out[g_unichar_to_utf8(arr[i], out)] = '\0';
-			g_string_append(str, out);
-		} else if (term_type == TERM_TYPE_BIG5) {
-			if (arr[i] > 0xff)
-				g_string_append_c(str, (arr[i] >> 8) & 0xff);
-			g_string_append_c(str, arr[i] & 0xff);
-		} else {
-			g_string_append_c(str, arr[i]);
-		}
-	}
+	str = paste_buffer_get_text(paste_buffer, i);
+	end = strrchr(str->str, '\n');
+	rest_pos = end == NULL ? 0 : end + 1 - str->str;
 
 	if (paste_was_bracketed_mode) {
 		/* the text before the bracket end should be sent along with the rest */
-		paste_send_line(str->str);
+		g_string_append_c(str, '\n');
 		gui_entry_set_text(active_entry, "");
 	} else {
-		gui_entry_set_text(active_entry, str->str);
+		gui_entry_set_text(active_entry, str->str + rest_pos);
+		g_string_truncate(str, rest_pos);
 	}
 
-	g_string_free(str, TRUE);
+	if (str->len > 0)
+		paste_send_queue(str);
+	else
+		g_string_free(str, TRUE);
 }
 
 static void paste_flush(void (*send)(void))
@@ -361,7 +478,14 @@ static void paste_flush(void (*send)(void))
 
 	if (send != NULL)
 		send();
-	g_array_set_size(paste_buffer, 0);
+	if (paste_buffer->len > PASTE_BUFFER_KEEP_LEN) {
+		/* don't keep the memory of a large paste around */
+		g_array_free(paste_buffer, TRUE);
+		paste_buffer = g_array_new(FALSE, FALSE, sizeof(unichar));
+	} else {
+		g_array_set_size(paste_buffer, 0);
+	}
+	paste_bracketed_scanned = 0;
 
 	/* re-add anything that may have been after the bracketed paste end */
 	if (paste_buffer_rest->len > 0) {
@@ -387,10 +511,8 @@ static void paste_print_line(const char *str)
 static void paste_print(void)
 {
 	GArray *garr;
-	unichar *arr;
 	GString *str;
-	char out[10];
-	unsigned int i;
+	char *line, *end;
 	gboolean free_garr;
 
 	if (paste_join_multiline) {
@@ -402,40 +524,25 @@ static void paste_print(void)
 		free_garr = FALSE;
 	}
 
-	arr = &g_array_index(garr, unichar, 0);
+	str = paste_buffer_get_text(garr, 0);
+	if (free_garr)
+		g_array_free(garr, TRUE);
 
-	str = g_string_new(NULL);
-	for (i = 0; i < garr->len; i++) {
-		if (isnewline(arr[i])) {
-			paste_print_line(str->str);
-			g_string_truncate(str, 0);
-		} else if (active_entry->utf8) {
-			out[g_unichar_to_utf8(arr[i], out)] = '\0';
-			g_string_append(str, out);
-		} else if (term_type == TERM_TYPE_BIG5) {
-			if (arr[i] > 0xff)
-				g_string_append_c(str, (arr[i] >> 8) & 0xff);
-			g_string_append_c(str, arr[i] & 0xff);
-		} else {
-			g_string_append_c(str, arr[i]);
-		}
+	for (line = str->str; (end = strchr(line, '\n')) != NULL; line = end + 1) {
+		*end = '\0';
+		paste_print_line(line);
 	}
 
-	if (str->len)
-		paste_print_line(str->str);
+	if (*line != '\0')
+		paste_print_line(line);
 
 	g_string_free(str, TRUE);
-	if (free_garr)
-		g_array_free(garr, TRUE);
 }
 
 static void paste_event(const char *arg)
 {
 	GArray *garr;
-	unichar *arr;
 	GString *str;
-	char out[10];
-	unsigned int i;
 	gboolean free_garr;
 
 	if (paste_join_multiline) {
@@ -447,30 +554,15 @@ static void paste_event(const char *arg)
 		free_garr = FALSE;
 	}
 
-	arr = &g_array_index(garr, unichar, 0);
-	str = g_string_new(NULL);
-	for (i = 0; i < garr->len; i++) {
-		if (isnewline(arr[i])) {
-			g_string_append_c(str, '\n');
-		} else if (active_entry->utf8) {
-			out[g_unichar_to_utf8(arr[i], out)] = '\0';
-			g_string_append(str, out);
-		} else if (term_type == TERM_TYPE_BIG5) {
-			if (arr[i] > 0xff)
-				g_string_append_c(str, (arr[i] >> 8) & 0xff);
-			g_string_append_c(str, arr[i] & 0xff);
-		} else {
-			g_string_append_c(str, arr[i]);
-		}
-	}
+	str = paste_buffer_get_text(garr, 0);
+	if (free_garr)
+		g_array_free(garr, TRUE);
 
 	if (signal_emit("paste event", 2, str->str, arg)) {
 		paste_flush(NULL);
 	}
 
 	g_string_free(str, TRUE);
-	if (free_garr)
-		g_array_free(garr, TRUE);
 }
 
 static void paste_insert_edit(void)
@@ -619,6 +711,10 @@ static void key_send_line(void)
 	char *str;
 	int add_history;
 
+	/* pasted lines are sent before the line typed after them */
+	if (redir == NULL)
+		paste_send_pending(-1);
+
 	str = gui_entry_get_text(active_entry);
 
 	/* we can't use gui_entry_get_text() later, since the entry might
@@ -895,6 +991,7 @@ static gboolean paste_timeout(gpointer data)
 			signal_emit("gui key pressed", 1, GINT_TO_POINTER(key));
 		}
 		g_array_set_size(paste_buffer, 0);
+		paste_bracketed_scanned = 0;
 	} else if (paste_verify_line_count > 0 &&
 				(paste_line_count >= paste_verify_line_count ||
 				split_lines > paste_verify_line_count) &&
@@ -938,18 +1035,19 @@ static void paste_bracketed_end(int i, gboolean rest)
 	paste_bracketed_mode = FALSE;
 }
 
-static void paste_bracketed_middle(void)
+/* Returns the position of the bracketed paste end marker in buf, or -1 if
+   it's not there yet. An end marker followed by a start marker is removed
+   from the buffer. The positions before *scanned have already been
+   searched, so only the new input needs to be looked at. */
+static int paste_bracketed_find_end(GArray *buf, unsigned int *scanned)
 {
-	int i;
 	int marklen = G_N_ELEMENTS(bp_end);
-	int len = paste_buffer->len - marklen;
-	unichar *ptr = (unichar *) paste_buffer->data;
-
-	if (len < 0) {
-		return;
-	}
+	int len = (int) buf->len - marklen;
+	int i = MIN(*scanned, buf->len);
+	unichar *ptr;
 
-	for (i = 0; i <= len; i++, ptr++) {
+	while (i <= len) {
+		ptr = (unichar *) buf->data + i;
 		if (ptr[0] == bp_end[0] && memcmp(ptr, bp_end, sizeof(bp_end)) == 0) {
 
 			/* if there are at least 6 bytes after the end,
@@ -957,23 +1055,37 @@ static void paste_bracketed_middle(void)
 			if (i <= (len - marklen) &&
 			    memcmp(ptr + marklen, bp_start, sizeof(bp_start)) == 0) {
 
-				/* remove both markers*/
-				g_array_remove_range(paste_buffer, i, marklen * 2);
+				/* remove both markers and check the same
+				   position again */
+				g_array_remove_range(buf, i, marklen * 2);
 				len -= marklen * 2;
-
-				/* go one step back */
-				i--;
-				ptr--;
 				continue;
 			}
-			paste_bracketed_end(i, i != len);
-			break;
+			*scanned = i;
+			return i;
 		}
+		i++;
+	}
+
+	*scanned = MAX(len + 1, 0);
+	return -1;
+}
+
+static void paste_bracketed_middle(void)
+{
+	int i;
+
+	i = paste_bracketed_find_end(paste_buffer, &paste_bracketed_scanned);
+	if (i >= 0) {
+		paste_bracketed_end(i, i + G_N_ELEMENTS(bp_end) != paste_buffer->len);
 	}
 }
 
 static void sig_input(void)
 {
+	/* show what the user typed without waiting for the next frame */
+	term_render_now();
+
 	if (!active_entry) {
                 /* no active entry yet - wait until we have it */
 		return;
@@ -1029,6 +1141,7 @@ static void key_paste_start(void)
 {
 	if (paste_use_bracketed_mode) {
 		paste_bracketed_mode = TRUE;
+		paste_bracketed_scanned = 0;
 		if (paste_timeout_id != -1)
 			g_source_remove(paste_timeout_id);
 		paste_timeout_id = g_timeout_add(BRACKETED_PASTE_TIMEOUT, paste_timeout, NULL);
@@ -1323,6 +1436,25 @@ static void sig_gui_entry_redirect(SIGNAL_FUNC func, const char *entry,
 	gui_entry_set_prompt(active_entry, entry);
 }
 
+static void sig_window_destroyed(WINDOW_REC *window)
+{
+	/* the lines still waiting to be pasted to it are dropped */
+	if (window == paste_send_window)
+		paste_send_window = NULL;
+}
+
+static void sig_window_item_remove(WINDOW_REC *window, WI_ITEM_REC *item)
+{
+	if (item == paste_send_item)
+		paste_send_window = NULL;
+}
+
+static void sig_server_disconnected(SERVER_REC *server)
+{
+	if (server == paste_send_server)
+		paste_send_window = NULL;
+}
+
 static void setup_changed(void)
 {
 	paste_detect_time = settings_get_time("paste_detect_time");
@@ -1354,6 +1486,11 @@ void gui_readline_init(void)
         paste_old_prompt = NULL;
 	paste_timeout_id = -1;
 	paste_bracketed_mode = FALSE;
+	paste_send_text = NULL;
+	paste_send_window = NULL;
+	paste_send_server = NULL;
+	paste_send_item = NULL;
+	paste_send_tag = -1;
 	last_keypress = g_get_real_time();
 	input_listen_init(STDIN_FILENO);
 
@@ -1537,6 +1674,9 @@ void gui_readline_init(void)
 	signal_add("window changed automatic", (SIGNAL_FUNC) sig_window_auto_changed);
 	signal_add("gui entry redirect", (SIGNAL_FUNC) sig_gui_entry_redirect);
 	signal_add("gui key pressed", (SIGNAL_FUNC) sig_gui_key_pressed);
+	signal_add("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_add("window item remove", (SIGNAL_FUNC) sig_window_item_remove);
+	signal_add("server disconnected", (SIGNAL_FUNC) sig_server_disconnected);
 	signal_add("setup changed", (SIGNAL_FUNC) setup_changed);
 }
 
@@ -1616,11 +1756,18 @@ void gui_readline_deinit(void)
 	keyboard_destroy(keyboard);
         g_array_free(paste_buffer, TRUE);
         g_array_free(paste_buffer_rest, TRUE);
+	if (paste_send_tag != -1)
+		g_source_remove(paste_send_tag);
+	if (paste_send_text != NULL)
+		g_string_free(paste_send_text, TRUE);
 
         key_configure_thaw();
 
 	signal_remove("window changed automatic", (SIGNAL_FUNC) sig_window_auto_changed);
 	signal_remove("gui entry redirect", (SIGNAL_FUNC) sig_gui_entry_redirect);
 	signal_remove("gui key pressed", (SIGNAL_FUNC) sig_gui_key_pressed);
+	signal_remove("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_remove("window item remove", (SIGNAL_FUNC) sig_window_item_remove);
+	signal_remove("server disconnected", (SIGNAL_FUNC) sig_server_disconnected);
 	signal_remove("setup changed", (SIGNAL_FUNC) setup_changed);
 }
@@ -283,7 +283,7 @@ int main(int argc, char **argv)
 		{ "version", 'v', 0, G_OPTION_ARG_NONE, &version, "Display Irssi version", NULL },
 		{ NULL }
 	};
-	int loglev;
+	int loglev, pending;
 
 	core_register_options();
 	fe_common_core_register_options();
@@ -329,7 +329,10 @@ int main(int argc, char **argv)
 	main_loop = g_main_loop_new(NULL, TRUE);
 
 	/* Does the same as g_main_run(main_loop), except we
-	   can call our dirty-checker after each iteration */
+	   can call our dirty-checker after each iteration. The screen is
+	   drawn at most term_max_fps times per second, changes between
+	   the frames are drawn together. */
+	term_refresh_freeze();
 	while (!quitting) {
 		if (sigterm_received) {
 			sigterm_received = FALSE;
@@ -347,12 +350,17 @@ int main(int argc, char **argv)
 			}
 		}
 
-		dirty_check();
+		pending = dirty || term_refresh_pending();
+		if (term_render_due(pending)) {
+			dirty_check();
+			term_refresh_thaw();
+			term_render_done(pending);
+			term_refresh_freeze();
+		}
 
-		term_refresh_freeze();
 		g_main_context_iteration(NULL, TRUE);
-		term_refresh_thaw();
 	}
+	term_refresh_thaw();
 
 	g_main_loop_unref(main_loop);
 	textui_deinit();
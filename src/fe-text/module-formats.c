@@ -51,6 +51,7 @@ FORMAT_REC gui_text_formats[] = {
 	{ "window_scroll", "Window scroll mode is now $0", 1, { 0 } },
 	{ "window_scroll_unknown", "Unknown scroll mode $0, must be ON, OFF or DEFAULT", 1, { 0 } },
 	{ "window_hidelevel", "Window hidden level is now $0", 1, { 0 } },
+	{ "render_stats", "Screen: $0 frames drawn, $1 frames merged into later ones, $2 scrolls coalesced", 3, { 1, 1, 1 } },
 
 	/* ---- */
 	{ NULL, "Statusbars", 0 },
@@ -27,6 +27,7 @@ enum {
 	TXT_WINDOW_SCROLL,
 	TXT_WINDOW_SCROLL_UNKNOWN,
 	TXT_WINDOW_HIDELEVEL,
+	TXT_RENDER_STATS,
 
 	TXT_FILL_3,
 
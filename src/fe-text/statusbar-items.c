@@ -31,7 +31,31 @@
 /* how often to redraw lagging time (seconds) */
 #define LAG_REFRESH_TIME 10
 
-static GList *activity_list;
+typedef struct {
+	WINDOW_REC *window;
+	GSequenceIter *iter;
+
+	/* sort keys, updated only together with the position */
+	int data_level;
+	int refnum;
+	guint64 recent;
+
+	/* the entry's format and its expansion with theme */
+	char *format;
+	THEME_REC *theme;
+	char *text;
+} ACTIVITY_REC;
+
+typedef struct {
+	THEME_REC *theme;
+	char *separator; /* expanded separator */
+	char *text; /* NULL when no windows have activity */
+} ACTIVITY_CACHE_REC;
+
+static GSequence *activity_list; /* ACTIVITY_REC, in actlist_sort order */
+static GHashTable *activity_windows; /* WINDOW_REC : ACTIVITY_REC */
+static GHashTable *activity_cache; /* MAIN_WINDOW_REC : ACTIVITY_CACHE_REC */
+static guint64 activity_counter;
 static guint8 actlist_sort;
 static char *actlist_separator;
 static GSList *more_visible; /* list of MAIN_WINDOW_RECs which have --more-- */
@@ -70,77 +94,157 @@ static void item_window_empty(SBAR_ITEM_REC *item, int get_size_only)
 	}
 }
 
+static void activity_rec_destroy(ACTIVITY_REC *rec)
+{
+	g_free(rec->format);
+	g_free(rec->text);
+	g_free(rec);
+}
+
+static void activity_cache_destroy(ACTIVITY_CACHE_REC *cache)
+{
+	g_free(cache->separator);
+	g_free(cache->text);
+	g_free(cache);
+}
+
+static int activity_cmp(ACTIVITY_REC *a1, ACTIVITY_REC *a2)
+{
+	switch (actlist_sort) {
+	case 1:
+		/* recent */
+		return a1->recent > a2->recent ? -1 : a1->recent < a2->recent;
+	case 2:
+		/* level */
+		if (a1->data_level != a2->data_level)
+			return a1->data_level > a2->data_level ? -1 : 1;
+		return a1->refnum < a2->refnum ? -1 : a1->refnum > a2->refnum;
+	case 3:
+		/* level,recent */
+		if (a1->data_level != a2->data_level)
+			return a1->data_level > a2->data_level ? -1 : 1;
+		return a1->recent > a2->recent ? -1 : a1->recent < a2->recent;
+	default:
+		/* refnum */
+		return a1->refnum < a2->refnum ? -1 : a1->refnum > a2->refnum;
+	}
+}
+
+/* The rendered lists need to be rebuilt, the entries' texts are kept */
+static void activity_cache_invalidate(void)
+{
+	g_hash_table_remove_all(activity_cache);
+}
+
+static void activity_entry_update_format(ACTIVITY_REC *rec, GString *format,
+					 int add_name, int pref_name)
+{
+	WINDOW_REC *window = rec->window;
+	char *name;
+
+	switch (window->data_level) {
+	case DATA_LEVEL_NONE:
+	case DATA_LEVEL_TEXT:
+		name = "{sb_act_text %d";
+		break;
+	case DATA_LEVEL_MSG:
+		name = "{sb_act_msg %d";
+		break;
+	default:
+		if (window->hilight_color == NULL)
+			name = "{sb_act_hilight %d";
+		else
+			name = NULL;
+		break;
+	}
+
+	if (name != NULL)
+		g_string_printf(format, name, window->refnum);
+	else
+		g_string_printf(format, "{sb_act_hilight_color %s %d",
+				window->hilight_color, window->refnum);
+
+	if (add_name && window->active != NULL)
+		g_string_append_printf(format, ":%s",
+			pref_name == 1 && window->name != NULL ?
+			window->name : window->active->visible_name);
+	g_string_append_c(format, '}');
+
+	if (g_strcmp0(rec->format, format->str) != 0) {
+		g_free(rec->format);
+		rec->format = g_strdup(format->str);
+		g_free_and_null(rec->text);
+	}
+}
+
 static char *get_activity_list(MAIN_WINDOW_REC *window, int normal, int hilight)
 {
-        THEME_REC *theme;
+	ACTIVITY_CACHE_REC *cache;
+	ACTIVITY_REC *rec;
+	THEME_REC *theme;
 	GString *str;
 	GString *format;
-	GList *tmp;
-        char *ret, *name, *value;
-        int is_det;
+	GSequenceIter *iter;
+	char *value;
+	int is_det;
 	int add_name = settings_get_bool("actlist_names");
 	int pref_name = settings_get_bool("actlist_prefer_window_name");
 
-	str = g_string_new(NULL);
-	format = g_string_new(NULL);
-
 	theme = window != NULL && window->active != NULL &&
 		window->active->theme != NULL ?
 		window->active->theme : current_theme;
 
-	for (tmp = activity_list; tmp != NULL; tmp = tmp->next) {
-		WINDOW_REC *window = tmp->data;
+	/* the cache is cleared whenever the activity changes */
+	cache = g_hash_table_lookup(activity_cache, window);
+	if (cache != NULL && cache->theme == theme && normal && hilight)
+		return g_strdup(cache->text);
 
-		is_det = window->data_level >= DATA_LEVEL_HILIGHT;
-		if ((!is_det && !normal) || (is_det && !hilight))
-                        continue;
-
-                /* comma separator */
-		if (str->len > 0) {
-			g_string_printf(format, "{sb_act_sep %s}", actlist_separator);
-			value = theme_format_expand(theme, format->str);
-			g_string_append(str, value);
-			g_free(value);
+	if (cache == NULL || cache->theme != theme) {
+		if (cache == NULL) {
+			cache = g_new0(ACTIVITY_CACHE_REC, 1);
+			g_hash_table_insert(activity_cache, window, cache);
 		}
+		cache->theme = theme;
+		g_free(cache->separator);
+		value = g_strdup_printf("{sb_act_sep %s}", actlist_separator);
+		cache->separator = theme_format_expand(theme, value);
+		g_free(value);
+	}
 
-		switch (window->data_level) {
-		case DATA_LEVEL_NONE:
-		case DATA_LEVEL_TEXT:
-			name = "{sb_act_text %d";
-			break;
-		case DATA_LEVEL_MSG:
-			name = "{sb_act_msg %d";
-			break;
-		default:
-                        if (window->hilight_color == NULL)
-				name = "{sb_act_hilight %d";
-			else
-                                name = NULL;
-			break;
+	str = g_string_new(NULL);
+	format = g_string_new(NULL);
+
+	iter = g_sequence_get_begin_iter(activity_list);
+	for (; !g_sequence_iter_is_end(iter); iter = g_sequence_iter_next(iter)) {
+		rec = g_sequence_get(iter);
+
+		is_det = rec->window->data_level >= DATA_LEVEL_HILIGHT;
+		if ((!is_det && !normal) || (is_det && !hilight))
+			continue;
+
+		/* only the entries that changed are expanded again */
+		activity_entry_update_format(rec, format, add_name, pref_name);
+		if (rec->text == NULL || rec->theme != theme) {
+			g_free(rec->text);
+			rec->text = theme_format_expand(theme, rec->format);
+			rec->theme = theme;
 		}
 
-		if (name != NULL)
-			g_string_printf(format, name, window->refnum);
-		else
-			g_string_printf(format, "{sb_act_hilight_color %s %d",
-						 window->hilight_color,
-						 window->refnum);
-
-		if (add_name && window->active != NULL)
-			g_string_append_printf(format, ":%s",
-				pref_name == 1 && window->name != NULL ?
-				window->name : window->active->visible_name);
-		g_string_append_c(format, '}');
-
-		value = theme_format_expand(theme, format->str);
-		g_string_append(str, value);
-                g_free(value);
+		/* comma separator */
+		if (str->len > 0)
+			g_string_append(str, cache->separator);
+		g_string_append(str, rec->text);
 	}
-
-	ret = str->len == 0 ? NULL : str->str;
-        g_string_free(str, ret == NULL);
 	g_string_free(format, TRUE);
-        return ret;
+
+	value = str->len == 0 ? NULL : str->str;
+	g_string_free(str, value == NULL);
+
+	if (normal && hilight) {
+		g_free(cache->text);
+		cache->text = g_strdup(value);
+	}
+	return value;
 }
 
 /* redraw activity, FIXME: if we didn't get enough size, this gets buggy.
@@ -152,7 +256,8 @@ static void item_act(SBAR_ITEM_REC *item, int get_size_only)
 	int max_size;
 
 	if (get_size_only) {
-		if (activity_list == NULL)
+		if (g_sequence_get_begin_iter(activity_list) ==
+		    g_sequence_get_end_iter(activity_list))
 			item->min_size = item->max_size = 0;
 		/* Skip activity calculation on regular trigger, only
 		   set dirty */
@@ -181,109 +286,111 @@ static void item_act(SBAR_ITEM_REC *item, int get_size_only)
 	g_free_not_null(actlist);
 }
 
-static int window_level_recent_cmp(WINDOW_REC *w1, WINDOW_REC *w2)
-{
-	if (w1->data_level >= w2->data_level)
-		return -1;
-	else
-		return 1;
-}
-
-static int window_level_cmp(WINDOW_REC *w1, WINDOW_REC *w2)
-{
-	if (w1->data_level > w2->data_level ||
-	    (w1->data_level == w2->data_level && w1->refnum < w2->refnum))
-		return -1;
-	else
-		return 1;
-}
-
 static void sig_statusbar_activity_hilight(WINDOW_REC *window, gpointer oldlevel)
 {
-	GList *node;
+	ACTIVITY_REC *rec;
 
 	g_return_if_fail(window != NULL);
 
-	node = g_list_find(activity_list, window);
+	rec = g_hash_table_lookup(activity_windows, window);
 
-	if (actlist_sort == 1) {
-		/* Move the window to the first in the activity list */
-		if (node != NULL)
-			activity_list = g_list_delete_link(activity_list, node);
-		if (window->data_level != 0)
-			activity_list = g_list_prepend(activity_list, window);
-		statusbar_items_redraw("act");
-		return;
-	}
+	if (window->data_level == 0) {
+		if (rec == NULL)
+			return;
 
-	if (actlist_sort == 2) {
-		if (node != NULL) {
-			if (window->data_level == GPOINTER_TO_INT(oldlevel)) {
-				if (window->hilight_color != 0)
-					statusbar_items_redraw("act");
-				return;
-			}
-			activity_list = g_list_delete_link(activity_list, node);
-		}
-		if (window->data_level != 0)
-			activity_list = g_list_insert_sorted(activity_list, window, (GCompareFunc)
-							     window_level_cmp);
+		/* remove from activity list */
+		g_sequence_remove(rec->iter);
+		g_hash_table_remove(activity_windows, window);
+		activity_cache_invalidate();
 		statusbar_items_redraw("act");
 		return;
 	}
 
-	if (actlist_sort == 3) {
-		if (node != NULL)
-			activity_list = g_list_delete_link(activity_list, node);
-		if (window->data_level != 0)
-			activity_list = g_list_insert_sorted(activity_list, window, (GCompareFunc)
-							     window_level_recent_cmp);
+	if (rec == NULL) {
+		/* add window to activity list .. */
+		rec = g_new0(ACTIVITY_REC, 1);
+		rec->window = window;
+		rec->data_level = window->data_level;
+		rec->refnum = window->refnum;
+		rec->recent = ++activity_counter;
+		rec->iter = g_sequence_insert_sorted(activity_list, rec,
+						     (GCompareDataFunc) activity_cmp, NULL);
+		g_hash_table_insert(activity_windows, window, rec);
+		activity_cache_invalidate();
 		statusbar_items_redraw("act");
 		return;
 	}
 
-	if (node != NULL) {
-		/* already in activity list */
-		if (window->data_level == 0) {
-			/* remove from activity list */
-			activity_list = g_list_delete_link(activity_list, node);
-			statusbar_items_redraw("act");
-		} else if (window->data_level != GPOINTER_TO_INT(oldlevel) ||
-			 window->hilight_color != 0) {
-			/* different level as last time (or maybe different
-			   hilight color?), just redraw it. */
-			statusbar_items_redraw("act");
-		}
+	/* already in activity list */
+	rec->recent = ++activity_counter;
+	if (actlist_sort == 1 || actlist_sort == 3 ||
+	    rec->data_level != window->data_level) {
+		/* move the window to its new place */
+		rec->data_level = window->data_level;
+		g_sequence_sort_changed(rec->iter, (GCompareDataFunc) activity_cmp, NULL);
+	} else if (window->data_level == GPOINTER_TO_INT(oldlevel) &&
+		   window->hilight_color == 0) {
 		return;
 	}
 
-	if (window->data_level == 0)
-		return;
-
-	/* add window to activity list .. */
-	activity_list = g_list_insert_sorted(activity_list, window, (GCompareFunc)
-					     window_refnum_cmp);
-
+	/* different place or level as last time (or maybe different
+	   hilight color?), just redraw it. */
+	activity_cache_invalidate();
 	statusbar_items_redraw("act");
 }
 
 static void sig_statusbar_activity_window_destroyed(WINDOW_REC *window)
 {
-	GList *node;
+	ACTIVITY_REC *rec;
 
 	g_return_if_fail(window != NULL);
 
-	node = g_list_find(activity_list, window);
-	if (node != NULL)
-		activity_list = g_list_delete_link(activity_list, node);
+	rec = g_hash_table_lookup(activity_windows, window);
+	if (rec != NULL) {
+		g_sequence_remove(rec->iter);
+		g_hash_table_remove(activity_windows, window);
+	}
+	activity_cache_invalidate();
 	statusbar_items_redraw("act");
 }
 
-static void sig_statusbar_activity_updated(void)
+static void sig_statusbar_activity_refnum_changed(WINDOW_REC *window)
 {
+	ACTIVITY_REC *rec;
+
+	rec = g_hash_table_lookup(activity_windows, window);
+	if (rec != NULL) {
+		rec->refnum = window->refnum;
+		g_sequence_sort_changed(rec->iter, (GCompareDataFunc) activity_cmp, NULL);
+	}
+	activity_cache_invalidate();
 	statusbar_items_redraw("act");
 }
 
+static void sig_statusbar_activity_mainwindow_destroyed(MAIN_WINDOW_REC *window)
+{
+	g_hash_table_remove(activity_cache, window);
+}
+
+static void sig_statusbar_activity_names_changed(void)
+{
+	activity_cache_invalidate();
+}
+
+static void sig_statusbar_activity_theme_changed(void)
+{
+	GHashTableIter iter;
+	ACTIVITY_REC *rec;
+
+	/* expand all the entries again */
+	g_hash_table_iter_init(&iter, activity_windows);
+	while (g_hash_table_iter_next(&iter, NULL, (void **) &rec)) {
+		rec->theme = NULL;
+		g_free_and_null(rec->text);
+	}
+	activity_cache_invalidate();
+}
+
 static void item_more(SBAR_ITEM_REC *item, int get_size_only)
 {
         MAIN_WINDOW_REC *mainwin;
@@ -454,10 +561,19 @@ static void item_input(SBAR_ITEM_REC *item, int get_size_only)
 static void read_settings(void)
 {
 	const char *sep;
+	int sort;
+
 	if (active_entry != NULL)
 		gui_entry_set_utf8(active_entry, term_type == TERM_TYPE_UTF8);
 
-	actlist_sort = settings_get_choice("actlist_sort");
+	sort = settings_get_choice("actlist_sort");
+	if (sort != actlist_sort) {
+		actlist_sort = sort;
+		g_sequence_sort(activity_list, (GCompareDataFunc) activity_cmp, NULL);
+		statusbar_items_redraw("act");
+	}
+	/* actlist_names etc. may have changed */
+	activity_cache_invalidate();
 
 	sep = settings_get_str("actlist_separator");
 	if (g_strcmp0(actlist_separator, sep) != 0) {
@@ -487,10 +603,20 @@ void statusbar_items_init(void)
 	statusbar_item_register("input", NULL, item_input);
 
         /* activity */
-	activity_list = NULL;
+	activity_list = g_sequence_new(NULL);
+	activity_windows = g_hash_table_new_full(NULL, NULL, NULL,
+						 (GDestroyNotify) activity_rec_destroy);
+	activity_cache = g_hash_table_new_full(NULL, NULL, NULL,
+					       (GDestroyNotify) activity_cache_destroy);
 	signal_add("window activity", (SIGNAL_FUNC) sig_statusbar_activity_hilight);
 	signal_add("window destroyed", (SIGNAL_FUNC) sig_statusbar_activity_window_destroyed);
-	signal_add("window refnum changed", (SIGNAL_FUNC) sig_statusbar_activity_updated);
+	signal_add("window refnum changed", (SIGNAL_FUNC) sig_statusbar_activity_refnum_changed);
+	signal_add("window name changed", (SIGNAL_FUNC) sig_statusbar_activity_names_changed);
+	signal_add("window item changed", (SIGNAL_FUNC) sig_statusbar_activity_names_changed);
+	signal_add("window item name changed", (SIGNAL_FUNC) sig_statusbar_activity_names_changed);
+	signal_add("mainwindow destroyed", (SIGNAL_FUNC) sig_statusbar_activity_mainwindow_destroyed);
+	signal_add("theme changed", (SIGNAL_FUNC) sig_statusbar_activity_theme_changed);
+	signal_add("theme destroyed", (SIGNAL_FUNC) sig_statusbar_activity_theme_changed);
 
         /* more */
         more_visible = NULL;
@@ -520,9 +646,17 @@ void statusbar_items_deinit(void)
         /* activity */
 	signal_remove("window activity", (SIGNAL_FUNC) sig_statusbar_activity_hilight);
 	signal_remove("window destroyed", (SIGNAL_FUNC) sig_statusbar_activity_window_destroyed);
-	signal_remove("window refnum changed", (SIGNAL_FUNC) sig_statusbar_activity_updated);
-	g_list_free(activity_list);
-        activity_list = NULL;
+	signal_remove("window refnum changed", (SIGNAL_FUNC) sig_statusbar_activity_refnum_changed);
+	signal_remove("window name changed", (SIGNAL_FUNC) sig_statusbar_activity_names_changed);
+	signal_remove("window item changed", (SIGNAL_FUNC) sig_statusbar_activity_names_changed);
+	signal_remove("window item name changed", (SIGNAL_FUNC) sig_statusbar_activity_names_changed);
+	signal_remove("mainwindow destroyed", (SIGNAL_FUNC) sig_statusbar_activity_mainwindow_destroyed);
+	signal_remove("theme changed", (SIGNAL_FUNC) sig_statusbar_activity_theme_changed);
+	signal_remove("theme destroyed", (SIGNAL_FUNC) sig_statusbar_activity_theme_changed);
+	g_sequence_free(activity_list);
+	activity_list = NULL;
+	g_hash_table_destroy(activity_windows);
+	g_hash_table_destroy(activity_cache);
 
         /* more */
         g_slist_free(more_visible);
@@ -346,6 +346,7 @@ void statusbar_redraw(STATUSBAR_REC *bar, int force)
 void statusbar_item_redraw(SBAR_ITEM_REC *item)
 {
         WINDOW_REC *old_active_win;
+	int old_min_size, old_max_size;
 
 	g_return_if_fail(item != NULL);
 
@@ -353,8 +354,18 @@ void statusbar_item_redraw(SBAR_ITEM_REC *item)
         if (item->bar->parent_window != NULL)
 		active_win = item->bar->parent_window->active;
 
+	old_min_size = item->min_size;
+	old_max_size = item->max_size;
+	item->cache_unchanged = FALSE;
 	item->func(item, TRUE);
 
+	if (item->cache_unchanged && item->min_size == old_min_size &&
+	    item->max_size == old_max_size) {
+		/* the item looks the same as before */
+		active_win = old_active_win;
+		return;
+	}
+
 	item->dirty = TRUE;
 	item->bar->dirty = TRUE;
 	irssi_set_dirty();
@@ -675,6 +686,96 @@ static GString *finalize_string(const char *str, const char *color)
 	return out;
 }
 
+static void statusbar_item_cache_free_vars(SBAR_ITEM_REC *item)
+{
+	g_slist_free_full(item->cache_vars, g_free);
+	item->cache_vars = NULL;
+}
+
+static void statusbar_item_cache_clear(SBAR_ITEM_REC *item)
+{
+	statusbar_item_cache_free_vars(item);
+	g_free_and_null(item->cache_str);
+	g_free_and_null(item->cache_data);
+	g_free_and_null(item->cache_template);
+	g_free_and_null(item->cache_text);
+	item->cache_theme = NULL;
+	item->cache_valid = FALSE;
+}
+
+/* Returns TRUE if none of the $variables in the item's template have
+   changed since cache_text was expanded */
+static int statusbar_item_cache_check(SBAR_ITEM_REC *item, const char *str,
+				      const char *data, int escape_vars,
+				      SERVER_REC *server, WI_ITEM_REC *wiitem)
+{
+	GSList *tmp;
+	char *value;
+	int free_ret, same;
+
+	if (item->cache_text == NULL || item->cache_volatile ||
+	    item->cache_theme != current_theme ||
+	    item->cache_escape != !!escape_vars ||
+	    g_strcmp0(item->cache_str, str) != 0 ||
+	    g_strcmp0(item->cache_data, data) != 0)
+		return FALSE;
+
+	for (tmp = item->cache_vars; tmp != NULL; tmp = tmp->next->next) {
+		value = special_vars_get_value(tmp->data, server, wiitem, &free_ret);
+		same = g_strcmp0(value, tmp->next->data) == 0;
+		if (free_ret) g_free(value);
+		if (!same)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* Remember the template and the current values of its $variables */
+static void statusbar_item_cache_set(SBAR_ITEM_REC *item, const char *str,
+				     const char *data, int escape_vars,
+				     SERVER_REC *server, WI_ITEM_REC *wiitem)
+{
+	theme_rm_col reset;
+	GSList *names, *tmp;
+	char *value;
+	int free_ret;
+
+	if (item->cache_theme != current_theme ||
+	    g_strcmp0(item->cache_str, str) != 0) {
+		g_free(item->cache_str);
+		item->cache_str = g_strdup(str);
+		item->cache_theme = current_theme;
+
+		strcpy(reset.m, "n");
+		g_free(item->cache_template);
+		item->cache_template =
+			theme_format_expand_data(current_theme, &str,
+						 reset, reset,
+						 NULL, NULL,
+						 EXPAND_FLAG_ROOT |
+						 EXPAND_FLAG_IGNORE_REPLACES |
+						 EXPAND_FLAG_IGNORE_EMPTY);
+	}
+
+	g_free(item->cache_data);
+	item->cache_data = g_strdup(data);
+	item->cache_escape = !!escape_vars;
+
+	statusbar_item_cache_free_vars(item);
+	item->cache_volatile = FALSE;
+	names = special_vars_get_names(item->cache_template);
+	for (tmp = names; tmp != NULL; tmp = tmp->next) {
+		if (strcmp(tmp->data, "!") == 0)
+			item->cache_volatile = TRUE;
+
+		value = special_vars_get_value(tmp->data, server, wiitem, &free_ret);
+		item->cache_vars = g_slist_prepend(item->cache_vars, g_strdup(value));
+		item->cache_vars = g_slist_prepend(item->cache_vars, tmp->data);
+		if (free_ret) g_free(value);
+	}
+	g_slist_free(names);
+}
+
 void statusbar_item_default_handler(SBAR_ITEM_REC *item, int get_size_only,
 				    const char *str, const char *data,
 				    int escape_vars)
@@ -682,9 +783,7 @@ void statusbar_item_default_handler(SBAR_ITEM_REC *item, int get_size_only,
 	SERVER_REC *server;
 	WI_ITEM_REC *wiitem;
 	char *tmpstr, *tmpstr2;
-	theme_rm_col reset;
 	int len;
-	strcpy(reset.m, "n");
 
 	if (str == NULL)
 		str = statusbar_item_get_value(item);
@@ -702,27 +801,41 @@ void statusbar_item_default_handler(SBAR_ITEM_REC *item, int get_size_only,
 		wiitem = active_win->active;
 	}
 
-	/* expand templates */
-	tmpstr = theme_format_expand_data(current_theme, &str,
-					  reset, reset,
-					  NULL, NULL,
-					  EXPAND_FLAG_ROOT |
-					  EXPAND_FLAG_IGNORE_REPLACES |
-					  EXPAND_FLAG_IGNORE_EMPTY);
-	/* expand $variables */
-	tmpstr2 = parse_special_string(tmpstr, server, wiitem, data, NULL,
-				       (escape_vars ? PARSE_FLAG_ESCAPE_VARS : 0 ));
-        g_free(tmpstr);
-
-	/* remove color codes (not %formats) */
-	tmpstr = strip_codes(tmpstr2);
-        g_free(tmpstr2);
+	if (!get_size_only && item->cache_valid) {
+		/* already expanded when the size was asked */
+		tmpstr = g_strdup(item->cache_text);
+	} else if (statusbar_item_cache_check(item, str, data, escape_vars,
+					      server, wiitem)) {
+		/* nothing in it changed */
+		item->cache_unchanged = TRUE;
+		item->cache_valid = get_size_only;
+		tmpstr = g_strdup(item->cache_text);
+	} else {
+		/* expand templates */
+		statusbar_item_cache_set(item, str, data, escape_vars,
+					 server, wiitem);
+		/* expand $variables */
+		tmpstr2 = parse_special_string(item->cache_template, server, wiitem,
+					       data, NULL,
+					       (escape_vars ? PARSE_FLAG_ESCAPE_VARS : 0 ));
+
+		/* remove color codes (not %formats) */
+		tmpstr = strip_codes(tmpstr2);
+		g_free(tmpstr2);
+
+		item->cache_unchanged = g_strcmp0(item->cache_text, tmpstr) == 0;
+		g_free(item->cache_text);
+		item->cache_text = g_strdup(tmpstr);
+		item->cache_size = format_get_length(tmpstr);
+		item->cache_valid = get_size_only;
+	}
 
 	if (get_size_only) {
-		item->min_size = item->max_size = format_get_length(tmpstr);
+		item->min_size = item->max_size = item->cache_size;
 	} else {
 		GString *out;
 
+		item->cache_valid = FALSE;
 		if (item->size < item->min_size) {
                         /* they're forcing us smaller than minimum size.. */
 			len = format_real_length(tmpstr, item->size);
@@ -969,6 +1082,7 @@ void statusbar_item_destroy(SBAR_ITEM_REC *item)
 		list = g_slist_remove(list, list->data);
 	}
 
+	statusbar_item_cache_clear(item);
 	g_free(item);
 }
 
@@ -1108,6 +1222,23 @@ static void sig_window_changed(void)
 	}
 }
 
+static void sig_theme_changed(void)
+{
+	GSList *group, *bar, *item;
+
+	/* the templates may expand differently now */
+	for (group = statusbar_groups; group != NULL; group = group->next) {
+		STATUSBAR_GROUP_REC *grec = group->data;
+
+		for (bar = grec->bars; bar != NULL; bar = bar->next) {
+			STATUSBAR_REC *brec = bar->data;
+
+			for (item = brec->items; item != NULL; item = item->next)
+				statusbar_item_cache_clear(item->data);
+		}
+	}
+}
+
 static void sig_gui_window_created(WINDOW_REC *window)
 {
         statusbars_add_visible(WINDOW_MAIN(window));
@@ -1158,6 +1289,7 @@ void statusbar_init(void)
 	signal_add("mainwindow moved", (SIGNAL_FUNC) sig_mainwindow_resized);
 	signal_add("gui window created", (SIGNAL_FUNC) sig_gui_window_created);
 	signal_add("window changed", (SIGNAL_FUNC) sig_window_changed);
+	signal_add_first("theme changed", (SIGNAL_FUNC) sig_theme_changed);
 	signal_add("mainwindow destroyed", (SIGNAL_FUNC) sig_mainwindow_destroyed);
 
 	statusbar_items_init();
@@ -1189,6 +1321,7 @@ void statusbar_deinit(void)
 	signal_remove("mainwindow moved", (SIGNAL_FUNC) sig_mainwindow_resized);
 	signal_remove("gui window created", (SIGNAL_FUNC) sig_gui_window_created);
 	signal_remove("window changed", (SIGNAL_FUNC) sig_window_changed);
+	signal_remove("theme changed", (SIGNAL_FUNC) sig_theme_changed);
 	signal_remove("mainwindow destroyed", (SIGNAL_FUNC) sig_mainwindow_destroyed);
 
 	statusbar_items_deinit();
@@ -81,6 +81,20 @@ struct SBAR_ITEM_REC {
 
         int current_size; /* item size currently in screen */
 	unsigned int dirty:1;
+
+	/* text from the last expansion of the item's template, it's expanded
+	   again only when the $variables in it change and redrawn only when
+	   the text changes */
+	char *cache_str, *cache_data; /* what was expanded */
+	void *cache_theme; /* THEME_REC */
+	char *cache_template; /* cache_str with the theme's templates expanded */
+	GSList *cache_vars; /* name, value, name, value, .. */
+	char *cache_text;
+	int cache_size; /* format_get_length(cache_text) */
+	unsigned int cache_escape:1;
+	unsigned int cache_volatile:1; /* uses $!, always expanded */
+	unsigned int cache_valid:1; /* cache_text can be drawn as it is */
+	unsigned int cache_unchanged:1; /* last expansion gave the same text */
 };
 
 extern GSList *statusbar_groups;
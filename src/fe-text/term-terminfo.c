@@ -54,16 +54,55 @@ struct _TERM_WINDOW {
 	int width, height;
 };
 
+/* One character cell of the screen */
+typedef struct {
+	unichar chr; /* 0 = right half of the wide character before it */
+	unichar combining; /* zero width character drawn over chr, or 0 */
+	int col; /* color and attributes as given to term_set_color2() */
+	unsigned int fgcol24, bgcol24;
+} TERM_CELL;
+
+/* cell that is never on the screen */
+#define CELL_UNKNOWN ((unichar) -1)
+
+/* unchanged cells between changed ones are redrawn if there's less than
+   this many of them, it's cheaper than moving the cursor over them */
+#define SCREEN_MAX_GAP 4
+
+#define SCREEN_LINE(screen, y) ((screen) + (y) * term_width)
+
 TERM_WINDOW *root_window;
 
-static char *term_lines_empty; /* 1 if line is entirely empty */
-static int vcmove, vcx, vcy, curs_visible;
+/* The screen is drawn to screen_back. At term_refresh() it's compared
+   against screen_front, what the terminal is showing, and only the
+   differences are sent to the terminal. */
+static TERM_CELL *screen_back, *screen_front;
+static char *screen_lines_dirty; /* 1 if line may differ in front and back */
+
+/* scroll of lines scroll_y1 .. scroll_y2-1 not yet sent to the terminal.
+   screen_front doesn't include it. */
+static int scroll_y1, scroll_y2, scroll_count;
+static unsigned int scroll_coalesced;
+
+static int vcx, vcy, curs_visible;
 static int crealx, crealy, cforcemove;
 static int curs_x, curs_y;
 
+/* color for the next drawn cells */
+static int cur_col;
+static unsigned int cur_fgcol24, cur_bgcol24;
+
+/* color of the last cell sent to terminal, -1 if unknown */
+static int emit_col;
+static unsigned int emit_fgcol24, emit_bgcol24;
+
 static unsigned int last_fg, last_bg;
 static int last_attrs;
 
+/* partial character given to term_addch() */
+static char addch_buf[6];
+static int addch_len;
+
 static GSource *sigcont_source;
 static volatile sig_atomic_t got_sigcont;
 static int freeze_counter;
@@ -72,6 +111,8 @@ static TERM_INPUT_FUNC input_func;
 static unsigned char term_inbuf[256];
 static int term_inbuf_pos;
 
+static void term_emit_color(int col, unsigned int fgcol24, unsigned int bgcol24);
+
 /* SIGCONT handler */
 static void sig_cont(int p)
 {
@@ -123,6 +164,67 @@ static void term_atexit(void)
 	term_deinit();
 }
 
+static void cells_clear(TERM_CELL *cell, int count)
+{
+	for (; count > 0; count--, cell++) {
+		cell->chr = ' ';
+		cell->combining = 0;
+		cell->col = ATTR_RESET;
+		cell->fgcol24 = cell->bgcol24 = 0;
+	}
+}
+
+static void cells_fill(TERM_CELL *cell, int count)
+{
+	for (; count > 0; count--, cell++) {
+		cell->chr = ' ';
+		cell->combining = 0;
+		cell->col = cur_col;
+		cell->fgcol24 = cur_fgcol24;
+		cell->bgcol24 = cur_bgcol24;
+	}
+}
+
+static int cell_equals(const TERM_CELL *cell1, const TERM_CELL *cell2)
+{
+	return cell1->chr == cell2->chr && cell1->col == cell2->col &&
+		cell1->combining == cell2->combining &&
+		cell1->fgcol24 == cell2->fgcol24 &&
+		cell1->bgcol24 == cell2->bgcol24;
+}
+
+/* Returns TRUE if cell is a space that clrtoeol would also draw */
+static int cell_is_empty(const TERM_CELL *cell)
+{
+	return cell->chr == ' ' && cell->combining == 0 &&
+		(cell->col & ~ATTR_BOLD) == ATTR_RESET;
+}
+
+/* Allocate the screen buffers for the current terminal size. What the
+   terminal shows is unknown until it's cleared. */
+static void screen_create(void)
+{
+	int i, size;
+
+	size = term_width * term_height;
+	screen_back = g_new(TERM_CELL, size);
+	screen_front = g_new(TERM_CELL, size);
+	screen_lines_dirty = g_new(char, term_height);
+
+	cells_clear(screen_back, size);
+	for (i = 0; i < size; i++)
+		screen_front[i].chr = CELL_UNKNOWN;
+	memset(screen_lines_dirty, 1, term_height);
+}
+
+static void screen_destroy(void)
+{
+	scroll_count = 0;
+	g_free_and_null(screen_back);
+	g_free_and_null(screen_front);
+	g_free_and_null(screen_lines_dirty);
+}
+
 int term_init(void)
 {
 	struct sigaction act;
@@ -130,8 +232,11 @@ int term_init(void)
 
 	last_fg = last_bg = -1;
 	last_attrs = 0;
+	emit_col = -1;
+	cur_col = ATTR_RESET;
+	cur_fgcol24 = cur_bgcol24 = 0;
 	vcx = vcy = 0; crealx = crealy = -1;
-	vcmove = FALSE; cforcemove = TRUE;
+	cforcemove = TRUE;
         curs_visible = TRUE;
 
 	current_term = terminfo_core_init(stdin, stdout);
@@ -157,7 +262,7 @@ int term_init(void)
 	term_height = current_term->height;
 	root_window = term_window_create(0, 0, term_width, term_height);
 
-        term_lines_empty = g_new0(char, term_height);
+	screen_create();
 
         term_set_input_type(TERM_TYPE_8BIT);
 	term_common_init();
@@ -175,12 +280,14 @@ void term_deinit(void)
 		term_common_deinit();
 		terminfo_core_deinit(current_term);
 		current_term = NULL;
+		screen_destroy();
 	}
 }
 
-static void term_move_real(void)
+/* Move the real cursor to x, y */
+static void term_move_real(int x, int y)
 {
-	if (vcx != crealx || vcy != crealy || cforcemove) {
+	if (x != crealx || y != crealy || cforcemove) {
 		if (curs_visible) {
 			terminfo_set_cursor_visible(FALSE);
 			curs_visible = FALSE;
@@ -190,14 +297,12 @@ static void term_move_real(void)
 			crealx = crealy = -1;
 			cforcemove = FALSE;
 		}
-		terminfo_move_relative(crealx, crealy, vcx, vcy);
-                crealx = vcx; crealy = vcy;
+		terminfo_move_relative(crealx, crealy, x, y);
+                crealx = x; crealy = y;
 	}
-
-        vcmove = FALSE;
 }
 
-/* Cursor position is unknown - move it immediately to known position */
+/* Cursor position is unknown */
 static void term_move_reset(int x, int y)
 {
 	if (x >= term_width) x = term_width-1;
@@ -205,7 +310,6 @@ static void term_move_reset(int x, int y)
 
 	vcx = x; vcy = y;
         cforcemove = TRUE;
-        term_move_real();
 }
 
 /* Resize terminal - if width or height is negative,
@@ -222,8 +326,8 @@ void term_resize(int width, int height)
 		term_height = current_term->height = height;
 		term_window_move(root_window, 0, 0, term_width, term_height);
 
-                g_free(term_lines_empty);
-		term_lines_empty = g_new0(char, term_height);
+		screen_destroy();
+		screen_create();
 	}
 
         term_move_reset(0, 0);
@@ -248,11 +352,18 @@ void term_force_colors(int set)
 /* Clear screen */
 void term_clear(void)
 {
+	int size;
+
         term_set_color(root_window, ATTR_RESET);
+	term_emit_color(ATTR_RESET, 0, 0);
 	terminfo_clear();
         term_move_reset(0, 0);
 
-	memset(term_lines_empty, 1, term_height);
+	size = term_width * term_height;
+	cells_clear(screen_back, size);
+	cells_clear(screen_front, size);
+	memset(screen_lines_dirty, 0, term_height);
+	scroll_count = 0;
 }
 
 /* Beep */
@@ -294,7 +405,7 @@ void term_window_clear(TERM_WINDOW *window)
 {
 	int y;
 
-	terminfo_set_normal();
+	term_set_color(window, ATTR_RESET);
 	if (window->y == 0 && window->height == term_height && window->width == term_width) {
 		term_clear();
 	} else {
@@ -305,17 +416,82 @@ void term_window_clear(TERM_WINDOW *window)
 	}
 }
 
+/* Shift the lines y1 .. y2-1 of screen by count, new lines are cleared */
+static void screen_shift(TERM_CELL *screen, int y1, int y2, int count)
+{
+	int moved;
+
+	moved = y2 - y1 - ABS(count);
+	if (moved <= 0) {
+		cells_clear(SCREEN_LINE(screen, y1), (y2 - y1) * term_width);
+	} else if (count > 0) {
+		memmove(SCREEN_LINE(screen, y1), SCREEN_LINE(screen, y1 + count),
+			moved * term_width * sizeof(TERM_CELL));
+		cells_clear(SCREEN_LINE(screen, y1 + moved), count * term_width);
+	} else {
+		memmove(SCREEN_LINE(screen, y1 - count), SCREEN_LINE(screen, y1),
+			moved * term_width * sizeof(TERM_CELL));
+		cells_clear(SCREEN_LINE(screen, y1), -count * term_width);
+	}
+}
+
+/* Send the pending scroll to the terminal */
+static void screen_scroll_flush(void)
+{
+	int count;
+
+	if (scroll_count == 0)
+		return;
+
+	count = scroll_count;
+	scroll_count = 0;
+	if (ABS(count) >= scroll_y2 - scroll_y1) {
+		/* everything scrolled away, the lines are redrawn anyway */
+		return;
+	}
+
+	/* the terminal may fill the new lines with the active color */
+	term_emit_color(ATTR_RESET, 0, 0);
+	terminfo_scroll(scroll_y1, scroll_y2 - 1, count);
+        term_move_reset(vcx, vcy);
+
+	screen_shift(screen_front, scroll_y1, scroll_y2, count);
+}
+
 /* Scroll window up/down */
 void term_window_scroll(TERM_WINDOW *window, int count)
 {
-	int y;
+	int y1, y2, height, moved;
 
-	terminfo_scroll(window->y, window->y+window->height-1, count);
-        term_move_reset(vcx, vcy);
+	y1 = window->y;
+	y2 = MIN(window->y + window->height, term_height);
+	height = y2 - y1;
+	if (count == 0 || height <= 0)
+		return;
 
-        /* set the newly scrolled area dirty */
-	for (y = 0; (window->y+y) < term_height && y < window->height; y++)
-		term_lines_empty[window->y+y] = FALSE;
+	/* the terminal is scrolled at the next refresh. scrolls of the same
+	   area into the same direction until then are sent as one. */
+	if (scroll_count != 0 &&
+	    (scroll_y1 != y1 || scroll_y2 != y2 || (scroll_count > 0) != (count > 0)))
+		screen_scroll_flush();
+	else if (scroll_count != 0)
+		scroll_coalesced++;
+	scroll_y1 = y1;
+	scroll_y2 = y2;
+	scroll_count += count;
+
+	/* the window's pending changes go along with the contents */
+	screen_shift(screen_back, y1, y2, count);
+	moved = height - ABS(count);
+	if (moved <= 0) {
+		memset(screen_lines_dirty + y1, 1, height);
+	} else if (count > 0) {
+		memmove(screen_lines_dirty + y1, screen_lines_dirty + y1 + count, moved);
+		memset(screen_lines_dirty + y1 + moved, 1, count);
+	} else {
+		memmove(screen_lines_dirty + y1 - count, screen_lines_dirty + y1, moved);
+		memset(screen_lines_dirty + y1, 1, -count);
+	}
 }
 
 #ifdef TPUTS_SVR4
@@ -349,8 +525,8 @@ static int termctl_set_color_24bit(int bg, unsigned int lc)
 #define COLOR_RESET UINT_MAX
 #define COLOR_BLACK24 COLOR_RESET - 1
 
-/* Change active color */
-void term_set_color2(TERM_WINDOW *window, int col, unsigned int fgcol24, unsigned int bgcol24)
+/* Send the color change to terminal */
+static void term_emit_color(int col, unsigned int fgcol24, unsigned int bgcol24)
 {
 	int set_normal;
 
@@ -371,6 +547,10 @@ void term_set_color2(TERM_WINDOW *window, int col, unsigned int fgcol24, unsigne
 	} else
 		bg = ((col & BG_MASK) >> BG_SHIFT);
 
+	emit_col = col;
+	emit_fgcol24 = fgcol24;
+	emit_bgcol24 = bgcol24;
+
 	if (!term_use_colors && bg > 0)
 		col |= ATTR_REVERSE;
 
@@ -403,10 +583,10 @@ void term_set_color2(TERM_WINDOW *window, int col, unsigned int fgcol24, unsigne
 	}
 
 	/* set background color */
-	if (window && window->term->TI_colors &&
-	    (term_color256map[bg & 0xff] & 8) == window->term->TI_colors)
+	if (current_term->TI_colors &&
+	    (term_color256map[bg & 0xff] & 8) == current_term->TI_colors)
 		col |= ATTR_BLINK;
-	if (col & ATTR_BLINK)
+	if (col & ATTR_BLINK && (last_attrs & ATTR_BLINK) == 0)
 		current_term->tr_set_blink(current_term);
 
 	if (bg != last_bg && (bg != 0 || (col & ATTR_RESETBG) == 0)) {
@@ -421,14 +601,14 @@ void term_set_color2(TERM_WINDOW *window, int col, unsigned int fgcol24, unsigne
 	}
 
 	/* reversed text */
-	if (col & ATTR_REVERSE)
+	if (col & ATTR_REVERSE && (last_attrs & ATTR_REVERSE) == 0)
 		terminfo_set_reverse();
 
 	/* bold */
-	if (window && window->term->TI_colors &&
-	    (term_color256map[fg & 0xff] & 8) == window->term->TI_colors)
+	if (current_term->TI_colors &&
+	    (term_color256map[fg & 0xff] & 8) == current_term->TI_colors)
 		col |= ATTR_BOLD;
-	if (col & ATTR_BOLD)
+	if (col & ATTR_BOLD && (last_attrs & ATTR_BOLD) == 0)
 		terminfo_set_bold();
 
 	/* underline */
@@ -449,10 +629,19 @@ void term_set_color2(TERM_WINDOW *window, int col, unsigned int fgcol24, unsigne
 	last_attrs = col & ~(BG_MASK | FG_MASK);
 }
 
+/* Change active color */
+void term_set_color2(TERM_WINDOW *window, int col, unsigned int fgcol24, unsigned int bgcol24)
+{
+	/* the 24bit colors are compared between cells, so keep them
+	   only when they're used */
+	cur_col = col;
+	cur_fgcol24 = (col & ATTR_FGCOLOR24) ? fgcol24 : 0;
+	cur_bgcol24 = (col & ATTR_BGCOLOR24) ? bgcol24 : 0;
+}
+
 void term_move(TERM_WINDOW *window, int x, int y)
 {
 	if (x >= 0 && y >= 0) {
-		vcmove = TRUE;
 		vcx = x+window->x;
 		vcy = y+window->y;
 
@@ -461,146 +650,202 @@ void term_move(TERM_WINDOW *window, int x, int y)
 		if (vcy >= term_height)
 			vcy = term_height-1;
 	}
+	addch_len = 0;
 }
 
-static void term_printed_text(int count)
+/* Put character to the screen at the cursor position */
+static void term_put_cell(unichar chr, int width)
 {
-	term_lines_empty[vcy] = FALSE;
+	TERM_CELL *line, *cell;
+
+	if (width == 0) {
+		/* combine with the previous character */
+		if (vcx == 0)
+			return;
+		line = SCREEN_LINE(screen_back, vcy);
+		cell = &line[vcx - 1];
+		if (cell->chr == 0 && vcx > 1)
+			cell--;
+		cell->combining = chr;
+		screen_lines_dirty[vcy] = TRUE;
+		return;
+	}
 
-	/* if we continued writing past the line, wrap to next line.
-	   However, next term_move() really shouldn't try to cache
-	   the move, otherwise terminals would try to combine the
-	   last word in upper line with first word in lower line. */
-	vcx += count;
-	while (vcx >= term_width) {
-		vcx -= term_width;
+	if (vcx + width > term_width) {
+		/* wide character doesn't fit to the end of line */
+		vcx = 0;
 		if (vcy < term_height-1) vcy++;
-		if (vcx > 0) term_lines_empty[vcy] = FALSE;
 	}
 
-	crealx += count;
-	if (crealx >= term_width)
-		cforcemove = TRUE;
-}
-
-void term_addch(TERM_WINDOW *window, char chr)
-{
-	if (vcmove) term_move_real();
-
-	/* With UTF-8, move cursor only if this char is either
-	   single-byte (8. bit off) or beginning of multibyte
-	   (7. bit off) */
-	if (term_type != TERM_TYPE_UTF8 ||
-	    (chr & 0x80) == 0 || (chr & 0x40) == 0) {
-		term_printed_text(1);
+	line = SCREEN_LINE(screen_back, vcy);
+	cell = &line[vcx];
+
+	/* don't leave halves of wide characters behind */
+	if (cell->chr == 0 && vcx > 0)
+		cells_fill(cell - 1, 1);
+	if (vcx + width < term_width && cell[width].chr == 0)
+		cells_fill(cell + width, 1);
+
+	cell->chr = chr;
+	cell->combining = 0;
+	cell->col = cur_col;
+	cell->fgcol24 = cur_fgcol24;
+	cell->bgcol24 = cur_bgcol24;
+	if (width == 2 && vcx + 1 < term_width) {
+		cell[1] = *cell;
+		cell[1].chr = 0;
 	}
+	screen_lines_dirty[vcy] = TRUE;
 
-	putc(chr, window->term->out);
+	/* if we continued writing past the line, wrap to next line */
+	vcx += width;
+	while (vcx >= term_width) {
+		vcx -= term_width;
+		if (vcy < term_height-1) vcy++;
+	}
 }
 
-static void term_addch_utf8(TERM_WINDOW *window, unichar chr)
+static void term_put_unichar(unichar chr)
 {
-	char buf[10];
-	int i, len;
-
-	len = g_unichar_to_utf8(chr, buf);
-	for (i = 0;  i < len; i++)
-                putc(buf[i], window->term->out);
+	switch (term_type) {
+	case TERM_TYPE_UTF8:
+		term_put_cell(chr, unichar_isprint(chr) ? i_wcwidth(chr) : 1);
+		break;
+	case TERM_TYPE_BIG5:
+		term_put_cell(chr, chr > 0xff ? 2 : 1);
+		break;
+	default:
+		term_put_cell(chr & 0xff, 1);
+		break;
+	}
 }
 
-void term_add_unichar(TERM_WINDOW *window, unichar chr)
+void term_addch(TERM_WINDOW *window, char chr)
 {
-	if (vcmove) term_move_real();
+	unsigned char c = (unsigned char) chr;
+	unichar uc;
 
 	switch (term_type) {
 	case TERM_TYPE_UTF8:
-		term_printed_text(unichar_isprint(chr) ? i_wcwidth(chr) : 1);
-                term_addch_utf8(window, chr);
+		/* collect the bytes of a multibyte character */
+		if (c < 0x80) {
+			addch_len = 0;
+			term_put_cell(c, 1);
+			break;
+		}
+		if ((c & 0x40) != 0)
+			addch_len = 0;
+		else if (addch_len == 0)
+			break;
+		addch_buf[addch_len++] = chr;
+		if (addch_len < g_utf8_skip[(unsigned char) addch_buf[0]] &&
+		    addch_len < (int) sizeof(addch_buf))
+			break;
+
+		uc = g_utf8_get_char_validated(addch_buf, addch_len);
+		addch_len = 0;
+		if (uc == (unichar) -1 || uc == (unichar) -2)
+			term_put_cell(0xfffd, 1);
+		else
+			term_put_unichar(uc);
 		break;
 	case TERM_TYPE_BIG5:
-		if (chr > 0xff) {
-			term_printed_text(2);
-			putc((chr >> 8) & 0xff, window->term->out);
-		} else {
-			term_printed_text(1);
+		if (addch_len == 1) {
+			addch_len = 0;
+			if (is_big5_lo(c)) {
+				term_put_cell(((unsigned char) addch_buf[0] << 8) + c, 2);
+				break;
+			}
+			term_put_cell((unsigned char) addch_buf[0], 1);
 		}
-		putc((chr & 0xff), window->term->out);
-                break;
+		if (is_big5_hi(c)) {
+			addch_buf[0] = chr;
+			addch_len = 1;
+			break;
+		}
+		term_put_cell(c, 1);
+		break;
 	default:
-		term_printed_text(1);
-		putc(chr, window->term->out);
-                break;
+		term_put_cell(c, 1);
+		break;
 	}
 }
 
+void term_add_unichar(TERM_WINDOW *window, unichar chr)
+{
+	addch_len = 0;
+	term_put_unichar(chr);
+}
+
 int term_addstr(TERM_WINDOW *window, const char *str)
 {
-	int len, raw_len;
+	int len, i, ascii;
 	unichar tmp;
-	const char *ptr;
+	const char *ptr, *end;
 
-	if (vcmove) term_move_real();
-
-	len = 0;
-	raw_len = strlen(str);
+	addch_len = 0;
 
 	/* The string length depends on the terminal encoding */
 
 	ptr = str;
 
 	if (term_type == TERM_TYPE_UTF8) {
-		while (*ptr != '\0') {
+		len = 0;
+		end = ptr + strlen(ptr);
+		while (ptr < end) {
+			ascii = string_printable_ascii_len(ptr, end - ptr);
+			for (i = 0; i < ascii; i++)
+				term_put_cell((unsigned char) ptr[i], 1);
+			len += ascii;
+			ptr += ascii;
+			if (ptr == end)
+				break;
+
 			tmp = g_utf8_get_char_validated(ptr, -1);
 			/* On utf8 error, treat as single byte and try to
 			   continue interpreting rest of string as utf8 */
 			if (tmp == (gunichar)-1 || tmp == (gunichar)-2) {
+				term_put_cell(0xfffd, 1);
 				len++;
 				ptr++;
 			} else {
 				len += unichar_isprint(tmp) ? i_wcwidth(tmp) : 1;
+				term_put_unichar(tmp);
 				ptr = g_utf8_next_char(ptr);
 			}
 		}
-	} else
-		len = raw_len;
-
-        term_printed_text(len);
-
-	/* Use strlen() here since we need the number of raw bytes */
-	fwrite(str, 1, raw_len, window->term->out);
+		return len;
+	}
 
-	return len;
+	for (; *ptr != '\0'; ptr++)
+		term_addch(window, *ptr);
+	if (addch_len > 0) {
+		/* incomplete character at the end */
+		term_put_cell((unsigned char) addch_buf[0], 1);
+		addch_len = 0;
+	}
+	return ptr - str;
 }
 
 void term_clrtoeol(TERM_WINDOW *window)
 {
+	int end;
+
 	if (vcx < window->x) {
 		/* we just wrapped outside of the split, warp the cursor back into the window */
 		vcx += window->x;
-		vcmove = TRUE;
 	}
+
 	if (window->x + window->width < term_width) {
 		/* we need to fill a vertical split */
-		if (vcmove) term_move_real();
-		terminfo_repeat(' ', window->x + window->width - vcx + 1);
-		terminfo_move(vcx, vcy);
-		term_lines_empty[vcy] = FALSE;
+		end = MIN(window->x + window->width + 1, term_width);
 	} else {
-		/* clrtoeol() doesn't necessarily understand colors */
-		if (last_fg == -1 && last_bg == -1 &&
-		    (last_attrs & (ATTR_UNDERLINE|ATTR_REVERSE|ATTR_ITALIC)) == 0) {
-			if (!term_lines_empty[vcy]) {
-				if (vcmove) term_move_real();
-				terminfo_clrtoeol();
-				if (vcx == 0) term_lines_empty[vcy] = TRUE;
-			}
-		} else if (vcx < term_width) {
-			/* we'll need to fill the line ourself. */
-			if (vcmove) term_move_real();
-			terminfo_repeat(' ', term_width-vcx);
-			terminfo_move(vcx, vcy);
-			term_lines_empty[vcy] = FALSE;
-		}
+		end = term_width;
+	}
+
+	if (vcx < end) {
+		cells_fill(SCREEN_LINE(screen_back, vcy) + vcx, end - vcx);
+		screen_lines_dirty[vcy] = TRUE;
 	}
 }
 
@@ -628,13 +873,130 @@ void term_move_cursor(int x, int y)
         curs_y = y;
 }
 
+/* Send the cell's character to terminal */
+static void term_emit_cell(const TERM_CELL *cell)
+{
+	char buf[12];
+	int len;
+
+	switch (term_type) {
+	case TERM_TYPE_UTF8:
+		len = g_unichar_to_utf8(cell->chr, buf);
+		if (cell->combining != 0)
+			len += g_unichar_to_utf8(cell->combining, buf + len);
+		fwrite(buf, 1, len, current_term->out);
+		break;
+	case TERM_TYPE_BIG5:
+		if (cell->chr > 0xff)
+			putc((cell->chr >> 8) & 0xff, current_term->out);
+		putc(cell->chr & 0xff, current_term->out);
+		break;
+	default:
+		putc(cell->chr & 0xff, current_term->out);
+		break;
+	}
+}
+
+/* Send cells start..end-1 of the line to terminal */
+static void term_flush_cells(int y, int start, int end)
+{
+	TERM_CELL *back, *front;
+	int x;
+
+	back = SCREEN_LINE(screen_back, y);
+	front = SCREEN_LINE(screen_front, y);
+
+	term_move_real(start, y);
+	for (x = start; x < end; x++) {
+		front[x] = back[x];
+		if (back[x].chr == 0)
+			continue;
+
+		if (back[x].col != emit_col ||
+		    back[x].fgcol24 != emit_fgcol24 ||
+		    back[x].bgcol24 != emit_bgcol24)
+			term_emit_color(back[x].col, back[x].fgcol24, back[x].bgcol24);
+		term_emit_cell(&back[x]);
+		crealx += x + 1 < term_width && back[x + 1].chr == 0 ? 2 : 1;
+	}
+
+	/* past the end of line the cursor position isn't reliable */
+	if (crealx >= term_width)
+		cforcemove = TRUE;
+}
+
+/* Send the changed parts of the line to terminal */
+static void term_flush_line(int y)
+{
+	TERM_CELL *back, *front;
+	int x, end, empty_start, gap;
+
+	back = SCREEN_LINE(screen_back, y);
+	front = SCREEN_LINE(screen_front, y);
+
+	/* the empty end of the line can be cleared with clrtoeol */
+	for (empty_start = term_width; empty_start > 0; empty_start--) {
+		if (!cell_is_empty(&back[empty_start - 1]))
+			break;
+	}
+
+	x = 0;
+	while (x < term_width) {
+		if (cell_equals(&back[x], &front[x])) {
+			x++;
+			continue;
+		}
+
+		if (x >= empty_start) {
+			term_move_real(x, y);
+			term_emit_color(ATTR_RESET, 0, 0);
+			terminfo_clrtoeol();
+			memcpy(front + x, back + x,
+			       (term_width - x) * sizeof(TERM_CELL));
+			break;
+		}
+
+		/* wide characters are always drawn whole */
+		while (x > 0 && (back[x].chr == 0 || front[x].chr == 0))
+			x--;
+
+		for (end = x + 1, gap = 0; end + gap < empty_start && gap < SCREEN_MAX_GAP; ) {
+			if (cell_equals(&back[end + gap], &front[end + gap]))
+				gap++;
+			else {
+				end += gap + 1;
+				gap = 0;
+			}
+		}
+		if (end < term_width && back[end].chr == 0)
+			end++;
+		if (end < term_width && front[end].chr == 0) {
+			/* we overwrite the left half, the terminal removes
+			   the right half */
+			front[end].chr = CELL_UNKNOWN;
+		}
+
+		term_flush_cells(y, x, end);
+		x = end;
+	}
+
+	screen_lines_dirty[y] = FALSE;
+}
+
 void term_refresh(TERM_WINDOW *window)
 {
+	int y;
+
 	if (freeze_counter > 0)
 		return;
 
-	term_move(root_window, curs_x, curs_y);
-	term_move_real();
+	screen_scroll_flush();
+	for (y = 0; y < term_height; y++) {
+		if (screen_lines_dirty[y])
+			term_flush_line(y);
+	}
+
+	term_move_real(MIN(curs_x, term_width-1), MIN(curs_y, term_height-1));
 
 	if (!curs_visible) {
 		terminfo_set_cursor_visible(TRUE);
@@ -642,7 +1004,20 @@ void term_refresh(TERM_WINDOW *window)
 	}
 
 	term_set_color(window, ATTR_RESET);
-	fflush(window != NULL ? window->term->out : current_term->out);
+	fflush(current_term->out);
+}
+
+int term_refresh_pending(void)
+{
+	return scroll_count != 0 || cforcemove || !curs_visible ||
+		MIN(curs_x, term_width-1) != crealx ||
+		MIN(curs_y, term_height-1) != crealy ||
+		memchr(screen_lines_dirty, 1, term_height) != NULL;
+}
+
+unsigned int term_scrolls_coalesced(void)
+{
+	return scroll_coalesced;
 }
 
 void term_refresh_freeze(void)
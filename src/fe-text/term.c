@@ -22,9 +22,12 @@
 #include <irssi/src/core/signals.h>
 #include <irssi/src/core/commands.h>
 #include <irssi/src/core/settings.h>
+#include <irssi/src/core/levels.h>
+#include <irssi/src/fe-common/core/printtext.h>
 
 #include <irssi/src/fe-text/term.h>
 #include <irssi/src/fe-text/mainwindows.h>
+#include <irssi/src/fe-text/module-formats.h>
 
 #ifdef HAVE_SYS_IOCTL_H
 #  include <sys/ioctl.h>
@@ -43,6 +46,12 @@ int term_type;
 static int force_colors;
 static int resize_dirty;
 
+static gint64 render_interval; /* usecs between frames, 0 = no limit */
+static gint64 render_last;
+static int render_immediate;
+static guint render_timeout_tag;
+static unsigned int render_frames, render_skipped;
+
 int term_get_size(int *width, int *height)
 {
 #ifdef TIOCGWINSZ
@@ -94,15 +103,79 @@ static void sig_winch(int p)
 }
 #endif
 
+static int sig_render_timeout(void)
+{
+	/* just wake up the main loop */
+	render_timeout_tag = 0;
+	return FALSE;
+}
+
+int term_render_due(int pending)
+{
+	gint64 wait;
+
+	/* with nothing to draw the refresh costs nothing */
+	if (!pending || render_interval == 0 || render_immediate)
+		return TRUE;
+
+	wait = render_last + render_interval - g_get_monotonic_time();
+	if (wait <= 0)
+		return TRUE;
+
+	/* changes until then are drawn in the same frame */
+	render_skipped++;
+	if (render_timeout_tag == 0) {
+		render_timeout_tag = g_timeout_add((wait + 999) / 1000,
+						   (GSourceFunc) sig_render_timeout,
+						   NULL);
+	}
+	return FALSE;
+}
+
+void term_render_done(int drawn)
+{
+	render_immediate = FALSE;
+	if (render_timeout_tag != 0) {
+		g_source_remove(render_timeout_tag);
+		render_timeout_tag = 0;
+	}
+
+	if (drawn) {
+		render_last = g_get_monotonic_time();
+		render_frames++;
+	}
+}
+
+void term_render_now(void)
+{
+	render_immediate = TRUE;
+}
+
 static void cmd_resize(void)
 {
 	resize_dirty = TRUE;
         term_resize_dirty();
 }
 
-static void cmd_redraw(void)
+/* SYNTAX: REDRAW [-stats] */
+static void cmd_redraw(const char *data)
 {
-	irssi_redraw();
+	GHashTable *optlist;
+	void *free_arg;
+
+	if (!cmd_get_params(data, &free_arg, PARAM_FLAG_OPTIONS,
+			    "redraw", &optlist))
+		return;
+
+	if (g_hash_table_lookup(optlist, "stats") != NULL) {
+		printformat(NULL, NULL, MSGLEVEL_CLIENTCRAP, TXT_RENDER_STATS,
+			    render_frames, render_skipped,
+			    term_scrolls_coalesced());
+	} else {
+		irssi_redraw();
+	}
+
+	cmd_params_free(free_arg);
 }
 
 int term_color256map[] = {
@@ -155,6 +228,9 @@ static void read_settings(void)
 
 	if (term_use_colors != old_colors || term_use_colors24 != old_colors24)
 		irssi_redraw();
+
+	render_interval = settings_get_int("term_max_fps") <= 0 ? 0 :
+		G_USEC_PER_SEC / settings_get_int("term_max_fps");
 }
 
 void term_common_init(void)
@@ -166,6 +242,7 @@ void term_common_init(void)
 	settings_add_bool("lookandfeel", "colors", TRUE);
 	settings_add_bool("lookandfeel", "term_force_colors", FALSE);
         settings_add_bool("lookandfeel", "mirc_blink_fix", FALSE);
+	settings_add_int("lookandfeel", "term_max_fps", 30);
 
 	force_colors = FALSE;
 	term_use_colors = term_has_colors() && settings_get_bool("colors");
@@ -182,6 +259,7 @@ void term_common_init(void)
 	signal_add("setup changed", (SIGNAL_FUNC) read_settings);
 	command_bind("resize", NULL, (SIGNAL_FUNC) cmd_resize);
 	command_bind("redraw", NULL, (SIGNAL_FUNC) cmd_redraw);
+	command_set_options("redraw", "stats");
 
 #ifdef SIGWINCH
 	sigemptyset (&act.sa_mask);
@@ -193,6 +271,10 @@ void term_common_init(void)
 
 void term_common_deinit(void)
 {
+	if (render_timeout_tag != 0)
+		g_source_remove(render_timeout_tag);
+	render_timeout_tag = 0;
+
 	command_unbind("resize", (SIGNAL_FUNC) cmd_resize);
 	command_unbind("redraw", (SIGNAL_FUNC) cmd_redraw);
 	signal_remove("beep", (SIGNAL_FUNC) term_beep);
@@ -88,6 +88,19 @@ void term_move_cursor(int x, int y);
 void term_refresh_freeze(void);
 void term_refresh_thaw(void);
 void term_refresh(TERM_WINDOW *window);
+/* Number of window scrolls sent to the terminal along with an earlier one */
+unsigned int term_scrolls_coalesced(void);
+
+/* Returns TRUE if the screen has changes not yet sent to the terminal */
+int term_refresh_pending(void);
+
+/* Returns TRUE if it's time to draw the next frame. If not, the main loop
+   is woken up when it is. pending tells if there's anything to draw. */
+int term_render_due(int pending);
+/* The frame was drawn, drawn is FALSE if it had nothing to draw */
+void term_render_done(int drawn);
+/* Draw the next frame without waiting, eg. after user input */
+void term_render_now(void);
 
 void term_stop(void);
 
@@ -132,7 +132,7 @@ static void _move_pa(TERM_REC *term, int x, int y)
 /* Move cursor from a known position */
 static void _move_relative(TERM_REC *term, int oldx, int oldy, int x, int y)
 {
-	if (oldx == 0 && x == 0 && y == oldy+1) {
+	if (oldx >= 0 && x == 0 && y == oldy+1) {
 		/* move to beginning of next line -
 		   hope this works everywhere */
 		tput("\r\n");
@@ -151,6 +151,23 @@ static void _move_relative(TERM_REC *term, int oldx, int oldy, int x, int y)
 		}
 	}
 
+	if (oldx >= 0 && oldy >= 0) {
+		/* only one coordinate changes - these are shorter than
+		   the absolute positioning */
+		if (y == oldy && x == 0) {
+			tput("\r");
+			return;
+		}
+		if (y == oldy && term->TI_hpa) {
+			tput(tparm(term->TI_hpa, x, 0, 0, 0, 0, 0, 0, 0, 0));
+			return;
+		}
+		if (x == oldx && term->TI_vpa) {
+			tput(tparm(term->TI_vpa, y, 0, 0, 0, 0, 0, 0, 0, 0));
+			return;
+		}
+	}
+
         /* fallback to absolute positioning */
 	if (term->TI_cup) {
 		tput(tparm(term->TI_cup, y, x, 0, 0, 0, 0, 0, 0, 0));
@@ -181,7 +198,6 @@ static void _scroll_region(TERM_REC *term, int y1, int y2, int count)
 	/* setup the scrolling region to wanted area */
 	scroll_region_setup(term, y1, y2);
 
-	term->tr_move(term, 0, y1);
 	if (count > 0) {
 		term->tr_move(term, 0, y2);
 		tput(tparm(term->TI_indn, count, count, 0, 0, 0, 0, 0, 0, 0));
@@ -332,49 +332,41 @@ static void cmd_scrollback_end(const char *data)
 	gui_window_scroll(active_win, view->bottom_subline);
 }
 
+/* SYNTAX: SCROLLBACK STATUS */
 static void cmd_scrollback_status(void)
 {
 	GSList *tmp;
-        int total_lines;
-	size_t window_mem, total_mem;
+	int total_lines, total_spilled, spilled;
+	size_t window_mem, total_mem, total_disk;
 
-        total_lines = 0; total_mem = 0;
+	total_lines = 0; total_spilled = 0; total_mem = 0; total_disk = 0;
 	for (tmp = windows; tmp != NULL; tmp = tmp->next) {
 		WINDOW_REC *window = tmp->data;
-		int i;
-		LINE_REC *tmp;
 		TEXT_BUFFER_VIEW_REC *view;
 
 		view = WINDOW_GUI(window)->view;
 
 		window_mem = sizeof(TEXT_BUFFER_REC);
 		window_mem += view->buffer->lines_count * sizeof(LINE_REC);
-		for (tmp = view->buffer->cur_line; tmp != NULL; tmp = tmp->prev) {
-			if (tmp->info.text != NULL) {
-				window_mem += sizeof(char) * (strlen(tmp->info.text) + 1);
-			}
-			if (tmp->info.format != NULL) {
-				window_mem += sizeof(TEXT_BUFFER_FORMAT_REC);
-				for (i = 0; i < tmp->info.format->nargs; i++) {
-					if (tmp->info.format->args[i] != NULL) {
-						window_mem +=
-						    sizeof(char) *
-						    (strlen(tmp->info.format->args[i]) + 1);
-					}
-				}
-			}
-		}
+		window_mem += view->buffer->resident_size;
+		spilled = textbuffer_spilled_lines(view->buffer);
+
 		total_lines += view->buffer->lines_count;
-                total_mem += window_mem;
+		total_spilled += spilled;
+		total_mem += window_mem;
+		total_disk += view->buffer->spill_live;
 		printtext(NULL, NULL, MSGLEVEL_CLIENTCRAP,
-			  "Window %d: %d lines, %dkB of data",
+			  "Window %d: %d lines, %dkB of data, "
+			  "%d lines (%dkB) on disk",
 			  window->refnum, view->buffer->lines_count,
-			  (int)(window_mem / 1024));
+			  (int)(window_mem / 1024), spilled,
+			  (int)(view->buffer->spill_live / 1024));
 	}
 
 	printtext(NULL, NULL, MSGLEVEL_CLIENTCRAP,
-		  "Total: %d lines, %dkB of data",
-		  total_lines, (int)(total_mem / 1024));
+		  "Total: %d lines, %dkB of data, %d lines (%dkB) on disk",
+		  total_lines, (int)(total_mem / 1024),
+		  total_spilled, (int)(total_disk / 1024));
 	{
 		char *tmp = i_refstr_table_size_info();
 		if (tmp != NULL)
@@ -382,6 +374,18 @@ static void cmd_scrollback_status(void)
 				  "%s", tmp);
 		g_free(tmp);
 	}
+	for (tmp = servers; tmp != NULL; tmp = tmp->next) {
+		SERVER_REC *server = tmp->data;
+		size_t strings, refs, bytes, unshared_bytes;
+
+		i_refstr_table_stats(server->nick_strings, &strings, &refs, &bytes,
+		                     &unshared_bytes);
+		printtext(NULL, NULL, MSGLEVEL_CLIENTCRAP,
+			  "Server %s: %d nick strings, %d references, "
+			  "%dkB of data (%dkB if unshared)",
+			  server->tag, (int) strings, (int) refs,
+			  (int) (bytes / 1024), (int) (unshared_bytes / 1024));
+	}
 }
 
 /* SYNTAX: SCROLLBACK REDRAW */
@@ -425,8 +425,11 @@ char *textbuffer_line_get_text(TEXT_BUFFER_REC *buffer, LINE_REC *line, gboolean
 		}
 		special_fill_cache(NULL);
 	} else {
-		format_create_dest(&dest, NULL, NULL, line->info.level, buffer->window);
-		text = g_strdup(line->info.text);
+		format_create_dest(&dest, NULL, NULL, line->info.level & ~MSGLEVEL_FORMAT,
+		                   buffer->window);
+		/* the line's text may have been moved to disk */
+		text = line->info.text != NULL ? g_strdup(line->info.text) :
+		                                 textbuffer_spill_get_text(buffer, line);
 	}
 
 	if (raw)
@@ -147,7 +147,16 @@ static void unformat_24bit_line_color(const unsigned char **ptr, int off, int *f
 
 static inline unichar read_unichar(const unsigned char *data, const unsigned char **next, int *width)
 {
-	unichar chr = g_utf8_get_char_validated((const char *) data, -1);
+	unichar chr;
+
+	if (*data >= 0x20 && *data < 0x7f) {
+		/* printable ASCII */
+		*next = data + 1;
+		*width = 1;
+		return *data;
+	}
+
+	chr = g_utf8_get_char_validated((const char *) data, -1);
 
 	if (chr & 0x80000000) {
 		chr = 0xfffd;
@@ -31,6 +31,15 @@
 
 #define TEXT_CHUNK_USABLE_SIZE (LINE_TEXT_CHUNK_SIZE-2-(int)sizeof(char*))
 
+/* don't bother compacting smaller scrollback files */
+#define SPILL_COMPACT_MIN_SIZE (1024*1024)
+/* wait for the lines removed at the same time before compacting */
+#define SPILL_COMPACT_DELAY_MSECS 500
+/* bytes copied at a time when compacting */
+#define SPILL_COMPACT_CHUNK_SIZE (64*1024)
+
+static gsize resident_total;
+
 TEXT_BUFFER_REC *textbuffer_create(WINDOW_REC *window)
 {
 	TEXT_BUFFER_REC *buffer;
@@ -41,6 +50,7 @@ TEXT_BUFFER_REC *textbuffer_create(WINDOW_REC *window)
 	buffer->last_fg = -1;
 	buffer->last_bg = -1;
 	buffer->cur_text = g_string_sized_new(TEXT_CHUNK_USABLE_SIZE);
+	buffer->spill_fd = -1;
 	return buffer;
 }
 
@@ -176,6 +186,8 @@ LINE_REC *textbuffer_insert(TEXT_BUFFER_REC *buffer, LINE_REC *insert_after,
 			line->info.text = g_strdup(buffer->cur_text->str);
 			g_string_truncate(buffer->cur_text, 0);
 		}
+		buffer->resident_size += textbuffer_line_size(line);
+		resident_total += textbuffer_line_size(line);
 
 		buffer->last_fg = -1;
 		buffer->last_bg = -1;
@@ -185,11 +197,346 @@ LINE_REC *textbuffer_insert(TEXT_BUFFER_REC *buffer, LINE_REC *insert_after,
         return line;
 }
 
+gsize textbuffer_line_size(LINE_REC *line)
+{
+	TEXT_BUFFER_FORMAT_REC *format;
+	gsize size;
+	int i;
+
+	size = 0;
+	if (line->info.text != NULL)
+		size += strlen(line->info.text) + 1;
+
+	format = line->info.format;
+	if (format != NULL) {
+		size += sizeof(TEXT_BUFFER_FORMAT_REC);
+		for (i = 0; i < format->nargs; i++) {
+			if (format->args[i] != NULL)
+				size += strlen(format->args[i]) + 1;
+		}
+	}
+	return size;
+}
+
+gsize textbuffer_resident_total(void)
+{
+	return resident_total;
+}
+
+static void resident_size_sub(TEXT_BUFFER_REC *buffer, gsize size)
+{
+	size = MIN(size, buffer->resident_size);
+	buffer->resident_size -= size;
+	resident_total -= size;
+}
+
+int textbuffer_spilled_lines(TEXT_BUFFER_REC *buffer)
+{
+	return buffer->spilled == NULL ? 0 : g_hash_table_size(buffer->spilled);
+}
+
+static int spill_file_open(void)
+{
+	GError *error = NULL;
+	char *path;
+	int fd;
+
+	fd = g_file_open_tmp("irssi-scrollback-XXXXXX", &path, &error);
+	if (fd == -1) {
+		g_warning("Couldn't create scrollback file: %s", error->message);
+		g_error_free(error);
+		return -1;
+	}
+
+	/* nobody else needs to see it, and it's gone when we exit */
+	unlink(path);
+	g_free(path);
+	return fd;
+}
+
+static void spill_file_close(TEXT_BUFFER_REC *buffer)
+{
+	if (buffer->spill_compact_tag != 0) {
+		g_source_remove(buffer->spill_compact_tag);
+		buffer->spill_compact_tag = 0;
+	}
+	if (buffer->spill_fd != -1) {
+		close(buffer->spill_fd);
+		buffer->spill_fd = -1;
+	}
+	if (buffer->spilled != NULL) {
+		g_hash_table_destroy(buffer->spilled);
+		buffer->spilled = NULL;
+	}
+	buffer->spill_size = buffer->spill_live = 0;
+	buffer->spill_next = NULL;
+}
+
+/* Read the length of the record at pos, and the text if text_r isn't NULL.
+   Records are the text's length as guint32 followed by the text. */
+static int spill_read(int fd, gsize pos, guint32 *len_r, char **text_r)
+{
+	char *text;
+
+	if (pread(fd, len_r, sizeof(*len_r), (off_t) pos) != sizeof(*len_r))
+		return FALSE;
+	if (text_r == NULL)
+		return TRUE;
+
+	text = g_malloc(*len_r + 1);
+	if (pread(fd, text, *len_r, (off_t) (pos + sizeof(*len_r))) != (ssize_t) *len_r) {
+		g_free(text);
+		return FALSE;
+	}
+	text[*len_r] = '\0';
+	*text_r = text;
+	return TRUE;
+}
+
+static void spill_append_record(GString *data, const char *text)
+{
+	guint32 len;
+
+	len = strlen(text);
+	g_string_append_len(data, (const char *) &len, sizeof(len));
+	g_string_append_len(data, text, len);
+}
+
+static int spill_write(int fd, gsize pos, GString *data)
+{
+	ssize_t ret;
+	gsize written;
+
+	for (written = 0; written < data->len; written += ret) {
+		ret = pwrite(fd, data->str + written, data->len - written,
+			     (off_t) (pos + written));
+		if (ret <= 0 && errno != EINTR) {
+			g_warning("Couldn't write scrollback file: %s",
+				  g_strerror(errno));
+			return FALSE;
+		}
+		if (ret < 0)
+			ret = 0;
+	}
+	return TRUE;
+}
+
+/* Copy the lines still in the buffer to a new file */
+static void spill_compact(TEXT_BUFFER_REC *buffer)
+{
+	GHashTableIter iter;
+	GString *data;
+	GArray *positions;
+	gpointer value;
+	gsize pos;
+	guint32 len;
+	char *text;
+	int fd, ok;
+
+	fd = spill_file_open();
+	if (fd == -1)
+		return;
+
+	data = g_string_sized_new(SPILL_COMPACT_CHUNK_SIZE);
+	positions = g_array_sized_new(FALSE, FALSE, sizeof(gsize),
+				      g_hash_table_size(buffer->spilled));
+	pos = 0;
+	ok = TRUE;
+
+	g_hash_table_iter_init(&iter, buffer->spilled);
+	while (ok && g_hash_table_iter_next(&iter, NULL, &value)) {
+		ok = spill_read(buffer->spill_fd, GPOINTER_TO_SIZE(value),
+				&len, &text);
+		if (ok) {
+			g_array_append_val(positions, pos);
+			spill_append_record(data, text);
+			pos += sizeof(len) + len;
+			g_free(text);
+		}
+
+		/* only a chunk of the text is kept in memory at a time */
+		if (ok && data->len >= SPILL_COMPACT_CHUNK_SIZE) {
+			ok = spill_write(fd, pos - data->len, data);
+			g_string_truncate(data, 0);
+		}
+	}
+
+	if (ok && spill_write(fd, pos - data->len, data)) {
+		close(buffer->spill_fd);
+		buffer->spill_fd = fd;
+		buffer->spill_size = buffer->spill_live = pos;
+
+		/* the order doesn't change as long as the table isn't */
+		g_hash_table_iter_init(&iter, buffer->spilled);
+		for (len = 0; g_hash_table_iter_next(&iter, NULL, NULL); len++) {
+			g_hash_table_iter_replace(&iter, GSIZE_TO_POINTER(
+				g_array_index(positions, gsize, len)));
+		}
+	} else {
+		close(fd);
+	}
+
+	g_array_free(positions, TRUE);
+	g_string_free(data, TRUE);
+}
+
+static int spill_need_compact(TEXT_BUFFER_REC *buffer)
+{
+	/* most of the file isn't used anymore */
+	return buffer->spill_size >= SPILL_COMPACT_MIN_SIZE &&
+		buffer->spill_live < buffer->spill_size / 2;
+}
+
+static int sig_spill_compact(TEXT_BUFFER_REC *buffer)
+{
+	buffer->spill_compact_tag = 0;
+	if (buffer->spilled != NULL && spill_need_compact(buffer))
+		spill_compact(buffer);
+	return FALSE;
+}
+
+/* The line is being removed, forget its text on disk */
+static void spill_forget(TEXT_BUFFER_REC *buffer, LINE_REC *line, gsize pos)
+{
+	guint32 len;
+
+	g_hash_table_remove(buffer->spilled, line);
+	if (g_hash_table_size(buffer->spilled) == 0) {
+		/* start again from the beginning of the file */
+		if (ftruncate(buffer->spill_fd, 0) == 0)
+			buffer->spill_size = 0;
+		buffer->spill_live = 0;
+		return;
+	}
+
+	if (spill_read(buffer->spill_fd, pos, &len, NULL))
+		buffer->spill_live -= MIN(buffer->spill_live, sizeof(len) + len);
+
+	/* lines are often removed many at a time, compact the file
+	   after them instead of in the middle */
+	if (buffer->spill_compact_tag == 0 && spill_need_compact(buffer)) {
+		buffer->spill_compact_tag =
+			g_timeout_add(SPILL_COMPACT_DELAY_MSECS,
+				      (GSourceFunc) sig_spill_compact, buffer);
+	}
+}
+
+static int line_can_spill(TEXT_BUFFER_REC *buffer, LINE_REC *line)
+{
+	return (line->info.text != NULL || line->info.format != NULL) &&
+		(buffer->spilled == NULL ||
+		 !g_hash_table_contains(buffer->spilled, line));
+}
+
+void textbuffer_spill(TEXT_BUFFER_REC *buffer, gsize max_size)
+{
+	GPtrArray *lines;
+	GString *data;
+	LINE_REC *line, *prev;
+	gsize size;
+	char *text;
+	int i;
+
+	g_return_if_fail(buffer != NULL);
+
+	/* the last line may still be written to */
+	if (buffer->resident_size <= max_size || !buffer->last_eol ||
+	    buffer->spill_failed)
+		return;
+
+	if (buffer->spill_fd == -1) {
+		buffer->spill_fd = spill_file_open();
+		if (buffer->spill_fd == -1) {
+			buffer->spill_failed = TRUE;
+			return;
+		}
+	}
+	if (buffer->spilled == NULL)
+		buffer->spilled = g_hash_table_new(NULL, NULL);
+
+	lines = g_ptr_array_new();
+	data = g_string_new(NULL);
+
+	/* collect the text of the oldest lines and write it in one go */
+	size = buffer->resident_size;
+	prev = NULL;
+	line = buffer->spill_next != NULL ? buffer->spill_next : buffer->first_line;
+	for (; line != NULL && size > max_size; line = line->next) {
+		prev = line;
+		if (!line_can_spill(buffer, line))
+			continue;
+
+		text = textbuffer_line_get_text(buffer, line, TRUE);
+		if (text == NULL)
+			continue;
+
+		g_ptr_array_add(lines, line);
+		g_ptr_array_add(lines, GSIZE_TO_POINTER(buffer->spill_size + data->len));
+		spill_append_record(data, text);
+		size -= MIN(size, textbuffer_line_size(line));
+		g_free(text);
+	}
+	buffer->spill_next = line != NULL ? line : prev;
+
+	if (!spill_write(buffer->spill_fd, buffer->spill_size, data)) {
+		buffer->spill_failed = TRUE;
+		g_ptr_array_free(lines, TRUE);
+		g_string_free(data, TRUE);
+		return;
+	}
+	buffer->spill_size += data->len;
+	buffer->spill_live += data->len;
+
+	for (i = 0; i < lines->len; i += 2) {
+		line = g_ptr_array_index(lines, i);
+		g_hash_table_insert(buffer->spilled, line,
+				    g_ptr_array_index(lines, i + 1));
+
+		resident_size_sub(buffer, textbuffer_line_size(line));
+		textbuffer_format_rec_free(line->info.format);
+		g_free(line->info.text);
+		line->info.format = NULL;
+		line->info.text = NULL;
+	}
+
+	g_ptr_array_free(lines, TRUE);
+	g_string_free(data, TRUE);
+}
+
+char *textbuffer_spill_get_text(TEXT_BUFFER_REC *buffer, LINE_REC *line)
+{
+	gpointer value;
+	guint32 len;
+	char *text;
+
+	g_return_val_if_fail(buffer != NULL, NULL);
+
+	if (buffer->spilled == NULL ||
+	    !g_hash_table_lookup_extended(buffer->spilled, line, NULL, &value))
+		return NULL;
+
+	if (!spill_read(buffer->spill_fd, GPOINTER_TO_SIZE(value), &len, &text)) {
+		g_warning("Couldn't read scrollback file: %s", g_strerror(errno));
+		return NULL;
+	}
+	return text;
+}
+
 void textbuffer_remove(TEXT_BUFFER_REC *buffer, LINE_REC *line)
 {
+	gpointer pos;
+
 	g_return_if_fail(buffer != NULL);
 	g_return_if_fail(line != NULL);
 
+	if (buffer->spilled != NULL &&
+	    g_hash_table_lookup_extended(buffer->spilled, line, NULL, &pos))
+		spill_forget(buffer, line, GPOINTER_TO_SIZE(pos));
+	else
+		resident_size_sub(buffer, textbuffer_line_size(line));
+	if (buffer->spill_next == line)
+		buffer->spill_next = line->next != NULL ? line->next : line->prev;
+
 	if (buffer->first_line == line)
 		buffer->first_line = line->next;
 	if (line->prev != NULL)
@@ -222,6 +569,9 @@ void textbuffer_remove_all_lines(TEXT_BUFFER_REC *buffer)
 		buffer->first_line = line;
 	}
 	buffer->lines_count = 0;
+	resident_size_sub(buffer, buffer->resident_size);
+	spill_file_close(buffer);
+	buffer->spill_failed = FALSE;
 
         buffer->cur_line = NULL;
 	g_string_truncate(buffer->cur_text, 0);
@@ -66,6 +66,18 @@ typedef struct {
 	int last_bg;
 	int last_flags;
 	unsigned int last_eol:1;
+	unsigned int spill_failed:1;
+
+	/* bytes used by the text of the lines kept in memory */
+	gsize resident_size;
+
+	/* text of the old lines moved to an unlinked temporary file */
+	int spill_fd;
+	gsize spill_size; /* bytes written to the file */
+	gsize spill_live; /* bytes of it used by lines still in the buffer */
+	GHashTable *spilled; /* LINE_REC : position in the file */
+	LINE_REC *spill_next; /* where to continue spilling from */
+	int spill_compact_tag; /* timeout that compacts the file */
 } TEXT_BUFFER_REC;
 
 /* Create new buffer */
@@ -90,6 +102,16 @@ LINE_REC *textbuffer_insert(TEXT_BUFFER_REC *buffer, LINE_REC *insert_after,
 			    LINE_INFO_REC *info);
 
 void textbuffer_remove(TEXT_BUFFER_REC *buffer, LINE_REC *line);
+/* Move the text of the oldest lines to disk until no more than max_size
+   bytes of text are left in memory */
+void textbuffer_spill(TEXT_BUFFER_REC *buffer, gsize max_size);
+/* Returns the text of a line moved to disk, or NULL */
+char *textbuffer_spill_get_text(TEXT_BUFFER_REC *buffer, LINE_REC *line);
+int textbuffer_spilled_lines(TEXT_BUFFER_REC *buffer);
+/* Bytes used by the text of the line */
+gsize textbuffer_line_size(LINE_REC *line);
+/* Bytes used by the text kept in memory in all buffers */
+gsize textbuffer_resident_total(void);
 /* Removes all lines from buffer, ignoring reference counters */
 void textbuffer_remove_all_lines(TEXT_BUFFER_REC *buffer);
 void textbuffer_line_info_free1(LINE_INFO_REC *info);
@@ -127,7 +127,7 @@ void ban_set(IRC_CHANNEL_REC *channel, const char *bans, int ban_type)
 void ban_remove(IRC_CHANNEL_REC *channel, const char *bans)
 {
 	GString *str;
-	GSList *tmp;
+	GSList *list, *tmp;
 	BAN_REC *rec;
 	char **ban, **banlist;
         int found;
@@ -135,10 +135,11 @@ void ban_remove(IRC_CHANNEL_REC *channel, const char *bans)
 	g_return_if_fail(bans != NULL);
 
 	str = g_string_new(NULL);
+	list = mode_list_get_entries(channel->banlist);
 	banlist = g_strsplit(bans, " ", -1);
 	for (ban = banlist; *ban != NULL; ban++) {
                 found = FALSE;
-		for (tmp = channel->banlist; tmp != NULL; tmp = tmp->next) {
+		for (tmp = list; tmp != NULL; tmp = tmp->next) {
 			rec = tmp->data;
 
 			if (match_wildcards(*ban, rec->ban)) {
@@ -151,13 +152,11 @@ void ban_remove(IRC_CHANNEL_REC *channel, const char *bans)
 			rec = NULL;
 			if (!g_ascii_strcasecmp(*ban, BAN_LAST)) {
 				/* unnbanning last set ban */
-				rec = g_slist_nth_data(channel->banlist,
-							g_slist_length(channel->banlist) - 1);
+				rec = mode_list_nth(channel->banlist, -1);
 			}
 			else if (is_numeric(*ban, '\0')) {
 				/* unbanning with ban# */
-				rec = g_slist_nth_data(channel->banlist,
-							atoi(*ban)-1);
+				rec = mode_list_nth(channel->banlist, atoi(*ban));
 			}
 			if (rec != NULL)
 				g_string_append_printf(str, "%s ", rec->ban);
@@ -166,6 +165,7 @@ void ban_remove(IRC_CHANNEL_REC *channel, const char *bans)
 		}
 	}
 	g_strfreev(banlist);
+	g_slist_free(list);
 
 	if (str->len > 0)
 		channel_set_singlemode(channel, str->str, "-b");
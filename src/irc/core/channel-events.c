@@ -277,10 +277,8 @@ static void event_join(IRC_SERVER_REC *server, const char *data, const char *nic
 	}
 
 	chanrec->joined = TRUE;
-	if (g_strcmp0(chanrec->name, channel) != 0) {
-                g_free(chanrec->name);
-		chanrec->name = g_strdup(channel);
-	}
+	if (g_strcmp0(chanrec->name, channel) != 0)
+		channel_change_name(CHANNEL(chanrec), channel);
 
 	g_free(shortchan);
 	g_free(params);
@@ -48,6 +48,7 @@ loop:
 #include <irssi/src/core/nicklist.h>
 #include <irssi/src/irc/core/irc-servers.h>
 #include <irssi/src/irc/core/irc-channels.h>
+#include <irssi/src/irc/core/latency.h>
 #include <irssi/src/irc/core/servers-redirect.h>
 
 /* here are the WHOX commands we send. the full spec can be found on [1].
@@ -437,6 +438,7 @@ void irc_channels_query_purge_accountquery(IRC_SERVER_REC *server, const char *n
 
 				/* remove the command */
 				g_slist_free_1(tmp);
+				irc_latency_dequeued(server, cmd, FALSE);
 				g_free(cmd);
 
 				server->cmdcount--;
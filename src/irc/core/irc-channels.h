@@ -29,7 +29,9 @@ enum {
 struct _IRC_CHANNEL_REC {
 #include <irssi/src/core/channel-rec.h>
 
-	GSList *banlist; /* list of bans */
+	struct _MODE_LIST_REC *banlist; /* list of bans */
+	struct _MODE_LIST_REC *exceptlist; /* list of ban exceptions */
+	struct _MODE_LIST_REC *invitelist; /* list of invite exceptions */
 
 	time_t massjoin_start; /* Massjoin start time */
 	int massjoins; /* Number of nicks waiting for massjoin signal.. */
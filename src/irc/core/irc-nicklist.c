@@ -102,9 +102,8 @@ static void event_names_list(IRC_SERVER_REC *server, const char *data)
 	IRC_CHANNEL_REC *chanrec;
 	NICK_REC *rec;
 	char *params, *type, *channel, *names, *ptr, *host;
-        int op, halfop, voice;
+        int op, halfop, voice, op_rank, rank;
 	char prefixes[MAX_USER_PREFIXES+1];
-	const char *nick_flags, *nick_flag_cur, *nick_flag_op;
 
 	g_return_if_fail(data != NULL);
 
@@ -116,8 +115,7 @@ static void event_names_list(IRC_SERVER_REC *server, const char *data)
 		g_free(params);
 		return;
 	}
-	nick_flags = server->get_nick_flags(SERVER(server));
-	nick_flag_op = strchr(nick_flags, '@');
+	op_rank = GET_PREFIX_RANK(server, '@');
 
 	/* type = '=' = public, '*' = private, '@' = secret.
 
@@ -163,8 +161,8 @@ static void event_names_list(IRC_SERVER_REC *server, const char *data)
 				/* If this flag is listed higher than op (in the
 				 * isupport PREFIX reply), then count this user
 				 * as an op. */
-				nick_flag_cur = strchr(nick_flags, *ptr);
-				if (nick_flag_cur && nick_flag_op && nick_flag_cur < nick_flag_op) {
+				rank = GET_PREFIX_RANK(server, *ptr);
+				if (rank != 0 && op_rank != 0 && rank < op_rank) {
 					op = TRUE;
 				}
 				break;
@@ -239,7 +237,7 @@ static void fill_who(SERVER_REC *server, const char *channel, const char *user,
                         g_free(str);
 		}
 		if (nickrec->realname == NULL) {
-			nickrec->realname = g_strdup(realname);
+			nicklist_set_realname(chanrec, nickrec, realname);
 		}
 		if (nickrec->account == NULL && account != NULL) {
 			nicklist_set_account(chanrec, nickrec,
@@ -342,7 +340,7 @@ static void event_whois(IRC_SERVER_REC *server, const char *data)
 		rec = tmp->next->data;
 
 		if (rec->realname == NULL)
-			rec->realname = g_strdup(realname);
+			nicklist_set_realname(CHANNEL(tmp->data), rec, realname);
 	}
 	g_slist_free(nicks);
 
@@ -553,8 +551,7 @@ static void event_setname(SERVER_REC *server, const char *data, const char *nick
 	for (tmp = nicks; tmp != NULL; tmp = tmp->next->next) {
 		rec = tmp->next->data;
 
-		g_free(rec->realname);
-		rec->realname = g_strdup(data);
+		nicklist_set_realname(CHANNEL(tmp->data), rec, data);
 	}
 	g_slist_free(nicks);
 }
@@ -34,6 +34,7 @@
 #include <irssi/src/irc/core/irc-servers-setup.h>
 #include <irssi/src/irc/core/irc-servers.h>
 #include <irssi/src/irc/core/irc-cap.h>
+#include <irssi/src/irc/core/latency.h>
 #include <irssi/src/irc/core/sasl.h>
 
 #include <irssi/src/core/channels-setup.h>
@@ -468,6 +469,7 @@ SERVER_REC *irc_server_init_connect(SERVER_CONNECT_REC *conn)
 	modes_server_init(server);
 
 	server->isupport = g_hash_table_new((GHashFunc) i_istr_hash, (GCompareFunc) i_istr_equal);
+	server->latency = irc_latency_create();
 
 	server->isnickflag = isnickflag_func;
 	server->ischannel = ischannel_func;
@@ -556,6 +558,7 @@ void irc_server_purge_output(IRC_SERVER_REC *server, const char *target)
                         /* remove the command */
 			server->cmdqueue =
 				g_slist_remove(server->cmdqueue, cmd);
+			irc_latency_dequeued(server, cmd, FALSE);
                         g_free(cmd);
                         server->cmdcount--;
 		}
@@ -568,6 +571,7 @@ static void sig_connected(IRC_SERVER_REC *server)
 		return;
 
 	server->splits = g_hash_table_new((GHashFunc) i_istr_hash, (GCompareFunc) i_istr_equal);
+	server->split_queue = g_sequence_new(NULL);
 
 	if (!server->session_reconnect)
 		server_init_1(server);
@@ -605,6 +609,11 @@ static void sig_destroyed(IRC_SERVER_REC *server)
 	g_slist_free(server->cmdqueue);
 	server->cmdqueue = NULL;
 
+	if (server->latency != NULL) {
+		irc_latency_destroy(server->latency);
+		server->latency = NULL;
+	}
+
 	i_slist_free_full(server->cap_active, (GDestroyNotify) g_free);
 	server->cap_active = NULL;
 
@@ -785,6 +794,7 @@ static int server_cmd_timeout(IRC_SERVER_REC *server, gint64 now)
 
 	/* remove from queue */
 	server->cmdqueue = g_slist_remove(server->cmdqueue, cmd);
+	irc_latency_dequeued(server, cmd, TRUE);
 	g_free(cmd);
 
         link = server->cmdqueue;
@@ -958,7 +968,7 @@ static void parse_chanmodes(IRC_SERVER_REC *server, const char *sptr)
 	for (i = 0, item = chanmodes; *item != NULL && i < 4; item++, i++) {
 		unsigned char *p = (unsigned char*) *item;
 		while (*p != '\0') {
-			server->modes[(int)*p].func = modefuncs[i];
+			modes_server_set_type(server, *p, modefuncs[i]);
 			p++;
 		}
 	}
@@ -969,6 +979,7 @@ static void parse_chanmodes(IRC_SERVER_REC *server, const char *sptr)
 static void parse_prefix(IRC_SERVER_REC *server, const char *sptr)
 {
 	const char *eptr;
+	int rank;
 
 	if (*sptr++ != '(')
 		return; /* Unknown prefix format */
@@ -978,10 +989,11 @@ static void parse_prefix(IRC_SERVER_REC *server, const char *sptr)
 		return;
 
 	eptr++;
+	rank = 1;
 	while (*sptr != '\0' && *eptr != '\0' && *sptr != ')' && *eptr != ' ') {
-		server->modes[(int)(unsigned char) *sptr].func =
-			modes_type_prefix;
+		modes_server_set_type(server, *sptr, modes_type_prefix);
 		server->modes[(int)(unsigned char) *sptr].prefix = *eptr;
+		server->modes[(int)(unsigned char) *sptr].rank = rank++;
 		server->prefix[(int)(unsigned char) *eptr] = *sptr;
 		sptr++; eptr++;
 	}
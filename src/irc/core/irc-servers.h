@@ -77,6 +77,10 @@ struct _IRC_SERVER_REC {
         GSList *redirect_queue; /* should be updated from redirect_next each time cmdqueue is updated */
         REDIRECT_REC *redirect_next;
 	GSList *redirect_active; /* redirects start event has been received for, must have unique prefix */
+	GHashTable *redirect_events; /* signal id : number of queued redirects waiting for it */
+	int redirects_destroyed; /* number of finished redirects still in `redirects' */
+
+	struct _IRC_LATENCY_REC *latency; /* latency histograms */
 
         char *last_nick; /* last /NICK, kept even if it resulted as not valid change */
 
@@ -138,6 +142,7 @@ struct _IRC_SERVER_REC {
 
 	GHashTable *splits; /* For keeping track of netsplits */
 	GSList *split_servers; /* Servers that are currently in split */
+	GSequence *split_queue; /* NETSPLIT_SERVER_RECs ordered by their destroy time */
 
 	GSList *rejoin_channels; /* try to join to these channels after a while -
 	                            channels go here if they're "temporarily unavailable"
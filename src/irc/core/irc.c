@@ -28,6 +28,7 @@
 
 #include <irssi/src/irc/core/irc-channels.h>
 #include <irssi/src/irc/core/irc-servers.h>
+#include <irssi/src/irc/core/latency.h>
 #include <irssi/src/irc/core/servers-redirect.h>
 
 char *current_server_event;
@@ -36,6 +37,11 @@ static int signal_server_event;
 static int signal_server_event_tags;
 static int signal_server_incoming;
 
+/* the last line handled by irc_server_event() */
+static IRC_SERVER_REC *last_event_server;
+static const char *last_event_line, *last_event_args;
+static char *last_event;
+
 #ifdef BLOCKING_SOCKETS
 #  define MAX_SOCKET_READS 1
 #else
@@ -50,6 +56,7 @@ static void strip_params_colon(char *const);
 void irc_send_cmd_full(IRC_SERVER_REC *server, const char *cmd, int irc_send_when, int raw)
 {
 	GString *str;
+	char *queued;
 	int len;
 	guint pos;
 	gboolean server_supports_tag;
@@ -123,15 +130,21 @@ void irc_send_cmd_full(IRC_SERVER_REC *server, const char *cmd, int irc_send_whe
 		g_string_free(str, TRUE);
 	} else if (irc_send_when == IRC_SEND_NEXT) {
 		/* add to queue */
+		queued = g_string_free(str, FALSE);
 		server->cmdqueue = g_slist_prepend(server->cmdqueue, server->redirect_next);
-		server->cmdqueue = g_slist_prepend(server->cmdqueue, g_string_free(str, FALSE));
+		server->cmdqueue = g_slist_prepend(server->cmdqueue, queued);
+		irc_latency_queued(server, queued);
 	} else if (irc_send_when == IRC_SEND_NORMAL) {
+		queued = g_string_free(str, FALSE);
 		server->cmdqueue = g_slist_insert(server->cmdqueue, server->redirect_next, pos);
-		server->cmdqueue = g_slist_insert(server->cmdqueue, g_string_free(str, FALSE), pos);
+		server->cmdqueue = g_slist_insert(server->cmdqueue, queued, pos);
+		irc_latency_queued(server, queued);
 	} else if (irc_send_when == IRC_SEND_LATER) {
-		server->cmdqueue = g_slist_append(server->cmdqueue, g_string_free(str, FALSE));
+		queued = g_string_free(str, FALSE);
+		server->cmdqueue = g_slist_append(server->cmdqueue, queued);
 		server->cmdqueue = g_slist_append(server->cmdqueue, server->redirect_next);
 		server->cmdlater++;
+		irc_latency_queued(server, queued);
 	} else {
 		g_warn_if_reached();
 	}
@@ -370,6 +383,8 @@ static void irc_server_event(IRC_SERVER_REC *server, const char *line,
 
 	g_return_if_fail(line != NULL);
 
+	last_event_line = NULL;
+
 	/* split event / args */
 	event = g_strconcat("event ", line, NULL);
 	args = strchr(event+6, ' ');
@@ -390,7 +405,23 @@ static void irc_server_event(IRC_SERVER_REC *server, const char *line,
 		signal_emit_id(signal_default_event, 4, server, line, nick, address);
 	current_server_event = NULL;
 
-	g_free(event);
+	/* keep the parsed event for the later "server event" handlers */
+	g_free(last_event);
+	last_event = event;
+	last_event_server = server;
+	last_event_line = line;
+	last_event_args = args;
+}
+
+const char *irc_server_event_get(IRC_SERVER_REC *server, const char *line,
+				 const char **args)
+{
+	if (last_event == NULL || server != last_event_server ||
+	    line != last_event_line)
+		return NULL;
+
+	*args = last_event_args;
+	return last_event;
 }
 
 static void unescape_tag(char *tag)
@@ -543,11 +574,14 @@ static void irc_parse_incoming_line(IRC_SERVER_REC *server, char *line)
 static void irc_parse_incoming(SERVER_REC *server)
 {
 	char *str;
+	gint64 readable;
 	int count;
 	int ret;
 
 	g_return_if_fail(server != NULL);
 
+	readable = g_get_monotonic_time();
+
 	/* Some commands can send huge replies and irssi might handle them
 	   too slowly, so read only a few times from the socket before
 	   letting other tasks to run. */
@@ -558,6 +592,9 @@ static void irc_parse_incoming(SERVER_REC *server)
 	       (ret = net_sendbuffer_receive_line(server->handle, &str, count < MAX_SOCKET_READS)) > 0) {
 		rawlog_input(server->rawlog, str);
 		signal_emit_id(signal_server_incoming, 2, server, str);
+		/* only IRC servers are read here */
+		irc_latency_add((IRC_SERVER_REC *) server, LATENCY_DISPATCH,
+				g_get_monotonic_time() - readable);
 
 		if (server->connection_lost)
 			server_disconnect(server);
@@ -605,4 +642,8 @@ void irc_irc_deinit(void)
 	signal_remove("server connected", (SIGNAL_FUNC) irc_init_server);
 	signal_remove("server connection switched", (SIGNAL_FUNC) irc_init_server);
 	signal_remove("server incoming", (SIGNAL_FUNC) irc_parse_incoming_line);
+
+	g_free(last_event);
+	last_event = NULL;
+	last_event_line = NULL;
 }
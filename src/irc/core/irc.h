@@ -59,6 +59,12 @@ void irc_send_cmd_full(IRC_SERVER_REC *server, const char *cmd, int irc_send_whe
 /* Extract a tag value from tags */
 GHashTable *irc_parse_message_tags(const char *tags);
 
+/* Returns the lowercased "event <name>" that was parsed from `line' when
+   it was handled by "server event", and sets `args' to its arguments.
+   Returns NULL if `line' isn't the last line that was handled. */
+const char *irc_server_event_get(IRC_SERVER_REC *server, const char *line,
+				 const char **args);
+
 /* Get count parameters from data */
 #include <irssi/src/core/commands.h>
 char *event_get_param(char **data);
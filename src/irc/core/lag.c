@@ -24,6 +24,7 @@
 #include <irssi/src/core/settings.h>
 
 #include <irssi/src/irc/core/irc-servers.h>
+#include <irssi/src/irc/core/latency.h>
 #include <irssi/src/irc/core/servers-redirect.h>
 
 static int timeout_tag;
@@ -32,6 +33,7 @@ static void lag_get(IRC_SERVER_REC *server)
 {
 	server->lag_sent = g_get_real_time();
 	server->lag_last_check = time(NULL);
+	server->latency->ping_sent = g_get_monotonic_time();
 
 	server_redirect_event(server, "ping", 1, NULL, FALSE,
 			      "lag ping error",
@@ -48,7 +50,7 @@ static void lag_ping_error(IRC_SERVER_REC *server)
 static void lag_event_pong(IRC_SERVER_REC *server, const char *data,
 			   const char *nick, const char *addr)
 {
-	gint64 now;
+	gint64 rtt;
 
 	g_return_if_fail(data != NULL);
 
@@ -57,9 +59,12 @@ static void lag_event_pong(IRC_SERVER_REC *server, const char *data,
 		return;
 	}
 
-	now = g_get_real_time();
-	server->lag = (now - server->lag_sent) / G_TIME_SPAN_MILLISECOND;
+	rtt = g_get_monotonic_time() - server->latency->ping_sent;
+	irc_latency_add(server, LATENCY_PING, rtt);
+
+	server->lag = rtt / G_TIME_SPAN_MILLISECOND;
 	server->lag_sent = 0;
+	server->latency->ping_sent = 0;
 
 	signal_emit("server lag", 1, server);
 }
@@ -77,6 +82,7 @@ static void sig_unknown_command(IRC_SERVER_REC *server, const char *data)
 		   servers. */
 		server->disable_lag = TRUE;
 		server->lag_sent = 0;
+		server->latency->ping_sent = 0;
 		server->lag = 0;
 	}
 	g_free(params);
@@ -0,0 +1,186 @@
+/*
+ latency.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "module.h"
+
+#include <irssi/src/irc/core/irc-servers.h>
+#include <irssi/src/irc/core/latency.h>
+
+#define LATENCY_MAX_VALUE ((G_GINT64_CONSTANT(1) << LATENCY_MAX_BITS) - 1)
+
+static const char *latency_types[] = {
+	"ping", "dispatch", "queue", NULL
+};
+
+const char *latency_type_name(int type)
+{
+	g_return_val_if_fail(type >= 0 && type < LATENCY_TYPES, NULL);
+
+	return latency_types[type];
+}
+
+int latency_type_find(const char *name)
+{
+	int type;
+
+	for (type = 0; type < LATENCY_TYPES; type++) {
+		if (g_ascii_strcasecmp(latency_types[type], name) == 0)
+			return type;
+	}
+
+	return -1;
+}
+
+static int latency_bucket(gint64 value)
+{
+	int bit;
+
+	if (value < LATENCY_SUB_BUCKETS)
+		return (int) value;
+
+	/* the highest bit selects the power of two, the next
+	   LATENCY_SUB_BITS bits the bucket inside it */
+	if ((value >> 32) != 0)
+		bit = 32 + g_bit_nth_msf((gulong) (value >> 32), -1);
+	else
+		bit = g_bit_nth_msf((gulong) value, -1);
+	return (bit - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS +
+		(int) ((value >> (bit - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+/* Returns the smallest value that goes to the bucket */
+static gint64 latency_bucket_value(int bucket)
+{
+	int group;
+
+	if (bucket < LATENCY_SUB_BUCKETS)
+		return bucket;
+
+	group = bucket / LATENCY_SUB_BUCKETS;
+	return (gint64) (LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << (group - 1);
+}
+
+void latency_histogram_add(LATENCY_HISTOGRAM_REC *hist, gint64 usecs)
+{
+	g_return_if_fail(hist != NULL);
+
+	if (usecs < 0)
+		usecs = 0;
+	else if (usecs > LATENCY_MAX_VALUE)
+		usecs = LATENCY_MAX_VALUE;
+
+	if (hist->count == 0 || usecs < hist->min)
+		hist->min = usecs;
+	if (usecs > hist->max)
+		hist->max = usecs;
+	hist->sum += usecs;
+	hist->count++;
+	hist->buckets[latency_bucket(usecs)]++;
+}
+
+gint64 latency_histogram_percentile(LATENCY_HISTOGRAM_REC *hist, double percent)
+{
+	guint64 wanted, count;
+	gint64 value;
+	int bucket;
+
+	g_return_val_if_fail(hist != NULL, 0);
+
+	if (hist->count == 0)
+		return 0;
+
+	wanted = (guint64) (hist->count * percent / 100.0 + 0.5);
+	if (wanted < 1)
+		wanted = 1;
+
+	count = 0;
+	for (bucket = 0; bucket < LATENCY_BUCKETS - 1; bucket++) {
+		count += hist->buckets[bucket];
+		if (count >= wanted)
+			break;
+	}
+
+	/* use the highest value of the bucket, but within min..max */
+	value = latency_bucket_value(bucket + 1) - 1;
+	return CLAMP(value, hist->min, hist->max);
+}
+
+IRC_LATENCY_REC *irc_latency_create(void)
+{
+	IRC_LATENCY_REC *rec;
+
+	rec = g_new0(IRC_LATENCY_REC, 1);
+	rec->queued = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+	return rec;
+}
+
+void irc_latency_destroy(IRC_LATENCY_REC *rec)
+{
+	g_return_if_fail(rec != NULL);
+
+	g_hash_table_destroy(rec->queued);
+	g_free(rec);
+}
+
+void irc_latency_clear(IRC_SERVER_REC *server)
+{
+	g_return_if_fail(IS_IRC_SERVER(server));
+
+	memset(server->latency->histograms, 0,
+	       sizeof(server->latency->histograms));
+}
+
+void irc_latency_add(IRC_SERVER_REC *server, int type, gint64 usecs)
+{
+	g_return_if_fail(type >= 0 && type < LATENCY_TYPES);
+
+	if (server->latency != NULL)
+		latency_histogram_add(&server->latency->histograms[type], usecs);
+}
+
+void irc_latency_queued(IRC_SERVER_REC *server, const char *cmd)
+{
+	gint64 *queued;
+
+	if (server->latency == NULL)
+		return;
+
+	queued = g_new(gint64, 1);
+	*queued = g_get_monotonic_time();
+	g_hash_table_insert(server->latency->queued, (char *) cmd, queued);
+}
+
+void irc_latency_dequeued(IRC_SERVER_REC *server, const char *cmd, int sent)
+{
+	gint64 *queued;
+
+	if (server->latency == NULL)
+		return;
+
+	queued = g_hash_table_lookup(server->latency->queued, cmd);
+	if (queued == NULL)
+		return;
+
+	if (sent) {
+		latency_histogram_add(&server->latency->histograms[LATENCY_QUEUE],
+				      g_get_monotonic_time() - *queued);
+	}
+	g_hash_table_remove(server->latency->queued, cmd);
+}
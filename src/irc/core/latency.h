@@ -0,0 +1,58 @@
+#ifndef IRSSI_IRC_CORE_LATENCY_H
+#define IRSSI_IRC_CORE_LATENCY_H
+
+#include <irssi/src/irc/core/irc.h>
+
+/* Latency histograms with log-linear buckets like HdrHistogram: each power
+   of two is split to LATENCY_SUB_BUCKETS buckets, so the recorded values
+   are accurate within 1/LATENCY_SUB_BUCKETS. Values are in microseconds,
+   measured with the monotonic clock. */
+#define LATENCY_SUB_BITS 3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+/* values up to 2^36 usecs (19 hours), larger ones go to the last bucket */
+#define LATENCY_MAX_BITS 36
+#define LATENCY_BUCKETS ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+enum {
+	LATENCY_PING, /* PING round trip */
+	LATENCY_DISPATCH, /* from socket readable until the line is handled */
+	LATENCY_QUEUE, /* time spent in the outgoing command queue */
+
+	LATENCY_TYPES
+};
+
+typedef struct {
+	guint64 count;
+	gint64 min, max, sum;
+	guint32 buckets[LATENCY_BUCKETS];
+} LATENCY_HISTOGRAM_REC;
+
+typedef struct _IRC_LATENCY_REC {
+	LATENCY_HISTOGRAM_REC histograms[LATENCY_TYPES];
+
+	gint64 ping_sent; /* 0 or when the lag PING was sent */
+	GHashTable *queued; /* command in server->cmdqueue : gint64 *queued */
+} IRC_LATENCY_REC;
+
+/* Returns "ping", "dispatch" or "queue" */
+const char *latency_type_name(int type);
+/* Returns the type for name, or -1 if not found */
+int latency_type_find(const char *name);
+
+void latency_histogram_add(LATENCY_HISTOGRAM_REC *hist, gint64 usecs);
+/* Returns the value below which `percent' of the recorded values are */
+gint64 latency_histogram_percentile(LATENCY_HISTOGRAM_REC *hist, double percent);
+
+IRC_LATENCY_REC *irc_latency_create(void);
+void irc_latency_destroy(IRC_LATENCY_REC *rec);
+void irc_latency_clear(IRC_SERVER_REC *server);
+
+void irc_latency_add(IRC_SERVER_REC *server, int type, gint64 usecs);
+
+/* Command was added to server->cmdqueue */
+void irc_latency_queued(IRC_SERVER_REC *server, const char *cmd);
+/* Command was removed from server->cmdqueue. If it was sent, the time it
+   was in the queue is recorded. */
+void irc_latency_dequeued(IRC_SERVER_REC *server, const char *cmd, int sent);
+
+#endif
@@ -104,7 +104,8 @@ static void event_join(IRC_SERVER_REC *server, const char *data,
 
 			if (rec->realname != NULL) {
 				nickrec->last_check = rec->last_check;
-				nickrec->realname = g_strdup(rec->realname);
+				nicklist_set_realname(CHANNEL(chanrec), nickrec,
+						      rec->realname);
 				nickrec->gone = rec->gone;
 				nickrec->serverop = rec->serverop;
 				break;
@@ -113,10 +114,8 @@ static void event_join(IRC_SERVER_REC *server, const char *data,
 		g_slist_free(nicks);
 	}
 
-	if (*realname != '\0' && g_strcmp0(nickrec->realname, realname) != 0) {
-		g_free(nickrec->realname);
-		nickrec->realname = g_strdup(realname);
-	}
+	if (*realname != '\0' && g_strcmp0(nickrec->realname, realname) != 0)
+		nicklist_set_realname(CHANNEL(chanrec), nickrec, realname);
 
 	if (send_massjoin) {
 		chanrec->massjoins++;
@@ -26,50 +26,279 @@
 #include <irssi/src/irc/core/irc-channels.h>
 #include <irssi/src/irc/core/mode-lists.h>
 
-static void ban_free(GSList **list, BAN_REC *rec)
+static void ban_free(BAN_REC *rec)
 {
-	g_return_if_fail(list != NULL);
 	g_return_if_fail(rec != NULL);
 
-	*list = g_slist_remove(*list, rec);
-
 	g_free(rec->ban);
 	g_free_not_null(rec->setby);
 	g_free(rec);
 }
 
-void banlist_free(GSList *banlist)
+static MODE_LIST_REC *mode_list_create(void)
 {
-	while (banlist != NULL)
-		ban_free(&banlist, banlist->data);
+	MODE_LIST_REC *list;
+
+	list = g_new0(MODE_LIST_REC, 1);
+	list->entries = g_sequence_new((GDestroyNotify) ban_free);
+	list->masks = g_hash_table_new((GHashFunc) i_istr_hash,
+				       (GCompareFunc) i_istr_equal);
+	list->hosts = g_hash_table_new_full((GHashFunc) i_istr_hash,
+					    (GCompareFunc) i_istr_equal,
+					    (GDestroyNotify) g_free, NULL);
+	list->nicks = g_hash_table_new_full((GHashFunc) i_istr_hash,
+					    (GCompareFunc) i_istr_equal,
+					    (GDestroyNotify) g_free, NULL);
+	list->others = g_hash_table_new(NULL, NULL);
+	return list;
 }
 
-BAN_REC *banlist_find(GSList *list, const char *ban)
+static void index_bucket_free(void *key, GSList *list)
 {
-	GSList *tmp;
+	g_slist_free(list);
+}
 
-	g_return_val_if_fail(ban != NULL, NULL);
+static void mode_list_destroy(MODE_LIST_REC *list)
+{
+	if (list == NULL)
+		return;
+
+	g_hash_table_foreach(list->hosts, (GHFunc) index_bucket_free, NULL);
+	g_hash_table_foreach(list->nicks, (GHFunc) index_bucket_free, NULL);
+	g_hash_table_destroy(list->hosts);
+	g_hash_table_destroy(list->nicks);
+	g_hash_table_destroy(list->others);
+	g_hash_table_destroy(list->masks);
+	g_sequence_free(list->entries);
+	g_free(list);
+}
+
+/* the index keys are compared case-insensitively, which doesn't know about
+   the server's casemapping. masks with these characters are always matched
+   one by one. */
+static int has_wildcards(const char *str, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (strchr("*?[]\\{}|^~", str[i]) != NULL)
+			return TRUE;
+	}
+	return FALSE;
+}
 
-	for (tmp = list; tmp != NULL; tmp = tmp->next) {
-		BAN_REC *rec = tmp->data;
+/* Find where the mask should be indexed. Returns the hash table and
+   allocated key, or NULL if the mask has to be checked one by one. */
+static GHashTable *mode_list_get_index(MODE_LIST_REC *list, const char *mask,
+				       char **key)
+{
+	const char *user, *host, *tail, *p;
+
+	*key = NULL;
+	user = strchr(mask, '!');
+	host = user == NULL ? NULL : strrchr(user, '@');
+	if (host == NULL || *mask == '$' || *mask == '~')
+		return NULL;
+	host++;
+
+	if (*host != '\0' && !has_wildcards(host, strlen(host))) {
+		/* nick!user@some.host */
+		*key = g_strdup(host);
+		return list->hosts;
+	}
 
-		if (g_ascii_strcasecmp(rec->ban, ban) == 0)
-			return rec;
+	/* index *.some.host by the ".some.host" suffix, which has to be
+	   found in all matching hosts */
+	tail = host + strlen(host);
+	while (tail > host && tail[-1] != '*' && tail[-1] != '?')
+		tail--;
+	p = strchr(tail, '.');
+	if (p != NULL && p[1] != '\0' && !has_wildcards(p, strlen(p))) {
+		*key = g_strdup(p);
+		return list->hosts;
+	}
+
+	if (user > mask && !has_wildcards(mask, (int) (user - mask))) {
+		/* nick!*@* */
+		*key = g_strndup(mask, (int) (user - mask));
+		return list->nicks;
 	}
 
 	return NULL;
 }
 
-BAN_REC *banlist_add(IRC_CHANNEL_REC *channel, const char *ban,
-		     const char *nick, time_t time)
+static void mode_list_index_add(MODE_LIST_REC *list, BAN_REC *rec)
 {
-	BAN_REC *rec;
+	GHashTable *index;
+	GSList *bucket;
+	char *key;
+
+	index = mode_list_get_index(list, rec->ban, &key);
+	if (index == NULL) {
+		g_hash_table_add(list->others, rec);
+		return;
+	}
 
-	g_return_val_if_fail(channel != NULL, NULL);
-	g_return_val_if_fail(ban != NULL, NULL);
+	bucket = g_hash_table_lookup(index, key);
+	g_hash_table_replace(index, key, g_slist_prepend(bucket, rec));
+}
 
-	rec = banlist_find(channel->banlist, ban);
-	if (rec != NULL) {
+static void mode_list_index_remove(MODE_LIST_REC *list, BAN_REC *rec)
+{
+	GHashTable *index;
+	GSList *bucket;
+	char *key;
+
+	index = mode_list_get_index(list, rec->ban, &key);
+	if (index == NULL) {
+		g_hash_table_remove(list->others, rec);
+		return;
+	}
+
+	bucket = g_slist_remove(g_hash_table_lookup(index, key), rec);
+	if (bucket != NULL) {
+		g_hash_table_insert(index, key, bucket);
+		return;
+	}
+
+	g_hash_table_remove(index, key);
+	g_free(key);
+}
+
+BAN_REC *mode_list_find(MODE_LIST_REC *list, const char *mask)
+{
+	GSequenceIter *iter;
+
+	g_return_val_if_fail(mask != NULL, NULL);
+
+	if (list == NULL)
+		return NULL;
+
+	iter = g_hash_table_lookup(list->masks, mask);
+	return iter == NULL ? NULL : g_sequence_get(iter);
+}
+
+int mode_list_position(MODE_LIST_REC *list, BAN_REC *rec)
+{
+	GSequenceIter *iter;
+
+	g_return_val_if_fail(list != NULL, 0);
+	g_return_val_if_fail(rec != NULL, 0);
+
+	iter = g_hash_table_lookup(list->masks, rec->ban);
+	return iter == NULL ? 0 : g_sequence_iter_get_position(iter) + 1;
+}
+
+BAN_REC *mode_list_nth(MODE_LIST_REC *list, int pos)
+{
+	GSequenceIter *iter;
+	int count;
+
+	g_return_val_if_fail(list != NULL, NULL);
+
+	count = g_sequence_get_length(list->entries);
+	if (pos == -1)
+		pos = count;
+	if (pos < 1 || pos > count)
+		return NULL;
+
+	iter = g_sequence_get_iter_at_pos(list->entries, pos - 1);
+	return g_sequence_get(iter);
+}
+
+GSList *mode_list_get_entries(MODE_LIST_REC *list)
+{
+	GSequenceIter *iter;
+	GSList *ret;
+
+	g_return_val_if_fail(list != NULL, NULL);
+
+	ret = NULL;
+	iter = g_sequence_get_end_iter(list->entries);
+	while (!g_sequence_iter_is_begin(iter)) {
+		iter = g_sequence_iter_prev(iter);
+		ret = g_slist_prepend(ret, g_sequence_get(iter));
+	}
+	return ret;
+}
+
+static GSList *mode_list_match_bucket(GSList *ret, GSList *bucket,
+				      int (*match_func)(const char *, const char *),
+				      const char *address)
+{
+	for (; bucket != NULL; bucket = bucket->next) {
+		BAN_REC *rec = bucket->data;
+
+		if (match_func(rec->ban, address))
+			ret = g_slist_prepend(ret, rec);
+	}
+	return ret;
+}
+
+static GSList *mode_list_match_func(MODE_LIST_REC *list,
+				    int (*match_func)(const char *, const char *),
+				    const char *nick, const char *address)
+{
+	GHashTableIter iter;
+	const char *host, *p;
+	char *str;
+	void *rec;
+	GSList *ret;
+
+	ret = NULL;
+	str = g_strdup_printf("%s!%s", nick, address);
+
+	/* only the masks indexed by the host, its domains or the nick
+	   can match, besides the ones that have to be checked anyway */
+	host = strrchr(address, '@');
+	host = host == NULL ? address : host + 1;
+	if (*host != '\0') {
+		ret = mode_list_match_bucket(ret, g_hash_table_lookup(list->hosts, host),
+					     match_func, str);
+		for (p = strchr(host, '.'); p != NULL; p = strchr(p + 1, '.')) {
+			ret = mode_list_match_bucket(ret, g_hash_table_lookup(list->hosts, p),
+						     match_func, str);
+		}
+	}
+	ret = mode_list_match_bucket(ret, g_hash_table_lookup(list->nicks, nick),
+				     match_func, str);
+
+	g_hash_table_iter_init(&iter, list->others);
+	while (g_hash_table_iter_next(&iter, &rec, NULL)) {
+		if (match_func(((BAN_REC *) rec)->ban, str))
+			ret = g_slist_prepend(ret, rec);
+	}
+
+	g_free(str);
+	return ret;
+}
+
+GSList *mode_list_match(IRC_CHANNEL_REC *channel, MODE_LIST_REC *list,
+			const char *nick, const char *address)
+{
+	int (*match_func)(const char *, const char *);
+
+	g_return_val_if_fail(IS_IRC_CHANNEL(channel), NULL);
+	g_return_val_if_fail(nick != NULL, NULL);
+
+	if (list == NULL)
+		return NULL;
+	if (address == NULL)
+		address = "";
+
+	match_func = channel->server != NULL &&
+		channel->server->mask_match_func != NULL ?
+		channel->server->mask_match_func : match_wildcards;
+	return mode_list_match_func(list, match_func, nick, address);
+}
+
+static BAN_REC *mode_list_add(MODE_LIST_REC *list, const char *mask,
+			      const char *nick, time_t time)
+{
+	GSequenceIter *iter;
+	BAN_REC *rec;
+
+	if (mode_list_find(list, mask) != NULL) {
 		/* duplicate - ignore. some servers send duplicates
 		   for non-ops because they just replace the hostname with
 		   eg. "localhost"... */
@@ -77,14 +306,47 @@ BAN_REC *banlist_add(IRC_CHANNEL_REC *channel, const char *ban,
 	}
 
 	rec = g_new(BAN_REC, 1);
-	rec->ban = g_strdup(ban);
+	rec->ban = g_strdup(mask);
 	rec->setby = nick == NULL || *nick == '\0' ? NULL :
 		g_strdup(nick);
 	rec->time = time;
 
-	channel->banlist = g_slist_append(channel->banlist, rec);
+	iter = g_sequence_append(list->entries, rec);
+	g_hash_table_insert(list->masks, rec->ban, iter);
+	mode_list_index_add(list, rec);
+	return rec;
+}
+
+static void mode_list_remove(MODE_LIST_REC *list, BAN_REC *rec)
+{
+	GSequenceIter *iter;
+
+	iter = g_hash_table_lookup(list->masks, rec->ban);
+	g_return_if_fail(iter != NULL);
+
+	mode_list_index_remove(list, rec);
+	g_hash_table_remove(list->masks, rec->ban);
+	g_sequence_remove(iter);
+}
+
+BAN_REC *banlist_find(IRC_CHANNEL_REC *channel, const char *ban)
+{
+	g_return_val_if_fail(IS_IRC_CHANNEL(channel), NULL);
+
+	return mode_list_find(channel->banlist, ban);
+}
+
+BAN_REC *banlist_add(IRC_CHANNEL_REC *channel, const char *ban,
+		     const char *nick, time_t time)
+{
+	BAN_REC *rec;
 
-	signal_emit("ban new", 2, channel, rec);
+	g_return_val_if_fail(channel != NULL, NULL);
+	g_return_val_if_fail(ban != NULL, NULL);
+
+	rec = mode_list_add(channel->banlist, ban, nick, time);
+	if (rec != NULL)
+		signal_emit("ban new", 2, channel, rec);
 	return rec;
 }
 
@@ -95,19 +357,80 @@ void banlist_remove(IRC_CHANNEL_REC *channel, const char *ban, const char *nick)
 	g_return_if_fail(channel != NULL);
 	g_return_if_fail(ban != NULL);
 
-	rec = banlist_find(channel->banlist, ban);
+	rec = mode_list_find(channel->banlist, ban);
 	if (rec != NULL) {
 		signal_emit("ban remove", 3, channel, rec, nick);
-		ban_free(&channel->banlist, rec);
+		mode_list_remove(channel->banlist, rec);
 	}
 }
 
+GSList *banlist_match(IRC_CHANNEL_REC *channel, const char *nick,
+		      const char *address)
+{
+	g_return_val_if_fail(IS_IRC_CHANNEL(channel), NULL);
+
+	return mode_list_match(channel, channel->banlist, nick, address);
+}
+
+BAN_REC *banlist_exception_add(IRC_CHANNEL_REC *channel, const char *ban,
+			       const char *nick, time_t time)
+{
+	g_return_val_if_fail(channel != NULL, NULL);
+	g_return_val_if_fail(ban != NULL, NULL);
+
+	return mode_list_add(channel->exceptlist, ban, nick, time);
+}
+
+void banlist_exception_remove(IRC_CHANNEL_REC *channel, const char *ban)
+{
+	BAN_REC *rec;
+
+	g_return_if_fail(channel != NULL);
+	g_return_if_fail(ban != NULL);
+
+	rec = mode_list_find(channel->exceptlist, ban);
+	if (rec != NULL)
+		mode_list_remove(channel->exceptlist, rec);
+}
+
+void invitelist_add(IRC_CHANNEL_REC *channel, const char *mask)
+{
+	g_return_if_fail(channel != NULL);
+	g_return_if_fail(mask != NULL);
+
+	mode_list_add(channel->invitelist, mask, NULL, time(NULL));
+}
+
+void invitelist_remove(IRC_CHANNEL_REC *channel, const char *mask)
+{
+	BAN_REC *rec;
+
+	g_return_if_fail(channel != NULL);
+	g_return_if_fail(mask != NULL);
+
+	rec = mode_list_find(channel->invitelist, mask);
+	if (rec != NULL)
+		mode_list_remove(channel->invitelist, rec);
+}
+
+static void channel_created(IRC_CHANNEL_REC *channel)
+{
+	if (!IS_IRC_CHANNEL(channel))
+                return;
+
+	channel->banlist = mode_list_create();
+	channel->exceptlist = mode_list_create();
+	channel->invitelist = mode_list_create();
+}
+
 static void channel_destroyed(IRC_CHANNEL_REC *channel)
 {
 	if (!IS_IRC_CHANNEL(channel))
                 return;
 
-	banlist_free(channel->banlist);
+	mode_list_destroy(channel->banlist);
+	mode_list_destroy(channel->exceptlist);
+	mode_list_destroy(channel->invitelist);
 }
 
 static void event_banlist(IRC_SERVER_REC *server, const char *data)
@@ -127,16 +450,50 @@ static void event_banlist(IRC_SERVER_REC *server, const char *data)
 	g_free(params);
 }
 
+static void event_exceptlist(IRC_SERVER_REC *server, const char *data)
+{
+	IRC_CHANNEL_REC *chanrec;
+	char *params, *channel, *ban, *setby, *tims;
+
+	g_return_if_fail(data != NULL);
+
+	params = event_get_params(data, 5, NULL, &channel, &ban, &setby, &tims);
+	chanrec = irc_channel_find(server, channel);
+	if (chanrec != NULL)
+		banlist_exception_add(chanrec, ban, setby, (time_t) atol(tims));
+	g_free(params);
+}
+
+static void event_invitelist(IRC_SERVER_REC *server, const char *data)
+{
+	IRC_CHANNEL_REC *chanrec;
+	char *params, *channel, *mask;
+
+	g_return_if_fail(data != NULL);
+
+	params = event_get_params(data, 3, NULL, &channel, &mask);
+	chanrec = irc_channel_find(server, channel);
+	if (chanrec != NULL)
+		invitelist_add(chanrec, mask);
+	g_free(params);
+}
+
 void mode_lists_init(void)
 {
+	signal_add_first("channel created", (SIGNAL_FUNC) channel_created);
 	signal_add("channel destroyed", (SIGNAL_FUNC) channel_destroyed);
 
 	signal_add("chanquery ban", (SIGNAL_FUNC) event_banlist);
+	signal_add("event 348", (SIGNAL_FUNC) event_exceptlist);
+	signal_add("event 346", (SIGNAL_FUNC) event_invitelist);
 }
 
 void mode_lists_deinit(void)
 {
+	signal_remove("channel created", (SIGNAL_FUNC) channel_created);
 	signal_remove("channel destroyed", (SIGNAL_FUNC) channel_destroyed);
 
 	signal_remove("chanquery ban", (SIGNAL_FUNC) event_banlist);
+	signal_remove("event 348", (SIGNAL_FUNC) event_exceptlist);
+	signal_remove("event 346", (SIGNAL_FUNC) event_invitelist);
 }
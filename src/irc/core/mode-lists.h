@@ -7,10 +7,37 @@ typedef struct {
 	time_t time;
 } BAN_REC;
 
-BAN_REC *banlist_find(GSList *list, const char *ban);
+/* List of channel masks (bans, ban exceptions or invites) */
+typedef struct _MODE_LIST_REC {
+	GSequence *entries; /* BAN_RECs in the order they were set */
+	GHashTable *masks; /* mask -> GSequenceIter in entries */
+
+	/* INTERNAL: for finding the masks matching an address */
+	GHashTable *hosts; /* literal host or ".domain" suffix -> GSList of BAN_RECs */
+	GHashTable *nicks; /* literal nick -> GSList of BAN_RECs */
+	GHashTable *others; /* BAN_RECs that have to be matched one by one */
+} MODE_LIST_REC;
+
+#define mode_list_count(list) \
+	g_sequence_get_length((list)->entries)
+
+BAN_REC *mode_list_find(MODE_LIST_REC *list, const char *mask);
+/* Returns the 1-based position of `rec' in the list */
+int mode_list_position(MODE_LIST_REC *list, BAN_REC *rec);
+/* Returns the `pos'th (1-based) entry, or the last one if `pos' is -1 */
+BAN_REC *mode_list_nth(MODE_LIST_REC *list, int pos);
+/* Returns a list of all BAN_RECs in the order they were set */
+GSList *mode_list_get_entries(MODE_LIST_REC *list);
+/* Returns a list of BAN_RECs whose mask matches nick!address */
+GSList *mode_list_match(IRC_CHANNEL_REC *channel, MODE_LIST_REC *list,
+			const char *nick, const char *address);
+
+BAN_REC *banlist_find(IRC_CHANNEL_REC *channel, const char *ban);
 
 BAN_REC *banlist_add(IRC_CHANNEL_REC *channel, const char *ban, const char *nick, time_t time);
 void banlist_remove(IRC_CHANNEL_REC *channel, const char *ban, const char *nick);
+/* Returns a list of bans matching nick!address */
+GSList *banlist_match(IRC_CHANNEL_REC *channel, const char *nick, const char *address);
 
 BAN_REC *banlist_exception_add(IRC_CHANNEL_REC *channel, const char *ban, const char *nick, time_t time);
 void banlist_exception_remove(IRC_CHANNEL_REC *channel, const char *ban);
@@ -60,46 +60,49 @@ static void nick_mode_change(IRC_CHANNEL_REC *channel, const char *nick,
 		    channel, nickrec, setby, modestr, typestr);
 }
 
+static int prefix_rank(SERVER_REC *server, char prefix)
+{
+	IRC_SERVER_REC *irc_server;
+	const char *flags, *pos;
+
+	irc_server = IRC_SERVER(server);
+	if (irc_server != NULL)
+		return GET_PREFIX_RANK(irc_server, prefix);
+
+	flags = server->get_nick_flags(server);
+	pos = prefix == '\0' ? NULL : strchr(flags, prefix);
+	return pos == NULL ? 0 : (int) (pos - flags) + 1;
+}
+
 void prefix_add(char prefixes[MAX_USER_PREFIXES+1], char newprefix, SERVER_REC *server)
 {
-	const char *prefixlst;
-	char newprefixes[MAX_USER_PREFIXES+1]; /* to hold the new prefixes */
-	unsigned int newpos = 0; /* to hold our position in the new prefixes */
-	unsigned int oldpos = 0; /* to hold our position in the old prefixes */
-
-	prefixlst = server->get_nick_flags(server);
-
-	/* go through the possible prefixes, copy higher ones, and find this one's place
-	 * always leave room for the current prefix to be added, though.
-	 */
-	while (*prefixlst != '\0' && prefixes[oldpos] != '\0' &&
-			newpos < MAX_USER_PREFIXES - 1) {
-		if (prefixes[oldpos] == newprefix)
-			return; /* already inserted.  why are we here? */
-
-		if (*prefixlst == newprefix)
-			break; /* insert the new prefix here */
-
-		if (*prefixlst == prefixes[oldpos]) {
-			/* this prefix is present.
-			 * the one we are inserting goes after it.
-			 * copy it over, and continue searching.
-			 */
-			newprefixes[newpos++] = prefixes[oldpos++];
-		}
-		prefixlst++;
-	}
+	int rank, pos, len;
 
-	/* newpos is now the position in which we wish to insert the prefix */
-	newprefixes[newpos++] = newprefix;
+	if (strchr(prefixes, newprefix) != NULL)
+		return; /* already inserted.  why are we here? */
 
-	/* finish copying the remaining prefixes */
-	while (prefixes[oldpos] != '\0' && newpos < MAX_USER_PREFIXES)
-		newprefixes[newpos++] = prefixes[oldpos++];
+	/* keep the prefixes in the order they are in PREFIX; unknown
+	   prefixes go last */
+	rank = prefix_rank(server, newprefix);
+	len = strlen(prefixes);
+	pos = len;
+	if (rank != 0) {
+		for (pos = 0; pos < len; pos++) {
+			int cur = prefix_rank(server, prefixes[pos]);
 
-	newprefixes[newpos] = '\0';
+			if (cur == 0 || cur > rank)
+				break;
+		}
+	}
+
+	if (pos >= MAX_USER_PREFIXES)
+		return;
+	if (len == MAX_USER_PREFIXES)
+		len--; /* drop the lowest one */
 
-	strcpy(prefixes, newprefixes);
+	memmove(prefixes + pos + 1, prefixes + pos, len - pos);
+	prefixes[pos] = newprefix;
+	prefixes[len + 1] = '\0';
 }
 
 void prefix_del(char prefixes[MAX_USER_PREFIXES+1], char oldprefix)
@@ -258,6 +261,16 @@ void modes_type_a(IRC_CHANNEL_REC *channel, const char *setby, char type,
 			banlist_add(channel, arg, setby, time(NULL));
 		else
 			banlist_remove(channel, arg, setby);
+	} else if (mode == 'e') {
+		if (type == '+')
+			banlist_exception_add(channel, arg, setby, time(NULL));
+		else
+			banlist_exception_remove(channel, arg);
+	} else if (mode == 'I') {
+		if (type == '+')
+			invitelist_add(channel, arg);
+		else
+			invitelist_remove(channel, arg);
 	}
 }
 
@@ -297,32 +310,29 @@ void modes_type_d(IRC_CHANNEL_REC *channel, const char *setby,
 	mode_set(channel->server, newmode, type, mode, FALSE);
 }
 
+/* see if we need to update channel->chanop */
+static void chanop_update(IRC_CHANNEL_REC *channel, char type, char mode,
+			  const char *nick)
+{
+	IRC_SERVER_REC *server = channel->server;
+	int rank, op_rank;
+
+	if (g_ascii_strcasecmp(server->nick, nick) != 0)
+		return;
+
+	/* modes equal to or higher than +o give ops */
+	rank = server->modes[(int) (unsigned char) mode].rank;
+	op_rank = server->modes['o'].rank;
+	if (rank != 0 && (op_rank == 0 || rank <= op_rank))
+		channel->chanop = type == '+';
+}
+
 void modes_type_prefix(IRC_CHANNEL_REC *channel, const char *setby,
 		       char type, char mode, char *arg, GString *newmode)
 {
 	int umode = (unsigned char) mode;
 
-	if (g_ascii_strcasecmp(channel->server->nick, arg) == 0) {
-		/* see if we need to update channel->chanop */
-		const char *prefix =
-			g_hash_table_lookup(channel->server->isupport, "PREFIX");
-		if (prefix != NULL && *prefix == '(') {
-			prefix++;
-			while (*prefix != ')' && *prefix != '\0') {
-				if (*prefix == mode) {
-					channel->chanop = type == '+';
-					break;
-				}
-				if (*prefix == 'o')
-					break;
-				prefix++;
-			}
-		} else {
-			if (mode == 'o' || mode == 'O')
-				channel->chanop = type == '+';
-		}
-	}
-
+	chanop_update(channel, type, mode, arg);
 	nick_mode_change(channel, arg, channel->server->modes[umode].prefix,
 			 type, setby);
 }
@@ -870,27 +880,50 @@ static void cmd_mode(const char *data, IRC_SERVER_REC *server,
 	cmd_params_free(free_arg);
 }
 
+void modes_server_set_type(IRC_SERVER_REC *server, char mode,
+			   mode_func_t *func)
+{
+	struct modes_type *rec;
+
+	g_return_if_fail(server != NULL);
+
+	rec = &server->modes[(int) (unsigned char) mode];
+	rec->func = func;
+	if (func == modes_type_a || func == modes_type_b ||
+	    func == modes_type_prefix)
+		rec->args = MODE_ARG_SET | MODE_ARG_UNSET;
+	else if (func == modes_type_c)
+		rec->args = MODE_ARG_SET;
+	else
+		rec->args = 0;
+}
+
 void modes_server_init(IRC_SERVER_REC *server)
 {
-	server->modes['b'].func = modes_type_a;
-	server->modes['e'].func = modes_type_a;
-	server->modes['I'].func = modes_type_a;
+	modes_server_set_type(server, 'b', modes_type_a);
+	modes_server_set_type(server, 'e', modes_type_a);
+	modes_server_set_type(server, 'I', modes_type_a);
 
-	server->modes['h'].func = modes_type_prefix;
+	/* same as PREFIX=(ohv)@%+ */
+	modes_server_set_type(server, 'h', modes_type_prefix);
 	server->modes['h'].prefix = '%';
-	server->modes['o'].func = modes_type_prefix;
+	server->modes['h'].rank = 2;
+	modes_server_set_type(server, 'o', modes_type_prefix);
 	server->modes['o'].prefix = '@';
-	server->modes['O'].func = modes_type_prefix;
+	server->modes['o'].rank = 1;
+	modes_server_set_type(server, 'O', modes_type_prefix);
 	server->modes['O'].prefix = '@';
-	server->modes['v'].func = modes_type_prefix;
+	server->modes['O'].rank = 1;
+	modes_server_set_type(server, 'v', modes_type_prefix);
 	server->modes['v'].prefix = '+';
+	server->modes['v'].rank = 3;
 
 	server->prefix['%'] = 'h';
 	server->prefix['@'] = 'o';
 	server->prefix['+'] = 'v';
 
-	server->modes['k'].func = modes_type_b;
-	server->modes['l'].func = modes_type_c;
+	modes_server_set_type(server, 'k', modes_type_b);
+	modes_server_set_type(server, 'l', modes_type_c);
 }
 
 void modes_init(void)
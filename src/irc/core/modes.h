@@ -7,21 +7,24 @@
 typedef void mode_func_t(IRC_CHANNEL_REC *, const char *, char, char,
 			 char *, GString *);
 
+#define MODE_ARG_SET	0x01 /* has argument when being set (+) */
+#define MODE_ARG_UNSET	0x02 /* has argument when being unset (-) */
+
 struct modes_type {
 	mode_func_t *func;
 	char prefix;
+	unsigned char args; /* MODE_ARG_* flags, derived from func */
+	unsigned char rank; /* position in PREFIX starting from 1, 0 if the
+			       mode doesn't give a nick prefix */
 };
 
 /* modes that have argument always */
 #define HAS_MODE_ARG_ALWAYS(server, mode) \
-   (server->modes[(int)(unsigned char) mode].func == modes_type_a || \
-    server->modes[(int)(unsigned char) mode].func == modes_type_b || \
-    server->modes[(int)(unsigned char) mode].func == modes_type_prefix)
+	((server->modes[(int)(unsigned char) mode].args & MODE_ARG_UNSET) != 0)
 
 /* modes that have argument when being set (+) */
 #define HAS_MODE_ARG_SET(server, mode) \
-	(HAS_MODE_ARG_ALWAYS(server, mode) || \
-	  server->modes[(int)(unsigned char) mode].func == modes_type_c)
+	((server->modes[(int)(unsigned char) mode].args & MODE_ARG_SET) != 0)
 
 /* modes that have argument when being unset (-) */
 #define HAS_MODE_ARG_UNSET(server, mode) \
@@ -35,10 +38,15 @@ struct modes_type {
 	((server)->modes[(int)(unsigned char)c].prefix)
 #define GET_PREFIX_MODE(server, c) \
 	((server)->prefix[(int)(unsigned char)c])
+/* position of nick prefix `c' in PREFIX starting from 1, 0 if it's unknown */
+#define GET_PREFIX_RANK(server, c) \
+	((server)->modes[(int)(unsigned char) GET_PREFIX_MODE(server, c)].rank)
 
 void modes_init(void);
 void modes_deinit(void);
 void modes_server_init(IRC_SERVER_REC *);
+/* Set the handler of channel `mode' in server's mode table */
+void modes_server_set_type(IRC_SERVER_REC *server, char mode, mode_func_t *func);
 
 /* add `mode' to `old' - return newly allocated mode.
    `channel' specifies if we're parsing channel mode and we should try
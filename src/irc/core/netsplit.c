@@ -22,6 +22,8 @@
 #include <irssi/src/core/signals.h>
 #include <irssi/src/core/commands.h>
 #include <irssi/src/core/misc.h>
+#include <irssi/src/core/settings.h>
+#include <irssi/src/core/refstrings.h>
 
 #include <irssi/src/irc/core/irc-servers.h>
 #include <irssi/src/irc/core/irc-channels.h>
@@ -29,8 +31,13 @@
 
 /* How long to keep netsplits in memory (seconds) */
 #define NETSPLIT_MAX_REMEMBER (60*60)
+/* How long to keep them after the split is over */
+#define NETSPLIT_MAX_REMEMBER_OVER 60
+
+NETSPLIT_STATS netsplit_stats;
 
 static int split_tag;
+static int netsplit_max_records;
 
 static NETSPLIT_SERVER_REC *netsplit_server_find(IRC_SERVER_REC *server,
 						 const char *servername,
@@ -69,6 +76,7 @@ static NETSPLIT_SERVER_REC *netsplit_server_create(IRC_SERVER_REC *server,
 	rec->last = time(NULL);
 	rec->server = g_strdup(servername);
 	rec->destserver = g_strdup(destserver);
+	rec->splits = g_queue_new();
 
 	server->split_servers = g_slist_append(server->split_servers, rec);
 	signal_emit("netsplit server new", 2, server, rec);
@@ -82,14 +90,38 @@ static void netsplit_server_destroy(IRC_SERVER_REC *server,
 	g_return_if_fail(IS_IRC_SERVER(server));
 
 	server->split_servers = g_slist_remove(server->split_servers, rec);
+	g_sequence_remove(rec->expire_iter);
 
 	signal_emit("netsplit server remove", 2, server, rec);
 
+	g_queue_free(rec->splits);
         g_free(rec->server);
 	g_free(rec->destserver);
 	g_free(rec);
 }
 
+static int netsplit_destroy_cmp(NETSPLIT_SERVER_REC *a,
+				NETSPLIT_SERVER_REC *b, void *data)
+{
+	return a->destroy < b->destroy ? -1 :
+		a->destroy > b->destroy ? 1 : 0;
+}
+
+/* move the split server in irc server's expiry queue after changing its
+   destroy time */
+static void netsplit_server_set_destroy(NETSPLIT_SERVER_REC *rec,
+					time_t destroy)
+{
+	if (rec->destroy == destroy)
+		return;
+
+	rec->destroy = destroy;
+	g_sequence_sort_changed(rec->expire_iter,
+				(GCompareDataFunc) netsplit_destroy_cmp, NULL);
+}
+
+static void netsplit_remove(IRC_SERVER_REC *server, NETSPLIT_REC *rec);
+
 static NETSPLIT_REC *netsplit_add(IRC_SERVER_REC *server, const char *nick,
 				  const char *address, const char *servers)
 {
@@ -113,6 +145,11 @@ static NETSPLIT_REC *netsplit_add(IRC_SERVER_REC *server, const char *nick,
 	}
 	*p++ = '\0';
 
+	/* shouldn't happen, the nick can't quit twice without joining */
+	rec = g_hash_table_lookup(server->splits, nick);
+	if (rec != NULL)
+		netsplit_remove(server, rec);
+
 	rec = g_new0(NETSPLIT_REC, 1);
 	rec->nick = g_strdup(nick);
 	rec->address = g_strdup(address);
@@ -120,8 +157,22 @@ static NETSPLIT_REC *netsplit_add(IRC_SERVER_REC *server, const char *nick,
 
 	rec->server = netsplit_server_create(server, dupservers, p);
 	rec->server->count++;
+	g_queue_push_tail(rec->server->splits, rec);
+	rec->server_link = rec->server->splits->tail;
 	g_free(dupservers);
 
+	/* the records of a split are forgotten in the order they quit,
+	   or all at once after the split is over */
+	if (rec->server->expire_iter == NULL) {
+		rec->server->destroy = rec->destroy;
+		rec->server->expire_iter =
+			g_sequence_insert_sorted(server->split_queue, rec->server,
+						 (GCompareDataFunc) netsplit_destroy_cmp,
+						 NULL);
+	} else if (rec->server->over) {
+		rec->destroy = rec->server->destroy;
+	}
+
 	/* copy the channel nick records.. */
 	for (tmp = server->channels; tmp != NULL; tmp = tmp->next) {
 		CHANNEL_REC *channel = tmp->data;
@@ -130,28 +181,51 @@ static NETSPLIT_REC *netsplit_add(IRC_SERVER_REC *server, const char *nick,
 		if (nickrec == NULL)
 			continue;
 
+		/* the same channel names are shared by all the split nicks */
 		splitchan = g_new0(NETSPLIT_CHAN_REC, 1);
-		splitchan->name = g_strdup(channel->visible_name);
+		splitchan->name = i_refstr_intern(channel->visible_name);
 		splitchan->op = nickrec->op;
 		splitchan->halfop = nickrec->halfop;
 		splitchan->voice = nickrec->voice;
 		memcpy(splitchan->prefixes, nickrec->prefixes, sizeof(splitchan->prefixes));
 
-		rec->channels = g_slist_append(rec->channels, splitchan);
+		rec->channels = g_slist_prepend(rec->channels, splitchan);
 	}
+	rec->channels = g_slist_reverse(rec->channels);
 
 	if (rec->channels == NULL)
 		g_warning("netsplit_add(): nick '%s' not in any channels", nick);
 
 	g_hash_table_insert(server->splits, rec->nick, rec);
 
+	netsplit_stats.records++;
+	if (netsplit_stats.records > netsplit_stats.peak)
+		netsplit_stats.peak = netsplit_stats.records;
+
+	/* too many nicks remembered, forget the ones expiring first */
+	while (netsplit_max_records > 0 &&
+	       g_hash_table_size(server->splits) > (unsigned int) netsplit_max_records) {
+		NETSPLIT_SERVER_REC *split;
+		NETSPLIT_REC *old;
+
+		split = g_sequence_get(g_sequence_get_begin_iter(server->split_queue));
+		old = g_queue_peek_head(split->splits);
+		if (old == rec)
+			break;
+
+		netsplit_stats.dropped++;
+		netsplit_remove(server, old);
+	}
+
 	signal_emit("netsplit new", 1, rec);
 	return rec;
 }
 
 static void netsplit_destroy(IRC_SERVER_REC *server, NETSPLIT_REC *rec)
 {
+	NETSPLIT_SERVER_REC *split;
 	GSList *tmp;
+	int first;
 
 	g_return_if_fail(IS_IRC_SERVER(server));
 	g_return_if_fail(rec != NULL);
@@ -160,25 +234,42 @@ static void netsplit_destroy(IRC_SERVER_REC *server, NETSPLIT_REC *rec)
 	for (tmp = rec->channels; tmp != NULL; tmp = tmp->next) {
 		NETSPLIT_CHAN_REC *rec = tmp->data;
 
-		g_free(rec->name);
+		i_refstr_release(rec->name);
 		g_free(rec);
 	}
 	g_slist_free(rec->channels);
 
-	if (--rec->server->count == 0)
-		netsplit_server_destroy(server, rec->server);
+	split = rec->server;
+	first = rec->server_link == split->splits->head;
+	g_queue_delete_link(split->splits, rec->server_link);
+	netsplit_stats.records--;
+
+	if (--split->count == 0)
+		netsplit_server_destroy(server, split);
+	else if (first && !split->over) {
+		/* the next oldest record decides when the split expires */
+		netsplit_server_set_destroy(split,
+			((NETSPLIT_REC *) g_queue_peek_head(split->splits))->destroy);
+	}
 
 	g_free(rec->nick);
 	g_free(rec->address);
 	g_free(rec);
 }
 
-static void netsplit_destroy_hash(void *key, NETSPLIT_REC *rec,
-				  IRC_SERVER_REC *server)
+static void netsplit_remove(IRC_SERVER_REC *server, NETSPLIT_REC *rec)
 {
+	g_hash_table_remove(server->splits, rec->nick);
 	netsplit_destroy(server, rec);
 }
 
+static int netsplit_destroy_hash(void *key, NETSPLIT_REC *rec,
+				 IRC_SERVER_REC *server)
+{
+	netsplit_destroy(server, rec);
+	return TRUE;
+}
+
 NETSPLIT_REC *netsplit_find(IRC_SERVER_REC *server, const char *nick,
 			    const char *address)
 {
@@ -298,11 +389,12 @@ int quitmsg_is_split(const char *msg)
         return TRUE;
 }
 
-static void split_set_timeout(void *key, NETSPLIT_REC *rec, NETSPLIT_REC *orig)
+static void split_set_timeout(NETSPLIT_SERVER_REC *split)
 {
-	/* same servers -> split over -> destroy old records sooner.. */
-	if (rec->server == orig->server)
-		rec->destroy = time(NULL)+60;
+	/* same servers -> split over -> destroy old records sooner..
+	   every rejoin pushes the time back while the netjoin goes on */
+	split->over = TRUE;
+	netsplit_server_set_destroy(split, time(NULL) + NETSPLIT_MAX_REMEMBER_OVER);
 }
 
 static void event_join(IRC_SERVER_REC *server, const char *data,
@@ -323,8 +415,7 @@ static void event_join(IRC_SERVER_REC *server, const char *data,
 		   .. if the user just changed server, she can't use the
 		   same nick (unless the server is broken) so don't bother
 		   checking that the nick's server matches the split. */
-		g_hash_table_foreach(server->splits,
-				     (GHFunc) split_set_timeout, rec);
+		split_set_timeout(rec->server);
 	}
 }
 
@@ -339,10 +430,8 @@ static void event_join_last(IRC_SERVER_REC *server, const char *data,
 		return;
 
 	rec = g_hash_table_lookup(server->splits, nick);
-	if (rec != NULL) {
-		g_hash_table_remove(server->splits, rec->nick);
-		netsplit_destroy(server, rec);
-	}
+	if (rec != NULL)
+		netsplit_remove(server, rec);
 }
 
 static void event_quit(IRC_SERVER_REC *server, const char *data,
@@ -367,10 +456,8 @@ static void event_nick(IRC_SERVER_REC *server, const char *data)
 	/* remove nick from split list when somebody changed
 	   nick to this one during split */
         rec = g_hash_table_lookup(server->splits, nick);
-	if (rec != NULL) {
-	        g_hash_table_remove(server->splits, rec->nick);
-		netsplit_destroy(server, rec);
-	}
+	if (rec != NULL)
+		netsplit_remove(server, rec);
 
         g_free(params);
 }
@@ -385,44 +472,71 @@ static void sig_disconnected(IRC_SERVER_REC *server)
 	if (server->splits == NULL)
 		return;
 
-	g_hash_table_foreach(server->splits,
-			     (GHFunc) netsplit_destroy_hash, server);
+	g_hash_table_foreach_remove(server->splits,
+				    (GHRFunc) netsplit_destroy_hash, server);
 	g_hash_table_destroy(server->splits);
+	g_sequence_free(server->split_queue);
         server->splits = NULL;
+	server->split_queue = NULL;
 }
 
-static int split_server_check(void *key, NETSPLIT_REC *rec,
-			      IRC_SERVER_REC *server)
+static void split_server_check(IRC_SERVER_REC *server, time_t now)
 {
-	/* Check if this split record is too old.. */
-	if (rec->destroy > time(NULL))
-		return FALSE;
-
-	netsplit_destroy(server, rec);
-	return TRUE;
+	NETSPLIT_SERVER_REC *split;
+	GSequenceIter *iter;
+	int count;
+
+	/* the queue is ordered by destroy time, so only the
+	   splits at its beginning can be too old.. */
+	for (;;) {
+		iter = g_sequence_get_begin_iter(server->split_queue);
+		if (g_sequence_iter_is_end(iter))
+			break;
+
+		split = g_sequence_get(iter);
+		if (split->destroy > now)
+			break;
+
+		/* the split is destroyed with its last record */
+		count = split->over ? split->count : 1;
+		while (count-- > 0) {
+			netsplit_stats.expired++;
+			netsplit_remove(server, g_queue_peek_head(split->splits));
+		}
+	}
 }
 
 static int split_check_old(void)
 {
 	GSList *tmp;
+	time_t now;
 
+	now = time(NULL);
 	for (tmp = servers; tmp != NULL; tmp = tmp->next) {
 		IRC_SERVER_REC *server = tmp->data;
 
-		if (!IS_IRC_SERVER(server))
+		if (!IS_IRC_SERVER(server) || server->split_queue == NULL)
 			continue;
 
-		g_hash_table_foreach_remove(server->splits,
-					    (GHRFunc) split_server_check,
-					    server);
+		split_server_check(server, now);
 	}
 
 	return 1;
 }
 
+static void read_settings(void)
+{
+	netsplit_max_records = settings_get_int("netsplit_max_records");
+}
+
 void netsplit_init(void)
 {
+	settings_add_int("misc", "netsplit_max_records", 50000);
+	memset(&netsplit_stats, 0, sizeof(netsplit_stats));
+
+	read_settings();
 	split_tag = g_timeout_add(1000, (GSourceFunc) split_check_old, NULL);
+	signal_add("setup changed", (SIGNAL_FUNC) read_settings);
 	signal_add_first("event join", (SIGNAL_FUNC) event_join);
 	signal_add_last("event join", (SIGNAL_FUNC) event_join_last);
 	signal_add_first("event quit", (SIGNAL_FUNC) event_quit);
@@ -433,6 +547,7 @@ void netsplit_init(void)
 void netsplit_deinit(void)
 {
 	g_source_remove(split_tag);
+	signal_remove("setup changed", (SIGNAL_FUNC) read_settings);
 	signal_remove("event join", (SIGNAL_FUNC) event_join);
 	signal_remove("event join", (SIGNAL_FUNC) event_join_last);
 	signal_remove("event quit", (SIGNAL_FUNC) event_quit);
@@ -10,6 +10,13 @@ typedef struct {
         int prints; /* temp variable */
 
 	time_t last; /* last time we received a QUIT msg here */
+	time_t destroy; /* when the oldest records are forgotten */
+	unsigned int over:1; /* nicks are rejoining, all records go at destroy */
+
+	GQueue *splits; /* NETSPLIT_RECs that quit because of this split */
+
+	/* INTERNAL: */
+	GSequenceIter *expire_iter; /* position in irc_server->split_queue */
 } NETSPLIT_SERVER_REC;
 
 typedef struct {
@@ -21,16 +28,28 @@ typedef struct {
 
 	unsigned int printed:1;
 	time_t destroy;
+
+	/* INTERNAL: */
+	GList *server_link; /* link in server->splits */
 } NETSPLIT_REC;
 
 typedef struct {
-	char *name;
+	char *name; /* shared string, see i_refstr_intern() */
 	unsigned int op:1;
 	unsigned int halfop:1;
 	unsigned int voice:1;
 	char prefixes[MAX_USER_PREFIXES+1];
 } NETSPLIT_CHAN_REC;
 
+typedef struct {
+	unsigned int records; /* nicks currently remembered, all servers */
+	unsigned int peak; /* highest value of records seen */
+	unsigned int expired; /* forgotten after NETSPLIT_MAX_REMEMBER */
+	unsigned int dropped; /* forgotten early because of netsplit_max_records */
+} NETSPLIT_STATS;
+
+extern NETSPLIT_STATS netsplit_stats;
+
 void netsplit_init(void);
 void netsplit_deinit(void);
 
@@ -33,6 +33,14 @@
    immediately. */
 #define MAX_FAILURE_COUNT 1
 
+/* argument position for events that aren't in the list */
+#define ARGPOS_NONE -2
+
+typedef struct {
+	/* argument positions in start, stop and optional event lists */
+	int start, stop, opt;
+} REDIRECT_EVENT_REC;
+
 typedef struct {
         char *name;
 	int refcount;
@@ -40,7 +48,7 @@ typedef struct {
 	int remote;
 	int timeout;
 	int pos;
-	GSList *start, *stop, *opt; /* char *event, int argpos, ... */
+	GHashTable *events; /* signal id : REDIRECT_EVENT_REC* */
 } REDIRECT_CMD_REC;
 
 struct _REDIRECT_REC {
@@ -55,12 +63,14 @@ struct _REDIRECT_REC {
 	unsigned int first_signal_sent:1;
 
 	char *arg;
+	char **args; /* `arg' split to words */
         int count;
 	char *failure_signal, *default_signal, *first_signal, *last_signal;
 	GSList *signals; /* event, signal, ... */
 };
 
 static GHashTable *command_redirects; /* "command xxx" : REDIRECT_CMD_REC* */
+static int signal_tryagain;
 
 /* Find redirection command record for specified command line. */
 static REDIRECT_CMD_REC *redirect_cmd_find(const char *command)
@@ -82,17 +92,7 @@ static REDIRECT_CMD_REC *redirect_cmd_find(const char *command)
 
 static void redirect_cmd_destroy(REDIRECT_CMD_REC *rec)
 {
-	GSList *tmp;
-
-	for (tmp = rec->start; tmp != NULL; tmp = tmp->next->next)
-                g_free(tmp->data);
-	for (tmp = rec->stop; tmp != NULL; tmp = tmp->next->next)
-                g_free(tmp->data);
-	for (tmp = rec->opt; tmp != NULL; tmp = tmp->next->next)
-                g_free(tmp->data);
-        g_slist_free(rec->start);
-        g_slist_free(rec->stop);
-        g_slist_free(rec->opt);
+	g_hash_table_destroy(rec->events);
         g_free(rec->name);
 	g_free(rec);
 }
@@ -114,6 +114,7 @@ void server_redirect_destroy(REDIRECT_REC *rec)
 
 	g_free_not_null(rec->prefix);
 	g_free_not_null(rec->arg);
+	g_strfreev(rec->args);
         g_free_not_null(rec->failure_signal);
         g_free_not_null(rec->default_signal);
         g_free_not_null(rec->first_signal);
@@ -155,6 +156,34 @@ void server_redirect_register(const char *command,
 	server_redirect_register_list(command, remote, timeout, start, stop, opt, 0);
 }
 
+/* Add events from start/stop/opt list to `events' and free the list */
+static void redirect_cmd_add_events(GHashTable *events, GSList *list,
+				    size_t offset)
+{
+	REDIRECT_EVENT_REC *rec;
+	GSList *tmp;
+	int id, *argpos;
+
+	for (tmp = list; tmp != NULL; tmp = tmp->next->next) {
+		id = signal_get_uniq_id(tmp->data);
+
+		rec = g_hash_table_lookup(events, GINT_TO_POINTER(id));
+		if (rec == NULL) {
+			rec = g_new(REDIRECT_EVENT_REC, 1);
+			rec->start = rec->stop = rec->opt = ARGPOS_NONE;
+			g_hash_table_insert(events, GINT_TO_POINTER(id), rec);
+		}
+
+		/* the first one in the list is used */
+		argpos = G_STRUCT_MEMBER_P(rec, offset);
+		if (*argpos == ARGPOS_NONE)
+			*argpos = GPOINTER_TO_INT(tmp->next->data);
+
+		g_free(tmp->data);
+	}
+	g_slist_free(list);
+}
+
 void server_redirect_register_list(const char *command, int remote, int timeout, GSList *start,
                                    GSList *stop, GSList *opt, int pos)
 {
@@ -177,10 +206,14 @@ void server_redirect_register_list(const char *command, int remote, int timeout,
         rec->name = g_strdup(command);
 	rec->remote = remote;
 	rec->timeout = timeout > 0 ? timeout : DEFAULT_REDIRECT_TIMEOUT;
-	rec->start = start;
-        rec->stop = stop;
-        rec->opt = opt;
 	rec->pos = pos;
+	rec->events = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+	redirect_cmd_add_events(rec->events, start,
+				G_STRUCT_OFFSET(REDIRECT_EVENT_REC, start));
+	redirect_cmd_add_events(rec->events, stop,
+				G_STRUCT_OFFSET(REDIRECT_EVENT_REC, stop));
+	redirect_cmd_add_events(rec->events, opt,
+				G_STRUCT_OFFSET(REDIRECT_EVENT_REC, opt));
 	g_hash_table_insert(command_redirects, rec->name, rec);
 }
 
@@ -233,6 +266,26 @@ static char *signal_list_move(GSList **signals, const char *event)
         return linksignal;
 }
 
+/* Split the wanted arguments to words, so they don't need to be parsed for
+   each event */
+static char **redirect_args_split(const char *arg)
+{
+	char **args, **src, **dest;
+
+	if (arg == NULL)
+		return NULL;
+
+	args = g_strsplit(arg, " ", -1);
+	for (src = dest = args; *src != NULL; src++) {
+		if (**src == '\0')
+			g_free(*src);
+		else
+			*dest++ = *src;
+	}
+	*dest = NULL;
+	return args;
+}
+
 void server_redirect_event_list(IRC_SERVER_REC *server, const char *command,
 				int count, const char *arg, int remote,
 				const char *failure_signal, GSList *signals)
@@ -256,6 +309,7 @@ void server_redirect_event_list(IRC_SERVER_REC *server, const char *command,
         rec->created = time(NULL);
         rec->cmd = cmdrec;
 	rec->arg = g_strdup(arg);
+	rec->args = redirect_args_split(arg);
         rec->count = count;
 	rec->remote = remote != -1 ? remote : cmdrec->remote;
 	rec->failure_signal = g_strdup(failure_signal);
@@ -270,6 +324,40 @@ void server_redirect_event_list(IRC_SERVER_REC *server, const char *command,
         server->redirect_next = rec;
 }
 
+/* Count the events that the queued redirections are waiting for, so the
+   other events can be skipped with a single lookup. */
+static void redirect_events_ref(IRC_SERVER_REC *server, REDIRECT_CMD_REC *cmd)
+{
+	GHashTableIter iter;
+	gpointer id;
+	int count;
+
+	if (server->redirect_events == NULL)
+		server->redirect_events = g_hash_table_new(NULL, NULL);
+
+	g_hash_table_iter_init(&iter, cmd->events);
+	while (g_hash_table_iter_next(&iter, &id, NULL)) {
+		count = GPOINTER_TO_INT(g_hash_table_lookup(server->redirect_events, id));
+		g_hash_table_insert(server->redirect_events, id, GINT_TO_POINTER(count + 1));
+	}
+}
+
+static void redirect_events_unref(IRC_SERVER_REC *server, REDIRECT_CMD_REC *cmd)
+{
+	GHashTableIter iter;
+	gpointer id;
+	int count;
+
+	g_hash_table_iter_init(&iter, cmd->events);
+	while (g_hash_table_iter_next(&iter, &id, NULL)) {
+		count = GPOINTER_TO_INT(g_hash_table_lookup(server->redirect_events, id));
+		if (count <= 1)
+			g_hash_table_remove(server->redirect_events, id);
+		else
+			g_hash_table_insert(server->redirect_events, id, GINT_TO_POINTER(count - 1));
+	}
+}
+
 void server_redirect_command(IRC_SERVER_REC *server, const char *command,
 			     REDIRECT_REC *redirect)
 {
@@ -293,13 +381,27 @@ void server_redirect_command(IRC_SERVER_REC *server, const char *command,
 		redirect->remote = cmdrec->remote;
 	}
 
+	redirect_events_ref(server, redirect->cmd);
 	server->redirects = g_slist_append(server->redirects, redirect);
 }
 
+static int redirect_arg_equal(const char *event_arg, size_t len,
+			      const char *arg)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (i_toupper(arg[i]) != i_toupper(event_arg[i]))
+			return FALSE;
+	}
+
+	return arg[len] == '\0';
+}
+
 static int redirect_args_match(const char *event_args,
-			       const char *arg, int pos)
+			       char **args, int pos)
 {
-	const char *start;
+	size_t len;
 
 	if (pos == -1)
 		return TRUE;
@@ -312,51 +414,27 @@ static int redirect_args_match(const char *event_args,
 	}
 
 	/* now compare the arguments */
-	start = event_args;
-	while (*arg != '\0') {
-		while (*arg != '\0' && *arg != ' ' && *event_args != '\0') {
-			if (i_toupper(*arg) != i_toupper(*event_args))
-				break;
-			arg++; event_args++;
-		}
-
-		if ((*arg == '\0' || *arg == ' ') &&
-		    (*event_args == '\0' || *event_args == ' '))
+	len = strcspn(event_args, " ");
+	for (; *args != NULL; args++) {
+		if (redirect_arg_equal(event_args, len, *args))
 			return TRUE;
-
-                /* compare the next argument */
-		while (*arg != ' ' && *arg != '\0') arg++;
-                while (*arg == ' ') arg++;
-
-		event_args = start;
 	}
 
         return FALSE;
 }
 
-static GSList *redirect_cmd_list_find(GSList *list, const char *event)
-{
-	while (list != NULL) {
-		const char *str = list->data;
-
-		if (g_strcmp0(str, event) == 0)
-                        break;
-                list = list->next->next;
-	}
-
-        return list;
-}
-
 #define MATCH_NONE      0
 #define MATCH_START	1
 #define MATCH_STOP	2
 
-static const char *redirect_match(REDIRECT_REC *redirect, const char *event,
-				  const char *args, int *match)
+static const char *redirect_match(REDIRECT_REC *redirect, int event_id,
+				  const char *event, const char *args,
+				  int *match)
 {
-	GSList *tmp, *cmdpos;
+	REDIRECT_EVENT_REC *cmdevent;
+	GSList *tmp;
 	const char *signal;
-        int match_list;
+        int match_list, argpos;
 
 	if (redirect->aborted)
                 return NULL;
@@ -372,52 +450,49 @@ static const char *redirect_match(REDIRECT_REC *redirect, const char *event,
 	}
 
 	/* find the argument position */
+	cmdevent = g_hash_table_lookup(redirect->cmd->events,
+				       GINT_TO_POINTER(event_id));
+	argpos = ARGPOS_NONE;
 	if (redirect->destroyed) {
 		/* stop event is already found for this redirection, but
 		   we'll still want to look for optional events */
-		cmdpos = redirect_cmd_list_find(redirect->cmd->opt, event);
-		if (cmdpos == NULL)
+		if (cmdevent == NULL || cmdevent->opt == ARGPOS_NONE)
 			return NULL;
 
+		argpos = cmdevent->opt;
                 match_list = MATCH_STOP;
-	} else {
+	} else if (cmdevent != NULL && cmdevent->start != ARGPOS_NONE) {
                 /* look from start/stop lists */
-		cmdpos = redirect_cmd_list_find(redirect->cmd->start, event);
-		if (cmdpos != NULL)
-			match_list = MATCH_START;
-		else {
-			cmdpos = redirect_cmd_list_find(redirect->cmd->stop,
-							event);
-			if (cmdpos != NULL)
-				match_list = MATCH_STOP;
-			else if (redirect->default_signal != NULL &&
-					args == NULL &&
-					strncmp(event, "event ", 6) == 0 &&
-					i_isdigit(event[6])) {
-				/* If there is a default signal, the
-				 * redirection has already started and
-				 * this is a numeric, use it */
-				/* XXX this should depend on the
-				 * REDIRECT_CMD_REC, not REDIRECT_REC */
-				if (signal == NULL)
-					signal = redirect->default_signal;
-				match_list = MATCH_START;
-			} else {
-				match_list = MATCH_NONE;
-			}
-		}
+		argpos = cmdevent->start;
+		match_list = MATCH_START;
+	} else if (cmdevent != NULL && cmdevent->stop != ARGPOS_NONE) {
+		argpos = cmdevent->stop;
+		match_list = MATCH_STOP;
+	} else if (redirect->default_signal != NULL &&
+		   args == NULL &&
+		   strncmp(event, "event ", 6) == 0 &&
+		   i_isdigit(event[6])) {
+		/* If there is a default signal, the
+		 * redirection has already started and
+		 * this is a numeric, use it */
+		/* XXX this should depend on the
+		 * REDIRECT_CMD_REC, not REDIRECT_REC */
+		if (signal == NULL)
+			signal = redirect->default_signal;
+		match_list = MATCH_START;
+	} else {
+		match_list = MATCH_NONE;
 	}
 
-	if (signal == NULL && cmdpos == NULL) {
+	if (signal == NULL && argpos == ARGPOS_NONE) {
 		/* event not found from specified redirection events nor
 		   registered command events, and no default signal */
 		return NULL;
 	}
 
 	/* check that arguments match */
-	if (args != NULL && redirect->arg != NULL && cmdpos != NULL &&
-	    !redirect_args_match(args, redirect->arg,
-				 GPOINTER_TO_INT(cmdpos->next->data)))
+	if (args != NULL && redirect->args != NULL && argpos != ARGPOS_NONE &&
+	    !redirect_args_match(args, redirect->args, argpos))
 		return NULL;
 
         *match = match_list;
@@ -449,7 +524,10 @@ static void redirect_abort(IRC_SERVER_REC *server, REDIRECT_REC *rec)
 	}
 
 	server->redirect_active = g_slist_remove(server->redirect_active, rec);
+	if (rec->destroyed)
+		server->redirects_destroyed--;
 
+	redirect_events_unref(server, rec->cmd);
 	server_redirect_destroy(rec);
 }
 
@@ -457,9 +535,23 @@ static void redirect_abort(IRC_SERVER_REC *server, REDIRECT_REC *rec)
 	((now-(rec)->created) > (rec)->cmd->timeout)
 
 
-static REDIRECT_REC *redirect_find(IRC_SERVER_REC *server, const char *event,
-				   const char *args, const char **signal,
-				   int *match)
+/* Remove the redirections that have already received their stop events */
+static void redirect_remove_destroyed(IRC_SERVER_REC *server)
+{
+	GSList *tmp, *next;
+
+	for (tmp = server->redirects; tmp != NULL && server->redirects_destroyed > 0; tmp = next) {
+		REDIRECT_REC *rec = tmp->data;
+
+		next = tmp->next;
+		if (rec->destroyed)
+			redirect_abort(server, rec);
+	}
+}
+
+static REDIRECT_REC *redirect_find(IRC_SERVER_REC *server, int event_id,
+				   const char *event, const char *args,
+				   const char **signal, int *match)
 {
         REDIRECT_REC *redirect;
 	GSList *tmp, *next;
@@ -475,7 +567,7 @@ static REDIRECT_REC *redirect_find(IRC_SERVER_REC *server, const char *event,
 		if (g_slist_find(server->redirect_active, rec) != NULL)
 			continue;
 
-		match_signal = redirect_match(rec, event, args, match);
+		match_signal = redirect_match(rec, event_id, event, args, match);
 		if (match_signal != NULL && *match != MATCH_NONE) {
 			redirect = rec;
                         *signal = match_signal;
@@ -483,9 +575,10 @@ static REDIRECT_REC *redirect_find(IRC_SERVER_REC *server, const char *event,
 		}
 	}
 
-	if (g_strcmp0("event 263", event) == 0) { /* RPL_TRYAGAIN */
-		char *params, *command;
+	if (event_id == signal_tryagain) { /* RPL_TRYAGAIN */
+		char *params, *command, *cmdargs[2];
 		params = event_get_params(args, 3, NULL, &command, NULL);
+		cmdargs[0] = command; cmdargs[1] = NULL;
 
 		for (tmp = server->redirects; tmp != NULL; tmp = next) {
 			REDIRECT_REC *rec = tmp->data;
@@ -498,7 +591,7 @@ static REDIRECT_REC *redirect_find(IRC_SERVER_REC *server, const char *event,
 			if (g_slist_find(server->redirect_active, rec) != NULL)
 				continue;
 
-			if (redirect_args_match(rec->cmd->name, command, rec->cmd->pos)) {
+			if (redirect_args_match(rec->cmd->name, cmdargs, rec->cmd->pos)) {
 				/* the server crashed our command with RPL_TRYAGAIN, send the
 				   failure */
 				rec->aborted = TRUE;
@@ -544,6 +637,7 @@ server_redirect_get(IRC_SERVER_REC *server, const char *prefix,
 	const char *signal = NULL;
 	GSList *ptr, *next;
 	REDIRECT_REC *r;
+	int event_id;
 
         *redirect = NULL;
 	*match = MATCH_NONE;
@@ -551,6 +645,8 @@ server_redirect_get(IRC_SERVER_REC *server, const char *prefix,
 	if (server->redirects == NULL)
 		return NULL;
 
+	event_id = signal_get_uniq_id(event);
+
 	for (ptr = server->redirect_active; ptr != NULL; ptr = next) {
 		next = ptr->next;
 		r = ptr->data;
@@ -562,7 +658,7 @@ server_redirect_get(IRC_SERVER_REC *server, const char *prefix,
 		/* redirection is already started, now we'll just need to
 		   keep redirecting until stop-event is found. */
 		*redirect = r;
-		signal = redirect_match(*redirect, event, NULL, match);
+		signal = redirect_match(*redirect, event_id, event, NULL, match);
 		if (signal == NULL) {
 			/* not a numeric, so we've lost the
 			   stop event.. */
@@ -575,9 +671,15 @@ server_redirect_get(IRC_SERVER_REC *server, const char *prefix,
 			break;
 	}
 
-	if (*redirect == NULL) {
+	if (*redirect == NULL && event_id != signal_tryagain &&
+	    !g_hash_table_contains(server->redirect_events,
+				   GINT_TO_POINTER(event_id))) {
+		/* none of the redirections are waiting for this event */
+		redirect_remove_destroyed(server);
+	} else if (*redirect == NULL) {
                 /* find the redirection */
-		*redirect = redirect_find(server, event, args, &signal, match);
+		*redirect = redirect_find(server, event_id, event, args,
+					  &signal, match);
 	}
 
 	/* remember which server is replying to our request */
@@ -613,8 +715,10 @@ const char *server_redirect_get_signal(IRC_SERVER_REC *server,
 		/* stop event - remove this redirection next time this
 		   function is called (can't destroy now or our return
 		   value would be corrupted) */
-                if (--redirect->count <= 0)
+		if (--redirect->count <= 0 && !redirect->destroyed) {
 			redirect->destroyed = TRUE;
+			server->redirects_destroyed++;
+		}
 		server->redirect_active = g_slist_remove(server->redirect_active, redirect);
 	}
 
@@ -647,6 +751,12 @@ static void sig_disconnected(IRC_SERVER_REC *server)
 			(GFunc) server_redirect_destroy, NULL);
 	g_slist_free(server->redirects);
         server->redirects = NULL;
+	server->redirects_destroyed = 0;
+
+	if (server->redirect_events != NULL) {
+		g_hash_table_destroy(server->redirect_events);
+		server->redirect_events = NULL;
+	}
 
 	if (server->redirect_next != NULL) {
 		server_redirect_destroy(server->redirect_next);
@@ -662,6 +772,7 @@ static void cmd_redirect_destroy(char *key, REDIRECT_CMD_REC *cmd)
 void servers_redirect_init(void)
 {
 	command_redirects = g_hash_table_new((GHashFunc) g_str_hash, (GCompareFunc) g_str_equal);
+	signal_tryagain = signal_get_uniq_id("event 263");
 
 	/* WHOIS - register as remote command by default
 	   with a default timeout */
@@ -7,4 +7,7 @@ typedef struct {
 #include <irssi/src/irc/dcc/dcc-file-rec.h>
 } FILE_DCC_REC;
 
+/* Send "dcc transfer update" signal, unless it was sent just a moment ago */
+void dcc_file_transfer_update(FILE_DCC_REC *dcc);
+
 #endif
@@ -29,8 +29,16 @@
 
 #include <irssi/src/irc/dcc/dcc-get.h>
 #include <irssi/src/irc/dcc/dcc-send.h>
+#include <irssi/src/irc/dcc/dcc-file.h>
+#include <irssi/src/irc/dcc/dcc-writer.h>
 
-static char *dcc_get_recv_buffer;
+/* max. bytes received to one transfer before going back to the main loop */
+#define DCC_GET_MAX_BATCH (4*1024*1024)
+
+/* how often a paused transfer checks if the writer has caught up */
+#define DCC_GET_WAIT_MSECS 10
+
+static int dcc_get_write_buffer;
 
 GET_DCC_REC *dcc_get_create(IRC_SERVER_REC *server, CHAT_DCC_REC *chat,
 				   const char *nick, const char *arg)
@@ -41,6 +49,7 @@ GET_DCC_REC *dcc_get_create(IRC_SERVER_REC *server, CHAT_DCC_REC *chat,
 	dcc->orig_type = module_get_uniq_id_str("DCC", "SEND");
 	dcc->type = module_get_uniq_id_str("DCC", "GET");
 	dcc->fhandle = -1;
+	dcc->tagwait = -1;
 
 	dcc_init_rec(DCC(dcc), server, chat, nick, arg);
 	if (dcc->module_data == NULL) {
@@ -57,9 +66,24 @@ static void sig_dcc_destroyed(GET_DCC_REC *dcc)
 	if (!IS_DCC_GET(dcc)) return;
 
 	g_free_not_null(dcc->file);
+	if (dcc->tagwait != -1) g_source_remove(dcc->tagwait);
+	if (dcc->writer != NULL) dcc_writer_destroy(dcc->writer);
 	if (dcc->fhandle != -1) close(dcc->fhandle);
 }
 
+/* the file must be complete before anyone else hears it's closed */
+static void sig_dcc_closed(GET_DCC_REC *dcc)
+{
+	int error;
+
+	if (!IS_DCC_GET(dcc) || dcc->writer == NULL) return;
+
+	error = dcc_writer_destroy(dcc->writer);
+	dcc->writer = NULL;
+	if (error != 0)
+		signal_emit("dcc error write", 2, dcc, g_strerror(error));
+}
+
 char *dcc_get_download_path(const char *fname)
 {
 	char *str, *downpath;
@@ -145,20 +169,49 @@ static void sig_dccget_send(GET_DCC_REC *dcc)
                 dcc_get_send_received(dcc);
 }
 
-#define DCC_GET_RECV_BUFFER_SIZE 32768
+static void sig_dccget_receive(GET_DCC_REC *dcc);
+
+static int dccget_check_write_error(GET_DCC_REC *dcc)
+{
+	int error;
+
+	error = dcc_writer_error(dcc->writer);
+	if (error == 0)
+		return FALSE;
+
+	/* most probably out of disk space */
+	dcc_writer_destroy(dcc->writer);
+	dcc->writer = NULL;
+	signal_emit("dcc error write", 2, dcc, g_strerror(error));
+	dcc_close(DCC(dcc));
+	return TRUE;
+}
+
+/* timeout function: continue reading when the writer has caught up */
+static int sig_dccget_wait(GET_DCC_REC *dcc)
+{
+	if (dccget_check_write_error(dcc))
+		return FALSE;
+
+	dcc_writer_flush(dcc->writer);
+	if (dcc_writer_pending(dcc->writer) > dcc_get_write_buffer / 2)
+		return TRUE;
+
+	dcc->tagwait = -1;
+	dcc->tagread =
+	    i_input_add(dcc->handle, I_INPUT_READ, (GInputFunction) sig_dccget_receive, dcc);
+	return FALSE;
+}
 
 /* input function: DCC GET received data */
 static void sig_dccget_receive(GET_DCC_REC *dcc)
 {
-	int ret;
-
-	if (dcc_get_recv_buffer == NULL) {
-		dcc_get_recv_buffer = g_malloc(DCC_GET_RECV_BUFFER_SIZE);
-	}
+	char *buffer;
+	int ret, size, received;
 
-	for (;;) {
-		ret = net_receive(dcc->handle, dcc_get_recv_buffer,
-				  DCC_GET_RECV_BUFFER_SIZE);
+	for (received = 0; received < DCC_GET_MAX_BATCH; received += ret) {
+		buffer = dcc_writer_buffer(dcc->writer, &size);
+		ret = net_receive(dcc->handle, buffer, size);
 		if (ret == 0) break;
 
 		if (ret < 0) {
@@ -168,22 +221,31 @@ static void sig_dccget_receive(GET_DCC_REC *dcc)
 			return;
 		}
 
-		if (write(dcc->fhandle, dcc_get_recv_buffer, ret) != ret) {
-			/* most probably out of disk space */
-			signal_emit("dcc error write", 2,
-				    dcc, g_strerror(errno));
-			dcc_close(DCC(dcc));
-                        return;
-		}
+		dcc_writer_commit(dcc->writer, ret);
 		dcc->transfd += ret;
-		break;
 	}
 
-	/* send number of total bytes received */
+	if (dccget_check_write_error(dcc))
+		return;
+	dcc_writer_flush(dcc->writer);
+
+	if (received == 0)
+		return;
+
+	/* send number of total bytes received, once for everything
+	   that was read now */
 	if (dcc->count_pos <= 0)
 		dcc_get_send_received(dcc);
 
-	signal_emit("dcc transfer update", 1, dcc);
+	dcc_file_transfer_update((FILE_DCC_REC *) dcc);
+
+	if (dcc_writer_pending(dcc->writer) > dcc_get_write_buffer) {
+		/* the disk can't keep up, stop reading for a while */
+		g_source_remove(dcc->tagread);
+		dcc->tagread = -1;
+		dcc->tagwait = g_timeout_add(DCC_GET_WAIT_MSECS,
+					     (GSourceFunc) sig_dccget_wait, dcc);
+	}
 }
 
 /* callback: net_connect() finished for DCC GET */
@@ -284,6 +346,7 @@ void sig_dccget_connected(GET_DCC_REC *dcc)
 		dcc_close(DCC(dcc));
 		return;
 	}
+	dcc->writer = dcc_writer_new(dcc->fhandle, dcc->size);
 	dcc->tagread =
 	    i_input_add(dcc->handle, I_INPUT_READ, (GInputFunction) sig_dccget_receive, dcc);
 	signal_emit("dcc connected", 1, dcc);
@@ -603,13 +666,22 @@ static void cmd_dcc_get(const char *data)
 	cmd_dcc_receive(data, dcc_get_connect, dcc_get_passive);
 }
 
+static void read_settings(void)
+{
+	dcc_get_write_buffer = settings_get_size("dcc_get_write_buffer");
+}
+
 void dcc_get_init(void)
 {
         dcc_register_type("GET");
 	settings_add_bool("dcc", "dcc_autorename", FALSE);
 	settings_add_str("dcc", "dcc_download_path", "~");
 	settings_add_int("dcc", "dcc_file_create_mode", 644);
+	settings_add_size("dcc", "dcc_get_write_buffer", "4M");
+	read_settings();
 
+	signal_add("setup changed", (SIGNAL_FUNC) read_settings);
+	signal_add_first("dcc closed", (SIGNAL_FUNC) sig_dcc_closed);
 	signal_add("dcc destroyed", (SIGNAL_FUNC) sig_dcc_destroyed);
 	signal_add("ctcp msg dcc send", (SIGNAL_FUNC) ctcp_msg_dcc_send);
 	command_bind("dcc get", NULL, (SIGNAL_FUNC) cmd_dcc_get);
@@ -618,8 +690,9 @@ void dcc_get_init(void)
 void dcc_get_deinit(void)
 {
         dcc_unregister_type("GET");
+	signal_remove("setup changed", (SIGNAL_FUNC) read_settings);
+	signal_remove("dcc closed", (SIGNAL_FUNC) sig_dcc_closed);
 	signal_remove("dcc destroyed", (SIGNAL_FUNC) sig_dcc_destroyed);
 	signal_remove("ctcp msg dcc send", (SIGNAL_FUNC) ctcp_msg_dcc_send);
 	command_unbind("dcc get", (SIGNAL_FUNC) cmd_dcc_get);
-	g_free_and_null(dcc_get_recv_buffer);
 }
@@ -30,14 +30,24 @@
 
 #include <irssi/src/irc/dcc/dcc-send.h>
 #include <irssi/src/irc/dcc/dcc-chat.h>
+#include <irssi/src/irc/dcc/dcc-file.h>
 #include <irssi/src/irc/dcc/dcc-queue.h>
 
 #include <glob.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#  include <sys/sendfile.h>
+#endif
 
 #ifndef GLOB_TILDE
 #  define GLOB_TILDE 0 /* unsupported */
 #endif
 
+/* max. bytes sent to one transfer before going back to the main loop */
+#define DCC_SEND_MAX_BATCH (4*1024*1024)
+
+static char *dcc_send_buffer;
+static int dcc_send_buffer_size;
+
 static int dcc_send_one_file(int queue, const char *target, const char *fname,
 			     IRC_SERVER_REC *server, CHAT_DCC_REC *chat,
 			     int passive);
@@ -257,28 +267,75 @@ static void sig_dcc_destroyed(SEND_DCC_REC *dcc)
 }
 
 /* input function: DCC SEND - we're ready to send more data */
-static void dcc_send_data(SEND_DCC_REC *dcc)
+int dcc_send_file_data(SEND_DCC_REC *dcc, int max)
 {
-        char buffer[512];
 	int ret;
 
-	ret = read(dcc->fhandle, buffer, sizeof(buffer));
-	if (ret <= 0) {
-		/* no need to call this function anymore..
-		   in fact it just eats all the cpu.. */
-		dcc->waitforend = TRUE;
-		g_source_remove(dcc->tagwrite);
-		dcc->tagwrite = -1;
-		return;
+	g_return_val_if_fail(dcc != NULL, -1);
+
+#ifdef HAVE_SYS_SENDFILE_H
+	if (!dcc->no_sendfile) {
+		off_t offset = dcc->transfd;
+
+		/* the file goes to the socket without being copied to us */
+		ret = sendfile(g_io_channel_unix_get_fd(dcc->handle),
+			       dcc->fhandle, &offset, max);
+		if (ret > 0) {
+			dcc->transfd += ret;
+			return ret;
+		}
+		if (ret == 0)
+			return -1;
+		if (errno != EINVAL && errno != ENOSYS)
+			return 0;
+
+		/* not supported for this file, read it ourself */
+		dcc->no_sendfile = TRUE;
 	}
+#endif
 
-	ret = net_transmit(dcc->handle, buffer, ret);
-	if (ret > 0) dcc->transfd += ret;
-	dcc->gotalldata = FALSE;
+	if (dcc_send_buffer == NULL)
+		dcc_send_buffer = g_malloc(dcc_send_buffer_size);
+	if (max > dcc_send_buffer_size)
+		max = dcc_send_buffer_size;
+
+	/* the file position doesn't matter, so nothing needs to be
+	   seeked back after partial writes */
+	ret = pread(dcc->fhandle, dcc_send_buffer, max, dcc->transfd);
+	if (ret <= 0)
+		return -1;
+
+	ret = net_transmit(dcc->handle, dcc_send_buffer, ret);
+	if (ret <= 0)
+		return 0;
+
+	dcc->transfd += ret;
+	return ret;
+}
 
-	lseek(dcc->fhandle, dcc->transfd, SEEK_SET);
+static void dcc_send_data(SEND_DCC_REC *dcc)
+{
+	int ret, sent;
+
+	/* send as much as the socket takes, but let the rest of irssi
+	   run now and then */
+	for (sent = 0; sent < DCC_SEND_MAX_BATCH; sent += ret) {
+		ret = dcc_send_file_data(dcc, DCC_SEND_MAX_BATCH - sent);
+		if (ret == -1) {
+			/* no need to call this function anymore..
+			   in fact it just eats all the cpu.. */
+			dcc->waitforend = TRUE;
+			g_source_remove(dcc->tagwrite);
+			dcc->tagwrite = -1;
+			break;
+		}
+		if (ret == 0)
+			break;
+	}
+	dcc->gotalldata = FALSE;
 
-	signal_emit("dcc transfer update", 1, dcc);
+	if (sent > 0)
+		dcc_file_transfer_update((FILE_DCC_REC *) dcc);
 }
 
 /* input function: DCC SEND - received some data */
@@ -463,11 +520,30 @@ static int dcc_send_one_file(int queue, const char *target, const char *fname,
 	return TRUE;
 }
 
+static void read_settings(void)
+{
+	int size;
+
+	size = settings_get_size("dcc_send_buffer_size");
+	if (size < 512)
+		size = 512;
+
+	if (size != dcc_send_buffer_size) {
+		g_free(dcc_send_buffer);
+		dcc_send_buffer = NULL;
+		dcc_send_buffer_size = size;
+	}
+}
+
 void dcc_send_init(void)
 {
         dcc_register_type("SEND");
 	settings_add_str("dcc", "dcc_upload_path", "~");
 	settings_add_bool("dcc", "dcc_send_replace_space_with_underscore", FALSE);
+	settings_add_size("dcc", "dcc_send_buffer_size", "64k");
+	read_settings();
+
+	signal_add("setup changed", (SIGNAL_FUNC) read_settings);
 	signal_add("dcc destroyed", (SIGNAL_FUNC) sig_dcc_destroyed);
 	signal_add("dcc reply send pasv", (SIGNAL_FUNC) dcc_send_connect);
 	command_bind("dcc send", NULL, (SIGNAL_FUNC) cmd_dcc_send);
@@ -481,7 +557,12 @@ void dcc_send_deinit(void)
 	dcc_queue_deinit();
 
         dcc_unregister_type("SEND");
+	signal_remove("setup changed", (SIGNAL_FUNC) read_settings);
 	signal_remove("dcc destroyed", (SIGNAL_FUNC) sig_dcc_destroyed);
 	signal_remove("dcc reply send pasv", (SIGNAL_FUNC) dcc_send_connect);
 	command_unbind("dcc send", (SIGNAL_FUNC) cmd_dcc_send);
+
+	g_free(dcc_send_buffer);
+	dcc_send_buffer = NULL;
+	dcc_send_buffer_size = 0;
 }
@@ -17,10 +17,16 @@ typedef struct {
 	/* fastsending: */
 	unsigned int waitforend:1; /* file is sent, just wait for the replies from the other side */
 	unsigned int gotalldata:1; /* got all acks from the other end (needed to make sure the end of transfer works right) */
+	unsigned int no_sendfile:1; /* sendfile() doesn't work for this transfer */
 } SEND_DCC_REC;
 
 #define DCC_SEND_TYPE module_get_uniq_id_str("DCC", "SEND")
 
+/* Send up to `max' bytes of the file. Returns the number of bytes sent,
+   0 if the socket can't take more data right now, or -1 if the whole file
+   has been read. */
+int dcc_send_file_data(SEND_DCC_REC *dcc, int max);
+
 void dcc_send_init(void);
 void dcc_send_deinit(void);
 
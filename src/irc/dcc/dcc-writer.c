@@ -0,0 +1,195 @@
+/*
+ dcc-writer.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/* for fallocate() */
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+
+#include "module.h"
+#include <irssi/src/irc/dcc/dcc-writer.h>
+
+#include <fcntl.h>
+
+/* data is given to the writer thread in chunks of this size */
+#define DCC_WRITER_CHUNK_SIZE (256*1024)
+
+typedef struct {
+	int len; /* 0 tells the thread to stop */
+	char data[DCC_WRITER_CHUNK_SIZE];
+} DCC_WRITER_CHUNK;
+
+struct _DCC_WRITER_REC {
+	int fd;
+	GThread *thread;
+	GAsyncQueue *queue; /* DCC_WRITER_CHUNK */
+
+	DCC_WRITER_CHUNK *chunk; /* being filled, not yet given to the thread */
+
+	/* these are changed by the thread too */
+	int pending; /* bytes given to the thread, not yet written */
+	int error;
+};
+
+static int write_all(int fd, const char *data, int len)
+{
+	int ret;
+
+	while (len > 0) {
+		ret = write(fd, data, len);
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return ret == 0 ? ENOSPC : errno;
+
+		data += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+static gpointer writer_thread(DCC_WRITER_REC *writer)
+{
+	DCC_WRITER_CHUNK *chunk;
+	int error;
+
+	while ((chunk = g_async_queue_pop(writer->queue))->len != 0) {
+		/* after a failure the rest of the data is just thrown away */
+		if (g_atomic_int_get(&writer->error) == 0) {
+			error = write_all(writer->fd, chunk->data, chunk->len);
+			if (error != 0)
+				g_atomic_int_set(&writer->error, error);
+		}
+
+		g_atomic_int_add(&writer->pending, -chunk->len);
+		g_free(chunk);
+	}
+
+	g_free(chunk);
+	return NULL;
+}
+
+static void writer_push(DCC_WRITER_REC *writer, DCC_WRITER_CHUNK *chunk)
+{
+	g_atomic_int_add(&writer->pending, chunk->len);
+	g_async_queue_push(writer->queue, chunk);
+}
+
+DCC_WRITER_REC *dcc_writer_new(int fd, uoff_t size)
+{
+	DCC_WRITER_REC *writer;
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE)
+	off_t pos;
+
+	/* reserve the space now to keep the file from fragmenting. the
+	   file size stays the same, so an interrupted transfer can still
+	   be resumed from the right position. */
+	pos = lseek(fd, 0, SEEK_CUR);
+	if (pos != -1 && size > (uoff_t) pos)
+		(void) fallocate(fd, FALLOC_FL_KEEP_SIZE, pos, size - pos);
+#endif
+
+	writer = g_new0(DCC_WRITER_REC, 1);
+	writer->fd = fd;
+	writer->queue = g_async_queue_new();
+	writer->thread = g_thread_new("dcc writer",
+				      (GThreadFunc) writer_thread, writer);
+	return writer;
+}
+
+int dcc_writer_destroy(DCC_WRITER_REC *writer)
+{
+	int error;
+
+	g_return_val_if_fail(writer != NULL, -1);
+
+	if (writer->chunk != NULL && writer->chunk->len > 0) {
+		writer_push(writer, writer->chunk);
+		writer->chunk = NULL;
+	}
+
+	/* stop the thread after it has written everything */
+	if (writer->chunk == NULL)
+		writer->chunk = g_new(DCC_WRITER_CHUNK, 1);
+	writer->chunk->len = 0;
+	g_async_queue_push(writer->queue, writer->chunk);
+	g_thread_join(writer->thread);
+
+	error = writer->error;
+	g_async_queue_unref(writer->queue);
+	g_free(writer);
+	return error;
+}
+
+char *dcc_writer_buffer(DCC_WRITER_REC *writer, int *size)
+{
+	g_return_val_if_fail(writer != NULL, NULL);
+	g_return_val_if_fail(size != NULL, NULL);
+
+	if (writer->chunk == NULL) {
+		writer->chunk = g_new(DCC_WRITER_CHUNK, 1);
+		writer->chunk->len = 0;
+	}
+
+	*size = DCC_WRITER_CHUNK_SIZE - writer->chunk->len;
+	return writer->chunk->data + writer->chunk->len;
+}
+
+void dcc_writer_commit(DCC_WRITER_REC *writer, int len)
+{
+	g_return_if_fail(writer != NULL);
+	g_return_if_fail(writer->chunk != NULL);
+	g_return_if_fail(len >= 0 && writer->chunk->len + len <= DCC_WRITER_CHUNK_SIZE);
+
+	writer->chunk->len += len;
+	if (writer->chunk->len == DCC_WRITER_CHUNK_SIZE) {
+		writer_push(writer, writer->chunk);
+		writer->chunk = NULL;
+	}
+}
+
+void dcc_writer_flush(DCC_WRITER_REC *writer)
+{
+	g_return_if_fail(writer != NULL);
+
+	/* while the thread is busy, more data is collected to the chunk so
+	   it gets written with fewer calls */
+	if (writer->chunk == NULL || writer->chunk->len == 0 ||
+	    g_atomic_int_get(&writer->pending) > 0)
+		return;
+
+	writer_push(writer, writer->chunk);
+	writer->chunk = NULL;
+}
+
+int dcc_writer_pending(DCC_WRITER_REC *writer)
+{
+	g_return_val_if_fail(writer != NULL, 0);
+
+	return g_atomic_int_get(&writer->pending) +
+		(writer->chunk == NULL ? 0 : writer->chunk->len);
+}
+
+int dcc_writer_error(DCC_WRITER_REC *writer)
+{
+	g_return_val_if_fail(writer != NULL, 0);
+
+	return g_atomic_int_get(&writer->error);
+}
@@ -0,0 +1,30 @@
+#ifndef IRSSI_IRC_DCC_DCC_WRITER_H
+#define IRSSI_IRC_DCC_DCC_WRITER_H
+
+/* Writes received DCC data to the file in a separate thread, so a slow
+   disk doesn't block irssi. The data is written in the order it's given,
+   starting from the file's current position. */
+
+typedef struct _DCC_WRITER_REC DCC_WRITER_REC;
+
+/* Space for `size' more bytes of the file is preallocated if possible */
+DCC_WRITER_REC *dcc_writer_new(int fd, uoff_t size);
+/* Wait until everything is written and free the writer. Returns 0 if all
+   the data was written, otherwise the errno of the failed write. */
+int dcc_writer_destroy(DCC_WRITER_REC *writer);
+
+/* Returns a buffer for the next data, `size' is set to its size. The
+   buffer is valid until dcc_writer_commit() is called. */
+char *dcc_writer_buffer(DCC_WRITER_REC *writer, int *size);
+/* `len' bytes were put to the buffer */
+void dcc_writer_commit(DCC_WRITER_REC *writer, int len);
+/* Start writing the buffered data now, unless earlier data is still
+   being written */
+void dcc_writer_flush(DCC_WRITER_REC *writer);
+
+/* Returns the number of bytes that haven't been written yet */
+int dcc_writer_pending(DCC_WRITER_REC *writer);
+/* Returns 0, or the errno of a failed write */
+int dcc_writer_error(DCC_WRITER_REC *writer);
+
+#endif
@@ -31,6 +31,7 @@
 #include <irssi/src/core/servers-setup.h>
 
 #include <irssi/src/irc/dcc/dcc-chat.h>
+#include <irssi/src/irc/dcc/dcc-file.h>
 #include <irssi/src/irc/dcc/dcc-get.h>
 #include <irssi/src/irc/dcc/dcc-send.h>
 #include <irssi/src/irc/dcc/dcc-server.h>
@@ -441,6 +442,23 @@ void dcc_reject(DCC_REC *dcc, IRC_SERVER_REC *server)
 	dcc_close(dcc);
 }
 
+/* how often "dcc transfer update" is sent during transfers */
+#define DCC_UPDATE_INTERVAL (G_USEC_PER_SEC / 5)
+
+void dcc_file_transfer_update(FILE_DCC_REC *dcc)
+{
+	gint64 now;
+
+	g_return_if_fail(dcc != NULL);
+
+	now = g_get_monotonic_time();
+	if (now - dcc->last_update < DCC_UPDATE_INTERVAL)
+		return;
+
+	dcc->last_update = now;
+	signal_emit("dcc transfer update", 1, dcc);
+}
+
 static int dcc_timeout_func(void)
 {
 	GSList *tmp, *next;
@@ -451,6 +469,10 @@ static int dcc_timeout_func(void)
 		DCC_REC *dcc = tmp->data;
 
 		next = tmp->next;
+		if (IS_DCC_GET(dcc) && DCC_GET(dcc)->tagwait != -1) {
+			/* connected, but waiting for the disk to catch up */
+			continue;
+		}
 		if (dcc->tagread == -1 && now > dcc->created && !IS_DCC_SERVER(dcc)) {
 			/* Timed out - don't send DCC REJECT CTCP so CTCP
 			   flooders won't affect us and it really doesn't
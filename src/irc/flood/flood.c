@@ -32,66 +32,65 @@
 void autoignore_init(void);
 void autoignore_deinit(void);
 
+/* Messages of one nick with one level to one target. The newest message
+   times are kept in a ring that has room for flood_max_msgs+1 entries,
+   which is all that is needed to see if there were too many. */
 typedef struct {
+	char *nick;
 	char *target;
 	int level;
 
-	GSList *msgtimes;
-} FLOOD_ITEM_REC;
-
-typedef struct {
-	char *nick;
-        GSList *items;
+	GList link; /* in MODULE_SERVER_REC->floodqueue */
+	int first, count, size;
+	time_t msgtimes[1];
 } FLOOD_REC;
 
 static int flood_tag;
-static int flood_max_msgs, flood_timecheck;
+static int flood_max_msgs, flood_timecheck, flood_max_records;
 
-static int flood_hash_check_remove(const char *key, FLOOD_REC *flood,
-				   time_t *now)
+static unsigned int flood_hash(const FLOOD_REC *flood)
 {
-	GSList *tmp, *next, *times, *tnext;
-
-	g_return_val_if_fail(key != NULL, FALSE);
-	g_return_val_if_fail(flood != NULL, FALSE);
-
-	for (tmp = flood->items; tmp != NULL; tmp = next) {
-		FLOOD_ITEM_REC *rec = tmp->data;
+	return (i_istr_hash(flood->nick) * 31 + i_istr_hash(flood->target)) ^
+		(unsigned int) flood->level;
+}
 
-		next = tmp->next;
-		/* remove old time entries for current rec item */
-		for (times = rec->msgtimes; times != NULL; times = tnext) {
-                        time_t *data = times->data;
-			tnext = times->next;
+static int flood_equal(const FLOOD_REC *a, const FLOOD_REC *b)
+{
+	return a->level == b->level &&
+		g_ascii_strcasecmp(a->nick, b->nick) == 0 &&
+		g_ascii_strcasecmp(a->target, b->target) == 0;
+}
 
-			if (*now-*((time_t *) times->data) >= flood_timecheck) {
-				rec->msgtimes = g_slist_remove(rec->msgtimes, data);
-				g_free(data);
-			}
-		}
-		/* if no more time entries remove rec item */
-		if (rec->msgtimes == NULL) {
-			flood->items = g_slist_remove(flood->items, rec);
-			g_free(rec->target);
-			g_free(rec);
-		}
-	}
+static time_t flood_last_time(FLOOD_REC *flood)
+{
+	return flood->msgtimes[(flood->first + flood->count - 1) % flood->size];
+}
 
-	if (flood->items != NULL)
-		return FALSE;
+static void flood_destroy(MODULE_SERVER_REC *mserver, FLOOD_REC *flood)
+{
+	g_queue_unlink(mserver->floodqueue, &flood->link);
+	g_hash_table_remove(mserver->floodlist, flood);
 
 	g_free(flood->nick);
+	g_free(flood->target);
 	g_free(flood);
-	return TRUE;
+}
+
+static void flood_server_clear(MODULE_SERVER_REC *mserver)
+{
+	while (mserver->floodqueue->head != NULL)
+		flood_destroy(mserver, mserver->floodqueue->head->data);
 }
 
 static int flood_timeout(void)
 {
 	MODULE_SERVER_REC *mserver;
+	FLOOD_REC *flood;
 	GSList *tmp;
 	time_t now;
 
-	/* remove the old people from flood lists */
+	/* remove the old people from flood lists. the queue is ordered by
+	   the last message time, so they're all at the head. */
 	now = time(NULL);
 	for (tmp = servers; tmp != NULL; tmp = tmp->next) {
 		IRC_SERVER_REC *rec = tmp->data;
@@ -100,9 +99,12 @@ static int flood_timeout(void)
                         continue;
 
 		mserver = MODULE_DATA(rec);
-		g_hash_table_foreach_remove(mserver->floodlist,
-					    (GHRFunc) flood_hash_check_remove,
-					    &now);
+		while (mserver->floodqueue->head != NULL) {
+			flood = mserver->floodqueue->head->data;
+			if (now - flood_last_time(flood) < flood_timecheck)
+				break;
+			flood_destroy(mserver, flood);
+		}
 	}
 	return 1;
 }
@@ -120,24 +122,8 @@ static void flood_init_server(IRC_SERVER_REC *server)
 	rec = g_new0(MODULE_SERVER_REC, 1);
 	MODULE_DATA_SET(server, rec);
 
-	rec->floodlist = g_hash_table_new((GHashFunc) i_istr_hash, (GCompareFunc) i_istr_equal);
-}
-
-static void flood_hash_destroy(const char *key, FLOOD_REC *flood)
-{
-	while (flood->items != NULL) {
-		FLOOD_ITEM_REC *rec = flood->items->data;
-
-		flood->items = g_slist_remove(flood->items, rec);
-
-		g_slist_foreach(rec->msgtimes, (GFunc) g_free, NULL);
-		g_slist_free(rec->msgtimes);
-		g_free(rec->target);
-		g_free(rec);
-	}
-
-	g_free(flood->nick);
-	g_free(flood);
+	rec->floodlist = g_hash_table_new((GHashFunc) flood_hash, (GCompareFunc) flood_equal);
+	rec->floodqueue = g_queue_new();
 }
 
 /* Deinitialize flood protection */
@@ -152,30 +138,36 @@ static void flood_deinit_server(IRC_SERVER_REC *server)
 
 	mserver = MODULE_DATA(server);
 	if (mserver != NULL && mserver->floodlist != NULL) {
-		flood_timecheck = 0;
-
-		g_hash_table_foreach(mserver->floodlist,
-				     (GHFunc) flood_hash_destroy, NULL);
+		flood_server_clear(mserver);
 		g_hash_table_destroy(mserver->floodlist);
+		g_queue_free(mserver->floodqueue);
 	}
 	g_free(mserver);
 	MODULE_DATA_UNSET(server);
 }
 
-static FLOOD_ITEM_REC *flood_find(FLOOD_REC *flood, int level,
-				  const char *target)
+static FLOOD_REC *flood_create(MODULE_SERVER_REC *mserver, int level,
+			       const char *nick, const char *target)
 {
-	GSList *tmp;
-
-	for (tmp = flood->items; tmp != NULL; tmp = tmp->next) {
-		FLOOD_ITEM_REC *rec = tmp->data;
+	FLOOD_REC *flood;
+	int size;
 
-		if (rec->level == level &&
-		    g_ascii_strcasecmp(rec->target, target) == 0)
-			return rec;
+	if (flood_max_records > 0 &&
+	    (int) mserver->floodqueue->length >= flood_max_records) {
+		/* forget the one we've heard from least recently */
+		flood_destroy(mserver, mserver->floodqueue->head->data);
 	}
 
-	return NULL;
+	size = flood_max_msgs + 1;
+	flood = g_malloc0(sizeof(FLOOD_REC) + sizeof(time_t) * (size - 1));
+	flood->nick = g_strdup(nick);
+	flood->target = g_strdup(target);
+	flood->level = level;
+	flood->size = size;
+	flood->link.data = flood;
+
+	g_hash_table_add(mserver->floodlist, flood);
+	return flood;
 }
 
 /* All messages should go through here.. */
@@ -183,56 +175,45 @@ static void flood_newmsg(IRC_SERVER_REC *server, int level, const char *nick,
 			 const char *host, const char *target)
 {
 	MODULE_SERVER_REC *mserver;
-	FLOOD_REC *flood;
-	FLOOD_ITEM_REC *rec;
-	time_t now, *ttime;
-	GSList *times, *tnext;
+	FLOOD_REC *flood, lookup;
+	time_t now;
 
 	g_return_if_fail(server != NULL);
 	g_return_if_fail(nick != NULL);
 
 	mserver = MODULE_DATA(server);
-	flood = g_hash_table_lookup(mserver->floodlist, nick);
-
-	rec = flood == NULL ? NULL : flood_find(flood, level, target);
-	if (rec != NULL) {
-		now = time(NULL);
-		for (times = rec->msgtimes; times != NULL; times = tnext) {
-			time_t *data = times->data;
-			tnext = times->next;
-
-			if (now - *data >= flood_timecheck) {
-				rec->msgtimes = g_slist_remove(rec->msgtimes, data);
-				g_free(data);
-			} else
-				break;
-		}
-		ttime = g_new(time_t, 1);
-		*ttime = now;
-		rec->msgtimes = g_slist_append(rec->msgtimes, ttime);
-		if (g_slist_length(rec->msgtimes) > flood_max_msgs) {
-			/* flooding! */
-			signal_emit("flood", 5, server, nick, host,
-				    GINT_TO_POINTER(rec->level), target);
-		}
-		return;
-	}
 
-	if (flood == NULL) {
-		flood = g_new0(FLOOD_REC, 1);
-		flood->nick = g_strdup(nick);
-		g_hash_table_insert(mserver->floodlist, flood->nick, flood);
+	lookup.nick = (char *) nick;
+	lookup.target = (char *) target;
+	lookup.level = level;
+	flood = g_hash_table_lookup(mserver->floodlist, &lookup);
+	if (flood == NULL)
+		flood = flood_create(mserver, level, nick, target);
+	else
+		g_queue_unlink(mserver->floodqueue, &flood->link);
+	g_queue_push_tail_link(mserver->floodqueue, &flood->link);
+
+	/* forget the expired messages */
+	now = time(NULL);
+	while (flood->count > 0 &&
+	       now - flood->msgtimes[flood->first] >= flood_timecheck) {
+		flood->first = (flood->first + 1) % flood->size;
+		flood->count--;
 	}
 
-	rec = g_new0(FLOOD_ITEM_REC, 1);
-	rec->level = level;
-	rec->msgtimes = NULL;
-	ttime = g_new(time_t, 1);
-	*ttime = time(NULL);
-	rec->msgtimes = g_slist_append(rec->msgtimes, ttime);
-	rec->target = g_strdup(target);
+	if (flood->count == flood->size) {
+		/* forget the oldest one, we only care if there's too many */
+		flood->first = (flood->first + 1) % flood->size;
+		flood->count--;
+	}
+	flood->msgtimes[(flood->first + flood->count) % flood->size] = now;
+	flood->count++;
 
-	flood->items = g_slist_append(flood->items, rec);
+	if (flood->count > flood_max_msgs) {
+		/* flooding! */
+		signal_emit("flood", 5, server, nick, host,
+			    GINT_TO_POINTER(level), target);
+	}
 }
 
 static void flood_privmsg(IRC_SERVER_REC *server, const char *data,
@@ -293,8 +274,23 @@ static void flood_ctcp(IRC_SERVER_REC *server, const char *data,
 
 static void read_settings(void)
 {
+	GSList *tmp;
+	int max_msgs;
+
 	flood_timecheck = settings_get_int("flood_timecheck");
-	flood_max_msgs = settings_get_int("flood_max_msgs");
+	flood_max_records = settings_get_int("flood_max_records");
+	max_msgs = settings_get_int("flood_max_msgs");
+
+	if (max_msgs != flood_max_msgs) {
+		/* the message time rings are sized by flood_max_msgs */
+		for (tmp = servers; tmp != NULL; tmp = tmp->next) {
+			IRC_SERVER_REC *rec = tmp->data;
+
+			if (IS_IRC_SERVER(rec) && MODULE_DATA(rec) != NULL)
+				flood_server_clear(MODULE_DATA(rec));
+		}
+	}
+	flood_max_msgs = max_msgs;
 
 	if (flood_timecheck > 0 && flood_max_msgs > 0) {
 		if (flood_tag == -1) {
@@ -318,8 +314,10 @@ void irc_flood_init(void)
 {
 	settings_add_int("flood", "flood_timecheck", 8);
 	settings_add_int("flood", "flood_max_msgs", 4);
+	settings_add_int("flood", "flood_max_records", 10000);
 
 	flood_tag = -1;
+	flood_max_msgs = 0;
 	read_settings();
 	signal_add("setup changed", (SIGNAL_FUNC) read_settings);
 	signal_add_first("server connected", (SIGNAL_FUNC) flood_init_server);
@@ -3,7 +3,8 @@
 
 typedef struct {
 	/* Flood protection */
-	GHashTable *floodlist;
+	GHashTable *floodlist; /* (nick, level, target) -> FLOOD_REC */
+	GQueue *floodqueue; /* FLOOD_RECs, least recently heard from first */
 
 	/* Auto ignore list */
 	GSList *ignorelist;
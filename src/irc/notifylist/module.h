@@ -19,6 +19,9 @@ typedef struct {
 typedef struct {
 	int ison_count; /* number of ISON requests sent */
 
+	unsigned int monitor:1; /* notify nicks are tracked with MONITOR */
+	unsigned int monitor_failed:1; /* MONITOR list got full, use ISON */
+
 	GSList *notify_users; /* NOTIFY_NICK_REC's of notifylist people who are in IRC */
 	GSList *ison_tempusers; /* Temporary list for saving /ISON events.. */
 } MODULE_SERVER_REC;
@@ -30,6 +33,7 @@ void notify_nick_destroy(NOTIFY_NICK_REC *rec);
 NOTIFY_NICK_REC *notify_nick_find(IRC_SERVER_REC *server, const char *nick);
 
 void notifylist_left(IRC_SERVER_REC *server, NOTIFY_NICK_REC *rec);
+void notifylist_check_joins(IRC_SERVER_REC *server, GSList *nicks);
 void notifylist_destroy_all(void);
 
 void notifylist_commands_init(void);
@@ -40,3 +44,10 @@ void notifylist_whois_deinit(void);
 
 void notifylist_ison_init(void);
 void notifylist_ison_deinit(void);
+
+/* Start using MONITOR if server supports it. Returns TRUE if it's used. */
+int notifylist_monitor_start(IRC_SERVER_REC *server);
+void notifylist_monitor_check_away(IRC_SERVER_REC *server);
+
+void notifylist_monitor_init(void);
+void notifylist_monitor_deinit(void);
@@ -112,6 +112,13 @@ static void notifylist_timeout_server(IRC_SERVER_REC *server)
 	if (!IS_IRC_SERVER(server))
 		return;
 
+	if (notifylist_monitor_start(server)) {
+		/* MONITOR tells when they come and go, only the away
+		   states need to be checked */
+		notifylist_monitor_check_away(server);
+		return;
+	}
+
 	mserver = MODULE_DATA(server);
 	if (mserver->ison_count > 0) {
 		/* still not received all replies to previous /ISON commands.. */
@@ -230,20 +237,19 @@ static void whois_list_send(IRC_SERVER_REC *server, GSList *nicks)
 	g_string_free(str, TRUE);
 }
 
-static void ison_check_joins(IRC_SERVER_REC *server)
+/* `nicks' are online, send WHOIS for the new ones and the ones whose away
+   state we need to check */
+void notifylist_check_joins(IRC_SERVER_REC *server, GSList *nicks)
 {
-	MODULE_SERVER_REC *mserver;
 	NOTIFYLIST_REC *notify;
 	NOTIFY_NICK_REC *rec;
 	GSList *tmp, *newnicks;
 	int send_whois;
 	time_t now;
 
-	mserver = MODULE_DATA(server);
-
 	now = time(NULL);
 	newnicks = NULL;
-	for (tmp = mserver->ison_tempusers; tmp != NULL; tmp = tmp->next) {
+	for (tmp = nicks; tmp != NULL; tmp = tmp->next) {
 		char *nick = tmp->data;
 
 		notify = notifylist_find(nick, server->connrec->chatnet);
@@ -307,7 +313,7 @@ static void event_ison(IRC_SERVER_REC *server, const char *data)
                 return;
 	}
 
-        ison_check_joins(server);
+        notifylist_check_joins(server, mserver->ison_tempusers);
         ison_check_parts(server);
 
 	/* free memory used by temp list */
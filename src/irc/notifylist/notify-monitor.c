@@ -0,0 +1,354 @@
+/*
+ notify-monitor.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "module.h"
+#include <irssi/src/core/signals.h>
+#include <irssi/src/core/misc.h>
+
+#include <irssi/src/irc/core/irc.h>
+#include <irssi/src/irc/core/irc-servers.h>
+
+#include <irssi/src/irc/notifylist/notifylist.h>
+
+/* Returns the max. number of MONITOR targets, 0 if unlimited or -1 if the
+   server doesn't support MONITOR */
+static int monitor_get_limit(IRC_SERVER_REC *server)
+{
+	const char *value;
+
+	if (server->isupport == NULL)
+		return -1;
+
+	value = g_hash_table_lookup(server->isupport, "MONITOR");
+	if (value == NULL)
+		return -1;
+
+	return *value == '\0' ? 0 : atoi(value);
+}
+
+static char *notify_get_nick(NOTIFYLIST_REC *rec)
+{
+	char *nick, *ptr;
+
+	nick = g_strdup(rec->mask);
+	ptr = strchr(nick, '!');
+	if (ptr != NULL) *ptr = '\0';
+	return nick;
+}
+
+/* Returns list of unique nicks in notify list for the server */
+static GSList *monitor_get_nicks(IRC_SERVER_REC *server)
+{
+	GHashTable *seen;
+	GSList *tmp, *nicks;
+	char *nick;
+
+	seen = g_hash_table_new((GHashFunc) i_istr_hash, (GCompareFunc) i_istr_equal);
+	nicks = NULL;
+	for (tmp = notifies; tmp != NULL; tmp = tmp->next) {
+		NOTIFYLIST_REC *rec = tmp->data;
+
+		if (!notifylist_ircnets_match(rec, server->connrec->chatnet))
+			continue;
+
+		nick = notify_get_nick(rec);
+		if (g_hash_table_contains(seen, nick)) {
+			g_free(nick);
+			continue;
+		}
+
+		g_hash_table_add(seen, nick);
+		nicks = g_slist_prepend(nicks, nick);
+	}
+	g_hash_table_destroy(seen);
+
+	return g_slist_reverse(nicks);
+}
+
+static void monitor_send(IRC_SERVER_REC *server, char type, GSList *nicks)
+{
+	GString *cmd;
+	GSList *tmp;
+	int prefix_len;
+
+	cmd = g_string_new(NULL);
+	g_string_printf(cmd, "MONITOR %c ", type);
+	prefix_len = cmd->len;
+
+	for (tmp = nicks; tmp != NULL; tmp = tmp->next) {
+		const char *nick = tmp->data;
+
+		if (cmd->len > prefix_len &&
+		    cmd->len + strlen(nick) + 1 > server->max_message_len) {
+			irc_send_cmd_later(server, cmd->str);
+			g_string_truncate(cmd, prefix_len);
+		}
+
+		if (cmd->len > prefix_len)
+			g_string_append_c(cmd, ',');
+		g_string_append(cmd, nick);
+	}
+
+	if (cmd->len > prefix_len)
+		irc_send_cmd_later(server, cmd->str);
+	g_string_free(cmd, TRUE);
+}
+
+static void monitor_send_nick(IRC_SERVER_REC *server, char type,
+			      const char *nick)
+{
+	GSList list;
+
+	list.data = (char *) nick;
+	list.next = NULL;
+	monitor_send(server, type, &list);
+}
+
+int notifylist_monitor_start(IRC_SERVER_REC *server)
+{
+	MODULE_SERVER_REC *mserver;
+	GSList *nicks;
+	int limit;
+
+	g_return_val_if_fail(server != NULL, FALSE);
+
+	mserver = MODULE_DATA(server);
+	if (mserver == NULL || !server->connected)
+		return FALSE;
+
+	if (mserver->monitor)
+		return TRUE;
+	if (mserver->monitor_failed)
+		return FALSE;
+
+	limit = monitor_get_limit(server);
+	if (limit < 0)
+		return FALSE;
+
+	nicks = monitor_get_nicks(server);
+	if (limit > 0 && g_slist_length(nicks) > limit) {
+		/* notify list doesn't fit, keep using ISON */
+		mserver->monitor_failed = TRUE;
+	} else {
+		mserver->monitor = TRUE;
+		monitor_send(server, '+', nicks);
+	}
+
+	g_slist_foreach(nicks, (GFunc) g_free, NULL);
+	g_slist_free(nicks);
+	return mserver->monitor;
+}
+
+void notifylist_monitor_check_away(IRC_SERVER_REC *server)
+{
+	MODULE_SERVER_REC *mserver;
+	GSList *tmp, *nicks;
+
+	mserver = MODULE_DATA(server);
+
+	/* nicks are copied, since WHOIS replies may destroy the records */
+	nicks = NULL;
+	for (tmp = mserver->notify_users; tmp != NULL; tmp = tmp->next) {
+		NOTIFY_NICK_REC *rec = tmp->data;
+
+		nicks = g_slist_prepend(nicks, g_strdup(rec->nick));
+	}
+	nicks = g_slist_reverse(nicks);
+
+	notifylist_check_joins(server, nicks);
+
+	g_slist_foreach(nicks, (GFunc) g_free, NULL);
+	g_slist_free(nicks);
+}
+
+static void event_end_of_motd(IRC_SERVER_REC *server)
+{
+	if (IS_IRC_SERVER(server))
+		notifylist_monitor_start(server);
+}
+
+/* RPL_MONONLINE: nick!user@host[,nick!user@host...] */
+static void event_mononline(IRC_SERVER_REC *server, const char *data)
+{
+	MODULE_SERVER_REC *mserver;
+	char *params, *targets, **list, **tmp, *ptr;
+	GSList *nicks;
+
+	g_return_if_fail(data != NULL);
+
+	mserver = MODULE_DATA(server);
+	if (mserver == NULL || !mserver->monitor)
+		return;
+
+	params = event_get_params(data, 2, NULL, &targets);
+
+	nicks = NULL;
+	list = g_strsplit(targets, ",", -1);
+	for (tmp = list; *tmp != NULL; tmp++) {
+		ptr = strchr(*tmp, '!');
+		if (ptr != NULL) *ptr = '\0';
+
+		if (**tmp != '\0')
+			nicks = g_slist_append(nicks, *tmp);
+	}
+
+	notifylist_check_joins(server, nicks);
+
+	g_slist_free(nicks);
+	g_strfreev(list);
+	g_free(params);
+}
+
+/* RPL_MONOFFLINE: nick[,nick...] */
+static void event_monoffline(IRC_SERVER_REC *server, const char *data)
+{
+	MODULE_SERVER_REC *mserver;
+	NOTIFY_NICK_REC *rec;
+	char *params, *targets, **list, **tmp;
+
+	g_return_if_fail(data != NULL);
+
+	mserver = MODULE_DATA(server);
+	if (mserver == NULL || !mserver->monitor)
+		return;
+
+	params = event_get_params(data, 2, NULL, &targets);
+
+	list = g_strsplit(targets, ",", -1);
+	for (tmp = list; *tmp != NULL; tmp++) {
+		rec = notify_nick_find(server, *tmp);
+		if (rec != NULL) notifylist_left(server, rec);
+	}
+
+	g_strfreev(list);
+	g_free(params);
+}
+
+/* ERR_MONLISTFULL: the list is full, go back to ISON */
+static void event_monlistfull(IRC_SERVER_REC *server, const char *data)
+{
+	MODULE_SERVER_REC *mserver;
+
+	mserver = MODULE_DATA(server);
+	if (mserver == NULL || !mserver->monitor)
+		return;
+
+	mserver->monitor = FALSE;
+	mserver->monitor_failed = TRUE;
+	irc_send_cmd_later(server, "MONITOR C");
+}
+
+/* Returns TRUE if some other notify mask than `rec' has the nick */
+static int notify_nick_duplicate(NOTIFYLIST_REC *rec, const char *nick,
+				 const char *chatnet)
+{
+	GSList *tmp;
+	int len;
+
+	len = strlen(nick);
+	for (tmp = notifies; tmp != NULL; tmp = tmp->next) {
+		NOTIFYLIST_REC *other = tmp->data;
+
+		if (other != rec &&
+		    g_ascii_strncasecmp(other->mask, nick, len) == 0 &&
+		    (other->mask[len] == '\0' || other->mask[len] == '!') &&
+		    notifylist_ircnets_match(other, chatnet))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void sig_notifylist_new(NOTIFYLIST_REC *rec)
+{
+	MODULE_SERVER_REC *mserver;
+	GSList *tmp;
+	char *nick;
+
+	nick = notify_get_nick(rec);
+	for (tmp = servers; tmp != NULL; tmp = tmp->next) {
+		IRC_SERVER_REC *server = IRC_SERVER(tmp->data);
+
+		if (server == NULL || !server->connected)
+			continue;
+
+		mserver = MODULE_DATA(server);
+		if (mserver == NULL || !mserver->monitor ||
+		    !notifylist_ircnets_match(rec, server->connrec->chatnet) ||
+		    notify_nick_duplicate(rec, nick, server->connrec->chatnet))
+			continue;
+
+		monitor_send_nick(server, '+', nick);
+	}
+	g_free(nick);
+}
+
+static void sig_notifylist_remove(NOTIFYLIST_REC *rec)
+{
+	MODULE_SERVER_REC *mserver;
+	NOTIFY_NICK_REC *nickrec;
+	GSList *tmp;
+	char *nick;
+
+	nick = notify_get_nick(rec);
+	for (tmp = servers; tmp != NULL; tmp = tmp->next) {
+		IRC_SERVER_REC *server = IRC_SERVER(tmp->data);
+
+		if (server == NULL || !server->connected)
+			continue;
+
+		mserver = MODULE_DATA(server);
+		if (mserver == NULL || !mserver->monitor ||
+		    !notifylist_ircnets_match(rec, server->connrec->chatnet))
+			continue;
+
+		/* some other mask may still want the nick */
+		if (notify_nick_duplicate(rec, nick, server->connrec->chatnet))
+			continue;
+
+		monitor_send_nick(server, '-', nick);
+
+		nickrec = notify_nick_find(server, nick);
+		if (nickrec != NULL) notifylist_left(server, nickrec);
+	}
+	g_free(nick);
+}
+
+void notifylist_monitor_init(void)
+{
+	signal_add("event 376", (SIGNAL_FUNC) event_end_of_motd);
+	signal_add("event 422", (SIGNAL_FUNC) event_end_of_motd);
+	signal_add("event 730", (SIGNAL_FUNC) event_mononline);
+	signal_add("event 731", (SIGNAL_FUNC) event_monoffline);
+	signal_add("event 734", (SIGNAL_FUNC) event_monlistfull);
+	signal_add("notifylist new", (SIGNAL_FUNC) sig_notifylist_new);
+	signal_add("notifylist remove", (SIGNAL_FUNC) sig_notifylist_remove);
+}
+
+void notifylist_monitor_deinit(void)
+{
+	signal_remove("event 376", (SIGNAL_FUNC) event_end_of_motd);
+	signal_remove("event 422", (SIGNAL_FUNC) event_end_of_motd);
+	signal_remove("event 730", (SIGNAL_FUNC) event_mononline);
+	signal_remove("event 731", (SIGNAL_FUNC) event_monoffline);
+	signal_remove("event 734", (SIGNAL_FUNC) event_monlistfull);
+	signal_remove("notifylist new", (SIGNAL_FUNC) sig_notifylist_new);
+	signal_remove("notifylist remove", (SIGNAL_FUNC) sig_notifylist_remove);
+}
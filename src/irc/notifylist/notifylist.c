@@ -332,6 +332,7 @@ void irc_notifylist_init(void)
 
 	notifylist_commands_init();
 	notifylist_ison_init();
+	notifylist_monitor_init();
 	notifylist_whois_init();
 	signal_add("server connected", (SIGNAL_FUNC) notifylist_init_server);
 	signal_add("server destroyed", (SIGNAL_FUNC) notifylist_deinit_server);
@@ -349,6 +350,7 @@ void irc_notifylist_deinit(void)
 {
 	notifylist_commands_deinit();
 	notifylist_ison_deinit();
+	notifylist_monitor_deinit();
 	notifylist_whois_deinit();
 
 	signal_remove("server connected", (SIGNAL_FUNC) notifylist_init_server);
@@ -0,0 +1,219 @@
+/*
+ backlog.c : proxy plugin - replay lines to reconnecting clients
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "module.h"
+#include <irssi/src/core/signals.h>
+#include <irssi/src/core/settings.h>
+#include <irssi/src/core/misc.h>
+
+typedef struct {
+	GQueue *lines; /* PROXY_LINE_REC */
+	guint64 first_seq; /* sequence number of the first line */
+	gsize size; /* bytes used by lines */
+
+	/* client user name : guint64 *seq of the first line it hasn't seen */
+	GHashTable *clients;
+} PROXY_BACKLOG_REC;
+
+/* server tag : PROXY_BACKLOG_REC */
+static GHashTable *backlogs;
+static gsize backlog_max_size;
+static int backlog_server_time;
+
+static gsize line_size(PROXY_LINE_REC *line)
+{
+	return sizeof(PROXY_LINE_REC) + line->len;
+}
+
+static void backlog_destroy(PROXY_BACKLOG_REC *rec)
+{
+	g_queue_free_full(rec->lines, (GDestroyNotify) proxy_line_unref);
+	g_hash_table_destroy(rec->clients);
+	g_free(rec);
+}
+
+static PROXY_BACKLOG_REC *backlog_get(IRC_SERVER_REC *server, int create)
+{
+	PROXY_BACKLOG_REC *rec;
+
+	rec = g_hash_table_lookup(backlogs, server->tag);
+	if (rec == NULL && create) {
+		rec = g_new0(PROXY_BACKLOG_REC, 1);
+		rec->lines = g_queue_new();
+		rec->clients = g_hash_table_new_full(g_str_hash, g_str_equal,
+						     g_free, g_free);
+		g_hash_table_insert(backlogs, g_strdup(server->tag), rec);
+	}
+	return rec;
+}
+
+static void backlog_trim(PROXY_BACKLOG_REC *rec, gsize max_size)
+{
+	PROXY_LINE_REC *line;
+
+	while (rec->size > max_size && !g_queue_is_empty(rec->lines)) {
+		line = g_queue_pop_head(rec->lines);
+		rec->size -= line_size(line);
+		rec->first_seq++;
+		proxy_line_unref(line);
+	}
+}
+
+void proxy_backlog_add(IRC_SERVER_REC *server, PROXY_LINE_REC *line)
+{
+	PROXY_BACKLOG_REC *rec;
+
+	g_return_if_fail(server != NULL);
+	g_return_if_fail(line != NULL);
+
+	if (backlogs == NULL || backlog_max_size == 0 ||
+	    line_size(line) > backlog_max_size)
+		return;
+
+	rec = backlog_get(server, TRUE);
+	backlog_trim(rec, backlog_max_size - line_size(line));
+
+	/* the same line is used for sending it to the clients */
+	proxy_line_ref(line);
+	g_queue_push_tail(rec->lines, line);
+	rec->size += line_size(line);
+}
+
+void proxy_backlog_client_left(CLIENT_REC *client)
+{
+	PROXY_BACKLOG_REC *rec;
+	guint64 *seq;
+
+	g_return_if_fail(client != NULL);
+
+	if (backlogs == NULL || client->user == NULL ||
+	    client->server == NULL || !client->connected)
+		return;
+
+	rec = backlog_get(client->server, TRUE);
+	seq = g_new(guint64, 1);
+	*seq = rec->first_seq + g_queue_get_length(rec->lines);
+	g_hash_table_replace(rec->clients, g_strdup(client->user), seq);
+}
+
+/* Returns TRUE if the line has the server-time tag */
+static int line_has_time(const char *line)
+{
+	const char *end, *pos;
+
+	if (*line != '@')
+		return FALSE;
+
+	end = strchr(line, ' ');
+	for (pos = line; pos != NULL && (end == NULL || pos < end);
+	     pos = strchr(pos + 1, ';')) {
+		if (strncmp(pos + 1, "time=", 5) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void backlog_send_line(CLIENT_REC *client, PROXY_LINE_REC *line)
+{
+	GDateTime *time;
+	char *timestr;
+
+	if (!backlog_server_time || line_has_time(line->str)) {
+		proxy_client_send(client, line->str, line->len);
+		return;
+	}
+
+	time = g_date_time_new_from_unix_utc(line->time / G_USEC_PER_SEC);
+	timestr = g_date_time_format(time, "%Y-%m-%dT%H:%M:%S");
+	if (*line->str == '@') {
+		/* add to the existing tags */
+		proxy_outdata(client, "@time=%s.%03dZ;%s", timestr,
+			      (int) (line->time % G_USEC_PER_SEC / 1000),
+			      line->str + 1);
+	} else {
+		proxy_outdata(client, "@time=%s.%03dZ %s", timestr,
+			      (int) (line->time % G_USEC_PER_SEC / 1000),
+			      line->str);
+	}
+	g_free(timestr);
+	g_date_time_unref(time);
+}
+
+void proxy_backlog_replay(CLIENT_REC *client)
+{
+	PROXY_BACKLOG_REC *rec;
+	GList *tmp;
+	guint64 *seq;
+
+	g_return_if_fail(client != NULL);
+
+	if (backlogs == NULL || client->user == NULL || client->server == NULL)
+		return;
+
+	rec = backlog_get(client->server, FALSE);
+	if (rec == NULL)
+		return;
+
+	/* only clients that have been here before get the lines they missed */
+	seq = g_hash_table_lookup(rec->clients, client->user);
+	if (seq == NULL)
+		return;
+
+	tmp = *seq <= rec->first_seq ? rec->lines->head :
+		g_queue_peek_nth_link(rec->lines, *seq - rec->first_seq);
+	for (; tmp != NULL; tmp = tmp->next)
+		backlog_send_line(client, tmp->data);
+
+	g_hash_table_remove(rec->clients, client->user);
+}
+
+static void read_settings(void)
+{
+	GHashTableIter iter;
+	PROXY_BACKLOG_REC *rec;
+
+	backlog_max_size = settings_get_size("irssiproxy_backlog_size");
+	backlog_server_time = settings_get_bool("irssiproxy_backlog_server_time");
+
+	g_hash_table_iter_init(&iter, backlogs);
+	while (g_hash_table_iter_next(&iter, NULL, (void **) &rec)) {
+		backlog_trim(rec, backlog_max_size);
+		if (backlog_max_size == 0)
+			g_hash_table_iter_remove(&iter);
+	}
+}
+
+void proxy_backlog_init(void)
+{
+	backlogs = g_hash_table_new_full((GHashFunc) i_istr_hash,
+					 (GEqualFunc) i_istr_equal, g_free,
+					 (GDestroyNotify) backlog_destroy);
+	read_settings();
+
+	signal_add("setup changed", (SIGNAL_FUNC) read_settings);
+}
+
+void proxy_backlog_deinit(void)
+{
+	g_hash_table_destroy(backlogs);
+	backlogs = NULL;
+
+	signal_remove("setup changed", (SIGNAL_FUNC) read_settings);
+}
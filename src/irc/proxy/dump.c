@@ -30,6 +30,38 @@
 #include <irssi/src/irc/core/irc-nicklist.h>
 #include <irssi/src/irc/core/modes.h>
 
+PROXY_LINE_REC *proxy_line_new(const char *line)
+{
+	PROXY_LINE_REC *rec;
+	int len;
+
+	g_return_val_if_fail(line != NULL, NULL);
+
+	len = strlen(line);
+	rec = g_malloc(sizeof(PROXY_LINE_REC) + len + 2);
+	rec->refcount = 1;
+	rec->time = g_get_real_time();
+	rec->len = len + 2;
+	memcpy(rec->str, line, len);
+	memcpy(rec->str + len, "\r\n", 3);
+	return rec;
+}
+
+void proxy_line_ref(PROXY_LINE_REC *rec)
+{
+	g_return_if_fail(rec != NULL);
+
+	rec->refcount++;
+}
+
+void proxy_line_unref(PROXY_LINE_REC *rec)
+{
+	g_return_if_fail(rec != NULL);
+
+	if (--rec->refcount == 0)
+		g_free(rec);
+}
+
 void proxy_outdata(CLIENT_REC *client, const char *data, ...)
 {
 	va_list args;
@@ -41,7 +73,7 @@ void proxy_outdata(CLIENT_REC *client, const char *data, ...)
 	va_start(args, data);
 
 	str = g_strdup_vprintf(data, args);
-	net_sendbuffer_send(client->handle, str, strlen(str));
+	proxy_client_send(client, str, strlen(str));
 	g_free(str);
 
 	va_end(args);
@@ -65,13 +97,46 @@ void proxy_outdata_all(IRC_SERVER_REC *server, const char *data, ...)
 		CLIENT_REC *rec = tmp->data;
 
 		if (rec->connected && rec->server == server)
-			net_sendbuffer_send(rec->handle, str, len);
+			proxy_client_send(rec, str, len);
 	}
 	g_free(str);
 
 	va_end(args);
 }
 
+void proxy_outline_all(IRC_SERVER_REC *server, PROXY_LINE_REC *line,
+		       int message)
+{
+	GSList *tmp;
+
+	g_return_if_fail(server != NULL);
+	g_return_if_fail(line != NULL);
+
+	for (tmp = proxy_clients; tmp != NULL; tmp = tmp->next) {
+		CLIENT_REC *rec = tmp->data;
+
+		if (rec->connected && rec->server == server)
+			proxy_client_send_line(rec, line, message);
+	}
+}
+
+/* Format the ":nick!user@proxy str" line for the clients, most of the time
+   all of them have the same nick and the line can be reused */
+static void proxy_outserver_line(GString *line, CLIENT_REC *client,
+				 const char *str)
+{
+	const char *nick;
+	int nick_len;
+
+	nick = line->len == 0 ? NULL : line->str + 1;
+	nick_len = strlen(client->nick);
+	if (nick == NULL || strncmp(nick, client->nick, nick_len) != 0 ||
+	    nick[nick_len] != '!') {
+		g_string_printf(line, ":%s!%s@proxy %s\r\n", client->nick,
+				settings_get_str("user_name"), str);
+	}
+}
+
 void proxy_outserver(CLIENT_REC *client, const char *data, ...)
 {
 	va_list args;
@@ -94,6 +159,7 @@ void proxy_outserver_all(IRC_SERVER_REC *server, const char *data, ...)
 {
 	va_list args;
 	GSList *tmp;
+	GString *line;
 	char *str;
 
 	g_return_if_fail(server != NULL);
@@ -102,14 +168,16 @@ void proxy_outserver_all(IRC_SERVER_REC *server, const char *data, ...)
 	va_start(args, data);
 
 	str = g_strdup_vprintf(data, args);
+	line = g_string_new(NULL);
 	for (tmp = proxy_clients; tmp != NULL; tmp = tmp->next) {
 		CLIENT_REC *rec = tmp->data;
 
 		if (rec->connected && rec->server == server) {
-			proxy_outdata(rec, ":%s!%s@proxy %s\r\n", rec->nick,
-				      settings_get_str("user_name"), str);
+			proxy_outserver_line(line, rec, str);
+			proxy_client_send(rec, line->str, line->len);
 		}
 	}
+	g_string_free(line, TRUE);
 	g_free(str);
 
 	va_end(args);
@@ -119,6 +187,7 @@ void proxy_outserver_all_except(CLIENT_REC *client, const char *data, ...)
 {
 	va_list args;
 	GSList *tmp;
+	GString *line;
 	char *str;
 
 	g_return_if_fail(client != NULL);
@@ -127,15 +196,17 @@ void proxy_outserver_all_except(CLIENT_REC *client, const char *data, ...)
 	va_start(args, data);
 
 	str = g_strdup_vprintf(data, args);
+	line = g_string_new(NULL);
 	for (tmp = proxy_clients; tmp != NULL; tmp = tmp->next) {
 		CLIENT_REC *rec = tmp->data;
 
 		if (rec->connected && rec != client &&
 		    rec->server == client->server) {
-			proxy_outdata(rec, ":%s!%s@proxy %s\r\n", rec->nick,
-				      settings_get_str("user_name"), str);
+			proxy_outserver_line(line, rec, str);
+			proxy_client_send(rec, line->str, line->len);
 		}
 	}
+	g_string_free(line, TRUE);
 	g_free(str);
 
 	va_end(args);
@@ -0,0 +1,304 @@
+/*
+ flow.c : proxy plugin - output flow control for slow clients
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "module.h"
+#include <irssi/src/core/signals.h>
+#include <irssi/src/core/net-sendbuffer.h>
+#include <irssi/src/core/settings.h>
+
+/* how often throttled clients are checked to have drained their buffer */
+#define DRAIN_CHECK_MSECS 500
+
+/* max. length of a coalesced line, without the \r\n */
+#define MAX_COALESCED_LEN 510
+
+enum {
+	SLOW_CLIENT_DROP,
+	SLOW_CLIENT_COMPRESS,
+	SLOW_CLIENT_DISCONNECT
+};
+
+/* line waiting for a throttled client to drain its send buffer */
+typedef struct {
+	PROXY_LINE_REC *line;
+	unsigned int message:1; /* may be coalesced or dropped */
+} HELD_LINE_REC;
+
+static int high_watermark, low_watermark;
+static int slow_client_policy;
+
+static void client_overflow(CLIENT_REC *client)
+{
+	if (!client->overflowed) {
+		client->overflowed = TRUE;
+		proxy_client_disconnect_later(client);
+	}
+}
+
+static int client_send(CLIENT_REC *client, const char *data, int len)
+{
+	int pending;
+
+	if (client->overflowed)
+		return -1;
+
+	if (net_sendbuffer_send(client->handle, data, len) == -1) {
+		client_overflow(client);
+		return -1;
+	}
+
+	pending = net_sendbuffer_pending(client->handle);
+	if (pending > client->queue_peak)
+		client->queue_peak = pending;
+	if (pending > high_watermark &&
+	    slow_client_policy == SLOW_CLIENT_DISCONNECT)
+		client_overflow(client);
+	return 0;
+}
+
+/* Returns length of the ":prefix COMMAND target :" part of the line,
+   or 0 if the line can't be coalesced */
+static int line_header_len(PROXY_LINE_REC *line)
+{
+	const char *pos;
+	int i;
+
+	if (*line->str != ':')
+		return 0;
+
+	pos = line->str;
+	for (i = 0; i < 3; i++) {
+		pos = strchr(pos + 1, ' ');
+		if (pos == NULL)
+			return 0;
+	}
+
+	/* CTCPs are kept as they are */
+	if (pos[1] != ':' || pos[2] == '\001')
+		return 0;
+	return pos + 2 - line->str;
+}
+
+static void held_line_free(HELD_LINE_REC *rec)
+{
+	proxy_line_unref(rec->line);
+	g_free(rec);
+}
+
+static void client_hold(CLIENT_REC *client, PROXY_LINE_REC *line,
+			int message)
+{
+	HELD_LINE_REC *rec;
+
+	if (client->held == NULL)
+		client->held = g_queue_new();
+
+	rec = g_new0(HELD_LINE_REC, 1);
+	rec->line = line;
+	rec->message = message;
+	g_queue_push_tail(client->held, rec);
+	client->held_size += line->len;
+}
+
+static void client_hold_message(CLIENT_REC *client, PROXY_LINE_REC *line)
+{
+	HELD_LINE_REC *last;
+	PROXY_LINE_REC *merged;
+	GList *link, *next;
+	char *str;
+	int header_len;
+
+	/* messages from the same sender to the same target are put on the
+	   same line */
+	last = client->held == NULL ? NULL : g_queue_peek_tail(client->held);
+	header_len = line_header_len(line);
+	if (last != NULL && last->message && header_len > 0 &&
+	    line_header_len(last->line) == header_len &&
+	    memcmp(last->line->str, line->str, header_len) == 0 &&
+	    last->line->len + line->len - header_len + 1 <=
+	    MAX_COALESCED_LEN + 2) {
+		str = g_strdup_printf("%.*s | %.*s",
+				      last->line->len - 2, last->line->str,
+				      line->len - header_len - 2,
+				      line->str + header_len);
+		merged = proxy_line_new(str);
+		merged->time = last->line->time;
+		g_free(str);
+
+		client->held_size += merged->len - last->line->len;
+		proxy_line_unref(last->line);
+		last->line = merged;
+		client->lines_coalesced++;
+	} else {
+		proxy_line_ref(line);
+		client_hold(client, line, TRUE);
+	}
+
+	/* the held lines use no more than the send buffer could, only
+	   messages are dropped to make room */
+	for (link = client->held->head;
+	     link != NULL && client->held_size > high_watermark; link = next) {
+		HELD_LINE_REC *rec = link->data;
+
+		next = link->next;
+		if (rec->message) {
+			client->held_size -= rec->line->len;
+			client->lines_dropped++;
+			held_line_free(rec);
+			g_queue_delete_link(client->held, link);
+		}
+	}
+}
+
+/* Send the held lines as long as the send buffer has room for them */
+static void client_flush_held(CLIENT_REC *client)
+{
+	HELD_LINE_REC *rec;
+
+	while (!client->overflowed &&
+	       net_sendbuffer_pending(client->handle) <= high_watermark &&
+	       (rec = g_queue_pop_head(client->held)) != NULL) {
+		client->held_size -= rec->line->len;
+		client_send(client, rec->line->str, rec->line->len);
+		held_line_free(rec);
+	}
+}
+
+static int sig_drain_check(CLIENT_REC *client)
+{
+	if (client->overflowed ||
+	    net_sendbuffer_pending(client->handle) > low_watermark)
+		return TRUE;
+
+	if (client->held != NULL) {
+		client_flush_held(client);
+		if (!g_queue_is_empty(client->held))
+			return TRUE;
+	}
+
+	client->throttled = FALSE;
+	client->drain_tag = 0;
+	return FALSE;
+}
+
+static void client_throttle(CLIENT_REC *client)
+{
+	if (client->throttled ||
+	    net_sendbuffer_pending(client->handle) <= high_watermark)
+		return;
+
+	client->throttled = TRUE;
+	client->throttle_count++;
+	client->drain_tag = g_timeout_add(DRAIN_CHECK_MSECS,
+					  (GSourceFunc) sig_drain_check,
+					  client);
+}
+
+int proxy_client_send(CLIENT_REC *client, const char *data, int len)
+{
+	PROXY_LINE_REC *line;
+
+	g_return_val_if_fail(client != NULL, -1);
+
+	if (client->overflowed)
+		return -1;
+
+	client_throttle(client);
+	if (!client->throttled)
+		return client_send(client, data, len);
+
+	/* the lines held before this go first */
+	line = g_malloc(sizeof(PROXY_LINE_REC) + len);
+	line->refcount = 1;
+	line->time = g_get_real_time();
+	line->len = len;
+	memcpy(line->str, data, len);
+	line->str[len] = '\0';
+	client_hold(client, line, FALSE);
+	return 0;
+}
+
+void proxy_client_send_line(CLIENT_REC *client, PROXY_LINE_REC *line,
+			    int message)
+{
+	g_return_if_fail(client != NULL);
+	g_return_if_fail(line != NULL);
+
+	if (client->overflowed)
+		return;
+
+	client_throttle(client);
+	if (!client->throttled) {
+		client_send(client, line->str, line->len);
+		return;
+	}
+
+	/* other lines than messages are needed to keep the client's state
+	   in sync, so they're never dropped, but wait behind the messages
+	   held before them */
+	if (!message) {
+		proxy_line_ref(line);
+		client_hold(client, line, FALSE);
+		return;
+	}
+
+	switch (slow_client_policy) {
+	case SLOW_CLIENT_DROP:
+		client->lines_dropped++;
+		break;
+	case SLOW_CLIENT_COMPRESS:
+		client_hold_message(client, line);
+		break;
+	}
+}
+
+void proxy_client_flow_destroy(CLIENT_REC *client)
+{
+	g_return_if_fail(client != NULL);
+
+	if (client->drain_tag != 0) {
+		g_source_remove(client->drain_tag);
+		client->drain_tag = 0;
+	}
+	if (client->held != NULL) {
+		g_queue_free_full(client->held, (GDestroyNotify) held_line_free);
+		client->held = NULL;
+	}
+}
+
+static void read_settings(void)
+{
+	high_watermark = settings_get_size("irssiproxy_client_high_watermark");
+	low_watermark = settings_get_size("irssiproxy_client_low_watermark");
+	if (low_watermark > high_watermark)
+		low_watermark = high_watermark;
+	slow_client_policy = settings_get_choice("irssiproxy_slow_client");
+}
+
+void proxy_flow_init(void)
+{
+	read_settings();
+	signal_add("setup changed", (SIGNAL_FUNC) read_settings);
+}
+
+void proxy_flow_deinit(void)
+{
+	signal_remove("setup changed", (SIGNAL_FUNC) read_settings);
+}
@@ -37,10 +37,11 @@
 GSList *proxy_listens;
 GSList *proxy_clients;
 
-static GString *next_line;
+static PROXY_LINE_REC *next_line;
 static int ignore_next;
 
 static int enabled = FALSE;
+static int overflow_tag = -1;
 
 static int is_all_digits(const char *s)
 {
@@ -108,19 +109,51 @@ static void remove_client(CLIENT_REC *rec)
 
 	proxy_clients = g_slist_remove(proxy_clients, rec);
 	rec->listen->clients = g_slist_remove(rec->listen->clients, rec);
+	proxy_backlog_client_left(rec);
 
 	signal_emit("proxy client disconnected", 1, rec);
 	printtext(rec->server, NULL, MSGLEVEL_CLIENTNOTICE,
 	          "Proxy: Client %s disconnected", rec->addr);
 
+	proxy_client_flow_destroy(rec);
 	g_free(rec->proxy_address);
 	net_sendbuffer_destroy(rec->handle, TRUE);
 	g_source_remove(rec->recv_tag);
 	g_free_not_null(rec->nick);
 	g_free_not_null(rec->addr);
+	g_free_not_null(rec->user);
 	g_free(rec);
 }
 
+static int sig_remove_overflowed(void)
+{
+	GSList *tmp, *next;
+
+	for (tmp = proxy_clients; tmp != NULL; tmp = next) {
+		CLIENT_REC *rec = tmp->data;
+
+		next = tmp->next;
+		if (rec->overflowed) {
+			printtext(rec->server, NULL, MSGLEVEL_CLIENTNOTICE,
+			          "Proxy: Client %s can't keep up with the output",
+			          rec->addr);
+			remove_client(rec);
+		}
+	}
+
+	overflow_tag = -1;
+	return FALSE;
+}
+
+void proxy_client_disconnect_later(CLIENT_REC *client)
+{
+	g_return_if_fail(client != NULL);
+
+	client->overflowed = TRUE;
+	if (overflow_tag == -1)
+		overflow_tag = g_idle_add((GSourceFunc) sig_remove_overflowed, NULL);
+}
+
 static void proxy_redirect_event(CLIENT_REC *client, const char *command,
                                  int count, const char *arg, int remote)
 {
@@ -214,6 +247,8 @@ static void handle_client_connect_cmd(CLIENT_REC *client,
 		g_free_not_null(client->nick);
 		client->nick = g_strdup(args);
 	} else if (g_strcmp0(cmd, "USER") == 0) {
+		g_free_not_null(client->user);
+		client->user = g_strndup(args, strcspn(args, " "));
 		client->user_sent = TRUE;
 	}
 
@@ -228,6 +263,7 @@ static void handle_client_connect_cmd(CLIENT_REC *client,
 			          client->addr);
 			client->connected = TRUE;
 			proxy_dump_data(client);
+			proxy_backlog_replay(client);
 		}
 	}
 }
@@ -486,7 +522,9 @@ static void sig_incoming(IRC_SERVER_REC *server, const char *line)
 	g_return_if_fail(line != NULL);
 
 	/* send server event to all clients */
-	g_string_printf(next_line, "%s\r\n", line);
+	if (next_line != NULL)
+		proxy_line_unref(next_line);
+	next_line = proxy_line_new(line);
 }
 
 static void sig_server_event(IRC_SERVER_REC *server, const char *line,
@@ -494,27 +532,32 @@ static void sig_server_event(IRC_SERVER_REC *server, const char *line,
 {
 	GSList *tmp;
         void *client;
-        const char *signal;
-	char *event, *args;
-        int redirected;
+        const char *signal, *event, *args;
+	char *event_alloc, *ptr;
+        int redirected, message;
 
 	g_return_if_fail(line != NULL);
-	if (!IS_IRC_SERVER(server))
+	if (!IS_IRC_SERVER(server) || next_line == NULL)
 		return;
 
-	/* get command.. */
-	event = g_strconcat("event ", line, NULL);
-	args = strchr(event+6, ' ');
-	if (args != NULL) *args++ = '\0'; else args = "";
-	while (*args == ' ') args++;
-	ascii_strdown(event);
+	/* get command, usually the irc core has already parsed it */
+	event_alloc = NULL;
+	event = irc_server_event_get(server, line, &args);
+	if (event == NULL) {
+		event = event_alloc = g_strconcat("event ", line, NULL);
+		ptr = strchr(event_alloc+6, ' ');
+		if (ptr != NULL) *ptr++ = '\0'; else ptr = "";
+		while (*ptr == ' ') ptr++;
+		ascii_strdown(event_alloc);
+		args = ptr;
+	}
 
 	signal = server_redirect_peek_signal(server, nick, event, args, &redirected);
 	if ((signal != NULL && strncmp(signal, "proxy ", 6) != 0) ||
 	    (signal == NULL && redirected)) {
 		/* we want to send this to one client (or proxy itself) only */
 		/* proxy only */
-		g_free(event);
+		g_free(event_alloc);
 		return;
 	}
 
@@ -523,8 +566,8 @@ static void sig_server_event(IRC_SERVER_REC *server, const char *line,
 		if (sscanf(signal+6, "%p", &client) == 1) {
 			/* send it to specific client only */
 			if (g_slist_find(proxy_clients, client) != NULL)
-				net_sendbuffer_send(((CLIENT_REC *) client)->handle, next_line->str, next_line->len);
-			g_free(event);
+				proxy_client_send(client, next_line->str, next_line->len);
+			g_free(event_alloc);
                         signal_stop();
 			return;
 		}
@@ -540,13 +583,13 @@ static void sig_server_event(IRC_SERVER_REC *server, const char *line,
 			if (rec->want_ctcp == 1) {
                         	/* only CTCP for the chatnet where client is connected to will be forwarded */
                         	if (strstr(rec->proxy_address, server->connrec->chatnet) != NULL) {
-					net_sendbuffer_send(rec->handle,
-							    next_line->str, next_line->len);
+					proxy_client_send(rec, next_line->str,
+							  next_line->len);
 					signal_stop();
 				}
 			}
 		}
-		g_free(event);
+		g_free(event_alloc);
 		return;
 	}
 
@@ -554,14 +597,20 @@ static void sig_server_event(IRC_SERVER_REC *server, const char *line,
 	    g_strcmp0(event, "event pong") == 0) {
 		/* We want to answer ourself to PINGs and CTCPs.
 		   Also hide PONGs from clients. */
-		g_free(event);
+		g_free(event_alloc);
 		return;
 	}
 
 	/* send the data to clients.. */
-        proxy_outdata_all(server, "%s", next_line->str);
+	message = g_strcmp0(event, "event privmsg") == 0 ||
+		g_strcmp0(event, "event notice") == 0;
+	proxy_outline_all(server, next_line, message);
 
-	g_free(event);
+	/* ..and keep the messages for the clients that aren't here now */
+	if (message)
+		proxy_backlog_add(server, next_line);
+
+	g_free(event_alloc);
 }
 
 static void event_connected(IRC_SERVER_REC *server)
@@ -645,6 +694,21 @@ static void event_nick(IRC_SERVER_REC *server, const char *data,
 	}
 }
 
+/* Add our own message to the backlog, as the server doesn't echo it */
+static void backlog_add_own(IRC_SERVER_REC *server, const char *target,
+			    const char *msg)
+{
+	PROXY_LINE_REC *line;
+	char *str;
+
+	str = g_strdup_printf(":%s!%s@proxy PRIVMSG %s :%s", server->nick,
+			      settings_get_str("user_name"), target, msg);
+	line = proxy_line_new(str);
+	proxy_backlog_add(server, line);
+	proxy_line_unref(line);
+	g_free(str);
+}
+
 static void sig_message_own_public(IRC_SERVER_REC *server, const char *msg,
                                    const char *target)
 {
@@ -653,6 +717,7 @@ static void sig_message_own_public(IRC_SERVER_REC *server, const char *msg,
 
 	if (!ignore_next)
 		proxy_outserver_all(server, "PRIVMSG %s :%s", target, msg);
+	backlog_add_own(server, target, msg);
 }
 
 static void sig_message_own_private(IRC_SERVER_REC *server, const char *msg,
@@ -663,16 +728,23 @@ static void sig_message_own_private(IRC_SERVER_REC *server, const char *msg,
 
 	if (!ignore_next)
 		proxy_outserver_all(server, "PRIVMSG %s :%s", target, msg);
+	backlog_add_own(server, target, msg);
 }
 
 static void sig_message_own_action(IRC_SERVER_REC *server, const char *msg,
                                    const char *target)
 {
+	char *action;
+
 	if (!IS_IRC_SERVER(server))
 		return;
 
 	if (!ignore_next)
 		proxy_outserver_all(server, "PRIVMSG %s :\001ACTION %s\001", target, msg);
+
+	action = g_strdup_printf("\001ACTION %s\001", msg);
+	backlog_add_own(server, target, action);
+	g_free(action);
 }
 
 static LISTEN_REC *find_listen(const char *ircnet, int port, const char *port_or_path)
@@ -830,11 +902,13 @@ void proxy_listen_init(void)
 	}
 	enabled = TRUE;
 
-	next_line = g_string_new(NULL);
+	next_line = NULL;
 
 	proxy_clients = NULL;
 	proxy_listens = NULL;
 	read_settings();
+	proxy_flow_init();
+	proxy_backlog_init();
 
 	signal_add("server incoming", (SIGNAL_FUNC) sig_incoming);
 	signal_add("server event", (SIGNAL_FUNC) sig_server_event);
@@ -858,7 +932,16 @@ void proxy_listen_deinit(void)
 
 	while (proxy_listens != NULL)
 		remove_listen(proxy_listens->data);
-	g_string_free(next_line, TRUE);
+	proxy_backlog_deinit();
+	proxy_flow_deinit();
+	if (overflow_tag != -1) {
+		g_source_remove(overflow_tag);
+		overflow_tag = -1;
+	}
+	if (next_line != NULL) {
+		proxy_line_unref(next_line);
+		next_line = NULL;
+	}
 
 	signal_remove("server incoming", (SIGNAL_FUNC) sig_incoming);
 	signal_remove("server event", (SIGNAL_FUNC) sig_server_event);
@@ -16,11 +16,44 @@ void proxy_listen_deinit(void);
 
 void proxy_settings_init(void);
 
+void proxy_flow_init(void);
+void proxy_flow_deinit(void);
+
+/* Send data to client, or hold it behind the lines already held back while
+   the client is throttled. The client is disconnected if it can't keep up */
+int proxy_client_send(CLIENT_REC *client, const char *data, int len);
+/* Send line to client, following the slow client policy */
+void proxy_client_send_line(CLIENT_REC *client, PROXY_LINE_REC *line,
+			    int message);
+void proxy_client_flow_destroy(CLIENT_REC *client);
+/* Disconnect the client once it's safe to do */
+void proxy_client_disconnect_later(CLIENT_REC *client);
+
+void proxy_backlog_init(void);
+void proxy_backlog_deinit(void);
+
+/* Add line to the network's backlog */
+void proxy_backlog_add(IRC_SERVER_REC *server, PROXY_LINE_REC *line);
+/* Remember what the client has seen, so it can be replayed the rest
+   when it connects again */
+void proxy_backlog_client_left(CLIENT_REC *client);
+void proxy_backlog_replay(CLIENT_REC *client);
+
 void proxy_dump_data(CLIENT_REC *client);
 void proxy_client_reset_nick(CLIENT_REC *client);
 
+/* Returns new line with refcount 1 and \r\n appended */
+PROXY_LINE_REC *proxy_line_new(const char *line);
+void proxy_line_ref(PROXY_LINE_REC *rec);
+void proxy_line_unref(PROXY_LINE_REC *rec);
+
 void proxy_outdata(CLIENT_REC *client, const char *data, ...);
 void proxy_outdata_all(IRC_SERVER_REC *server, const char *data, ...);
+/* Send the line to all clients connected to the server. If `message' is
+   TRUE, the line is PRIVMSG or NOTICE that may be held back from slow
+   clients. */
+void proxy_outline_all(IRC_SERVER_REC *server, PROXY_LINE_REC *line,
+		       int message);
 void proxy_outserver(CLIENT_REC *client, const char *data, ...);
 void proxy_outserver_all(IRC_SERVER_REC *server, const char *data, ...);
 void proxy_outserver_all_except(CLIENT_REC *client, const char *data, ...);
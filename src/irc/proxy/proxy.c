@@ -22,6 +22,7 @@
 #include <irssi/src/core/signals.h>
 #include <irssi/src/core/settings.h>
 #include <irssi/src/core/levels.h>
+#include <irssi/src/core/net-sendbuffer.h>
 
 #include <irssi/src/fe-common/core/printtext.h>
 
@@ -49,6 +50,13 @@ static void cmd_irssiproxy_status(const char *data, IRC_SERVER_REC *server)
 			  rec->addr,
 			  rec->connected ? "ed" : "ing",
 			  rec->listen->port_or_path, rec->listen->ircnet);
+		printtext(server, NULL, MSGLEVEL_CLIENTNOTICE,
+			  "    %d bytes queued (peak %d), %d bytes held%s, "
+			  "throttled %u times, %u messages dropped, %u coalesced",
+			  net_sendbuffer_pending(rec->handle), rec->queue_peak,
+			  rec->held_size, rec->throttled ? " (throttled now)" : "",
+			  rec->throttle_count, rec->lines_dropped,
+			  rec->lines_coalesced);
 	}
 }
 
@@ -78,6 +86,12 @@ void irc_proxy_init(void)
 	settings_add_str("irssiproxy", "irssiproxy_password", "");
 	settings_add_str("irssiproxy", "irssiproxy_bind", "");
 	settings_add_bool("irssiproxy", "irssiproxy", TRUE);
+	settings_add_size("irssiproxy", "irssiproxy_backlog_size", "256k");
+	settings_add_size("irssiproxy", "irssiproxy_client_high_watermark", "256k");
+	settings_add_size("irssiproxy", "irssiproxy_client_low_watermark", "64k");
+	settings_add_choice("irssiproxy", "irssiproxy_slow_client", 0,
+			    "drop;compress;disconnect");
+	settings_add_bool("irssiproxy", "irssiproxy_backlog_server_time", TRUE);
 
 	if (*settings_get_str("irssiproxy_password") == '\0') {
 		/* no password - bad idea! */
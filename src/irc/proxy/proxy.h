@@ -26,6 +26,17 @@ typedef struct {
 	char *proxy_address;
 	LISTEN_REC *listen;
 	IRC_SERVER_REC *server;
+	char *user; /* name given in USER, identifies the client in backlog */
+
+	/* output flow control */
+	int drain_tag; /* checks when the send buffer has drained */
+	GQueue *held; /* lines held while throttled */
+	int held_size;
+	int queue_peak; /* largest send buffer seen */
+	unsigned int throttle_count, lines_dropped, lines_coalesced;
+
+	unsigned int throttled:1; /* send buffer went over high watermark */
+	unsigned int overflowed:1; /* to be disconnected */
 	unsigned int pass_sent:1;
 	unsigned int user_sent:1;
 	unsigned int connected:1;
@@ -33,4 +44,12 @@ typedef struct {
 	unsigned int multiplex:1;
 } CLIENT_REC;
 
+/* Line from the server, shared by all the clients it's sent to */
+typedef struct {
+	int refcount;
+	gint64 time; /* when the line was received, g_get_real_time() */
+	int len; /* length of str, including the \r\n */
+	char str[1];
+} PROXY_LINE_REC;
+
 #endif
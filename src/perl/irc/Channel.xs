@@ -44,11 +44,27 @@ void
 bans(channel)
 	Irssi::Irc::Channel channel
 PREINIT:
-	GSList *tmp;
+	GSList *list, *tmp;
 PPCODE:
-	for (tmp = channel->banlist; tmp != NULL; tmp = tmp->next) {
+	list = mode_list_get_entries(channel->banlist);
+	for (tmp = list; tmp != NULL; tmp = tmp->next) {
 		XPUSHs(sv_2mortal(plain_bless(tmp->data, "Irssi::Irc::Ban")));
 	}
+	g_slist_free(list);
+
+void
+bans_match(channel, nick, address)
+	Irssi::Irc::Channel channel
+	char *nick
+	char *address
+PREINIT:
+	GSList *list, *tmp;
+PPCODE:
+	list = banlist_match(channel, nick, address);
+	for (tmp = list; tmp != NULL; tmp = tmp->next) {
+		XPUSHs(sv_2mortal(plain_bless(tmp->data, "Irssi::Irc::Ban")));
+	}
+	g_slist_free(list);
 
 Irssi::Irc::Nick
 irc_nick_insert(channel, nick, op, halfop, voice, send_massjoin)
@@ -133,7 +133,9 @@ static void perl_netsplit_fill_hash(HV *hv, NETSPLIT_REC *netsplit)
 
 	(void) hv_store(hv, "nick", 4, new_pv(netsplit->nick), 0);
 	(void) hv_store(hv, "address", 7, new_pv(netsplit->address), 0);
-	(void) hv_store(hv, "destroy", 7, newSViv(netsplit->destroy), 0);
+	(void) hv_store(hv, "destroy", 7,
+			newSViv(netsplit->server->over ? netsplit->server->destroy :
+				netsplit->destroy), 0);
 
 	(void) hv_store(hv, "server", 6,
 		 plain_bless(netsplit->server,
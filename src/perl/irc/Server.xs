@@ -164,6 +164,39 @@ CODE:
 OUTPUT:
 	RETVAL
 
+void
+server_latency(server)
+	Irssi::Irc::Server server
+PREINIT:
+	LATENCY_HISTOGRAM_REC *rec;
+	HV *hv, *stats;
+	int type;
+PPCODE:
+	hv = newHV();
+	for (type = 0; type < LATENCY_TYPES; type++) {
+		rec = &server->latency->histograms[type];
+
+		stats = newHV();
+		(void) hv_store(stats, "count", 5, newSViv(rec->count), 0);
+		(void) hv_store(stats, "min", 3, newSViv(rec->min), 0);
+		(void) hv_store(stats, "max", 3, newSViv(rec->max), 0);
+		(void) hv_store(stats, "mean", 4, newSViv(rec->count == 0 ? 0 :
+							 rec->sum / (gint64) rec->count), 0);
+		(void) hv_store(stats, "p50", 3, newSViv(latency_histogram_percentile(rec, 50)), 0);
+		(void) hv_store(stats, "p90", 3, newSViv(latency_histogram_percentile(rec, 90)), 0);
+		(void) hv_store(stats, "p99", 3, newSViv(latency_histogram_percentile(rec, 99)), 0);
+
+		(void) hv_store(hv, latency_type_name(type), strlen(latency_type_name(type)),
+				newRV_noinc((SV *) stats), 0);
+	}
+	XPUSHs(sv_2mortal(newRV_noinc((SV *) hv)));
+
+void
+server_latency_clear(server)
+	Irssi::Irc::Server server
+CODE:
+	irc_latency_clear(server);
+
 int
 irc_server_cap_toggle(server, cap, enable)
 	Irssi::Irc::Server server
@@ -8,6 +8,7 @@
 #include <irssi/src/irc/core/irc-nicklist.h>
 #include <irssi/src/irc/core/irc-masks.h>
 #include <irssi/src/irc/core/irc-cap.h>
+#include <irssi/src/irc/core/latency.h>
 
 #include <irssi/src/irc/core/bans.h>
 #include <irssi/src/irc/core/modes.h>
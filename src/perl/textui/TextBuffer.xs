@@ -80,6 +80,7 @@ PREINIT:
 	AV *av;
 	LINE_REC *l;
 	TEXT_BUFFER_FORMAT_REC *f;
+	char *text;
 	int i;
 PPCODE:
 	hv = newHV();
@@ -96,8 +97,13 @@ PPCODE:
 			av_push(av, new_pv(f->args[i]));
 		}
 		(void) hv_store(hv, "args", 4, newRV_noinc((SV *) av), 0);
-	} else {
+	} else if (l->info.text != NULL) {
 		(void) hv_store(hv, "text", 4, new_pv(l->info.text), 0);
+	} else {
+		/* moved to disk */
+		text = textbuffer_spill_get_text(line->buffer, l);
+		(void) hv_store(hv, "text", 4, new_pv(text), 0);
+		g_free(text);
 	}
 	XPUSHs(sv_2mortal(newRV_noinc((SV *) hv)));
 
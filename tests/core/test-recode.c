@@ -0,0 +1,154 @@
+/*
+ test-recode.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/core/recode.h>
+#include <irssi/src/core/settings.h>
+#include <irssi/src/lib-config/iconfig.h>
+
+#define MODULE_NAME "tests"
+
+#define LINES 100000
+
+/* "café" in ISO-8859-1 and UTF-8 */
+#define CAFE_LATIN1 "caf\xe9"
+#define CAFE_UTF8 "caf\xc3\xa9"
+/* "こんにちは" in ISO-2022-JP and UTF-8 */
+#define HELLO_JIS "\x1b$B$3$s$K$A$O\x1b(B"
+#define HELLO_UTF8 "\xe3\x81\x93\xe3\x82\x93\xe3\x81\xab\xe3\x81\xa1\xe3\x81\xaf"
+
+static void recode_assert(const char *target, const char *in, const char *out)
+{
+	char *recoded;
+
+	recoded = recode_in(NULL, in, target);
+	g_assert_cmpstr(recoded, ==, out);
+	g_free(recoded);
+}
+
+static void test_recode_in(void)
+{
+	recode_assert("#latin", "hello world", "hello world");
+	recode_assert("#latin", CAFE_LATIN1, CAFE_UTF8);
+	/* UTF-8 is detected */
+	recode_assert("#latin", CAFE_UTF8, CAFE_UTF8);
+	recode_assert("#latin", "the long ascii prefix is skipped: " CAFE_LATIN1,
+		      "the long ascii prefix is skipped: " CAFE_UTF8);
+
+	/* ESC changes the state, so it can't be passed as ASCII */
+	recode_assert("#jis", HELLO_JIS, HELLO_UTF8);
+	recode_assert("#jis", "hi " HELLO_JIS " again", "hi " HELLO_UTF8 " again");
+	recode_assert("#jis", "plain", "plain");
+
+	/* no conversion, 8-bit text goes through recode_fallback */
+	recode_assert("#other", CAFE_LATIN1, CAFE_UTF8);
+}
+
+static void test_recode_out(void)
+{
+	char *recoded;
+
+	recoded = recode_out(NULL, CAFE_UTF8, "#latin");
+	g_assert_cmpstr(recoded, ==, CAFE_LATIN1);
+	g_free(recoded);
+
+	recoded = recode_out(NULL, "hello world", "#latin");
+	g_assert_cmpstr(recoded, ==, "hello world");
+	g_free(recoded);
+
+	recoded = recode_out(NULL, HELLO_UTF8, "#jis");
+	g_assert_cmpstr(recoded, ==, HELLO_JIS);
+	g_free(recoded);
+}
+
+static void test_recode_split(void)
+{
+	char **lines;
+
+	/* the split doesn't break the multibyte characters */
+	lines = recode_split(NULL, CAFE_UTF8 CAFE_UTF8, "#other", 4, FALSE);
+	g_assert_cmpint(g_strv_length(lines), ==, 3);
+	g_assert_cmpstr(lines[0], ==, "caf");
+	g_assert_cmpstr(lines[1], ==, "\xc3\xa9" "ca");
+	g_assert_cmpstr(lines[2], ==, "f\xc3\xa9");
+	g_strfreev(lines);
+}
+
+static void test_recode_mixed(void)
+{
+	static const char *corpus[] = {
+		"just some text in a channel, nothing special here",
+		"caf\xe9 cr\xe8me br\xfbl\xe9" "e, \xe0 bient\xf4t",
+		"caf\xc3\xa9 cr\xc3\xa8me br\xc3\xbbl\xc3\xa9" "e",
+		"and then " HELLO_JIS " from someone",
+		"another perfectly ordinary line of 7-bit ascii text",
+		NULL
+	};
+	static const char *targets[] = {
+		"#latin", "#latin", "#latin", "#jis", "#jis", NULL
+	};
+	double elapsed;
+	char *recoded;
+	int i;
+
+	g_test_timer_start();
+	for (i = 0; i < LINES; i++) {
+		recoded = recode_in(NULL, corpus[i % 5], targets[i % 5]);
+		g_free(recoded);
+	}
+	elapsed = g_test_timer_elapsed();
+
+	g_test_message("%d mixed charset lines in %.3f seconds", LINES, elapsed);
+	g_test_minimized_result(elapsed, "%d lines", LINES);
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/test/recode/in", test_recode_in);
+	g_test_add_func("/test/recode/out", test_recode_out);
+	g_test_add_func("/test/recode/split", test_recode_split);
+	g_test_add_func("/test/recode/mixed", test_recode_mixed);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	args_execute(0, NULL);
+	core_init();
+	settings_add_str("lookandfeel", "term_charset", "UTF-8");
+	recode_update_charset();
+
+	iconfig_set_str("conversions", "#latin", "ISO-8859-1");
+	iconfig_set_str("conversions", "#jis", "ISO-2022-JP");
+
+	ret = g_test_run();
+
+	core_deinit();
+	return ret;
+}
@@ -0,0 +1,279 @@
+/*
+ test-session-stream.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/session-stream.h>
+
+#include <unistd.h>
+
+#define SERVERS 10
+#define CHANNELS 50
+#define NICKS 400
+
+static char *session_path;
+
+static void write_server(SESSION_STREAM *stream, int server)
+{
+	CONFIG_NODE *node, *isupport;
+	char *str;
+
+	node = session_stream_record(stream);
+	str = g_strdup_printf("irc%d.example.org", server);
+	config_node_set_str(stream->config, node, "address", str);
+	g_free(str);
+	config_node_set_int(stream->config, node, "port", 6660 + server);
+	config_node_set_bool(stream->config, node, "use_tls", server % 2);
+
+	isupport = config_node_section(stream->config, node, "isupport", NODE_TYPE_BLOCK);
+	config_node_set_str(stream->config, isupport, "CHANTYPES", "#&");
+	config_node_set_str(stream->config, isupport, "PREFIX", "(ov)@+");
+	config_node_set_str(stream->config, isupport, "EXCEPTS", "");
+	session_stream_write(stream, SESSION_RECORD_SERVER);
+}
+
+static void write_channel(SESSION_STREAM *stream, int server, int channel)
+{
+	CONFIG_NODE *node;
+	char *str;
+
+	node = session_stream_record(stream);
+	str = g_strdup_printf("#chan%d-%d", server, channel);
+	config_node_set_str(stream->config, node, "name", str);
+	g_free(str);
+	config_node_set_str(stream->config, node, "topic",
+			    channel % 3 == 0 ? NULL : "some topic \xc3\xa4");
+	config_node_set_int(stream->config, node, "topic_time", channel);
+	session_stream_write(stream, SESSION_RECORD_CHANNEL);
+}
+
+static void write_nick(SESSION_STREAM *stream, int channel, int nick)
+{
+	CONFIG_NODE *node;
+	char *str;
+
+	node = session_stream_record(stream);
+	str = g_strdup_printf("nick%d_%d", channel, nick);
+	config_node_set_str(stream->config, node, "nick", str);
+	g_free(str);
+	config_node_set_bool(stream->config, node, "op", nick % 7 == 0);
+	config_node_set_str(stream->config, node, "prefixes", nick % 7 == 0 ? "@" : "");
+	session_stream_write(stream, SESSION_RECORD_NICK);
+}
+
+static void write_session_stream(SESSION_STREAM *stream)
+{
+	int server, channel, nick;
+
+	g_assert_nonnull(stream);
+
+	for (server = 0; server < SERVERS; server++) {
+		write_server(stream, server);
+		for (channel = 0; channel < CHANNELS; channel++) {
+			write_channel(stream, server, channel);
+			for (nick = 0; nick < NICKS; nick++)
+				write_nick(stream, channel, nick);
+		}
+	}
+
+	g_assert_true(session_stream_close(stream));
+}
+
+static void write_session(void)
+{
+	write_session_stream(session_stream_create(session_path));
+}
+
+static void check_server(CONFIG_NODE *node, int server)
+{
+	char *str;
+
+	str = g_strdup_printf("irc%d.example.org", server);
+	g_assert_cmpstr(config_node_get_str(node, "address", NULL), ==, str);
+	g_free(str);
+	g_assert_cmpint(config_node_get_int(node, "port", 0), ==, 6660 + server);
+	g_assert_cmpint(config_node_get_bool(node, "use_tls", -1), ==, server % 2);
+
+	node = config_node_section(NULL, node, "isupport", -1);
+	g_assert_nonnull(node);
+	g_assert_cmpint(node->type, ==, NODE_TYPE_BLOCK);
+	g_assert_cmpstr(config_node_get_str(node, "CHANTYPES", NULL), ==, "#&");
+	g_assert_cmpstr(config_node_get_str(node, "PREFIX", NULL), ==, "(ov)@+");
+	g_assert_cmpstr(config_node_get_str(node, "EXCEPTS", NULL), ==, "");
+}
+
+static void check_channel(CONFIG_NODE *node, int server, int channel)
+{
+	char *str;
+
+	str = g_strdup_printf("#chan%d-%d", server, channel);
+	g_assert_cmpstr(config_node_get_str(node, "name", NULL), ==, str);
+	g_free(str);
+	g_assert_cmpstr(config_node_get_str(node, "topic", NULL), ==,
+			channel % 3 == 0 ? NULL : "some topic \xc3\xa4");
+	g_assert_cmpint(config_node_get_int(node, "topic_time", -1), ==, channel);
+}
+
+static void check_nick(CONFIG_NODE *node, int channel, int nick)
+{
+	char *str;
+
+	str = g_strdup_printf("nick%d_%d", channel, nick);
+	g_assert_cmpstr(config_node_get_str(node, "nick", NULL), ==, str);
+	g_free(str);
+	g_assert_cmpint(config_node_get_bool(node, "op", -1), ==, nick % 7 == 0);
+	g_assert_cmpstr(config_node_get_str(node, "prefixes", NULL), ==,
+			nick % 7 == 0 ? "@" : "");
+}
+
+static void test_session_stream_round_trip(void)
+{
+	SESSION_STREAM *stream;
+	CONFIG_NODE *node;
+	int server, channel, nick;
+
+	write_session();
+
+	stream = session_stream_open(session_path);
+	g_assert_nonnull(stream);
+	g_assert_cmpint(stream->version, ==, SESSION_STREAM_VERSION);
+
+	node = stream->config->mainnode;
+	for (server = 0; server < SERVERS; server++) {
+		g_assert_cmpint(session_stream_read(stream), ==, SESSION_RECORD_SERVER);
+		check_server(node, server);
+
+		for (channel = 0; channel < CHANNELS; channel++) {
+			g_assert_cmpint(session_stream_read(stream), ==, SESSION_RECORD_CHANNEL);
+			check_channel(node, server, channel);
+
+			for (nick = 0; nick < NICKS; nick++) {
+				g_assert_cmpint(session_stream_read(stream), ==, SESSION_RECORD_NICK);
+				check_nick(node, channel, nick);
+			}
+		}
+	}
+
+	g_assert_cmpint(session_stream_read(stream), ==, SESSION_RECORD_END);
+	g_assert_true(session_stream_close(stream));
+}
+
+static void test_session_stream_truncated(void)
+{
+	SESSION_STREAM *stream;
+	struct stat statbuf;
+	int type, records;
+
+	write_session();
+
+	g_assert_cmpint(stat(session_path, &statbuf), ==, 0);
+	g_assert_cmpint(truncate(session_path, statbuf.st_size / 2), ==, 0);
+
+	stream = session_stream_open(session_path);
+	g_assert_nonnull(stream);
+
+	records = 0;
+	while ((type = session_stream_read(stream)) > SESSION_RECORD_END)
+		records++;
+
+	g_assert_cmpint(type, ==, -1);
+	g_assert_cmpint(records, >, 0);
+	g_assert_cmpint(records, <, SERVERS * CHANNELS * NICKS);
+	g_assert_false(session_stream_close(stream));
+}
+
+static void test_session_stream_text_file(void)
+{
+	g_assert_true(g_file_set_contents(session_path,
+					  "servers = ( { chat_type = \"IRC\"; } );\n",
+					  -1, NULL));
+
+	/* old session files are left for lib-config */
+	g_assert_null(session_stream_open(session_path));
+}
+
+static void test_session_stream_write_text(void)
+{
+	CONFIG_REC *config;
+	CONFIG_NODE *node, *chnode, *nicknode;
+	GSList *tmp, *chtmp, *nicktmp;
+	int server, channel, nick;
+
+	write_session_stream(session_stream_create_text(session_path));
+
+	/* the layout the versions before the binary files read */
+	g_assert_null(session_stream_open(session_path));
+	config = config_open(session_path, -1);
+	g_assert_nonnull(config);
+	g_assert_cmpint(config_parse(config), ==, 0);
+
+	node = config_node_traverse(config, "(servers", FALSE);
+	g_assert_nonnull(node);
+	server = 0;
+	for (tmp = config_node_first(node->value); tmp != NULL;
+	     tmp = config_node_next(tmp), server++) {
+		check_server(tmp->data, server);
+
+		chnode = config_node_section(NULL, tmp->data, "channels", -1);
+		g_assert_nonnull(chnode);
+		channel = 0;
+		for (chtmp = config_node_first(chnode->value); chtmp != NULL;
+		     chtmp = config_node_next(chtmp), channel++) {
+			check_channel(chtmp->data, server, channel);
+
+			nicknode = config_node_section(NULL, chtmp->data, "nicks", -1);
+			g_assert_nonnull(nicknode);
+			nick = 0;
+			for (nicktmp = config_node_first(nicknode->value); nicktmp != NULL;
+			     nicktmp = config_node_next(nicktmp), nick++)
+				check_nick(nicktmp->data, channel, nick);
+			g_assert_cmpint(nick, ==, NICKS);
+		}
+		g_assert_cmpint(channel, ==, CHANNELS);
+	}
+	g_assert_cmpint(server, ==, SERVERS);
+
+	config_close(config);
+}
+
+int main(int argc, char **argv)
+{
+	int handle, ret;
+
+	g_test_init(&argc, &argv, NULL);
+
+	handle = g_file_open_tmp("irssi-session-XXXXXX", &session_path, NULL);
+	g_assert_cmpint(handle, !=, -1);
+	close(handle);
+
+	g_test_add_func("/test/session_stream/round_trip",
+			test_session_stream_round_trip);
+	g_test_add_func("/test/session_stream/truncated",
+			test_session_stream_truncated);
+	g_test_add_func("/test/session_stream/text_file",
+			test_session_stream_text_file);
+	g_test_add_func("/test/session_stream/write_text",
+			test_session_stream_write_text);
+
+	ret = g_test_run();
+
+	unlink(session_path);
+	g_free(session_path);
+	return ret;
+}
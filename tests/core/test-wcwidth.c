@@ -0,0 +1,152 @@
+/*
+ test-wcwidth.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/utf8.h>
+
+#define LINES 100000
+
+extern WCWIDTH_FUNC wcwidth_impl_func;
+
+/* "日本語" */
+#define NIHONGO "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e"
+/* "é" with a combining acute accent */
+#define E_ACUTE "e\xcc\x81"
+/* "🔥" */
+#define FIRE "\xf0\x9f\x94\xa5"
+
+static int all_wide_wcwidth(unichar ucs)
+{
+	return 2;
+}
+
+static void test_wcwidth_table(void)
+{
+	unichar ucs;
+
+	/* the table gives what the implementation gives */
+	wcwidth_impl_func = mk_wcwidth;
+	for (ucs = 0; ucs <= 0x10ffff; ucs++) {
+		if (i_wcwidth(ucs) != mk_wcwidth(ucs))
+			g_assert_cmpint(i_wcwidth(ucs), ==, mk_wcwidth(ucs));
+	}
+	g_assert_cmpint(i_wcwidth(0x110000), ==, mk_wcwidth(0x110000));
+
+	/* and is filled again when the implementation changes */
+	wcwidth_impl_func = all_wide_wcwidth;
+	g_assert_cmpint(i_wcwidth(0xe9), ==, 2);
+	g_assert_cmpint(i_wcwidth(0x4e00), ==, 2);
+	/* except for ASCII, which is always one column */
+	g_assert_cmpint(i_wcwidth('a'), ==, 1);
+
+	wcwidth_impl_func = mk_wcwidth;
+	g_assert_cmpint(i_wcwidth(0xe9), ==, 1);
+	g_assert_cmpint(i_wcwidth(0x4e00), ==, 2);
+	g_assert_cmpint(i_wcwidth(0x301), ==, 0);
+}
+
+static void test_printable_ascii_len(void)
+{
+	char buf[64];
+	int i, len;
+
+	g_assert_cmpuint(string_printable_ascii_len("", 0), ==, 0);
+	g_assert_cmpuint(string_printable_ascii_len("hello", 5), ==, 5);
+	g_assert_cmpuint(string_printable_ascii_len("hello", 3), ==, 3);
+	g_assert_cmpuint(string_printable_ascii_len(" ~", 2), ==, 2);
+	g_assert_cmpuint(string_printable_ascii_len("caf\xc3\xa9", 5), ==, 3);
+
+	/* stops at each kind of other byte, wherever it is */
+	for (len = 1; len < (int) sizeof(buf); len++) {
+		for (i = 0; i < len; i++) {
+			memset(buf, 'x', len);
+			buf[i] = '\x1f';
+			g_assert_cmpuint(string_printable_ascii_len(buf, len), ==, i);
+			buf[i] = '\x7f';
+			g_assert_cmpuint(string_printable_ascii_len(buf, len), ==, i);
+			buf[i] = '\x80';
+			g_assert_cmpuint(string_printable_ascii_len(buf, len), ==, i);
+			buf[i] = '\0';
+			g_assert_cmpuint(string_printable_ascii_len(buf, len), ==, i);
+		}
+		memset(buf, 'x', len);
+		g_assert_cmpuint(string_printable_ascii_len(buf, len), ==, len);
+	}
+}
+
+static void test_string_width(void)
+{
+	wcwidth_impl_func = mk_wcwidth;
+
+	g_assert_cmpint(string_width("", TREAT_STRING_AS_UTF8), ==, 0);
+	g_assert_cmpint(string_width("hello world", TREAT_STRING_AS_UTF8), ==, 11);
+	g_assert_cmpint(string_width(NIHONGO, TREAT_STRING_AS_UTF8), ==, 6);
+	g_assert_cmpint(string_width("a long ascii prefix, then " NIHONGO " and " E_ACUTE,
+				     TREAT_STRING_AS_UTF8), ==, 26 + 6 + 5 + 1);
+	g_assert_cmpint(string_width("tab\there", TREAT_STRING_AS_UTF8), ==, 8);
+	g_assert_cmpint(string_width(NIHONGO, TREAT_STRING_AS_BYTES), ==, 9);
+}
+
+static void time_string_width(const char *name, const char *line)
+{
+	double elapsed;
+	int i, width;
+
+	width = 0;
+	g_test_timer_start();
+	for (i = 0; i < LINES; i++)
+		width += string_width(line, TREAT_STRING_AS_UTF8);
+	elapsed = g_test_timer_elapsed();
+
+	g_assert_cmpint(width, ==, LINES * string_width(line, TREAT_STRING_AS_UTF8));
+	g_test_message("%d %s lines in %.3f seconds", LINES, name, elapsed);
+	g_test_minimized_result(elapsed, "%d %s lines", LINES, name);
+}
+
+static void test_string_width_speed(void)
+{
+	wcwidth_impl_func = mk_wcwidth;
+
+	time_string_width("latin",
+			  "<nick> just some text in a channel, caf\xc3\xa9 cr\xc3\xa8me "
+			  "br\xc3\xbbl\xc3\xa9" "e and nothing special here");
+	time_string_width("cjk",
+			  "<nick> " NIHONGO NIHONGO NIHONGO " " NIHONGO NIHONGO
+			  NIHONGO " " NIHONGO NIHONGO NIHONGO NIHONGO);
+	time_string_width("emoji",
+			  "<nick> " FIRE FIRE " lol " FIRE FIRE FIRE " ok "
+			  FIRE " " FIRE FIRE FIRE FIRE FIRE FIRE);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/test/wcwidth/table", test_wcwidth_table);
+	g_test_add_func("/test/wcwidth/printable_ascii_len", test_printable_ascii_len);
+	g_test_add_func("/test/wcwidth/string_width", test_string_width);
+	g_test_add_func("/test/wcwidth/string_width_speed", test_string_width_speed);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	return g_test_run();
+}
@@ -0,0 +1,201 @@
+/*
+ test-keyboard.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/fe-common/core/keyboard.h>
+
+#define MODULE_NAME "tests"
+
+#define INPUT_SIZE (64 * 1024)
+#define INPUT_ROUNDS 20
+
+static KEYBOARD_REC *keyboard;
+static GString *actions;
+static int unused_keys;
+
+static void key_test_action(const char *data)
+{
+	g_string_append_printf(actions, "<%s>", data);
+}
+
+static void key_test_combo(void)
+{
+}
+
+/* Feeds input to the keyboard the same way gui-readline does */
+static void feed(const char *input)
+{
+	const unsigned char *p;
+	char str[8];
+
+	for (p = (const unsigned char *) input; *p != '\0'; p = (const unsigned char *) g_utf8_next_char(p)) {
+		if (*p < 32) {
+			str[0] = '^';
+			str[1] = *p + '@';
+			str[2] = '\0';
+		} else if (*p == 127) {
+			str[0] = '^';
+			str[1] = '?';
+			str[2] = '\0';
+		} else {
+			str[g_unichar_to_utf8(g_utf8_get_char((const char *) p), str)] = '\0';
+		}
+		if (strcmp(str, "^") == 0)
+			strcpy(str, "^-");
+
+		if (key_pressed(keyboard, str) < 0)
+			unused_keys++;
+	}
+}
+
+static void assert_actions(const char *input, const char *expected, int unused)
+{
+	g_string_truncate(actions, 0);
+	unused_keys = 0;
+	feed(input);
+	g_assert_cmpstr(actions->str, ==, expected);
+	g_assert_cmpint(unused_keys, ==, unused);
+}
+
+static void test_keyboard_combos(void)
+{
+	assert_actions("hello", "", 5);
+	assert_actions("\x1b[A", "<up>", 0);
+	assert_actions("\x1bOA", "<up>", 0);
+	assert_actions("a\x1b[Bb", "<down>", 2);
+	assert_actions("\x1b[1;5C", "<cright>", 0);
+	assert_actions("\x1b" "b", "<meta-b>", 0);
+	assert_actions("\x17", "<^W>", 0);
+	assert_actions("^", "<caret>", 0);
+	assert_actions("\xc3\xa9t\xc3\xa9", "<e-acute>t<e-acute>", 1);
+
+	/* unknown combos eat the key that didn't match */
+	assert_actions("\x1b[Z!", "", 1);
+}
+
+static void test_keyboard_rebind(void)
+{
+	key_configure_add("test_action", "meta-x", "meta-x");
+	assert_actions("\x1bx", "<meta-x>", 0);
+
+	key_configure_remove("meta-x");
+	assert_actions("\x1bxy", "", 1);
+
+	/* named keys change the other combos */
+	key_configure_add("key", "meta-[O", "meta2");
+	assert_actions("\x1b[OA", "<up>", 0);
+	key_configure_remove("meta-[O");
+	assert_actions("\x1b[OA", "", 1);
+
+	/* the key combo in progress continues when the bindings change */
+	feed("\x1b");
+	key_configure_add("test_action", "meta-y", "meta-y");
+	assert_actions("[A", "<up>", 0);
+	feed("\x1b");
+	key_configure_remove("meta-y");
+	assert_actions("y", "", 0);
+	feed("\x1b[");
+	key_configure_remove("up");
+	assert_actions("Ab", "", 1);
+}
+
+static void test_keyboard_input_speed(void)
+{
+	static const char *chunks[] = {
+		"just some text typed or pasted into the input line, ",
+		"caf\xc3\xa9 cr\xc3\xa8me ",
+		"\x1b[A", "\x1b[D", "\x17",
+		NULL
+	};
+	GString *input;
+	double elapsed;
+	int i;
+
+	input = g_string_new(NULL);
+	for (i = 0; input->len < INPUT_SIZE; i++)
+		g_string_append(input, chunks[i % 5]);
+
+	g_string_truncate(actions, 0);
+	g_test_timer_start();
+	for (i = 0; i < INPUT_ROUNDS; i++)
+		feed(input->str);
+	elapsed = g_test_timer_elapsed();
+	g_assert_cmpuint(actions->len, >, 0);
+
+	g_test_message("%d kB of input in %.3f seconds",
+		       (int) (INPUT_ROUNDS * input->len / 1024), elapsed);
+	g_test_minimized_result(elapsed, "%d kB of input",
+				(int) (INPUT_ROUNDS * input->len / 1024));
+	g_string_free(input, TRUE);
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/test/keyboard/combos", test_keyboard_combos);
+	g_test_add_func("/test/keyboard/rebind", test_keyboard_rebind);
+	g_test_add_func("/test/keyboard/input_speed", test_keyboard_input_speed);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	args_execute(0, NULL);
+	core_init();
+	keyboard_init();
+
+	actions = g_string_new(NULL);
+	keyboard = keyboard_create(NULL);
+
+	key_configure_freeze();
+	key_bind("key", NULL, "^[", "meta", (SIGNAL_FUNC) key_test_combo);
+	key_bind("key", NULL, "meta-[", "meta2", (SIGNAL_FUNC) key_test_combo);
+	key_bind("key", NULL, "meta-O", "meta2", (SIGNAL_FUNC) key_test_combo);
+	key_bind("key", NULL, "meta2-A", "up", (SIGNAL_FUNC) key_test_combo);
+	key_bind("key", NULL, "meta2-B", "down", (SIGNAL_FUNC) key_test_combo);
+	key_bind("key", NULL, "meta2-D", "left", (SIGNAL_FUNC) key_test_combo);
+	key_bind("key", NULL, "meta2-1;5C", "cright", (SIGNAL_FUNC) key_test_combo);
+
+	key_bind("test_action", "Test action", "up", "up", (SIGNAL_FUNC) key_test_action);
+	key_bind("test_action", NULL, "down", "down", NULL);
+	key_bind("test_action", NULL, "left", "left", NULL);
+	key_bind("test_action", NULL, "cright", "cright", NULL);
+	key_bind("test_action", NULL, "meta-b", "meta-b", NULL);
+	key_bind("test_action", NULL, "^W", "^W", NULL);
+	key_bind("test_action", NULL, "^-", "caret", NULL);
+	key_bind("test_action", NULL, "\xc3\xa9", "e-acute", NULL);
+	key_configure_thaw();
+
+	ret = g_test_run();
+
+	keyboard_destroy(keyboard);
+	g_string_free(actions, TRUE);
+	keyboard_deinit();
+	core_deinit();
+	return ret;
+}
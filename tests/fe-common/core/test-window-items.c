@@ -0,0 +1,248 @@
+/*
+ test-window-items.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/core/signals.h>
+#include <irssi/src/fe-common/core/fe-windows.h>
+#include <irssi/src/fe-common/core/window-items.h>
+
+#define TEST_ROUNDS 2000
+
+static const char *names[] = {
+	"#irssi", "#IRSSI", "#Irssi", "nick", "NICK", "other", "#chan", NULL
+};
+
+/* only the pointers are compared */
+static int servers[2];
+
+static void test_item_destroy(WI_ITEM_REC *item)
+{
+	g_free(item->visible_name);
+	g_free(item->name);
+	g_free(item);
+}
+
+static WI_ITEM_REC *test_item_new(const char *name, const char *visible_name)
+{
+	WI_ITEM_REC *item;
+
+	item = g_new0(WI_ITEM_REC, 1);
+	item->name = g_strdup(name);
+	item->visible_name = g_strdup(visible_name);
+	item->destroy = test_item_destroy;
+	return item;
+}
+
+static void test_item_rename(WI_ITEM_REC *item, const char *visible_name)
+{
+	g_free(item->visible_name);
+	item->visible_name = g_strdup(visible_name);
+	signal_emit("window item name changed", 1, item);
+}
+
+/* The lookups as they were done by going through all the windows */
+static WI_ITEM_REC *item_find_linear(void *server, const char *name)
+{
+	GSList *tmp, *sub;
+
+	for (tmp = windows; tmp != NULL; tmp = tmp->next) {
+		WINDOW_REC *window = tmp->data;
+
+		for (sub = window->items; sub != NULL; sub = sub->next) {
+			WI_ITEM_REC *rec = sub->data;
+
+			if ((server == NULL || rec->server == server) &&
+			    (g_ascii_strcasecmp(name, rec->visible_name) == 0 ||
+			     (rec->name && g_ascii_strcasecmp(name, rec->name) == 0)))
+				return rec;
+		}
+	}
+	return NULL;
+}
+
+static WINDOW_REC *window_find_name_linear(const char *name)
+{
+	GSList *tmp;
+
+	for (tmp = windows; tmp != NULL; tmp = tmp->next) {
+		WINDOW_REC *rec = tmp->data;
+
+		if (rec->name != NULL && g_ascii_strcasecmp(rec->name, name) == 0)
+			return rec;
+	}
+	return NULL;
+}
+
+static void assert_lookups(void)
+{
+	int i;
+
+	for (i = 0; names[i] != NULL; i++) {
+		g_assert_true(window_item_find(NULL, names[i]) ==
+			      item_find_linear(NULL, names[i]));
+		g_assert_true(window_item_find(&servers[0], names[i]) ==
+			      item_find_linear(&servers[0], names[i]));
+		g_assert_true(window_item_find(&servers[1], names[i]) ==
+			      item_find_linear(&servers[1], names[i]));
+		g_assert_true(window_find_name(names[i]) ==
+			      window_find_name_linear(names[i]));
+	}
+}
+
+static WINDOW_REC *random_window(void)
+{
+	return g_slist_nth_data(windows, g_test_rand_int_range(0, g_slist_length(windows)));
+}
+
+static const char *random_name(void)
+{
+	return names[g_test_rand_int_range(0, G_N_ELEMENTS(names) - 1)];
+}
+
+static void test_window_item_find(void)
+{
+	WINDOW_REC *window1, *window2;
+	WI_ITEM_REC *item1, *item2;
+
+	window1 = window_create(NULL, FALSE);
+	item1 = test_item_new("!ABCDE#irssi", "#irssi");
+	window_item_add(window1, item1, FALSE);
+	item1->server = (void *) &servers[0];
+
+	window2 = window_create(NULL, FALSE);
+	item2 = test_item_new("#irssi", "#irssi");
+	window_item_add(window2, item2, FALSE);
+	item2->server = (void *) &servers[1];
+
+	/* the active window is the first in the list */
+	g_assert_true(window_item_find(NULL, "#IRSSI") == item2);
+	window_set_active(window1);
+	g_assert_true(window_item_find(NULL, "#IRSSI") == item1);
+	g_assert_true(window_item_find(&servers[1], "#irssi") == item2);
+	g_assert_true(window_item_find(NULL, "!abcde#irssi") == item1);
+	g_assert_true(window_item_find(&servers[1], "!ABCDE#irssi") == NULL);
+
+	test_item_rename(item1, "#other");
+	g_assert_true(window_item_find(&servers[0], "#irssi") == NULL);
+	g_assert_true(window_item_find(NULL, "#other") == item1);
+
+	window_item_remove(item1);
+	g_assert_true(window_item_find(NULL, "#other") == NULL);
+	test_item_destroy(item1);
+
+	window_set_name(window2, "Status");
+	g_assert_true(window_find_name("status") == window2);
+	window_set_name(window2, "other");
+	g_assert_true(window_find_name("status") == NULL);
+	g_assert_true(window_find_item(NULL, "OTHER") == window2);
+
+	window_destroy(window1);
+	window_destroy(window2);
+	g_assert_true(window_item_find(NULL, "#irssi") == NULL);
+	g_assert_true(window_find_name("other") == NULL);
+}
+
+static void test_window_item_find_random(void)
+{
+	WINDOW_REC *window;
+	WI_ITEM_REC *item;
+	int i;
+
+	for (i = 0; i < 5; i++)
+		window_create(NULL, FALSE);
+
+	for (i = 0; i < TEST_ROUNDS; i++) {
+		switch (g_test_rand_int_range(0, 8)) {
+		case 0:
+			window_create(NULL, FALSE);
+			break;
+		case 1:
+			if (g_slist_length(windows) > 5)
+				window_destroy(random_window());
+			break;
+		case 2:
+			window_set_name(random_window(),
+					g_test_rand_int_range(0, 2) ? random_name() : NULL);
+			break;
+		case 3:
+			window_set_active(random_window());
+			break;
+		case 4:
+			/* one item per window, so the window doesn't print
+			   anything when the active item changes */
+			window = random_window();
+			if (window->items != NULL)
+				break;
+			item = test_item_new(g_test_rand_int_range(0, 2) ?
+					     random_name() : NULL, random_name());
+			window_item_add(window, item, FALSE);
+			item->server = (void *) &servers[g_test_rand_int_range(0, 2)];
+			break;
+		case 5:
+			window = random_window();
+			if (window->items != NULL)
+				window_item_destroy(window->items->data);
+			break;
+		case 6:
+			window = random_window();
+			if (window->items != NULL)
+				test_item_rename(window->items->data, random_name());
+			break;
+		default:
+			assert_lookups();
+			break;
+		}
+	}
+
+	assert_lookups();
+	while (windows != NULL)
+		window_destroy(windows->data);
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/test/window_items/find", test_window_item_find);
+	g_test_add_func("/test/window_items/find_random", test_window_item_find_random);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	args_execute(0, NULL);
+	core_init();
+	windows_init();
+	window_items_init();
+
+	ret = g_test_run();
+
+	window_items_deinit();
+	windows_deinit();
+	core_deinit();
+	return ret;
+}
@@ -0,0 +1,217 @@
+/*
+ test-gui-entry.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/fe-text/terminfo-core.h>
+
+#include <stdio.h>
+
+/* see what the entry draws instead of printing it */
+#define gui_printtext_internal test_printtext_internal
+#include <irssi/src/fe-text/gui-entry.c>
+
+#define WIDTH 80
+
+typedef struct {
+	FILE *out;
+	GUI_ENTRY_REC *entry;
+} EntryData;
+
+static int draw_count;
+
+void test_printtext_internal(int xpos, int ypos, const char *str)
+{
+	draw_count++;
+}
+
+/* Screen position of pos calculated from the start of the text */
+static int scrpos_from_start(GUI_ENTRY_REC *entry, int pos)
+{
+	int i, xpos = 0;
+
+	if (entry->uses_extents && entry->extents[0] != NULL)
+		xpos += scrlen_str(entry->extents[0], entry->utf8);
+
+	for (i = 0; i < entry->text_len && i < pos; i++) {
+		xpos += unichar_isprint(entry->text[i]) ?
+			i_wcwidth(entry->text[i]) : 1;
+		if (entry->uses_extents && entry->extents[i+1] != NULL)
+			xpos += scrlen_str(entry->extents[i+1], entry->utf8);
+	}
+	return xpos + pos - i;
+}
+
+static void assert_positions(GUI_ENTRY_REC *entry)
+{
+	int pos;
+
+	/* the cached position must match what it caches */
+	if (entry->width_cache_pos >= 0 &&
+	    entry->width_cache_pos <= entry->text_len) {
+		g_assert_cmpint(entry->width_cache_xpos, ==,
+				scrpos_from_start(entry, entry->width_cache_pos));
+	}
+	g_assert_cmpint(pos2scrpos(entry, entry->pos, TRUE), ==,
+			scrpos_from_start(entry, entry->pos));
+	g_assert_cmpint(pos2scrpos(entry, entry->scrstart, TRUE), ==,
+			scrpos_from_start(entry, entry->scrstart));
+	pos = g_test_rand_int_range(0, entry->text_len + 1);
+	g_assert_cmpint(pos2scrpos(entry, pos, TRUE), ==,
+			scrpos_from_start(entry, pos));
+	/* the start of the text is at 0 even with an extent there */
+	g_assert_cmpint(entry->scrpos, ==,
+			scrpos_from_start(entry, entry->pos) -
+			(entry->scrstart == 0 ? 0 :
+			 scrpos_from_start(entry, entry->scrstart)));
+}
+
+static void entry_set_up(EntryData *fixture, const void *data)
+{
+	g_setenv("TERM", "xterm-256color", TRUE);
+	fixture->out = tmpfile();
+	g_assert_nonnull(fixture->out);
+
+	current_term = terminfo_core_init(fixture->out, fixture->out);
+	if (current_term == NULL) {
+		g_test_skip("no terminfo for xterm-256color");
+		return;
+	}
+
+	term_type = TERM_TYPE_UTF8;
+	if (root_window == NULL)
+		root_window = term_window_create(0, 0, WIDTH, 24);
+	term_resize(WIDTH, 24);
+
+	fixture->entry = gui_entry_create(0, 23, WIDTH, TRUE);
+	gui_entry_set_active(fixture->entry);
+	gui_entry_set_prompt(fixture->entry, "[#irssi] ");
+	draw_count = 0;
+}
+
+static void entry_tear_down(EntryData *fixture, const void *data)
+{
+	if (fixture->entry != NULL)
+		gui_entry_destroy(fixture->entry);
+	if (current_term != NULL) {
+		terminfo_core_deinit(current_term);
+		current_term = NULL;
+	}
+	fclose(fixture->out);
+}
+
+static void test_gui_entry_widths(EntryData *fixture, const void *data)
+{
+	static const unichar chars[] = {
+		'a', ' ', 0x65e5 /* wide */, 0x301 /* combining */, 0x1f600, 1
+	};
+	static const char *extents[] = { "%U", "<<", "" };
+	GUI_ENTRY_REC *entry = fixture->entry;
+	int i;
+
+	if (current_term == NULL)
+		return;
+
+	for (i = 0; i < 3000; i++) {
+		switch (g_test_rand_int_range(0, 10)) {
+		case 0:
+			gui_entry_set_pos(entry, g_test_rand_int_range(0, entry->text_len + 1));
+			break;
+		case 1:
+			gui_entry_erase(entry, MIN(entry->pos, 3), CUTBUFFER_UPDATE_NOOP);
+			break;
+		case 2:
+			if (entry->pos < entry->text_len)
+				gui_entry_erase_cell(entry);
+			break;
+		case 3:
+			gui_entry_transpose_chars(entry);
+			break;
+		case 4:
+			gui_entry_set_extent(entry, g_test_rand_int_range(0, entry->text_len + 1),
+					     extents[g_test_rand_int_range(0, G_N_ELEMENTS(extents))]);
+			break;
+		case 5:
+			gui_entry_insert_text(entry, "ab\xc3\xa4\xe6\x97\xa5 ");
+			break;
+		default:
+			gui_entry_insert_char(entry, chars[g_test_rand_int_range(0, G_N_ELEMENTS(chars))]);
+			break;
+		}
+		assert_positions(entry);
+	}
+
+	gui_entry_set_text(entry, "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e text");
+	assert_positions(entry);
+	g_assert_cmpint(pos2scrpos(entry, entry->text_len, TRUE), ==, 11);
+}
+
+static void test_gui_entry_long_line(EntryData *fixture, const void *data)
+{
+	GUI_ENTRY_REC *entry = fixture->entry;
+	gint64 start;
+	int i;
+
+	if (current_term == NULL)
+		return;
+
+	/* type a long message, then edit it in the middle */
+	start = g_get_monotonic_time();
+	for (i = 0; i < 8192; i++)
+		gui_entry_insert_char(entry, i % 7 == 6 ? ' ' : 'a' + i % 26);
+	gui_entry_set_pos(entry, 4096);
+	for (i = 0; i < 2048; i++) {
+		gui_entry_insert_char(entry, 'x');
+		gui_entry_erase(entry, 1, CUTBUFFER_UPDATE_NOOP);
+		gui_entry_insert_char(entry, 'y');
+	}
+	g_test_message("typed %d characters in %.3f seconds", 8192 + 3 * 2048,
+		       (g_get_monotonic_time() - start) / (double) G_USEC_PER_SEC);
+
+	g_assert_cmpint(entry->text_len, ==, 8192 + 2048);
+	g_assert_cmpint(entry->pos, ==, 4096 + 2048);
+	assert_positions(entry);
+	g_assert_cmpint(draw_count, >, 0);
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	g_test_init(&argc, &argv, NULL);
+
+	core_init();
+	gui_entry_init();
+
+	g_test_add("/test/gui_entry/widths", EntryData, NULL,
+		   entry_set_up, test_gui_entry_widths, entry_tear_down);
+	g_test_add("/test/gui_entry/long_line", EntryData, NULL,
+		   entry_set_up, test_gui_entry_long_line, entry_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	ret = g_test_run();
+
+	gui_entry_deinit();
+	core_deinit();
+	return ret;
+}
@@ -1,4 +1,6 @@
 #include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
 #include <irssi/src/fe-text/gui-readline.c>
 
 typedef struct {
@@ -8,6 +10,11 @@ typedef struct {
 } paste_join_multiline_test_case;
 
 static void test_paste_join_multiline(const paste_join_multiline_test_case *test);
+static void test_paste_bracketed_end(void);
+static void test_paste_bracketed_end_split(void);
+static void test_paste_buffer_get_text(void);
+static void test_paste_send_queue(void);
+static void test_paste_send_drop(void);
 
 paste_join_multiline_test_case const paste_join_multiline_fixture[] = {
 	{
@@ -29,7 +36,7 @@ paste_join_multiline_test_case const paste_join_multiline_fixture[] = {
 
 int main(int argc, char **argv)
 {
-	int i;
+	int i, ret;
 
 	g_test_init(&argc, &argv, NULL);
 
@@ -39,10 +46,29 @@ int main(int argc, char **argv)
 		g_free(name);
 	}
 
+	g_test_add_func("/test/paste_bracketed_end", test_paste_bracketed_end);
+	g_test_add_func("/test/paste_bracketed_end_split", test_paste_bracketed_end_split);
+	g_test_add_func("/test/paste_buffer_get_text", test_paste_buffer_get_text);
+	g_test_add_func("/test/paste_send_queue", test_paste_send_queue);
+	g_test_add_func("/test/paste_send_drop", test_paste_send_drop);
+
 #if GLIB_CHECK_VERSION(2,38,0)
 	g_test_set_nonfatal_assertions();
 #endif
-	return g_test_run();
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	args_execute(0, NULL);
+	core_init();
+	command_history_init();
+	paste_send_tag = -1;
+
+	ret = g_test_run();
+
+	command_history_deinit();
+	core_deinit();
+	return ret;
 }
 
 static void test_paste_join_multiline(const paste_join_multiline_test_case *test)
@@ -70,3 +96,261 @@ static void test_paste_join_multiline(const paste_join_multiline_test_case *test
 
 	return;
 }
+
+static void buffer_append_utf8(GArray *buffer, const char *str)
+{
+	unichar *arr;
+	glong len;
+
+	arr = g_utf8_to_ucs4_fast(str, -1, &len);
+	g_array_append_vals(buffer, arr, len);
+	g_free(arr);
+}
+
+static char *buffer_get_utf8(GArray *buffer, int len)
+{
+	return g_ucs4_to_utf8((unichar *) buffer->data, len, NULL, NULL, NULL);
+}
+
+static void test_paste_bracketed_end(void)
+{
+	GArray *buffer = g_array_new(FALSE, FALSE, sizeof(unichar));
+	unsigned int scanned = 0;
+	char *str;
+	int pos;
+
+	buffer_append_utf8(buffer, "line 1\nline 2");
+	g_assert_cmpint(paste_bracketed_find_end(buffer, &scanned), ==, -1);
+
+	/* an end immediately followed by a start joins the pastes */
+	buffer_append_utf8(buffer, "\x1b[201~\x1b[200~line 3\x1b[201~rest");
+	pos = paste_bracketed_find_end(buffer, &scanned);
+	str = buffer_get_utf8(buffer, pos);
+	g_assert_cmpstr(str, ==, "line 1\nline 2line 3");
+	g_free(str);
+	g_assert_cmpint(buffer->len, ==, pos + G_N_ELEMENTS(bp_end) + 4);
+
+	g_array_free(buffer, TRUE);
+}
+
+static void test_paste_bracketed_end_split(void)
+{
+	const char *input = "abc\x1b[201~xyz";
+	GArray *buffer = g_array_new(FALSE, FALSE, sizeof(unichar));
+	unsigned int scanned;
+	char chr[2], *str;
+	int i, pos;
+
+	/* a marker split between reads is found once it's complete */
+	scanned = 0;
+	pos = -1;
+	chr[1] = '\0';
+	for (i = 0; input[i] != '\0' && pos == -1; i++) {
+		chr[0] = input[i];
+		buffer_append_utf8(buffer, chr);
+		pos = paste_bracketed_find_end(buffer, &scanned);
+		g_assert_cmpint(scanned, <=, buffer->len);
+	}
+
+	g_assert_cmpint(i, ==, 3 + G_N_ELEMENTS(bp_end));
+	g_assert_cmpint(pos, ==, 3);
+	str = buffer_get_utf8(buffer, pos);
+	g_assert_cmpstr(str, ==, "abc");
+	g_free(str);
+
+	g_array_free(buffer, TRUE);
+}
+
+static void test_paste_buffer_get_text(void)
+{
+	GUI_ENTRY_REC entry = { 0 };
+	GArray *buffer = g_array_new(FALSE, FALSE, sizeof(unichar));
+	GString *str;
+	int i;
+	gint64 start;
+
+	entry.utf8 = TRUE;
+	active_entry = &entry;
+
+	buffer_append_utf8(buffer, "a\rb\n\xc3\xa4\xe2\x82\xac");
+	str = paste_buffer_get_text(buffer, 0);
+	g_assert_cmpstr(str->str, ==, "a\nb\n\xc3\xa4\xe2\x82\xac");
+	g_string_free(str, TRUE);
+
+	str = paste_buffer_get_text(buffer, 2);
+	g_assert_cmpstr(str->str, ==, "b\n\xc3\xa4\xe2\x82\xac");
+	g_string_free(str, TRUE);
+
+	/* a large paste is converted in one go */
+	g_array_set_size(buffer, 0);
+	for (i = 0; i < 65536; i++)
+		buffer_append_utf8(buffer, "line of pasted text \xc3\xa4\n");
+
+	start = g_get_monotonic_time();
+	str = paste_buffer_get_text(buffer, 0);
+	g_test_message("%u characters converted in %.3f seconds", buffer->len,
+		       (g_get_monotonic_time() - start) / (double) G_USEC_PER_SEC);
+	g_assert_cmpint(str->len, ==, 65536 * strlen("line of pasted text \xc3\xa4\n"));
+	g_string_free(str, TRUE);
+
+	active_entry = NULL;
+	g_array_free(buffer, TRUE);
+}
+
+/* only the pointers are compared */
+static SERVER_REC *test_servers[2];
+static WI_ITEM_REC *test_items[2];
+
+typedef struct {
+	char *text;
+	SERVER_REC *server;
+	WI_ITEM_REC *item;
+} sent_line;
+
+static GSList *sent_lines;
+
+static void sig_send_command(const char *text, SERVER_REC *server, WI_ITEM_REC *item)
+{
+	sent_line *rec;
+
+	rec = g_new0(sent_line, 1);
+	rec->text = g_strdup(text);
+	rec->server = server;
+	rec->item = item;
+	sent_lines = g_slist_append(sent_lines, rec);
+	signal_stop();
+}
+
+static void sent_line_free(sent_line *rec)
+{
+	g_free(rec->text);
+	g_free(rec);
+}
+
+static GString *paste_lines(const char *prefix, int count)
+{
+	GString *str;
+	int i;
+
+	str = g_string_new(NULL);
+	for (i = 0; i < count; i++)
+		g_string_append_printf(str, "%s %d\n", prefix, i);
+	return str;
+}
+
+static void paste_send_run(void)
+{
+	while (paste_send_text != NULL)
+		g_main_context_iteration(NULL, TRUE);
+}
+
+static void assert_sent_lines(GSList *lines, const char *prefix, int first, int count,
+			      SERVER_REC *server, WI_ITEM_REC *item)
+{
+	char *text;
+	int i;
+
+	for (i = first; i < first + count; i++, lines = lines->next) {
+		sent_line *rec;
+
+		g_assert_nonnull(lines);
+		if (lines == NULL)
+			return;
+
+		rec = lines->data;
+		text = g_strdup_printf("%s %d", prefix, i);
+		g_assert_cmpstr(rec->text, ==, text);
+		g_assert_true(rec->server == server);
+		g_assert_true(rec->item == item);
+		g_free(text);
+	}
+}
+
+static void paste_send_set_up(WINDOW_REC *window)
+{
+	test_servers[0] = GINT_TO_POINTER(1);
+	test_servers[1] = GINT_TO_POINTER(2);
+	test_items[0] = GINT_TO_POINTER(3);
+	test_items[1] = GINT_TO_POINTER(4);
+
+	signal_add_first("send command", (SIGNAL_FUNC) sig_send_command);
+	window->active_server = test_servers[0];
+	window->active = test_items[0];
+	active_win = window;
+}
+
+static void paste_send_tear_down(void)
+{
+	active_win = NULL;
+	signal_remove("send command", (SIGNAL_FUNC) sig_send_command);
+}
+
+static void test_paste_send_queue(void)
+{
+	WINDOW_REC window = { 0 };
+
+	paste_send_set_up(&window);
+
+	/* the first lines are sent immediately, the rest later */
+	paste_send_queue(paste_lines("one", PASTE_SEND_BATCH_LINES * 3));
+	g_assert_cmpint(g_slist_length(sent_lines), ==, PASTE_SEND_BATCH_LINES);
+	g_assert_cmpint(paste_send_tag, !=, -1);
+
+	/* the rest go to where they were pasted even when another item
+	   becomes active */
+	window.active_server = test_servers[1];
+	window.active = test_items[1];
+	paste_send_run();
+	g_assert_cmpint(g_slist_length(sent_lines), ==, PASTE_SEND_BATCH_LINES * 3);
+	assert_sent_lines(sent_lines, "one", 0, PASTE_SEND_BATCH_LINES * 3,
+			  test_servers[0], test_items[0]);
+	g_assert_cmpint(paste_send_tag, ==, -1);
+	g_slist_free_full(sent_lines, (GDestroyNotify) sent_line_free);
+	sent_lines = NULL;
+
+	/* lines pasted to another item are sent after the earlier ones */
+	paste_send_queue(paste_lines("two", PASTE_SEND_BATCH_LINES * 2));
+	window.active_server = test_servers[0];
+	window.active = test_items[0];
+	paste_send_queue(paste_lines("three", 10));
+	paste_send_run();
+	g_assert_cmpint(g_slist_length(sent_lines), ==, PASTE_SEND_BATCH_LINES * 2 + 10);
+	assert_sent_lines(sent_lines, "two", 0, PASTE_SEND_BATCH_LINES * 2,
+			  test_servers[1], test_items[1]);
+	assert_sent_lines(g_slist_nth(sent_lines, PASTE_SEND_BATCH_LINES * 2),
+			  "three", 0, 10, test_servers[0], test_items[0]);
+	g_slist_free_full(sent_lines, (GDestroyNotify) sent_line_free);
+	sent_lines = NULL;
+
+	paste_send_tear_down();
+}
+
+static void test_paste_send_drop(void)
+{
+	WINDOW_REC window = { 0 };
+
+	paste_send_set_up(&window);
+
+	/* the lines aren't sent anywhere else when their item is gone */
+	paste_send_queue(paste_lines("one", PASTE_SEND_BATCH_LINES * 2));
+	sig_window_item_remove(&window, test_items[1]);
+	sig_server_disconnected(test_servers[1]);
+	sig_window_item_remove(&window, test_items[0]);
+	window.active = test_items[1];
+	paste_send_run();
+	g_assert_cmpint(g_slist_length(sent_lines), ==, PASTE_SEND_BATCH_LINES);
+	g_assert_cmpint(paste_send_tag, ==, -1);
+	g_slist_free_full(sent_lines, (GDestroyNotify) sent_line_free);
+	sent_lines = NULL;
+
+	/* or when their server is disconnected */
+	window.active = test_items[0];
+	paste_send_queue(paste_lines("two", PASTE_SEND_BATCH_LINES * 2));
+	sig_server_disconnected(test_servers[0]);
+	paste_send_run();
+	g_assert_cmpint(g_slist_length(sent_lines), ==, PASTE_SEND_BATCH_LINES);
+	g_slist_free_full(sent_lines, (GDestroyNotify) sent_line_free);
+	sent_lines = NULL;
+
+	paste_send_tear_down();
+}
@@ -0,0 +1,530 @@
+/*
+ test-term-screen.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/fe-text/term.h>
+#include <irssi/src/fe-text/terminfo-core.h>
+
+#include <stdio.h>
+
+#define WIDTH 80
+#define HEIGHT 24
+
+/* A minimal xterm: just enough to see which characters end up where */
+typedef struct {
+	gunichar cells[HEIGHT][WIDTH]; /* 0 = right half of a wide char */
+	int x, y, top, bottom;
+	gunichar last;
+} VTERM;
+
+typedef struct {
+	FILE *out;
+	long pos;
+	VTERM vt;
+} ScreenData;
+
+static void vt_scroll(VTERM *vt, int top, int bottom, int count)
+{
+	int y;
+
+	for (; count > 0; count--) {
+		for (y = top; y < bottom; y++)
+			memcpy(vt->cells[y], vt->cells[y + 1], sizeof(vt->cells[y]));
+		for (y = 0; y < WIDTH; y++)
+			vt->cells[bottom][y] = ' ';
+	}
+	for (; count < 0; count++) {
+		for (y = bottom; y > top; y--)
+			memcpy(vt->cells[y], vt->cells[y - 1], sizeof(vt->cells[y]));
+		for (y = 0; y < WIDTH; y++)
+			vt->cells[top][y] = ' ';
+	}
+}
+
+static void vt_clear_cells(VTERM *vt, int y, int x1, int x2)
+{
+	for (; x1 < x2; x1++)
+		vt->cells[y][x1] = ' ';
+}
+
+static void vt_put(VTERM *vt, gunichar chr)
+{
+	int width = g_unichar_iswide(chr) ? 2 : 1;
+
+	if (g_unichar_ismark(chr))
+		return;
+
+	if (vt->x + width > WIDTH) {
+		vt->x = 0;
+		if (vt->y == vt->bottom)
+			vt_scroll(vt, vt->top, vt->bottom, 1);
+		else if (vt->y < HEIGHT - 1)
+			vt->y++;
+	}
+
+	/* halves of wide characters don't stay */
+	if (vt->cells[vt->y][vt->x] == 0 && vt->x > 0)
+		vt->cells[vt->y][vt->x - 1] = ' ';
+	if (vt->x + width < WIDTH && vt->cells[vt->y][vt->x + width] == 0)
+		vt->cells[vt->y][vt->x + width] = ' ';
+
+	vt->cells[vt->y][vt->x] = chr;
+	if (width == 2)
+		vt->cells[vt->y][vt->x + 1] = 0;
+	vt->x += width;
+	vt->last = chr;
+}
+
+static void vt_csi(VTERM *vt, const char *params, char cmd)
+{
+	int args[4] = { 0, 0, 0, 0 };
+	int i, n;
+
+	if (*params == '?' || *params == '>' || *params == '!')
+		return;
+
+	for (n = 0; n < 4; n++) {
+		args[n] = atoi(params);
+		params = strchr(params, ';');
+		if (params == NULL)
+			break;
+		params++;
+	}
+	n = MAX(args[0], 1);
+
+	switch (cmd) {
+	case 'H':
+		vt->y = MAX(args[0], 1) - 1;
+		vt->x = MAX(args[1], 1) - 1;
+		break;
+	case 'G':
+		vt->x = n - 1;
+		break;
+	case 'd':
+		vt->y = n - 1;
+		break;
+	case 'A':
+		vt->y = MAX(vt->y - n, 0);
+		break;
+	case 'B':
+		vt->y = MIN(vt->y + n, HEIGHT - 1);
+		break;
+	case 'C':
+		vt->x = MIN(vt->x + n, WIDTH - 1);
+		break;
+	case 'D':
+		vt->x = MAX(MIN(vt->x, WIDTH - 1) - n, 0);
+		break;
+	case 'K':
+		if (vt->x < WIDTH && vt->cells[vt->y][vt->x] == 0 && vt->x > 0)
+			vt->cells[vt->y][vt->x - 1] = ' ';
+		vt_clear_cells(vt, vt->y, MIN(vt->x, WIDTH), WIDTH);
+		break;
+	case 'J':
+		for (i = vt->y; i < HEIGHT; i++)
+			vt_clear_cells(vt, i, i == vt->y ? vt->x : 0, WIDTH);
+		break;
+	case 'r':
+		vt->top = MAX(args[0], 1) - 1;
+		vt->bottom = (args[1] > 0 ? args[1] : HEIGHT) - 1;
+		vt->x = vt->y = 0;
+		break;
+	case 'S':
+		vt_scroll(vt, vt->top, vt->bottom, n);
+		break;
+	case 'T':
+		vt_scroll(vt, vt->top, vt->bottom, -n);
+		break;
+	case 'L':
+		vt_scroll(vt, vt->y, vt->bottom, -n);
+		break;
+	case 'M':
+		vt_scroll(vt, vt->y, vt->bottom, n);
+		break;
+	case 'b':
+		for (i = 0; i < n; i++)
+			vt_put(vt, vt->last);
+		break;
+	}
+}
+
+/* Run the terminal output written since the last call */
+static int vt_feed(ScreenData *fixture)
+{
+	VTERM *vt = &fixture->vt;
+	char *data, *p, *end, params[32];
+	long pos;
+	int len, i;
+
+	fflush(fixture->out);
+	pos = ftell(fixture->out);
+	len = pos - fixture->pos;
+	data = g_malloc(len + 1);
+	fseek(fixture->out, fixture->pos, SEEK_SET);
+	g_assert_cmpint(fread(data, 1, len, fixture->out), ==, len);
+	fseek(fixture->out, pos, SEEK_SET);
+	fixture->pos = pos;
+
+	end = data + len;
+	for (p = data; p < end; ) {
+		if (*p == '\033') {
+			if (++p == end)
+				break;
+			if (*p == '[') {
+				for (p++, i = 0; p < end && !g_ascii_isalpha(*p) && *p != '@' && *p != '`'; p++) {
+					if (i < (int) sizeof(params) - 1)
+						params[i++] = *p;
+				}
+				params[i] = '\0';
+				if (p < end)
+					vt_csi(vt, params, *p++);
+			} else if (*p == 'M') {
+				p++;
+				if (vt->y == vt->top)
+					vt_scroll(vt, vt->top, vt->bottom, -1);
+				else if (vt->y > 0)
+					vt->y--;
+			} else if (*p == '(' || *p == ')') {
+				p += 2;
+			} else {
+				p++;
+			}
+		} else if (*p == '\r') {
+			vt->x = 0;
+			p++;
+		} else if (*p == '\n') {
+			if (vt->y == vt->bottom)
+				vt_scroll(vt, vt->top, vt->bottom, 1);
+			else if (vt->y < HEIGHT - 1)
+				vt->y++;
+			p++;
+		} else if (*p == '\b') {
+			vt->x = MAX(MIN(vt->x, WIDTH - 1) - 1, 0);
+			p++;
+		} else if ((unsigned char) *p < 32) {
+			p++;
+		} else {
+			gunichar chr = g_utf8_get_char_validated(p, end - p);
+			g_assert_true(chr != (gunichar) -1 && chr != (gunichar) -2);
+			vt_put(vt, chr);
+			p = g_utf8_next_char(p);
+		}
+	}
+
+	g_free(data);
+	return len;
+}
+
+static void assert_line(ScreenData *fixture, int y, const char *expected)
+{
+	GString *str;
+	int x, width;
+
+	str = g_string_new(NULL);
+	for (x = 0; x < WIDTH; x++) {
+		if (fixture->vt.cells[y][x] != 0)
+			g_string_append_unichar(str, fixture->vt.cells[y][x]);
+	}
+
+	/* expected is padded with spaces to the end of line */
+	width = g_utf8_strlen(expected, -1);
+	for (x = 0; expected[x] != '\0'; x++) {
+		if ((expected[x] & 0xc0) == 0x80)
+			continue;
+		if (g_unichar_iswide(g_utf8_get_char(expected + x)))
+			width++;
+	}
+	g_assert_cmpint(width, <=, WIDTH);
+	g_assert_true(strncmp(str->str, expected, strlen(expected)) == 0);
+	g_assert_cmpuint(str->len, ==, strlen(expected) + WIDTH - width);
+	g_string_free(str, TRUE);
+}
+
+static void screen_set_up(ScreenData *fixture, const void *data)
+{
+	int y, x;
+
+	g_setenv("TERM", "xterm-256color", TRUE);
+	fixture->out = tmpfile();
+	g_assert_nonnull(fixture->out);
+
+	current_term = terminfo_core_init(fixture->out, fixture->out);
+	if (current_term == NULL) {
+		g_test_skip("no terminfo for xterm-256color");
+		return;
+	}
+
+	term_type = TERM_TYPE_UTF8;
+	term_use_colors = TRUE;
+	if (root_window == NULL)
+		root_window = term_window_create(0, 0, WIDTH, HEIGHT);
+	term_resize(WIDTH, HEIGHT);
+
+	for (y = 0; y < HEIGHT; y++) {
+		for (x = 0; x < WIDTH; x++)
+			fixture->vt.cells[y][x] = '?';
+	}
+	fixture->vt.bottom = HEIGHT - 1;
+
+	term_clear();
+	term_refresh(NULL);
+	vt_feed(fixture);
+}
+
+static void screen_tear_down(ScreenData *fixture, const void *data)
+{
+	if (current_term != NULL) {
+		terminfo_core_deinit(current_term);
+		current_term = NULL;
+	}
+	fclose(fixture->out);
+}
+
+static void draw_text_line(int y, int nick, const char *text)
+{
+	char *str;
+
+	term_move(root_window, 0, y);
+	term_set_color(root_window, ATTR_RESET);
+	term_addstr(root_window, "12:00 <");
+	term_set_color(root_window, ATTR_RESETBG | ATTR_BOLD | (nick % 6 + 1));
+	str = g_strdup_printf("nick%d", nick);
+	term_addstr(root_window, str);
+	g_free(str);
+	term_set_color(root_window, ATTR_RESET);
+	term_addstr(root_window, "> ");
+	term_addstr(root_window, text);
+	term_clrtoeol(root_window);
+}
+
+static void draw_statusbar(int y, const char *clock)
+{
+	term_move(root_window, 0, y);
+	term_set_color(root_window, ATTR_RESETFG | (4 << BG_SHIFT));
+	term_addstr(root_window, " [");
+	term_addstr(root_window, clock);
+	term_addstr(root_window, "] [me(+i)] [1:#irssi(+nt)] [Act: 2,3]");
+	term_clrtoeol(root_window);
+}
+
+/* Draw a screen like irssi's: text, statusbar, prompt */
+static void draw_screen(const char *clock)
+{
+	int y;
+
+	for (y = 0; y < HEIGHT - 2; y++)
+		draw_text_line(y, y, "the quick brown fox jumps over the lazy dog");
+	draw_statusbar(HEIGHT - 2, clock);
+	term_move(root_window, 0, HEIGHT - 1);
+	term_set_color(root_window, ATTR_RESET);
+	term_addstr(root_window, "[#irssi] ");
+	term_clrtoeol(root_window);
+	term_move_cursor(9, HEIGHT - 1);
+}
+
+static void test_term_screen_redraw(ScreenData *fixture, const void *data)
+{
+	int full, same, clock;
+
+	if (current_term == NULL)
+		return;
+
+	draw_screen("12:00");
+	term_refresh(NULL);
+	full = vt_feed(fixture);
+	assert_line(fixture, 0, "12:00 <nick0> the quick brown fox jumps over the lazy dog");
+	assert_line(fixture, HEIGHT - 2, " [12:00] [me(+i)] [1:#irssi(+nt)] [Act: 2,3]");
+	assert_line(fixture, HEIGHT - 1, "[#irssi] ");
+
+	/* drawing the same screen again sends nothing */
+	draw_screen("12:00");
+	term_refresh(NULL);
+	same = vt_feed(fixture);
+	g_assert_cmpint(same, ==, 0);
+
+	/* only the changed character is sent */
+	draw_screen("12:01");
+	term_refresh(NULL);
+	clock = vt_feed(fixture);
+	assert_line(fixture, HEIGHT - 2, " [12:01] [me(+i)] [1:#irssi(+nt)] [Act: 2,3]");
+	g_assert_cmpint(clock, <, 50);
+
+	g_test_message("bytes: full screen %d, unchanged %d, clock %d",
+		       full, same, clock);
+}
+
+static void test_term_screen_scroll(ScreenData *fixture, const void *data)
+{
+	TERM_WINDOW *window;
+	int scroll;
+
+	if (current_term == NULL)
+		return;
+
+	draw_screen("12:00");
+	term_refresh(NULL);
+	vt_feed(fixture);
+	g_assert_false(term_refresh_pending());
+
+	/* a new line in the channel */
+	window = term_window_create(0, 0, WIDTH, HEIGHT - 2);
+	term_window_scroll(window, 1);
+	g_assert_true(term_refresh_pending());
+	draw_text_line(HEIGHT - 3, 99, "a new line");
+	term_window_destroy(window);
+	term_refresh(NULL);
+	scroll = vt_feed(fixture);
+	g_assert_false(term_refresh_pending());
+
+	assert_line(fixture, 0, "12:00 <nick1> the quick brown fox jumps over the lazy dog");
+	assert_line(fixture, HEIGHT - 4, "12:00 <nick21> the quick brown fox jumps over the lazy dog");
+	assert_line(fixture, HEIGHT - 3, "12:00 <nick99> a new line");
+	assert_line(fixture, HEIGHT - 2, " [12:00] [me(+i)] [1:#irssi(+nt)] [Act: 2,3]");
+	g_assert_cmpint(scroll, <, 120);
+
+	g_test_message("bytes: new line %d", scroll);
+}
+
+static void test_term_screen_scroll_many(ScreenData *fixture, const void *data)
+{
+	TERM_WINDOW *window;
+	unsigned int coalesced;
+	int i, bytes;
+
+	if (current_term == NULL)
+		return;
+
+	draw_screen("12:00");
+	term_refresh(NULL);
+	vt_feed(fixture);
+
+	/* lines arriving faster than the screen is refreshed are scrolled
+	   in with one scroll */
+	coalesced = term_scrolls_coalesced();
+	window = term_window_create(0, 0, WIDTH, HEIGHT - 2);
+	for (i = 0; i < 10; i++) {
+		term_set_color(window, ATTR_RESET);
+		term_window_scroll(window, 1);
+		draw_text_line(HEIGHT - 3, 100 + i, "flood");
+	}
+	term_window_destroy(window);
+	term_refresh(NULL);
+	bytes = vt_feed(fixture);
+
+	assert_line(fixture, 0, "12:00 <nick10> the quick brown fox jumps over the lazy dog");
+	assert_line(fixture, HEIGHT - 13, "12:00 <nick21> the quick brown fox jumps over the lazy dog");
+	assert_line(fixture, HEIGHT - 12, "12:00 <nick100> flood");
+	assert_line(fixture, HEIGHT - 3, "12:00 <nick109> flood");
+	assert_line(fixture, HEIGHT - 2, " [12:00] [me(+i)] [1:#irssi(+nt)] [Act: 2,3]");
+	g_assert_cmpuint(term_scrolls_coalesced() - coalesced, ==, 9);
+	g_assert_cmpint(bytes, <, 700);
+
+	/* scrolling more than the window's height redraws it */
+	window = term_window_create(0, 0, WIDTH, HEIGHT - 2);
+	for (i = 0; i < HEIGHT; i++) {
+		term_set_color(window, ATTR_RESET);
+		term_window_scroll(window, 1);
+		draw_text_line(HEIGHT - 3, 200 + i, "flood");
+	}
+	term_window_destroy(window);
+	term_refresh(NULL);
+	vt_feed(fixture);
+
+	assert_line(fixture, 0, "12:00 <nick202> flood");
+	assert_line(fixture, HEIGHT - 3, "12:00 <nick223> flood");
+	assert_line(fixture, HEIGHT - 2, " [12:00] [me(+i)] [1:#irssi(+nt)] [Act: 2,3]");
+
+	g_test_message("bytes: 10 new lines %d", bytes);
+}
+
+static void test_term_screen_clrtoeol(ScreenData *fixture, const void *data)
+{
+	int bytes;
+
+	if (current_term == NULL)
+		return;
+
+	draw_text_line(3, 1, "a long line that gets replaced with a short one");
+	term_refresh(NULL);
+	vt_feed(fixture);
+
+	draw_text_line(3, 1, "short");
+	term_refresh(NULL);
+	bytes = vt_feed(fixture);
+	assert_line(fixture, 3, "12:00 <nick1> short");
+	g_assert_cmpint(bytes, <, 50);
+
+	/* clearing with a background color needs the spaces */
+	term_move(root_window, 10, 3);
+	term_set_color(root_window, ATTR_RESETFG | (2 << BG_SHIFT));
+	term_clrtoeol(root_window);
+	term_refresh(NULL);
+	vt_feed(fixture);
+	assert_line(fixture, 3, "12:00 <nic");
+}
+
+static void test_term_screen_wide(ScreenData *fixture, const void *data)
+{
+	if (current_term == NULL)
+		return;
+
+	term_move(root_window, 0, 5);
+	term_set_color(root_window, ATTR_RESET);
+	term_addstr(root_window, "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e text");
+	term_refresh(NULL);
+	vt_feed(fixture);
+	assert_line(fixture, 5, "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e text");
+
+	/* overwriting the right half of a wide character */
+	term_move(root_window, 3, 5);
+	term_addstr(root_window, "x");
+	term_refresh(NULL);
+	vt_feed(fixture);
+	assert_line(fixture, 5, "\xe6\x97\xa5 x\xe8\xaa\x9e text");
+
+	/* a wide character over two narrow ones */
+	term_move(root_window, 7, 5);
+	term_addstr(root_window, "\xe6\x9c\xac");
+	term_refresh(NULL);
+	vt_feed(fixture);
+	assert_line(fixture, 5, "\xe6\x97\xa5 x\xe8\xaa\x9e \xe6\x9c\xac\x78t");
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add("/test/term_screen/redraw", ScreenData, NULL,
+		   screen_set_up, test_term_screen_redraw, screen_tear_down);
+	g_test_add("/test/term_screen/scroll", ScreenData, NULL,
+		   screen_set_up, test_term_screen_scroll, screen_tear_down);
+	g_test_add("/test/term_screen/scroll_many", ScreenData, NULL,
+		   screen_set_up, test_term_screen_scroll_many, screen_tear_down);
+	g_test_add("/test/term_screen/clrtoeol", ScreenData, NULL,
+		   screen_set_up, test_term_screen_clrtoeol, screen_tear_down);
+	g_test_add("/test/term_screen/wide", ScreenData, NULL,
+		   screen_set_up, test_term_screen_wide, screen_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	return g_test_run();
+}
@@ -0,0 +1,178 @@
+/*
+ test-textbuffer-spill.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+
+/* read the lines' text without needing a window and a theme */
+#define textbuffer_line_get_text test_line_get_text
+#include <irssi/src/fe-text/textbuffer.c>
+
+typedef struct {
+	TEXT_BUFFER_REC *buffer;
+	int line_num;
+} SpillData;
+
+char *test_line_get_text(TEXT_BUFFER_REC *buffer, LINE_REC *line, gboolean raw)
+{
+	if (line->info.text != NULL)
+		return g_strdup(line->info.text);
+	return textbuffer_spill_get_text(buffer, line);
+}
+
+static void add_lines(SpillData *fixture, int count, int len)
+{
+	static const unsigned char eol[] = { 0, LINE_CMD_EOL };
+	LINE_INFO_REC info = { 0 };
+	char *text;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		text = g_strdup_printf("%d %0*d", fixture->line_num++, len, 0);
+		textbuffer_append(fixture->buffer, (unsigned char *) text, strlen(text), &info);
+		textbuffer_append(fixture->buffer, eol, sizeof(eol), NULL);
+		g_free(text);
+	}
+}
+
+/* Check the text of the lines and the counters */
+static void assert_lines(TEXT_BUFFER_REC *buffer, int first)
+{
+	LINE_REC *line;
+	gsize resident;
+	char *text, *prefix;
+	int spilled, num;
+
+	resident = 0;
+	spilled = 0;
+	num = first;
+	for (line = buffer->first_line; line != NULL; line = line->next, num++) {
+		text = test_line_get_text(buffer, line, TRUE);
+		prefix = g_strdup_printf("%d ", num);
+		g_assert_nonnull(text);
+		g_assert_true(g_str_has_prefix(text, prefix));
+		g_free(prefix);
+		g_free(text);
+
+		if (line->info.text == NULL)
+			spilled++;
+		else
+			resident += textbuffer_line_size(line);
+	}
+
+	g_assert_cmpint(spilled, ==, textbuffer_spilled_lines(buffer));
+	g_assert_cmpuint(resident, ==, buffer->resident_size);
+	g_assert_cmpuint(buffer->spill_live, <=, buffer->spill_size);
+}
+
+static void spill_set_up(SpillData *fixture, const void *data)
+{
+	fixture->buffer = textbuffer_create(NULL);
+	fixture->line_num = 0;
+}
+
+static void spill_tear_down(SpillData *fixture, const void *data)
+{
+	textbuffer_destroy(fixture->buffer);
+	g_assert_cmpuint(textbuffer_resident_total(), ==, 0);
+}
+
+static void test_textbuffer_spill(SpillData *fixture, const void *data)
+{
+	TEXT_BUFFER_REC *buffer = fixture->buffer;
+	gsize size;
+
+	add_lines(fixture, 100, 20);
+	size = buffer->resident_size;
+	g_assert_cmpuint(textbuffer_resident_total(), ==, size);
+	assert_lines(buffer, 0);
+
+	textbuffer_spill(buffer, size / 2);
+	g_assert_cmpuint(buffer->resident_size, <=, size / 2);
+	g_assert_cmpuint(textbuffer_resident_total(), ==, buffer->resident_size);
+	g_assert_cmpint(textbuffer_spilled_lines(buffer), >, 0);
+	g_assert_null(buffer->first_line->info.text);
+	g_assert_nonnull(buffer->cur_line->info.text);
+	assert_lines(buffer, 0);
+
+	/* more lines are spilled after the earlier ones */
+	add_lines(fixture, 100, 20);
+	textbuffer_spill(buffer, size / 2);
+	g_assert_cmpuint(buffer->resident_size, <=, size / 2);
+	assert_lines(buffer, 0);
+
+	/* the file is emptied when the spilled lines are gone */
+	while (buffer->first_line->info.text == NULL)
+		textbuffer_remove(buffer, buffer->first_line);
+	g_assert_cmpint(textbuffer_spilled_lines(buffer), ==, 0);
+	g_assert_cmpuint(buffer->spill_size, ==, 0);
+	assert_lines(buffer, 200 - buffer->lines_count);
+
+	textbuffer_remove_all_lines(buffer);
+	g_assert_cmpuint(buffer->resident_size, ==, 0);
+	g_assert_cmpint(buffer->spill_fd, ==, -1);
+}
+
+static void test_textbuffer_spill_compact(SpillData *fixture, const void *data)
+{
+	TEXT_BUFFER_REC *buffer = fixture->buffer;
+	gsize size;
+	int i;
+
+	add_lines(fixture, 1000, 2000);
+	textbuffer_spill(buffer, 0);
+	g_assert_cmpint(textbuffer_spilled_lines(buffer), ==, 1000);
+	g_assert_cmpuint(buffer->resident_size, ==, 0);
+	g_assert_cmpuint(buffer->spill_size, >, SPILL_COMPACT_MIN_SIZE);
+
+	/* the removed lines' space in the file is given back after they've
+	   all been removed */
+	size = buffer->spill_size;
+	for (i = 0; i < 600; i++)
+		textbuffer_remove(buffer, buffer->first_line);
+	g_assert_cmpuint(buffer->spill_size, ==, size);
+	g_assert_cmpint(buffer->spill_compact_tag, !=, 0);
+	assert_lines(buffer, 600);
+
+	while (buffer->spill_compact_tag != 0)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_cmpuint(buffer->spill_size, <, 600 * 2000);
+	g_assert_cmpuint(buffer->spill_size, ==, buffer->spill_live);
+	assert_lines(buffer, 600);
+
+	add_lines(fixture, 10, 2000);
+	textbuffer_spill(buffer, 0);
+	assert_lines(buffer, 600);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add("/test/textbuffer/spill", SpillData, NULL,
+		   spill_set_up, test_textbuffer_spill, spill_tear_down);
+	g_test_add("/test/textbuffer/spill_compact", SpillData, NULL,
+		   spill_set_up, test_textbuffer_spill_compact, spill_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	return g_test_run();
+}
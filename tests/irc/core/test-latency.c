@@ -0,0 +1,97 @@
+/*
+ test-latency.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/irc/core/latency.h>
+
+static void test_latency_empty(void)
+{
+	LATENCY_HISTOGRAM_REC hist;
+
+	memset(&hist, 0, sizeof(hist));
+	g_assert_cmpint(latency_histogram_percentile(&hist, 50), ==, 0);
+	g_assert_cmpint(latency_histogram_percentile(&hist, 100), ==, 0);
+}
+
+static void test_latency_small(void)
+{
+	LATENCY_HISTOGRAM_REC hist;
+	int i;
+
+	/* the smallest values have a bucket each */
+	memset(&hist, 0, sizeof(hist));
+	for (i = 1; i <= 10; i++)
+		latency_histogram_add(&hist, i);
+
+	g_assert_cmpint(hist.count, ==, 10);
+	g_assert_cmpint(hist.min, ==, 1);
+	g_assert_cmpint(hist.max, ==, 10);
+	g_assert_cmpint(hist.sum, ==, 55);
+	g_assert_cmpint(latency_histogram_percentile(&hist, 50), ==, 5);
+	g_assert_cmpint(latency_histogram_percentile(&hist, 0), ==, 1);
+	g_assert_cmpint(latency_histogram_percentile(&hist, 100), ==, 10);
+}
+
+static void test_latency_accuracy(void)
+{
+	LATENCY_HISTOGRAM_REC hist;
+	gint64 value, result;
+	int i;
+
+	for (value = 7; value < G_GINT64_CONSTANT(1) << LATENCY_MAX_BITS;
+	     value = value * 3 + 1) {
+		memset(&hist, 0, sizeof(hist));
+		latency_histogram_add(&hist, 1);
+		for (i = 0; i < 98; i++)
+			latency_histogram_add(&hist, value);
+		latency_histogram_add(&hist, value * 100);
+
+		/* the same bucket, within 1/LATENCY_SUB_BUCKETS */
+		result = latency_histogram_percentile(&hist, 50);
+		g_assert_cmpint(result, >=, value);
+		g_assert_cmpint(result, <=, value + value / LATENCY_SUB_BUCKETS);
+	}
+}
+
+static void test_latency_overflow(void)
+{
+	LATENCY_HISTOGRAM_REC hist;
+
+	memset(&hist, 0, sizeof(hist));
+	latency_histogram_add(&hist, -5);
+	latency_histogram_add(&hist, G_MAXINT64);
+
+	g_assert_cmpint(hist.min, ==, 0);
+	g_assert_cmpint(hist.max, ==, (G_GINT64_CONSTANT(1) << LATENCY_MAX_BITS) - 1);
+	g_assert_cmpint(hist.buckets[LATENCY_BUCKETS - 1], ==, 1);
+	g_assert_cmpint(latency_histogram_percentile(&hist, 100), ==, hist.max);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/test/latency/empty", test_latency_empty);
+	g_test_add_func("/test/latency/small", test_latency_small);
+	g_test_add_func("/test/latency/accuracy", test_latency_accuracy);
+	g_test_add_func("/test/latency/overflow", test_latency_overflow);
+
+	return g_test_run();
+}
@@ -0,0 +1,208 @@
+/*
+ test-mode-lists.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+
+/* match the masks without needing a channel */
+#include <irssi/src/irc/core/mode-lists.c>
+
+#define TEST_ROUNDS 2000
+
+static const char *masks[] = {
+	/* exact */
+	"nick!user@host.example.org",
+	"other!ident@192.0.2.1",
+	/* exact in another case */
+	"NICK!USER@HOST.EXAMPLE.ORG",
+	"*!*@Host.Example.Org",
+	/* wildcards */
+	"*!*@*.example.org",
+	"*!*@host*.example.org",
+	"*!*@*example.org",
+	"*!*@*.org",
+	"*!*@192.0.2.*",
+	"*!user@*",
+	"nick!*@*",
+	"n?ck!*@*",
+	"*!*@*",
+	"*",
+	"*@host.example.org",
+	/* characters that differ in the server's casemapping */
+	"nick[a]!*@*",
+	"nick{a}!*@*",
+	"*!*@host~.example.org",
+	/* extbans */
+	"$a:account",
+	"~q:*!*@*.example.org",
+	NULL
+};
+
+static const char *nicks[] = {
+	"nick", "NICK", "n1ck", "other", "nick[a]", "NICK{A}", "someone", NULL
+};
+
+static const char *addresses[] = {
+	"user@host.example.org",
+	"USER@HOST.EXAMPLE.ORG",
+	"ident@host2.example.org",
+	"user@sub.host.example.org",
+	"user@example.org",
+	"user@badexample.org",
+	"ident@192.0.2.1",
+	"ident@192.0.2.10",
+	"user@host~.example.org",
+	"user@",
+	"user",
+	"",
+	NULL
+};
+
+/* The matching masks found by going through all of them */
+static GSList *match_linear(MODE_LIST_REC *list, const char *nick, const char *address)
+{
+	GSList *tmp, *entries, *ret;
+	char *str;
+
+	str = g_strdup_printf("%s!%s", nick, address);
+	ret = NULL;
+	entries = mode_list_get_entries(list);
+	for (tmp = entries; tmp != NULL; tmp = tmp->next) {
+		BAN_REC *rec = tmp->data;
+
+		if (match_wildcards(rec->ban, str))
+			ret = g_slist_prepend(ret, rec);
+	}
+	g_slist_free(entries);
+	g_free(str);
+	return ret;
+}
+
+static int ptr_cmp(const void *a, const void *b)
+{
+	return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static void assert_matches(MODE_LIST_REC *list)
+{
+	GSList *indexed, *linear, *tmp1, *tmp2;
+	int i, j;
+
+	for (i = 0; nicks[i] != NULL; i++) {
+		for (j = 0; addresses[j] != NULL; j++) {
+			indexed = mode_list_match_func(list, match_wildcards,
+						       nicks[i], addresses[j]);
+			linear = match_linear(list, nicks[i], addresses[j]);
+			indexed = g_slist_sort(indexed, (GCompareFunc) ptr_cmp);
+			linear = g_slist_sort(linear, (GCompareFunc) ptr_cmp);
+
+			tmp1 = indexed;
+			tmp2 = linear;
+			for (; tmp1 != NULL && tmp2 != NULL;
+			     tmp1 = tmp1->next, tmp2 = tmp2->next)
+				g_assert_true(tmp1->data == tmp2->data);
+			g_assert_cmpuint(g_slist_length(indexed), ==,
+					 g_slist_length(linear));
+
+			g_slist_free(indexed);
+			g_slist_free(linear);
+		}
+	}
+}
+
+static int match_count(MODE_LIST_REC *list, const char *nick, const char *address)
+{
+	GSList *matches;
+	int count;
+
+	matches = mode_list_match_func(list, match_wildcards, nick, address);
+	count = g_slist_length(matches);
+	g_slist_free(matches);
+	return count;
+}
+
+static void test_mode_list_match(void)
+{
+	MODE_LIST_REC *list;
+	BAN_REC *rec;
+
+	list = mode_list_create();
+	g_assert_cmpint(match_count(list, "nick", "user@host.example.org"), ==, 0);
+
+	mode_list_add(list, "nick!user@host.example.org", "op", 0);
+	g_assert_cmpint(match_count(list, "NICK", "USER@Host.Example.Org"), ==, 1);
+	g_assert_cmpint(match_count(list, "nick", "user@host2.example.org"), ==, 0);
+
+	mode_list_add(list, "*!*@*.example.org", "op", 0);
+	g_assert_cmpint(match_count(list, "x", "y@sub.host.example.org"), ==, 1);
+	g_assert_cmpint(match_count(list, "x", "y@example.org"), ==, 0);
+
+	mode_list_add(list, "nick[a]!*@*", "op", 0);
+	g_assert_cmpint(match_count(list, "NICK[A]", "y@z"), ==, 1);
+	assert_matches(list);
+
+	/* masks are found again after they're removed */
+	rec = mode_list_find(list, "*!*@*.EXAMPLE.ORG");
+	g_assert_nonnull(rec);
+	mode_list_remove(list, rec);
+	g_assert_cmpint(match_count(list, "x", "y@sub.host.example.org"), ==, 0);
+	g_assert_cmpint(mode_list_count(list), ==, 2);
+	assert_matches(list);
+
+	mode_list_destroy(list);
+}
+
+static void test_mode_list_match_random(void)
+{
+	MODE_LIST_REC *list;
+	BAN_REC *rec;
+	const char *mask;
+	int i;
+
+	list = mode_list_create();
+	for (i = 0; i < TEST_ROUNDS; i++) {
+		mask = masks[g_test_rand_int_range(0, G_N_ELEMENTS(masks) - 1)];
+		rec = mode_list_find(list, mask);
+		if (rec == NULL)
+			g_assert_nonnull(mode_list_add(list, mask, "op", i));
+		else
+			mode_list_remove(list, rec);
+
+		g_assert_cmpuint(mode_list_count(list), ==,
+				 g_hash_table_size(list->masks));
+		if (i % 10 == 0)
+			assert_matches(list);
+	}
+	assert_matches(list);
+	mode_list_destroy(list);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/test/mode_lists/match", test_mode_list_match);
+	g_test_add_func("/test/mode_lists/match_random", test_mode_list_match_random);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	return g_test_run();
+}
@@ -0,0 +1,242 @@
+/*
+ test-redirect.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/core/servers-setup.h>
+#include <irssi/src/core/signals.h>
+
+#include <irssi/src/irc/core/irc.h>
+#include <irssi/src/irc/core/irc-servers.h>
+#include <irssi/src/irc/core/servers-redirect.h>
+
+/* irc-core.c */
+void irc_core_init(void);
+void irc_core_deinit(void);
+
+/* irc-session.c */
+void irc_session_init(void);
+void irc_session_deinit(void);
+
+#define MODULE_NAME "tests"
+
+#define QUERIES 1000
+#define LINES 100000
+
+typedef struct {
+	SERVER_REC *server;
+	GString *received;
+	int privmsgs;
+} RedirectData;
+
+static RedirectData *current;
+
+static void sig_received(const char *name, const char *data)
+{
+	char *nick, *params;
+
+	params = event_get_params(data, 2, NULL, &nick);
+	g_string_append_printf(current->received, "%s:%s ", name, nick);
+	g_free(params);
+}
+
+static void sig_whois_alice(SERVER_REC *server, const char *data)
+{
+	sig_received("alice", data);
+}
+
+static void sig_whois_bob(SERVER_REC *server, const char *data)
+{
+	sig_received("bob", data);
+}
+
+static void sig_whois_end(SERVER_REC *server, const char *data)
+{
+	sig_received("end", data);
+}
+
+static void event_privmsg(SERVER_REC *server, const char *data)
+{
+	current->privmsgs++;
+}
+
+static void server_input(RedirectData *fixture, const char *line)
+{
+	signal_emit("server incoming", 2, fixture->server, line);
+}
+
+/* Redirect a WHOIS as if it was sent to the server */
+static void redirect_whois(RedirectData *fixture, const char *nick,
+			   const char *signal)
+{
+	IRC_SERVER_REC *server = IRC_SERVER(fixture->server);
+	char *cmd;
+
+	server_redirect_event(server, "whois", 1, nick, -1, NULL,
+			      "event 311", signal,
+			      "event 318", "redirect test end",
+			      "", "event empty", NULL);
+
+	cmd = g_strdup_printf("WHOIS %s", nick);
+	server_redirect_command(server, cmd, server->redirect_next);
+	server->redirect_next = NULL;
+	g_free(cmd);
+}
+
+static void redirect_set_up(RedirectData *fixture, const void *data)
+{
+	CHAT_PROTOCOL_REC *proto;
+	SERVER_CONNECT_REC *conn;
+
+	args_execute(0, NULL);
+	core_init();
+	irc_core_init();
+	signal_emit("irssi init finished", 0);
+
+	current = fixture;
+	fixture->received = g_string_new(NULL);
+	signal_add("redirect test alice", (SIGNAL_FUNC) sig_whois_alice);
+	signal_add("redirect test bob", (SIGNAL_FUNC) sig_whois_bob);
+	signal_add("redirect test end", (SIGNAL_FUNC) sig_whois_end);
+	signal_add("event privmsg", (SIGNAL_FUNC) event_privmsg);
+
+	proto = chat_protocol_find("IRC");
+	conn = server_create_conn(proto->id, "localhost", 0, "", "", "me");
+	fixture->server = proto->server_init_connect(conn);
+	fixture->server->session_reconnect = TRUE;
+	fixture->server->tag = g_strdup("testserver");
+
+	/* we skip some initialisations that would try to send data */
+	irc_session_deinit();
+	irc_irc_deinit();
+
+	server_connect_finished(fixture->server);
+
+	irc_irc_init();
+	irc_session_init();
+}
+
+static void redirect_tear_down(RedirectData *fixture, const void *data)
+{
+	fixture->server->connection_lost = TRUE;
+	server_disconnect(fixture->server);
+
+	signal_remove("redirect test alice", (SIGNAL_FUNC) sig_whois_alice);
+	signal_remove("redirect test bob", (SIGNAL_FUNC) sig_whois_bob);
+	signal_remove("redirect test end", (SIGNAL_FUNC) sig_whois_end);
+	signal_remove("event privmsg", (SIGNAL_FUNC) event_privmsg);
+	g_string_free(fixture->received, TRUE);
+	current = NULL;
+
+	irc_core_deinit();
+	core_deinit();
+}
+
+static void test_redirect_args(RedirectData *fixture, const void *data)
+{
+	IRC_SERVER_REC *server = IRC_SERVER(fixture->server);
+
+	redirect_whois(fixture, "alice", "redirect test alice");
+	redirect_whois(fixture, "bob", "redirect test bob");
+
+	/* replies are matched by the nick argument */
+	server_input(fixture, ":irc.example.org 311 me BOB b host.example.org * :Bob");
+	server_input(fixture, ":irc.example.org 318 me bob :End of /WHOIS list.");
+	server_input(fixture, ":irc.example.org 311 me alice a host.example.org * :Alice");
+	server_input(fixture, ":irc.example.org 318 me alice :End of /WHOIS list.");
+
+	g_assert_cmpstr(fixture->received->str, ==,
+			"bob:BOB end:bob alice:alice end:alice ");
+
+	/* unrelated events aren't redirected, but they remove the finished
+	   redirections */
+	server_input(fixture, ":nick!user@host PRIVMSG me :hello");
+	g_assert_cmpint(fixture->privmsgs, ==, 1);
+	g_assert_null(server->redirects);
+	g_assert_cmpint(g_hash_table_size(server->redirect_events), ==, 0);
+	g_assert_cmpint(server->redirects_destroyed, ==, 0);
+}
+
+static void test_redirect_optional(RedirectData *fixture, const void *data)
+{
+	IRC_SERVER_REC *server = IRC_SERVER(fixture->server);
+
+	redirect_whois(fixture, "alice", "redirect test alice");
+
+	/* 401 stops the WHOIS, 318 may still come right after it */
+	server_input(fixture, ":irc.example.org 401 me alice :No such nick/channel");
+	g_assert_cmpint(server->redirects_destroyed, ==, 1);
+	server_input(fixture, ":irc.example.org 318 me alice :End of /WHOIS list.");
+	g_assert_cmpstr(fixture->received->str, ==, "end:alice ");
+
+	server_input(fixture, ":nick!user@host PRIVMSG me :hello");
+	g_assert_null(server->redirects);
+}
+
+static void test_redirect_busy(RedirectData *fixture, const void *data)
+{
+	char *nick, *line;
+	double elapsed;
+	int i;
+
+	for (i = 0; i < QUERIES; i++) {
+		nick = g_strdup_printf("nick%d", i);
+		redirect_whois(fixture, nick, "redirect test alice");
+		g_free(nick);
+	}
+
+	g_test_timer_start();
+	for (i = 0; i < LINES; i++)
+		server_input(fixture, ":nick!user@host PRIVMSG #channel :hello");
+	elapsed = g_test_timer_elapsed();
+
+	g_test_message("%d lines with %d queued redirections in %.3f seconds",
+		       LINES, QUERIES, elapsed);
+	g_test_minimized_result(elapsed, "%d lines", LINES);
+	g_assert_cmpint(fixture->privmsgs, ==, LINES);
+
+	/* the last one still gets its reply */
+	line = g_strdup_printf(":irc.example.org 311 me nick%d u h * :Name", QUERIES - 1);
+	server_input(fixture, line);
+	g_free(line);
+	g_assert_cmpstr(fixture->received->str, ==, "alice:nick999 ");
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add("/test/redirect/args", RedirectData, NULL,
+		   redirect_set_up, test_redirect_args, redirect_tear_down);
+	g_test_add("/test/redirect/optional", RedirectData, NULL,
+		   redirect_set_up, test_redirect_optional, redirect_tear_down);
+	g_test_add("/test/redirect/busy", RedirectData, NULL,
+		   redirect_set_up, test_redirect_busy, redirect_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	return g_test_run();
+}
@@ -0,0 +1,112 @@
+/*
+ test-dcc-get.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/core/settings.h>
+
+#include <irssi/src/irc/core/irc.h>
+#include <irssi/src/irc/dcc/dcc-get.h>
+
+/* irc-core.c */
+void irc_core_init(void);
+void irc_core_deinit(void);
+
+/* dcc.c */
+void irc_dcc_init(void);
+void irc_dcc_deinit(void);
+
+/* dcc-get.c */
+GET_DCC_REC *dcc_get_create(IRC_SERVER_REC *server, CHAT_DCC_REC *chat,
+			    const char *nick, const char *arg);
+
+#define MODULE_NAME "tests"
+
+typedef struct {
+	GET_DCC_REC *paused;
+	GET_DCC_REC *idle;
+} GetData;
+
+static void get_set_up(GetData *fixture, const void *data)
+{
+	args_execute(0, NULL);
+	core_init();
+	irc_core_init();
+	irc_dcc_init();
+}
+
+static void get_tear_down(GetData *fixture, const void *data)
+{
+	while (dcc_conns != NULL)
+		dcc_destroy(dcc_conns->data);
+
+	irc_dcc_deinit();
+	irc_core_deinit();
+	core_deinit();
+}
+
+static int sig_never(void *data)
+{
+	return TRUE;
+}
+
+static void test_dcc_get_paused_timeout(GetData *fixture, const void *data)
+{
+	time_t created;
+
+	created = time(NULL) - settings_get_time("dcc_timeout") / 1000 - 60;
+
+	/* a transfer that stopped reading while the disk catches up */
+	fixture->paused = dcc_get_create(NULL, NULL, "nick", "paused");
+	g_assert_nonnull(fixture->paused);
+	fixture->paused->created = created;
+	fixture->paused->starttime = created;
+	fixture->paused->tagwait = g_timeout_add(60 * 1000, (GSourceFunc) sig_never, NULL);
+
+	/* a request nobody answered */
+	fixture->idle = dcc_get_create(NULL, NULL, "nick", "idle");
+	g_assert_nonnull(fixture->idle);
+	fixture->idle->created = created;
+
+	/* the timeout check runs once a second */
+	while (g_slist_find(dcc_conns, fixture->idle) != NULL)
+		g_main_context_iteration(NULL, TRUE);
+
+	g_assert_nonnull(g_slist_find(dcc_conns, fixture->paused));
+	g_assert_cmpint(fixture->paused->tagwait, !=, -1);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add("/test/dcc_get/paused_timeout", GetData, NULL,
+		   get_set_up, test_dcc_get_paused_timeout, get_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	return g_test_run();
+}
@@ -0,0 +1,184 @@
+/*
+ test-dcc-send.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/core/network.h>
+
+#include <irssi/src/irc/core/irc.h>
+#include <irssi/src/irc/dcc/dcc-send.h>
+
+#include <sys/socket.h>
+#include <fcntl.h>
+
+/* irc-core.c */
+void irc_core_init(void);
+void irc_core_deinit(void);
+
+/* dcc.c */
+void irc_dcc_init(void);
+void irc_dcc_deinit(void);
+
+#define MODULE_NAME "tests"
+
+#define FILE_SIZE (8*1024*1024 + 123)
+
+typedef struct {
+	char *path;
+	GByteArray *data;
+	int sock[2];
+	SEND_DCC_REC *dcc;
+} SendData;
+
+static void set_nonblock(int fd)
+{
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void send_set_up(SendData *fixture, const void *data)
+{
+	int fd, i;
+
+	args_execute(0, NULL);
+	core_init();
+	irc_core_init();
+	irc_dcc_init();
+
+	fixture->data = g_byte_array_sized_new(FILE_SIZE);
+	g_byte_array_set_size(fixture->data, FILE_SIZE);
+	for (i = 0; i < FILE_SIZE; i++)
+		fixture->data->data[i] = (guint8) (i * 7 + i / 4096);
+
+	fd = g_file_open_tmp("irssi-dcc-XXXXXX", &fixture->path, NULL);
+	g_assert_cmpint(fd, >=, 0);
+	g_assert_cmpint(write(fd, fixture->data->data, FILE_SIZE), ==, FILE_SIZE);
+
+	g_assert_cmpint(socketpair(AF_UNIX, SOCK_STREAM, 0, fixture->sock), ==, 0);
+	set_nonblock(fixture->sock[0]);
+	set_nonblock(fixture->sock[1]);
+
+	fixture->dcc = g_new0(SEND_DCC_REC, 1);
+	fixture->dcc->fhandle = fd;
+	fixture->dcc->size = FILE_SIZE;
+	fixture->dcc->handle = i_io_channel_new(fixture->sock[0]);
+}
+
+static void send_tear_down(SendData *fixture, const void *data)
+{
+	g_io_channel_unref(fixture->dcc->handle);
+	close(fixture->dcc->fhandle);
+	g_free(fixture->dcc);
+	close(fixture->sock[0]);
+	close(fixture->sock[1]);
+
+	unlink(fixture->path);
+	g_free(fixture->path);
+	g_byte_array_free(fixture->data, TRUE);
+
+	irc_dcc_deinit();
+	irc_core_deinit();
+	core_deinit();
+}
+
+static void receive_all(int fd, GByteArray *received)
+{
+	char buf[65536];
+	int ret;
+
+	while ((ret = read(fd, buf, sizeof(buf))) > 0)
+		g_byte_array_append(received, (guint8 *) buf, ret);
+}
+
+static void send_file(SendData *fixture, const char *name)
+{
+	GByteArray *received;
+	double elapsed;
+	int ret;
+
+	received = g_byte_array_sized_new(FILE_SIZE);
+
+	g_test_timer_start();
+	while ((ret = dcc_send_file_data(fixture->dcc, 1024*1024)) != -1) {
+		g_assert_cmpint(ret, >=, 0);
+		receive_all(fixture->sock[1], received);
+	}
+	receive_all(fixture->sock[1], received);
+	elapsed = g_test_timer_elapsed();
+
+	g_test_message("%s: %d bytes in %.3f seconds", name, FILE_SIZE, elapsed);
+	g_test_minimized_result(elapsed, "%s", name);
+
+	g_assert_cmpuint(fixture->dcc->transfd, ==, FILE_SIZE);
+	g_assert_cmpuint(received->len, ==, FILE_SIZE);
+	g_assert_true(memcmp(received->data, fixture->data->data, FILE_SIZE) == 0);
+
+	g_byte_array_free(received, TRUE);
+}
+
+static void test_dcc_send_sendfile(SendData *fixture, const void *data)
+{
+	send_file(fixture, "sendfile");
+}
+
+static void test_dcc_send_read(SendData *fixture, const void *data)
+{
+	fixture->dcc->no_sendfile = TRUE;
+	send_file(fixture, "read");
+}
+
+static void test_dcc_send_resume(SendData *fixture, const void *data)
+{
+	GByteArray *received;
+	int ret;
+
+	/* the file position isn't used, only transfd */
+	fixture->dcc->transfd = FILE_SIZE - 1000;
+	received = g_byte_array_new();
+	while ((ret = dcc_send_file_data(fixture->dcc, 512)) != -1)
+		receive_all(fixture->sock[1], received);
+	receive_all(fixture->sock[1], received);
+
+	g_assert_cmpuint(received->len, ==, 1000);
+	g_assert_true(memcmp(received->data, fixture->data->data + FILE_SIZE - 1000,
+			     1000) == 0);
+	g_byte_array_free(received, TRUE);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add("/test/dcc_send/sendfile", SendData, NULL,
+		   send_set_up, test_dcc_send_sendfile, send_tear_down);
+	g_test_add("/test/dcc_send/read", SendData, NULL,
+		   send_set_up, test_dcc_send_read, send_tear_down);
+	g_test_add("/test/dcc_send/resume", SendData, NULL,
+		   send_set_up, test_dcc_send_resume, send_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	return g_test_run();
+}
@@ -0,0 +1,156 @@
+/*
+ test-dcc-writer.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/irc/dcc/dcc-writer.h>
+
+#include <fcntl.h>
+
+#define FILE_SIZE (32*1024*1024 + 17)
+
+typedef struct {
+	char *path;
+	int fd;
+} WriterData;
+
+static void writer_set_up(WriterData *fixture, const void *data)
+{
+	fixture->fd = g_file_open_tmp("irssi-dcc-XXXXXX", &fixture->path, NULL);
+	g_assert_cmpint(fixture->fd, >=, 0);
+}
+
+static void writer_tear_down(WriterData *fixture, const void *data)
+{
+	close(fixture->fd);
+	unlink(fixture->path);
+	g_free(fixture->path);
+}
+
+static guint8 file_byte(int pos)
+{
+	return (guint8) (pos * 7 + pos / 4096);
+}
+
+/* Write `len' bytes in pieces of varying size */
+static void write_data(DCC_WRITER_REC *writer, int start, int len)
+{
+	char *buffer;
+	int i, pos, size, piece;
+
+	for (pos = start, i = 0; pos < start + len; pos += piece, i++) {
+		buffer = dcc_writer_buffer(writer, &size);
+		piece = MIN(1 + (i * 7919) % 70000, size);
+		piece = MIN(piece, start + len - pos);
+		for (size = 0; size < piece; size++)
+			buffer[size] = file_byte(pos + size);
+		dcc_writer_commit(writer, piece);
+
+		if (i % 4 == 0)
+			dcc_writer_flush(writer);
+	}
+}
+
+static void check_file(WriterData *fixture, int start, int len)
+{
+	char *contents;
+	gsize size;
+	int pos;
+
+	g_assert_true(g_file_get_contents(fixture->path, &contents, &size, NULL));
+	g_assert_cmpuint(size, ==, start + len);
+	for (pos = start; pos < start + len; pos++) {
+		if ((guint8) contents[pos] != file_byte(pos)) {
+			g_assert_cmpint(pos, ==, -1);
+			break;
+		}
+	}
+	g_free(contents);
+}
+
+static void test_dcc_writer_write(WriterData *fixture, const void *data)
+{
+	DCC_WRITER_REC *writer;
+	struct stat statbuf;
+	double elapsed;
+
+	g_test_timer_start();
+	writer = dcc_writer_new(fixture->fd, FILE_SIZE);
+
+	/* preallocation doesn't change the size */
+	g_assert_cmpint(fstat(fixture->fd, &statbuf), ==, 0);
+	g_assert_cmpint(statbuf.st_size, ==, 0);
+
+	write_data(writer, 0, FILE_SIZE);
+	g_assert_cmpint(dcc_writer_pending(writer), <=, FILE_SIZE);
+	g_assert_cmpint(dcc_writer_destroy(writer), ==, 0);
+	elapsed = g_test_timer_elapsed();
+
+	g_test_message("%d bytes in %.3f seconds", FILE_SIZE, elapsed);
+	g_test_minimized_result(elapsed, "%d bytes", FILE_SIZE);
+	check_file(fixture, 0, FILE_SIZE);
+}
+
+static void test_dcc_writer_resume(WriterData *fixture, const void *data)
+{
+	DCC_WRITER_REC *writer;
+	int start = 100000;
+
+	writer = dcc_writer_new(fixture->fd, 0);
+	write_data(writer, 0, start);
+	g_assert_cmpint(dcc_writer_destroy(writer), ==, 0);
+
+	/* continues from the file position */
+	g_assert_cmpint(lseek(fixture->fd, 0, SEEK_END), ==, start);
+	writer = dcc_writer_new(fixture->fd, start + 1000000);
+	write_data(writer, start, 1000000);
+	g_assert_cmpint(dcc_writer_destroy(writer), ==, 0);
+
+	check_file(fixture, 0, start + 1000000);
+}
+
+static void test_dcc_writer_error(WriterData *fixture, const void *data)
+{
+	DCC_WRITER_REC *writer;
+	int fd;
+
+	fd = open(fixture->path, O_RDONLY);
+	writer = dcc_writer_new(fd, 0);
+	write_data(writer, 0, 1000000);
+	g_assert_cmpint(dcc_writer_destroy(writer), ==, EBADF);
+	close(fd);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add("/test/dcc_writer/write", WriterData, NULL,
+		   writer_set_up, test_dcc_writer_write, writer_tear_down);
+	g_test_add("/test/dcc_writer/resume", WriterData, NULL,
+		   writer_set_up, test_dcc_writer_resume, writer_tear_down);
+	g_test_add("/test/dcc_writer/error", WriterData, NULL,
+		   writer_set_up, test_dcc_writer_error, writer_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	return g_test_run();
+}
@@ -0,0 +1,190 @@
+/*
+ test-flood.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/core/misc.h>
+#include <irssi/src/core/settings.h>
+#include <irssi/src/core/servers-setup.h>
+
+#include <irssi/src/irc/core/irc.h>
+#include <irssi/src/irc/core/irc-servers.h>
+
+/* flood.c */
+void irc_flood_init(void);
+void irc_flood_deinit(void);
+
+/* irc-core.c */
+void irc_core_init(void);
+void irc_core_deinit(void);
+
+/* irc-session.c */
+void irc_session_init(void);
+void irc_session_deinit(void);
+
+#define MODULE_NAME "tests"
+
+#define BOTS 5000
+#define ROUNDS 20
+#define MAX_RECORDS 100
+
+typedef struct {
+	SERVER_REC *server;
+	int bot_floods;
+	int flooder_floods;
+} FloodData;
+
+static FloodData *current;
+
+static void sig_flood(SERVER_REC *server, const char *nick, const char *host,
+		      void *level, const char *target)
+{
+	if (g_strcmp0(nick, "flooder") == 0)
+		current->flooder_floods++;
+	else
+		current->bot_floods++;
+}
+
+static void flood_set_up(FloodData *fixture, const void *data)
+{
+	CHAT_PROTOCOL_REC *proto;
+	SERVER_CONNECT_REC *conn;
+
+	args_execute(0, NULL);
+	core_init();
+	irc_core_init();
+	irc_flood_init();
+	signal_emit("irssi init finished", 0);
+
+	settings_set_int("flood_max_records", MAX_RECORDS);
+	signal_emit("setup changed", 0);
+
+	current = fixture;
+	signal_add("flood", (SIGNAL_FUNC) sig_flood);
+
+	proto = chat_protocol_find("IRC");
+	conn = server_create_conn(proto->id, "localhost", 0, "", "", "user");
+	fixture->server = proto->server_init_connect(conn);
+	fixture->server->session_reconnect = TRUE;
+	fixture->server->tag = g_strdup("testserver");
+
+	/* we skip some initialisations that would try to send data */
+	irc_session_deinit();
+	irc_irc_deinit();
+
+	server_connect_finished(fixture->server);
+
+	irc_irc_init();
+	irc_session_init();
+
+	IRC_SERVER(fixture->server)->isupport =
+		g_hash_table_new((GHashFunc) i_istr_hash, (GCompareFunc) i_istr_equal);
+}
+
+static void flood_tear_down(FloodData *fixture, const void *data)
+{
+	fixture->server->connection_lost = TRUE;
+	server_disconnect(fixture->server);
+
+	signal_remove("flood", (SIGNAL_FUNC) sig_flood);
+	current = NULL;
+
+	irc_flood_deinit();
+	irc_core_deinit();
+	core_deinit();
+}
+
+static void test_flood_botnet(FloodData *fixture, const void *data)
+{
+	char *bots[BOTS];
+	double elapsed;
+	int i;
+
+	for (i = 0; i < BOTS; i++)
+		bots[i] = g_strdup_printf("bot%d", i);
+
+	g_test_timer_start();
+	for (i = 0; i < BOTS * ROUNDS; i++) {
+		/* every bot sends many lines, but there are so many of
+		   them that each one gets forgotten before the next */
+		signal_emit("event privmsg", 4, fixture->server,
+			    "#spam :buy cheap things", bots[i % BOTS],
+			    "bot@botnet.example.org");
+
+		if (i % 10 == 0) {
+			signal_emit("event privmsg", 4, fixture->server,
+				    "#spam :flood", "flooder",
+				    "user@example.org");
+		}
+	}
+	elapsed = g_test_timer_elapsed();
+
+	g_test_message("%d messages from %d nicks in %.3f seconds",
+		       BOTS * ROUNDS + BOTS * ROUNDS / 10, BOTS + 1, elapsed);
+	g_test_minimized_result(elapsed, "flood check of %d messages",
+				BOTS * ROUNDS);
+
+	g_assert_cmpint(fixture->bot_floods, ==, 0);
+	g_assert_cmpint(fixture->flooder_floods, >, 0);
+
+	for (i = 0; i < BOTS; i++)
+		g_free(bots[i]);
+}
+
+static void test_flood_targets(FloodData *fixture, const void *data)
+{
+	int i;
+
+	/* the same amount of lines to different channels isn't flooding */
+	for (i = 0; i < 20; i++) {
+		char *line = g_strdup_printf("#chan%d :hello", i);
+
+		signal_emit("event privmsg", 4, fixture->server, line,
+			    "flooder", "user@example.org");
+		g_free(line);
+	}
+	g_assert_cmpint(fixture->flooder_floods, ==, 0);
+
+	for (i = 0; i < 5; i++) {
+		signal_emit("event privmsg", 4, fixture->server,
+			    "#chan0 :hello", "flooder", "user@example.org");
+	}
+	g_assert_cmpint(fixture->flooder_floods, >, 0);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add("/test/flood/botnet", FloodData, NULL,
+		   flood_set_up, test_flood_botnet, flood_tear_down);
+	g_test_add("/test/flood/targets", FloodData, NULL,
+		   flood_set_up, test_flood_targets, flood_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	return g_test_run();
+}
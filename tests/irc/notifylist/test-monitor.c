@@ -0,0 +1,277 @@
+/*
+ test-monitor.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/core/misc.h>
+#include <irssi/src/core/net-sendbuffer.h>
+#include <irssi/src/core/network.h>
+#include <irssi/src/core/servers-setup.h>
+#include <irssi/src/core/signals.h>
+
+#include <irssi/src/irc/core/irc.h>
+#include <irssi/src/irc/core/irc-servers.h>
+#include <irssi/src/irc/notifylist/notifylist.h>
+
+/* notify-monitor.c */
+int notifylist_monitor_start(IRC_SERVER_REC *server);
+
+/* notifylist.c */
+void irc_notifylist_init(void);
+void irc_notifylist_deinit(void);
+
+/* irc-core.c */
+void irc_core_init(void);
+void irc_core_deinit(void);
+
+/* irc-session.c */
+void irc_session_init(void);
+void irc_session_deinit(void);
+
+#include <sys/socket.h>
+
+#define MODULE_NAME "tests"
+
+typedef struct {
+	SERVER_REC *server;
+	int fd; /* the server's end of the connection */
+	GString *received;
+	int joined, left;
+} MonitorData;
+
+static MonitorData *current;
+
+static void sig_joined(SERVER_REC *server, const char *nick)
+{
+	current->joined++;
+}
+
+static void sig_left(SERVER_REC *server, const char *nick)
+{
+	current->left++;
+}
+
+static void server_input(MonitorData *fixture, const char *line)
+{
+	signal_emit("server incoming", 2, fixture->server, line);
+}
+
+/* Lets the command queue send everything and returns the lines the
+   server received starting with `prefix' separated with '|' */
+static char *server_received(MonitorData *fixture, const char *prefix)
+{
+	GString *str;
+	char buf[512], **lines, **line;
+	ssize_t ret;
+
+	while (IRC_SERVER(fixture->server)->cmdqueue != NULL)
+		g_main_context_iteration(NULL, TRUE);
+
+	while ((ret = recv(fixture->fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+		g_string_append_len(fixture->received, buf, ret);
+
+	str = g_string_new(NULL);
+	lines = g_strsplit(fixture->received->str, "\r\n", -1);
+	for (line = lines; *line != NULL; line++) {
+		if (!g_str_has_prefix(*line, prefix))
+			continue;
+
+		if (str->len > 0)
+			g_string_append_c(str, '|');
+		g_string_append(str, *line);
+	}
+	g_strfreev(lines);
+	return g_string_free(str, FALSE);
+}
+
+static void monitor_set_up(MonitorData *fixture, const void *data)
+{
+	CHAT_PROTOCOL_REC *proto;
+	SERVER_CONNECT_REC *conn;
+	int fds[2];
+
+	args_execute(0, NULL);
+	core_init();
+	irc_core_init();
+	irc_notifylist_init();
+	signal_emit("irssi init finished", 0);
+
+	current = fixture;
+	signal_add("notifylist joined", (SIGNAL_FUNC) sig_joined);
+	signal_add("notifylist left", (SIGNAL_FUNC) sig_left);
+
+	proto = chat_protocol_find("IRC");
+	conn = server_create_conn(proto->id, "localhost", 0, "", "", "me");
+	fixture->server = proto->server_init_connect(conn);
+	fixture->server->session_reconnect = TRUE;
+	fixture->server->tag = g_strdup("testserver");
+
+	/* we skip some initialisations that would try to send data */
+	irc_session_deinit();
+	irc_irc_deinit();
+
+	server_connect_finished(fixture->server);
+
+	irc_irc_init();
+	irc_session_init();
+
+	/* the other end of a socket pair acts as the server */
+	g_assert_cmpint(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), ==, 0);
+	fixture->server->handle = net_sendbuffer_create(i_io_channel_new(fds[0]), 0);
+	fixture->fd = fds[1];
+	fixture->received = g_string_new(NULL);
+	/* don't wait between the commands */
+	IRC_SERVER(fixture->server)->cmd_queue_speed = 0;
+
+	notifylist_add("alice", NULL, FALSE);
+	notifylist_add("bob!*@*.example.org", NULL, FALSE);
+}
+
+static void monitor_tear_down(MonitorData *fixture, const void *data)
+{
+	notifylist_remove("alice");
+	notifylist_remove("bob!*@*.example.org");
+
+	fixture->server->connection_lost = TRUE;
+	server_disconnect(fixture->server);
+	close(fixture->fd);
+	g_string_free(fixture->received, TRUE);
+
+	signal_remove("notifylist joined", (SIGNAL_FUNC) sig_joined);
+	signal_remove("notifylist left", (SIGNAL_FUNC) sig_left);
+	current = NULL;
+
+	irc_notifylist_deinit();
+	irc_core_deinit();
+	core_deinit();
+}
+
+static void test_monitor_online(MonitorData *fixture, const void *data)
+{
+	IRC_SERVER_REC *server = IRC_SERVER(fixture->server);
+	char *cmds;
+
+	server_input(fixture, ":irc.example.org 005 me MONITOR=100 :are supported by this server");
+	server_input(fixture, ":irc.example.org 376 me :End of /MOTD command.");
+
+	cmds = server_received(fixture, "MONITOR");
+	g_assert_cmpstr(cmds, ==, "MONITOR + alice,bob");
+	g_free(cmds);
+
+	/* MONITOR replaces polling */
+	cmds = server_received(fixture, "ISON");
+	g_assert_cmpstr(cmds, ==, "");
+	g_free(cmds);
+
+	server_input(fixture, ":irc.example.org 730 me :alice!a@host.example.org,bob!b@host.example.org");
+	cmds = server_received(fixture, "WHOIS");
+	g_assert_cmpstr(cmds, ==, "WHOIS alice,bob");
+	g_free(cmds);
+
+	/* the WHOIS replies, as given by the redirect */
+	signal_emit("notifylist event whois", 2, server,
+		    "me alice a host.example.org * :Alice");
+	signal_emit("notifylist event whois", 2, server,
+		    "me bob b host.example.org * :Bob");
+	signal_emit("notifylist event whois end", 2, server,
+		    "me alice,bob :End of /WHOIS list.");
+
+	g_assert_cmpint(fixture->joined, ==, 2);
+	g_assert_true(notifylist_ison_server(server, "alice"));
+	g_assert_true(notifylist_ison_server(server, "bob"));
+
+	server_input(fixture, ":irc.example.org 731 me :alice");
+	g_assert_cmpint(fixture->left, ==, 1);
+	g_assert_false(notifylist_ison_server(server, "alice"));
+	g_assert_true(notifylist_ison_server(server, "bob"));
+}
+
+static void test_monitor_changes(MonitorData *fixture, const void *data)
+{
+	char *cmds;
+
+	server_input(fixture, ":irc.example.org 005 me MONITOR :are supported by this server");
+	server_input(fixture, ":irc.example.org 422 me :MOTD File is missing");
+
+	notifylist_add("carol", NULL, FALSE);
+	/* another mask for the same nick */
+	notifylist_add("carol!*@*.example.com", NULL, FALSE);
+	notifylist_remove("carol!*@*.example.com");
+	notifylist_remove("carol");
+
+	cmds = server_received(fixture, "MONITOR");
+	g_assert_cmpstr(cmds, ==, "MONITOR + alice,bob|MONITOR + carol|MONITOR - carol");
+	g_free(cmds);
+}
+
+static void test_monitor_list_full(MonitorData *fixture, const void *data)
+{
+	char *cmds;
+
+	server_input(fixture, ":irc.example.org 005 me MONITOR=1 :are supported by this server");
+	server_input(fixture, ":irc.example.org 376 me :End of /MOTD command.");
+
+	/* notify list doesn't fit to the server's limit */
+	cmds = server_received(fixture, "MONITOR");
+	g_assert_cmpstr(cmds, ==, "");
+	g_free(cmds);
+	g_assert_false(notifylist_monitor_start(IRC_SERVER(fixture->server)));
+}
+
+static void test_monitor_unsupported(MonitorData *fixture, const void *data)
+{
+	char *cmds;
+
+	server_input(fixture, ":irc.example.org 376 me :End of /MOTD command.");
+	server_input(fixture, ":irc.example.org 730 me :alice!a@host.example.org");
+
+	cmds = server_received(fixture, "MONITOR");
+	g_assert_cmpstr(cmds, ==, "");
+	g_free(cmds);
+
+	/* replies to someone else's MONITOR aren't ours */
+	cmds = server_received(fixture, "WHOIS");
+	g_assert_cmpstr(cmds, ==, "");
+	g_free(cmds);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add("/test/monitor/online", MonitorData, NULL,
+		   monitor_set_up, test_monitor_online, monitor_tear_down);
+	g_test_add("/test/monitor/changes", MonitorData, NULL,
+		   monitor_set_up, test_monitor_changes, monitor_tear_down);
+	g_test_add("/test/monitor/list_full", MonitorData, NULL,
+		   monitor_set_up, test_monitor_list_full, monitor_tear_down);
+	g_test_add("/test/monitor/unsupported", MonitorData, NULL,
+		   monitor_set_up, test_monitor_unsupported, monitor_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	return g_test_run();
+}
@@ -0,0 +1,200 @@
+/*
+ test-flow.c : irssi
+
+    Copyright (C) 2026 The Irssi project.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <irssi/src/common.h>
+#include <irssi/src/core/args.h>
+#include <irssi/src/core/core.h>
+#include <irssi/src/core/net-sendbuffer.h>
+#include <irssi/src/core/network.h>
+#include <irssi/src/core/settings.h>
+
+#include <irssi/src/irc/proxy/proxy.h>
+
+#include <sys/socket.h>
+
+/* flow.c */
+void proxy_flow_init(void);
+void proxy_flow_deinit(void);
+void proxy_client_send_line(CLIENT_REC *client, PROXY_LINE_REC *line,
+			    int message);
+void proxy_client_flow_destroy(CLIENT_REC *client);
+
+/* dump.c */
+PROXY_LINE_REC *proxy_line_new(const char *line);
+void proxy_line_unref(PROXY_LINE_REC *rec);
+
+#define MODULE_NAME "tests"
+
+#define HIGH_WATERMARK (16*1024)
+/* a line may be sent while the buffer is just under the high watermark */
+#define MAX_PENDING (HIGH_WATERMARK + 512)
+
+GSList *proxy_clients;
+
+void proxy_client_disconnect_later(CLIENT_REC *client)
+{
+	client->overflowed = TRUE;
+}
+
+typedef struct {
+	int sock[2];
+	CLIENT_REC *client;
+	GString *received;
+	int seq;
+} FlowData;
+
+static void set_nonblock(int fd)
+{
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void flow_set_up(FlowData *fixture, const void *data)
+{
+	args_execute(0, NULL);
+	core_init();
+
+	settings_add_size("irssiproxy", "irssiproxy_client_high_watermark", "256k");
+	settings_add_size("irssiproxy", "irssiproxy_client_low_watermark", "64k");
+	settings_add_choice("irssiproxy", "irssiproxy_slow_client", 0,
+			    "drop;compress;disconnect");
+	settings_set_size("irssiproxy_client_high_watermark", "16k");
+	settings_set_size("irssiproxy_client_low_watermark", "4k");
+	settings_set_choice("irssiproxy_slow_client", "compress");
+	proxy_flow_init();
+
+	g_assert_cmpint(socketpair(AF_UNIX, SOCK_STREAM, 0, fixture->sock), ==, 0);
+	set_nonblock(fixture->sock[0]);
+	set_nonblock(fixture->sock[1]);
+
+	fixture->client = g_new0(CLIENT_REC, 1);
+	fixture->client->handle =
+	    net_sendbuffer_create(i_io_channel_new(fixture->sock[0]), 0);
+	fixture->received = g_string_new(NULL);
+}
+
+static void flow_tear_down(FlowData *fixture, const void *data)
+{
+	proxy_client_flow_destroy(fixture->client);
+	net_sendbuffer_destroy(fixture->client->handle, TRUE);
+	g_free(fixture->client);
+	close(fixture->sock[1]);
+	g_string_free(fixture->received, TRUE);
+
+	proxy_flow_deinit();
+	core_deinit();
+}
+
+/* Every line carries a sequence number, so the order they were received
+   in can be checked */
+static void flow_send(FlowData *fixture, const char *fmt, int message)
+{
+	PROXY_LINE_REC *line;
+	char *str;
+
+	str = g_strdup_printf(fmt, fixture->seq % 3, fixture->seq);
+	fixture->seq++;
+
+	line = proxy_line_new(str);
+	proxy_client_send_line(fixture->client, line, message);
+	proxy_line_unref(line);
+	g_free(str);
+}
+
+static void flow_read(FlowData *fixture)
+{
+	char buf[4096];
+	int ret;
+
+	while ((ret = read(fixture->sock[1], buf, sizeof(buf))) > 0)
+		g_string_append_len(fixture->received, buf, ret);
+}
+
+static void test_flow_stalled_client(FlowData *fixture, const void *data)
+{
+	CLIENT_REC *client = fixture->client;
+	GHashTable *joins;
+	const char *pos;
+	char *end;
+	int i, seq, last_seq;
+
+	/* the client reads nothing until its buffer is full */
+	for (i = 0; i < 100000 && !client->throttled; i++) {
+		flow_send(fixture, ":nick%d!user@host PRIVMSG #chan :seq%d", TRUE);
+		g_assert_cmpint(net_sendbuffer_pending(client->handle), <=, MAX_PENDING);
+	}
+	g_assert_true(client->throttled);
+
+	joins = g_hash_table_new(NULL, NULL);
+	for (i = 0; i < 5000; i++) {
+		if (i % 5 == 0) {
+			g_hash_table_add(joins, GINT_TO_POINTER(fixture->seq));
+			flow_send(fixture, ":nick%d!user@host JOIN #seq%d", FALSE);
+		} else {
+			flow_send(fixture, ":nick%d!user@host PRIVMSG #chan :seq%d", TRUE);
+		}
+		g_main_context_iteration(NULL, FALSE);
+
+		g_assert_false(client->overflowed);
+		g_assert_cmpint(net_sendbuffer_pending(client->handle), <=, MAX_PENDING);
+	}
+	g_assert_cmpuint(client->lines_dropped, >, 0);
+
+	/* the client catches up */
+	while (client->throttled) {
+		flow_read(fixture);
+		g_main_context_iteration(NULL, TRUE);
+		g_assert_cmpint(net_sendbuffer_pending(client->handle), <=, MAX_PENDING);
+	}
+	while (net_sendbuffer_pending(client->handle) > 0) {
+		flow_read(fixture);
+		g_main_context_iteration(NULL, FALSE);
+	}
+	flow_read(fixture);
+	g_assert_cmpint(client->held_size, ==, 0);
+
+	/* the lines kept their order and no JOIN was lost */
+	last_seq = -1;
+	for (pos = strstr(fixture->received->str, "seq"); pos != NULL;
+	     pos = strstr(end, "seq")) {
+		seq = strtol(pos + 3, &end, 10);
+		g_assert_cmpint(seq, >, last_seq);
+		last_seq = seq;
+		g_hash_table_remove(joins, GINT_TO_POINTER(seq));
+	}
+	g_assert_cmpint(g_hash_table_size(joins), ==, 0);
+	g_hash_table_destroy(joins);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add("/test/proxy_flow/stalled_client", FlowData, NULL,
+		   flow_set_up, test_flow_stalled_client, flow_tear_down);
+
+#if GLIB_CHECK_VERSION(2,38,0)
+	g_test_set_nonfatal_assertions();
+#endif
+
+	core_preinit(*argv);
+	irssi_gui = IRSSI_GUI_NONE;
+
+	return g_test_run();
+}